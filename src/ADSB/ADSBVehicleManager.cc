@@ -105,15 +105,23 @@ void ADSBVehicleManager::_stop()
 
 void ADSBVehicleManager::_cleanupStaleVehicles()
 {
-    for (qsizetype i = _adsbVehicles->count() - 1; i >= 0; i--) {
+    QObjectList activeVehicles;
+    activeVehicles.reserve(_adsbVehicles->count());
+    for (qsizetype i = 0; i < _adsbVehicles->count(); i++) {
         ADSBVehicle* const adsbVehicle = _adsbVehicles->value<ADSBVehicle*>(i);
         if (adsbVehicle->expired()) {
             qCDebug(ADSBVehicleManagerLog) << "Expired" << QString::number(adsbVehicle->icaoAddress());
-            (void) _adsbVehicles->removeAt(i);
             (void) _adsbICAOMap.remove(adsbVehicle->icaoAddress());
-            adsbVehicle->deleteLater();
+        } else {
+            activeVehicles.append(adsbVehicle);
         }
     }
+
+    // Expired vehicles next to each other go in a single row removal
+    const QObjectList expiredVehicles = _adsbVehicles->replaceAll(activeVehicles);
+    for (QObject* const adsbVehicle : expiredVehicles) {
+        adsbVehicle->deleteLater();
+    }
 }
 
 void ADSBVehicleManager::_linkError(const QString &errorMsg, bool stopped)
@@ -158,6 +158,12 @@ public:
     /// Reset the state of the MissionItemHandler to no items, no transactions in progress.
     void resetMissionItemHandler(void) { _missionItemHandler.reset(); }
 
+    /// Delays responses to mission protocol messages to simulate a slow link
+    void setMissionItemResponseLatency(int responseLatencyMsecs) { _missionItemHandler.setResponseLatency(responseLatencyMsecs); }
+
+    /// Sets the number of mission items the ground station streams ahead of MISSION_REQUEST_INT during a write
+    void setMissionTransferWindow(int transferWindow) { _missionItemHandler.setTransferWindow(transferWindow); }
+
     /// Returns the filename for the simulated log file. Only available after a download is requested.
     QString logDownloadFile(void) { return _logDownloadFilename; }
 
@@ -41,7 +41,7 @@ void MockLinkMissionItemHandler::_startMissionItemResponseTimer(void)
         _missionItemResponseTimer = new QTimer();
         connect(_missionItemResponseTimer, &QTimer::timeout, this, &MockLinkMissionItemHandler::_missionItemResponseTimeout);
     }
-    _missionItemResponseTimer->start(500);
+    _missionItemResponseTimer->start(500 + _responseLatencyMsecs);
 }
 
 bool MockLinkMissionItemHandler::handleMessage(const mavlink_message_t& msg)
@@ -168,7 +168,7 @@ void MockLinkMissionItemHandler::_handleMissionRequestList(const mavlink_message
             _requestType,
             0
         );
-        _mockLink->respondWithMavlinkMessage(responseMsg);
+        _respond(responseMsg);
     }
 }
 
@@ -241,7 +241,7 @@ void MockLinkMissionItemHandler::_handleMissionRequest(const mavlink_message_t&
                                                    missionItemInt.param1, missionItemInt.param2, missionItemInt.param3, missionItemInt.param4,
                                                    missionItemInt.x, missionItemInt.y, missionItemInt.z,
                                                    _requestType);
-            _mockLink->respondWithMavlinkMessage(responseMsg);
+            _respond(responseMsg);
         }
     }
 }
@@ -321,7 +321,8 @@ void MockLinkMissionItemHandler::_requestNextMissionItem(int sequenceNumber)
                                                       _mavlinkProtocol->getComponentId(),
                                                       sequenceNumber,
                                                       _requestType);
-            _mockLink->respondWithMavlinkMessage(message);
+            _respond(message);
+            _writeRequestIndex = sequenceNumber;
 
             // If response with Mission Item doesn't come before timer fires it's an error
             _startMissionItemResponseTimer();
@@ -329,6 +330,17 @@ void MockLinkMissionItemHandler::_requestNextMissionItem(int sequenceNumber)
     }
 }
 
+void MockLinkMissionItemHandler::_respond(const mavlink_message_t& msg)
+{
+    if (_responseLatencyMsecs > 0) {
+        QTimer::singleShot(_responseLatencyMsecs, Qt::PreciseTimer, _mockLink, [this, msg]() {
+            _mockLink->respondWithMavlinkMessage(msg);
+        });
+    } else {
+        _mockLink->respondWithMavlinkMessage(msg);
+    }
+}
+
 void MockLinkMissionItemHandler::_sendAck(MAV_MISSION_RESULT ackType)
 {
     qCDebug(MockLinkMissionItemHandlerLog) << "_sendAck write sequence complete ackType:" << ackType;
@@ -346,7 +358,7 @@ void MockLinkMissionItemHandler::_sendAck(MAV_MISSION_RESULT ackType)
         _requestType,
         0
     );
-    _mockLink->respondWithMavlinkMessage(message);
+    _respond(message);
 }
 
 void MockLinkMissionItemHandler::_handleMissionItem(const mavlink_message_t& msg)
@@ -358,6 +370,7 @@ void MockLinkMissionItemHandler::_handleMissionItem(const mavlink_message_t& msg
     MAV_MISSION_TYPE            missionType;
     uint16_t                    seq;
     mavlink_mission_item_int_t  missionItemInt;
+    MissionItemList_t*          writeItems = nullptr;
 
     mavlink_msg_mission_item_int_decode(&msg, &missionItemInt);
     missionType = static_cast<MAV_MISSION_TYPE>(missionItemInt.mission_type);
@@ -365,21 +378,34 @@ void MockLinkMissionItemHandler::_handleMissionItem(const mavlink_message_t& msg
     
     switch (missionType) {
     case MAV_MISSION_TYPE_MISSION:
-        _missionItems[seq] = missionItemInt;
+        writeItems = &_missionItems;
         break;
     case MAV_MISSION_TYPE_FENCE:
-        _fenceItems[seq] = missionItemInt;
+        writeItems = &_fenceItems;
         break;
     case MAV_MISSION_TYPE_RALLY:
-        _rallyItems[seq] = missionItemInt;
+        writeItems = &_rallyItems;
         break;
     case MAV_MISSION_TYPE_ENUM_END:
     case MAV_MISSION_TYPE_ALL:
         qWarning() << "Internal error";
-        break;
+        return;
     }
+    (*writeItems)[seq] = missionItemInt;
 
-    _writeSequenceIndex++;
+    if (_transferWindow > 1) {
+        // Items following the requested one are streamed without being requested, skip over everything already received
+        while (_writeSequenceIndex < _writeSequenceCount && writeItems->contains(_writeSequenceIndex)) {
+            _writeSequenceIndex++;
+        }
+        if (_writeSequenceIndex < qMin(_writeRequestIndex + _transferWindow, _writeSequenceCount)) {
+            // Remainder of the streamed items are still on the way
+            _startMissionItemResponseTimer();
+            return;
+        }
+    } else {
+        _writeSequenceIndex++;
+    }
     if (_writeSequenceIndex < _writeSequenceCount) {
         if (_failureMode == FailWriteFinalAckMissingRequests && _writeSequenceIndex == 3) {
             // Send MAV_MISSION_ACCEPTED ack too early
@@ -80,6 +80,14 @@ public:
 
     void setSendHomePositionOnEmptyList(bool sendHomePositionOnEmptyList) { _sendHomePositionOnEmptyList = sendHomePositionOnEmptyList; }
 
+    /// Delays all responses to simulate a slow link
+    ///     @param responseLatencyMsecs Round trip time to simulate, 0 for none
+    void setResponseLatency(int responseLatencyMsecs) { _responseLatencyMsecs = responseLatencyMsecs; }
+
+    /// Sets the number of items the ground station streams after each MISSION_REQUEST_INT during a write. The next
+    /// item is only requested once all of the streamed items have arrived.
+    void setTransferWindow(int transferWindow) { _transferWindow = transferWindow; }
+
 private slots:
     void _missionItemResponseTimeout(void);
 
@@ -91,6 +99,7 @@ private:
     void _handleMissionClearAll         (const mavlink_message_t& msg);
     void _requestNextMissionItem        (int sequenceNumber);
     void _sendAck                       (MAV_MISSION_RESULT ackType);
+    void _respond                       (const mavlink_message_t& msg);
     void _startMissionItemResponseTimer (void);
 
 private:
@@ -98,6 +107,7 @@ private:
     
     int _writeSequenceCount;    ///< Numbers of items about to be written
     int _writeSequenceIndex;    ///< Current index being reqested
+    int _writeRequestIndex = 0; ///< Index of the last MISSION_REQUEST_INT sent
 
     typedef QMap<uint16_t, mavlink_mission_item_int_t> MissionItemList_t;
 
@@ -114,5 +124,7 @@ private:
     bool                _failReadRequestListFirstResponse;
     bool                _failReadRequest1FirstResponse;
     bool                _failWriteMissionCountFirstResponse;
+    int                 _responseLatencyMsecs = 0;
+    int                 _transferWindow = 1;
 };
 
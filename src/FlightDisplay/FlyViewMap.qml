@@ -222,6 +222,19 @@ FlightMap {
         onTriggered:    updateMapToVehiclePosition()
     }
 
+    // Warm the tile cache ahead of the vehicle so fast movers do not fly off the edge of cached imagery
+    Timer {
+        interval:       2000
+        running:        !pipMode && _activeVehicleCoordinate.isValid
+        repeat:         true
+        onTriggered: {
+            var missionController = _planMasterController.missionController
+            var missionPath = missionController.missionItemCount > 0 ? missionController.waypointPath : []
+            QGroundControl.mapEngineManager.updatePrefetch(activeMapType.name, zoomLevel, _activeVehicleCoordinate,
+                                                           _activeVehicle.heading.rawValue, _activeVehicle.groundSpeed.rawValue, missionPath)
+        }
+    }
+
     QGCMapPalette { id: mapPal; lightColors: isSatelliteMap }
 
     Connections {
@@ -199,6 +199,25 @@ Item {
         property real topEdgeCenterInset: visible ? y + height : 0
     }
 
+    // Live indicator for the vehicle position being outside of the fence
+    Rectangle {
+        anchors.margins:            _toolsMargin
+        anchors.top:                parent.top
+        anchors.horizontalCenter:   parent.horizontalCenter
+        width:                      fenceBreachLabel.contentWidth + ScreenTools.defaultFontPixelWidth * 2
+        height:                     fenceBreachLabel.contentHeight + ScreenTools.defaultFontPixelHeight / 2
+        radius:                     ScreenTools.defaultFontPixelWidth / 2
+        color:                      qgcPal.alertBackground
+        visible:                    _activeVehicle && _geoFenceController.vehicleBreachesFence
+
+        QGCLabel {
+            id:                 fenceBreachLabel
+            anchors.centerIn:   parent
+            text:               qsTr("Vehicle is outside of the GeoFence")
+            color:              qgcPal.alertText
+        }
+    }
+
     Loader {
         id: preFlightChecklistLoader
         sourceComponent: preFlightChecklistPopup
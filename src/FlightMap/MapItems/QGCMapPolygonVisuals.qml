@@ -224,9 +224,10 @@ Item {
         title:          qsTr("Select Polygon File")
 
         onAcceptedForLoad: (file) => {
-            mapPolygon.loadKMLOrSHPFile(file)
-            mapFitFunctions.fitMapViewportToMissionItems()
             close()
+            if (mapPolygon.loadKMLOrSHPFile(file)) {
+                mapFitFunctions.fitMapViewportToMissionItems()
+            }
         }
     }
 
@@ -622,8 +623,8 @@ Item {
 
             QGCButton {
                 _horizontalPadding: 0
-                text:               qsTr("Load KML/SHP...")
-                onClicked:          kmlOrSHPLoadDialog.openForLoad()
+                text:               mapPolygon.importing ? qsTr("Cancel Load (%1%)").arg(Math.round(mapPolygon.importProgress * 100)) : qsTr("Load KML/SHP...")
+                onClicked:          mapPolygon.importing ? mapPolygon.cancelImport() : kmlOrSHPLoadDialog.openForLoad()
                 visible:            !mapPolygon.traceMode
             }
         }
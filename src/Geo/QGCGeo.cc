@@ -19,6 +19,8 @@
 #include <GeographicLib/MGRS.hpp>
 #include <GeographicLib/UTMUPS.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 
 QGC_LOGGING_CATEGORY(QGCGeoLog, "qgc.geo.qgcgeo")
@@ -86,6 +88,112 @@ void convertNedToGeo(double x, double y, double z, const QGeoCoordinate &origin,
     coord.setAltitude(-z + origin.altitude());
 }
 
+void convertGeoToNed(const double *latitudes, const double *longitudes, const double *altitudes, const QGeoCoordinate &origin, double *x, double *y, double *z, qsizetype count)
+{
+    NedOrigin(origin).convertGeoToNed(latitudes, longitudes, altitudes, x, y, z, count);
+}
+
+void convertNedToGeo(const double *x, const double *y, const double *z, const QGeoCoordinate &origin, double *latitudes, double *longitudes, double *altitudes, qsizetype count)
+{
+    NedOrigin(origin).convertNedToGeo(x, y, z, latitudes, longitudes, altitudes, count);
+}
+
+/*===========================================================================*/
+
+NedOrigin::NedOrigin(const QGeoCoordinate &origin)
+    : _origin(origin)
+    , _latRad(qDegreesToRadians(origin.latitude()))
+    , _lonRad(qDegreesToRadians(origin.longitude()))
+    , _sinLat(sin(_latRad))
+    , _cosLat(cos(_latRad))
+    , _altitude(origin.altitude())
+{
+
+}
+
+void NedOrigin::convertGeoToNed(const QGeoCoordinate &coord, double &x, double &y, double &z) const
+{
+    if (coord == _origin) {
+        // Prevent NaNs in calculation
+        x = y = z = 0;
+        return;
+    }
+
+    const double latitude = coord.latitude();
+    const double longitude = coord.longitude();
+    const double altitude = coord.altitude();
+    convertGeoToNed(&latitude, &longitude, &altitude, &x, &y, &z, 1);
+}
+
+void NedOrigin::convertNedToGeo(double x, double y, double z, QGeoCoordinate &coord) const
+{
+    double latitude;
+    double longitude;
+    double altitude;
+    convertNedToGeo(&x, &y, &z, &latitude, &longitude, &altitude, 1);
+
+    coord.setLatitude(latitude);
+    coord.setLongitude(longitude);
+    coord.setAltitude(altitude);
+}
+
+void NedOrigin::convertGeoToNed(const double *latitudes, const double *longitudes, const double *altitudes, double *x, double *y, double *z, qsizetype count) const
+{
+    const double radius = GeographicLib::Constants::WGS84_a();
+
+    // Branch free so that the loop vectorizes. Clamping keeps acos defined for coordinates at the origin,
+    // where c is 0 and k is selected as 1 which yields 0 for both components.
+    for (qsizetype i = 0; i < count; i++) {
+        const double lat_rad = qDegreesToRadians(latitudes[i]);
+        const double d_lon_rad = qDegreesToRadians(longitudes[i]) - _lonRad;
+
+        const double sin_lat = std::sin(lat_rad);
+        const double cos_lat = std::cos(lat_rad);
+        const double sin_d_lon = std::sin(d_lon_rad);
+        const double cos_d_lon = std::cos(d_lon_rad);
+
+        const double c = std::acos(std::clamp((_sinLat * sin_lat) + (_cosLat * cos_lat * cos_d_lon), -1.0, 1.0));
+        const double k = (c < epsilon) ? 1.0 : (c / std::sin(c));
+
+        x[i] = k * ((_cosLat * sin_lat) - (_sinLat * cos_lat * cos_d_lon)) * radius;
+        y[i] = k * cos_lat * sin_d_lon * radius;
+    }
+
+    if (altitudes && z) {
+        for (qsizetype i = 0; i < count; i++) {
+            z[i] = -(altitudes[i] - _altitude);
+        }
+    }
+}
+
+void NedOrigin::convertNedToGeo(const double *x, const double *y, const double *z, double *latitudes, double *longitudes, double *altitudes, qsizetype count) const
+{
+    const double radius = GeographicLib::Constants::WGS84_a();
+
+    for (qsizetype i = 0; i < count; i++) {
+        const double x_rad = x[i] / radius;
+        const double y_rad = y[i] / radius;
+        const double c = std::sqrt((x_rad * x_rad) + (y_rad * y_rad));
+        const double sin_c = std::sin(c);
+        const double cos_c = std::cos(c);
+
+        // Both are NaN at the origin, where the origin itself is selected instead
+        const double lat_rad = std::asin(std::clamp((cos_c * _sinLat) + ((x_rad * sin_c * _cosLat) / c), -1.0, 1.0));
+        const double lon_rad = _lonRad + std::atan2(y_rad * sin_c, (c * _cosLat * cos_c) - (x_rad * _sinLat * sin_c));
+
+        latitudes[i] = qRadiansToDegrees((c > epsilon) ? lat_rad : _latRad);
+        longitudes[i] = qRadiansToDegrees((c > epsilon) ? lon_rad : _lonRad);
+    }
+
+    if (z && altitudes) {
+        for (qsizetype i = 0; i < count; i++) {
+            altitudes[i] = -z[i] + _altitude;
+        }
+    }
+}
+
+/*===========================================================================*/
+
 int convertGeoToUTM(const QGeoCoordinate& coord, double &easting, double &northing)
 {
     try {
@@ -116,6 +224,50 @@ bool convertUTMToGeo(double easting, double northing, int zone, bool southhemi,
     return true;
 }
 
+int convertGeoToUTM(const double *latitudes, const double *longitudes, double *eastings, double *northings, qsizetype count)
+{
+    if (count <= 0) {
+        return 0;
+    }
+
+    try {
+        int zone;
+        bool northp;
+        GeographicLib::UTMUPS::Forward(latitudes[0], longitudes[0], zone, northp, eastings[0], northings[0]);
+
+        // The zone is forced to the one of the first point, the hemisphere follows each point
+        // and is moved over to the one of the first point through the false northing
+        static constexpr double falseNorthing = 10000000.0;
+        for (qsizetype i = 1; i < count; i++) {
+            int pointZone;
+            bool pointNorthp;
+            GeographicLib::UTMUPS::Forward(latitudes[i], longitudes[i], pointZone, pointNorthp, eastings[i], northings[i], zone);
+            if (pointNorthp != northp) {
+                northings[i] += northp ? -falseNorthing : falseNorthing;
+            }
+        }
+
+        return zone;
+    } catch(const GeographicLib::GeographicErr& e) {
+        qCDebug(QGCGeoLog) << Q_FUNC_INFO << e.what();
+        return 0;
+    }
+}
+
+bool convertUTMToGeo(const double *eastings, const double *northings, int zone, bool southhemi, double *latitudes, double *longitudes, qsizetype count)
+{
+    try {
+        for (qsizetype i = 0; i < count; i++) {
+            GeographicLib::UTMUPS::Reverse(zone, !southhemi, eastings[i], northings[i], latitudes[i], longitudes[i]);
+        }
+    } catch(const GeographicLib::GeographicErr& e) {
+        qCDebug(QGCGeoLog) << Q_FUNC_INFO << e.what();
+        return false;
+    }
+
+    return true;
+}
+
 QString convertGeoToMGRS(const QGeoCoordinate &coord)
 {
     std::string mgrs;
@@ -45,6 +45,49 @@ void convertGeoToNed(const QGeoCoordinate &coord, const QGeoCoordinate &origin,
  */
 void convertNedToGeo(double x, double y, double z, const QGeoCoordinate &origin, QGeoCoordinate &coord);
 
+/**
+ * @brief Batch version of convertGeoToNed over structure of arrays buffers, see NedOrigin.
+ * @param[in] altitudes May be nullptr together with z, only x and y are computed then.
+ */
+void convertGeoToNed(const double *latitudes, const double *longitudes, const double *altitudes, const QGeoCoordinate &origin, double *x, double *y, double *z, qsizetype count);
+
+/**
+ * @brief Batch version of convertNedToGeo over structure of arrays buffers, see NedOrigin.
+ * @param[in] z May be nullptr together with altitudes, only latitudes and longitudes are computed then.
+ */
+void convertNedToGeo(const double *x, const double *y, const double *z, const QGeoCoordinate &origin, double *latitudes, double *longitudes, double *altitudes, qsizetype count);
+
+/**
+ * @brief Local tangential plane origin with its trigonometry precomputed, for converting many
+ * coordinates around the same origin. The batch conversions work on structure of arrays buffers
+ * (degrees and meters) with branch free loops the compiler can vectorize.
+ */
+class NedOrigin
+{
+public:
+    explicit NedOrigin(const QGeoCoordinate &origin);
+
+    const QGeoCoordinate &origin() const { return _origin; }
+
+    /// Same as the free convertGeoToNed with this origin
+    void convertGeoToNed(const QGeoCoordinate &coord, double &x, double &y, double &z) const;
+    /// Same as the free convertNedToGeo with this origin
+    void convertNedToGeo(double x, double y, double z, QGeoCoordinate &coord) const;
+
+    /// altitudes and z may both be nullptr
+    void convertGeoToNed(const double *latitudes, const double *longitudes, const double *altitudes, double *x, double *y, double *z, qsizetype count) const;
+    /// z and altitudes may both be nullptr
+    void convertNedToGeo(const double *x, const double *y, const double *z, double *latitudes, double *longitudes, double *altitudes, qsizetype count) const;
+
+private:
+    QGeoCoordinate _origin;
+    double _latRad = 0;
+    double _lonRad = 0;
+    double _sinLat = 0;
+    double _cosLat = 1;
+    double _altitude = 0;
+};
+
 // LatLonToUTMXY
 // Converts a latitude/longitude pair to x and y coordinates in the
 // Universal Transverse Mercator projection.
@@ -86,6 +129,19 @@ int convertGeoToUTM(const QGeoCoordinate& coord, double &easting, double &northi
 // The function returns true if conversion succeeded.
 bool convertUTMToGeo(double easting, double northing, int zone, bool southhemi, QGeoCoordinate &coord);
 
+// Batch version of convertGeoToUTM. All points are projected into the zone and hemisphere of the
+// first point, so that they share one grid even when they straddle a zone boundary or the equator.
+//
+// Returns:
+//   The UTM zone used for all points, 0 if conversion failed
+int convertGeoToUTM(const double *latitudes, const double *longitudes, double *eastings, double *northings, qsizetype count);
+
+// Batch version of convertUTMToGeo, latitudes and longitudes are in degrees.
+//
+// Returns:
+// The function returns true if conversion succeeded for all points.
+bool convertUTMToGeo(const double *eastings, const double *northings, int zone, bool southhemi, double *latitudes, double *longitudes, qsizetype count);
+
 // Converts a latitude/longitude pair to MGRS string
 //
 // Inputs:
@@ -59,6 +59,13 @@ void ComplexMissionItem::savePreset(const QString& name)
     qgcApp()->showAppMessage(tr("This Pattern does not support Presets."));
 }
 
+bool ComplexMissionItem::applyPreset(const QJsonObject& presetObject, QString& errorString)
+{
+    Q_UNUSED(presetObject);
+    errorString = tr("This Pattern does not support Presets.");
+    return false;
+}
+
 void ComplexMissionItem::deletePreset(const QString& name)
 {
     if (QGCCorePlugin::instance()->options()->surveyBuiltInPresetNames().contains(name)) {
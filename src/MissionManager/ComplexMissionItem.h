@@ -74,6 +74,12 @@ public:
 
     Q_INVOKABLE void deletePreset(const QString& name);
 
+    /// Applies preset settings to the complex item. The shape of the item is not part of a preset.
+    ///     @param presetObject Preset json object as saved by savePreset
+    ///     @param[out] errorString Error if the preset could not be applied
+    /// @return true: preset applied, false: preset not supported or invalid, errorString set
+    virtual bool applyPreset(const QJsonObject& presetObject, QString& errorString);
+
 
     /// Get the point of complex mission item furthest away from a coordinate
     ///     @param other QGeoCoordinate to which distance is calculated
@@ -86,10 +86,16 @@ void CorridorScanComplexItem::loadPreset(const QString& name)
     QString errorString;
 
     QJsonObject presetObject = _loadPresetJson(name);
-    if (!_loadWorker(presetObject, 0, errorString, true /* forPresets */)) {
+    if (!applyPreset(presetObject, errorString)) {
         qgcApp()->showAppMessage(QStringLiteral("Internal Error: Preset load failed. Name: %1 Error: %2").arg(name).arg(errorString));
     }
+}
+
+bool CorridorScanComplexItem::applyPreset(const QJsonObject& presetObject, QString& errorString)
+{
+    const bool success = _loadWorker(presetObject, 0, errorString, true /* forPresets */);
     _rebuildTransects();
+    return success;
 }
 
 bool CorridorScanComplexItem::_loadWorker(const QJsonObject& complexObject, int sequenceNumber, QString& errorString, bool forPresets)
@@ -102,7 +108,7 @@ bool CorridorScanComplexItem::_loadWorker(const QJsonObject& complexObject, int
         { ComplexMissionItem::jsonComplexItemTypeKey,   QJsonValue::String, true },
         { corridorWidthName,                            QJsonValue::Double, true },
         { _jsonEntryPointKey,                           QJsonValue::Double, true },
-        { QGCMapPolyline::jsonPolylineKey,              QJsonValue::Array,  true },
+        { QGCMapPolyline::jsonPolylineKey,              QJsonValue::Array,  !forPresets },
     };
     if (!JsonHelper::validateKeys(complexObject, keyInfoList, errorString)) {
         _ignoreRecalc = false;
@@ -129,9 +135,9 @@ bool CorridorScanComplexItem::_loadWorker(const QJsonObject& complexObject, int
             _ignoreRecalc = false;
             return false;
         }
-    }
 
-    setSequenceNumber(sequenceNumber);
+        setSequenceNumber(sequenceNumber);
+    }
 
     if (!_load(complexObject, forPresets, errorString)) {
         _ignoreRecalc = false;
@@ -46,6 +46,7 @@ public:
     QString presetsSettingsGroup(void) { return settingsGroup; }
     void    savePreset          (const QString& name);
     void    loadPreset          (const QString& name);
+    bool    applyPreset         (const QJsonObject& presetObject, QString& errorString) final;
 
     // Overrides from VisualMissionionItem
     QString             commandDescription  (void) const final { return tr("Corridor Scan"); }
@@ -19,8 +19,12 @@
 #include "SettingsManager.h"
 #include "AppSettings.h"
 #include "GeoFenceManager.h"
+#include "MissionController.h"
 #include "QGCFenceCircle.h"
 #include "QGCFencePolygon.h"
+#include "RallyPoint.h"
+#include "RallyPointController.h"
+#include "VisualMissionItem.h"
 #include "QGCLoggingCategory.h"
 
 #include <QtCore/QJsonArray>
@@ -46,11 +50,17 @@ GeoFenceController::GeoFenceController(PlanMasterController* masterController, Q
 
     connect(&_polygons, &QmlObjectListModel::countChanged, this, &GeoFenceController::_updateContainsItems);
     connect(&_circles,  &QmlObjectListModel::countChanged, this, &GeoFenceController::_updateContainsItems);
+    connect(&_polygons, &QmlObjectListModel::countChanged, this, &GeoFenceController::_fenceItemsChanged);
+    connect(&_circles,  &QmlObjectListModel::countChanged, this, &GeoFenceController::_fenceItemsChanged);
 
     connect(this,                       &GeoFenceController::breachReturnPointChanged,  this, &GeoFenceController::_setDirty);
     connect(&_breachReturnAltitudeFact, &Fact::rawValueChanged,                         this, &GeoFenceController::_setDirty);
     connect(&_polygons,                 &QmlObjectListModel::dirtyChanged,              this, &GeoFenceController::_setDirty);
     connect(&_circles,                  &QmlObjectListModel::dirtyChanged,              this, &GeoFenceController::_setDirty);
+
+    _vehicleBreachTimer.setSingleShot(true);
+    _vehicleBreachTimer.setInterval(0);
+    connect(&_vehicleBreachTimer, &QTimer::timeout, this, &GeoFenceController::_updateVehicleBreach);
 }
 
 GeoFenceController::~GeoFenceController()
@@ -94,6 +104,7 @@ void GeoFenceController::_managerVehicleChanged(Vehicle* managerVehicle)
     }
 
     _managerVehicle = managerVehicle;
+    _vehicleBreachTimer.start();
     if (!_managerVehicle) {
         qWarning() << "GeoFenceController::managerVehicleChanged managerVehicle=nullptr";
         return;
@@ -112,6 +123,8 @@ void GeoFenceController::_managerVehicleChanged(Vehicle* managerVehicle)
     connect(_managerVehicle->parameterManager(), &ParameterManager::parametersReadyChanged, this, &GeoFenceController::_parametersReady);
     _parametersReady();
 
+    connect(_managerVehicle,  &Vehicle::coordinateChanged,                      this, &GeoFenceController::_updateVehicleBreach);
+
     emit supportedChanged(supported());
 }
 
@@ -590,6 +603,120 @@ bool GeoFenceController::isEmpty(void) const
 
 }
 
+void GeoFenceController::_fenceItemsChanged(void)
+{
+    _invalidateGeoFenceIndex();
+
+    // Edits to the individual fences invalidate the index as well
+    for (int i=0; i<_polygons.count(); i++) {
+        QGCFencePolygon* polygon = _polygons.value<QGCFencePolygon*>(i);
+        connect(polygon, &QGCFencePolygon::verticesChanged,     this, &GeoFenceController::_invalidateGeoFenceIndex, Qt::UniqueConnection);
+        connect(polygon, &QGCFencePolygon::inclusionChanged,    this, &GeoFenceController::_invalidateGeoFenceIndex, Qt::UniqueConnection);
+    }
+    for (int i=0; i<_circles.count(); i++) {
+        QGCFenceCircle* circle = _circles.value<QGCFenceCircle*>(i);
+        connect(circle,             &QGCFenceCircle::centerChanged,     this, &GeoFenceController::_invalidateGeoFenceIndex, Qt::UniqueConnection);
+        connect(circle,             &QGCFenceCircle::inclusionChanged,  this, &GeoFenceController::_invalidateGeoFenceIndex, Qt::UniqueConnection);
+        connect(circle->radius(),   &Fact::rawValueChanged,             this, &GeoFenceController::_invalidateGeoFenceIndex, Qt::UniqueConnection);
+    }
+}
+
+void GeoFenceController::_invalidateGeoFenceIndex(void)
+{
+    _geoFenceIndexValid = false;
+    _geoFenceIndex.clear();
+    _vehicleBreachTimer.start();
+}
+
+void GeoFenceController::_updateVehicleBreach(void)
+{
+    bool vehicleBreachesFence = false;
+    if (_flyView && _managerVehicle && _managerVehicle->coordinate().isValid() && containsItems()) {
+        vehicleBreachesFence = breachesFence(_managerVehicle->coordinate());
+    }
+
+    if (vehicleBreachesFence != _vehicleBreachesFence) {
+        _vehicleBreachesFence = vehicleBreachesFence;
+        emit vehicleBreachesFenceChanged(_vehicleBreachesFence);
+    }
+}
+
+QList<GeoFenceIndex::FenceStatus_t> GeoFenceController::classifyCoordinates(const QList<QGeoCoordinate>& coordinates)
+{
+    if (!_geoFenceIndexValid) {
+        QList<const QGCFencePolygon*> polygons;
+        for (int i=0; i<_polygons.count(); i++) {
+            polygons.append(_polygons.value<QGCFencePolygon*>(i));
+        }
+        QList<QGCFenceCircle*> circles;
+        for (int i=0; i<_circles.count(); i++) {
+            circles.append(_circles.value<QGCFenceCircle*>(i));
+        }
+        _geoFenceIndex.build(polygons, circles);
+        _geoFenceIndexValid = true;
+    }
+
+    return _geoFenceIndex.classify(coordinates);
+}
+
+bool GeoFenceController::breachesFence(const QGeoCoordinate& coordinate)
+{
+    return classifyCoordinates({ coordinate }).first() != GeoFenceIndex::FenceStatusInside;
+}
+
+QList<int> GeoFenceController::_indicesBreachingFence(const QList<QGeoCoordinate>& coordinates, const QList<int>& coordinateOwners)
+{
+    QList<int> indices;
+
+    const QList<GeoFenceIndex::FenceStatus_t> statuses = classifyCoordinates(coordinates);
+    for (int i=0; i<statuses.count(); i++) {
+        if (statuses[i] != GeoFenceIndex::FenceStatusInside && (indices.isEmpty() || indices.last() != coordinateOwners[i])) {
+            indices.append(coordinateOwners[i]);
+        }
+    }
+
+    return indices;
+}
+
+QList<int> GeoFenceController::missionItemsBreachingFence(void)
+{
+    QList<QGeoCoordinate> coordinates;
+    QList<int> itemIndices;
+
+    QmlObjectListModel* visualItems = _masterController->missionController()->visualItems();
+    if (!visualItems) {
+        return QList<int>();
+    }
+    for (int i=0; i<visualItems->count(); i++) {
+        const VisualMissionItem* item = visualItems->value<VisualMissionItem*>(i);
+        if (!item->specifiesCoordinate() || item->isStandaloneCoordinate() || !item->coordinate().isValid()) {
+            continue;
+        }
+        coordinates.append(item->coordinate());
+        itemIndices.append(i);
+        if (!item->exitCoordinateSameAsEntry()) {
+            coordinates.append(item->exitCoordinate());
+            itemIndices.append(i);
+        }
+    }
+
+    return _indicesBreachingFence(coordinates, itemIndices);
+}
+
+QList<int> GeoFenceController::rallyPointsBreachingFence(void)
+{
+    QList<QGeoCoordinate> coordinates;
+    QList<int> pointIndices;
+
+    QmlObjectListModel* points = _masterController->rallyPointController()->points();
+    for (int i=0; i<points->count(); i++) {
+        coordinates.append(points->value<RallyPoint*>(i)->coordinate());
+        pointIndices.append(i);
+    }
+
+    return _indicesBreachingFence(coordinates, pointIndices);
+}
+
 #ifdef QGC_UTM_ADAPTER
 void GeoFenceController::loadFlightPlanData()
 {
@@ -10,10 +10,12 @@
 #pragma once
 
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QTimer>
 #include <QtPositioning/QGeoCoordinate>
 
 #include "PlanElementController.h"
 #include "QmlObjectListModel.h"
+#include "GeoFenceIndex.h"
 #include "Fact.h"
 
 Q_DECLARE_LOGGING_CATEGORY(GeoFenceControllerLog)
@@ -41,6 +43,9 @@ public:
     // Radius of the "paramCircularFence" which is called the "Geofence Failsafe" in PX4 and the "Circular Geofence" on ArduPilot
     Q_PROPERTY(double               paramCircularFence      READ paramCircularFence                                 NOTIFY paramCircularFenceChanged)
 
+    /// Fly view only: true when the vehicle position is outside of the fence
+    Q_PROPERTY(bool                 vehicleBreachesFence    READ vehicleBreachesFence                               NOTIFY vehicleBreachesFenceChanged)
+
     /// Add a new inclusion polygon to the fence
     ///     @param topLeft: Top left coordinate or map viewport
     ///     @param bottomRight: Bottom right left coordinate or map viewport
@@ -62,6 +67,18 @@ public:
     /// Clears the interactive bit from all fence items
     Q_INVOKABLE void clearAllInteractive(void);
 
+    /// @return true: Coordinate is outside of the fence
+    Q_INVOKABLE bool breachesFence(const QGeoCoordinate& coordinate);
+
+    /// @return Indices into the mission visual items of the items whose entry or exit is outside of the fence
+    Q_INVOKABLE QList<int> missionItemsBreachingFence(void);
+
+    /// @return Indices of the rally points which are outside of the fence
+    Q_INVOKABLE QList<int> rallyPointsBreachingFence(void);
+
+    /// Classifies many coordinates at once against the inclusion and exclusion fences
+    QList<GeoFenceIndex::FenceStatus_t> classifyCoordinates(const QList<QGeoCoordinate>& coordinates);
+
 #ifdef QGC_UTM_ADAPTER
     Q_INVOKABLE void loadFlightPlanData(void);
 #endif
@@ -84,6 +101,7 @@ public:
     bool containsItems              (void) const final;
     bool showPlanFromManagerVehicle (void) final;
 
+    bool                vehicleBreachesFence    (void) const { return _vehicleBreachesFence; }
     QmlObjectListModel* polygons                (void) { return &_polygons; }
     QmlObjectListModel* circles                 (void) { return &_circles; }
     QGeoCoordinate      breachReturnPoint       (void) const { return _breachReturnPoint; }
@@ -96,6 +114,7 @@ signals:
     void editorQmlChanged               (QString editorQml);
     void loadComplete                   (void);
     void paramCircularFenceChanged      (void);
+    void vehicleBreachesFenceChanged    (bool vehicleBreachesFence);
 
 #ifdef QGC_UTM_ADAPTER
     void uploadFlagSent         (bool flag);
@@ -113,9 +132,13 @@ private slots:
     void _managerRemoveAllComplete  (bool error);
     void _parametersReady           (void);
     void _managerVehicleChanged      (Vehicle* managerVehicle);
+    void _fenceItemsChanged         (void);
+    void _invalidateGeoFenceIndex   (void);
+    void _updateVehicleBreach       (void);
 
 private:
-    void _init(void);
+    void        _init                   (void);
+    QList<int>  _indicesBreachingFence  (const QList<QGeoCoordinate>& coordinates, const QList<int>& coordinateOwners);
 
     Vehicle*            _managerVehicle =               nullptr;
     GeoFenceManager*    _geoFenceManager =              nullptr;
@@ -126,6 +149,10 @@ private:
     Fact                _breachReturnAltitudeFact;
     double              _breachReturnDefaultAltitude =  qQNaN();
     bool                _itemsRequested =               false;
+    GeoFenceIndex       _geoFenceIndex;
+    bool                _geoFenceIndexValid =           false;  ///< Rebuilt on first use after a fence changed
+    bool                _vehicleBreachesFence =         false;
+    QTimer              _vehicleBreachTimer;                    ///< Coalesces breach updates while a fence is loaded or edited
 
     Fact*               _px4ParamCircularFenceFact =        nullptr;
     Fact*               _apmParamCircularFenceRadiusFact =  nullptr;
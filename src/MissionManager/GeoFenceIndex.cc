@@ -0,0 +1,174 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "GeoFenceIndex.h"
+#include "QGCFenceCircle.h"
+#include "QGCFencePolygon.h"
+
+#include <QtCore/QtMath>
+
+void GeoFenceIndex::clear(void)
+{
+    _fences.clear();
+    _cells.clear();
+    _gridBounds = QRectF();
+    _columns = 0;
+    _rows = 0;
+    _hasInclusion = false;
+}
+
+void GeoFenceIndex::build(const QList<const QGCFencePolygon*>& polygons, const QList<QGCFenceCircle*>& circles)
+{
+    clear();
+
+    const auto grow = [](const QRectF& bounds) {
+        const double marginX = qMax(bounds.width() * _boundsMargin, 1e-7);
+        const double marginY = qMax(bounds.height() * _boundsMargin, 1e-7);
+        return bounds.adjusted(-marginX, -marginY, marginX, marginY);
+    };
+
+    for (const QGCFencePolygon* polygon: polygons) {
+        if (!polygon->isValid()) {
+            continue;
+        }
+
+        const QList<QGeoCoordinate> vertices = polygon->coordinateList();
+        double west = vertices.first().longitude();
+        double east = west;
+        double south = vertices.first().latitude();
+        double north = south;
+        for (const QGeoCoordinate& vertex: vertices) {
+            west = qMin(west, vertex.longitude());
+            east = qMax(east, vertex.longitude());
+            south = qMin(south, vertex.latitude());
+            north = qMax(north, vertex.latitude());
+        }
+
+        _fences.append({ grow(QRectF(west, south, east - west, north - south)), polygon->inclusion(), polygon, QGeoCoordinate(), 0 });
+    }
+
+    for (QGCFenceCircle* circle: circles) {
+        const QGeoCoordinate center = circle->center();
+        const double radius = circle->radius()->rawValue().toDouble();
+        if (!center.isValid() || radius <= 0) {
+            continue;
+        }
+
+        // Approximate meters per degree, the margin covers the difference
+        const double halfHeight = radius / 111320.0;
+        const double halfWidth = halfHeight / qMax(qCos(qDegreesToRadians(center.latitude())), 0.01);
+        const QRectF bounds(center.longitude() - halfWidth, center.latitude() - halfHeight, 2 * halfWidth, 2 * halfHeight);
+
+        _fences.append({ grow(bounds), circle->inclusion(), nullptr, center, radius });
+    }
+
+    if (_fences.isEmpty()) {
+        return;
+    }
+
+    for (const Fence_t& fence: _fences) {
+        _gridBounds = _gridBounds.isNull() ? fence.bounds : _gridBounds.united(fence.bounds);
+        _hasInclusion |= fence.inclusion;
+    }
+
+    // Around a few fences per cell for evenly spread fences
+    _columns = _rows = qBound(1, qCeil(qSqrt(_fences.count())) * 2, _maxCellsPerAxis);
+    _cells.resize(_columns * _rows);
+
+    const double cellWidth = _gridBounds.width() / _columns;
+    const double cellHeight = _gridBounds.height() / _rows;
+    for (int fenceIndex=0; fenceIndex<_fences.count(); fenceIndex++) {
+        const QRectF& bounds = _fences[fenceIndex].bounds;
+        const int firstColumn = qBound(0, static_cast<int>((bounds.left() - _gridBounds.left()) / cellWidth), _columns - 1);
+        const int lastColumn = qBound(0, static_cast<int>((bounds.right() - _gridBounds.left()) / cellWidth), _columns - 1);
+        const int firstRow = qBound(0, static_cast<int>((bounds.top() - _gridBounds.top()) / cellHeight), _rows - 1);
+        const int lastRow = qBound(0, static_cast<int>((bounds.bottom() - _gridBounds.top()) / cellHeight), _rows - 1);
+
+        for (int row=firstRow; row<=lastRow; row++) {
+            for (int column=firstColumn; column<=lastColumn; column++) {
+                _cells[(row * _columns) + column].append(fenceIndex);
+            }
+        }
+    }
+}
+
+int GeoFenceIndex::_cellIndex(const QGeoCoordinate& coordinate) const
+{
+    const QPointF point(coordinate.longitude(), coordinate.latitude());
+    if (_cells.isEmpty() || !_gridBounds.contains(point)) {
+        return -1;
+    }
+
+    const int column = qMin(static_cast<int>((point.x() - _gridBounds.left()) / (_gridBounds.width() / _columns)), _columns - 1);
+    const int row = qMin(static_cast<int>((point.y() - _gridBounds.top()) / (_gridBounds.height() / _rows)), _rows - 1);
+    return (row * _columns) + column;
+}
+
+GeoFenceIndex::FenceStatus_t GeoFenceIndex::classify(const QGeoCoordinate& coordinate) const
+{
+    return classify(QList<QGeoCoordinate>({ coordinate })).first();
+}
+
+QList<GeoFenceIndex::FenceStatus_t> GeoFenceIndex::classify(const QList<QGeoCoordinate>& coordinates) const
+{
+    const qsizetype count = coordinates.count();
+    QList<bool> insideInclusion(count, false);
+    QList<bool> insideExclusion(count, false);
+
+    // Gather the coordinates to test per fence so each polygon projects all of its candidates in one go
+    QList<QList<qsizetype>> candidates(_fences.count());
+    for (qsizetype i=0; i<count; i++) {
+        const int cellIndex = _cellIndex(coordinates[i]);
+        if (cellIndex < 0) {
+            continue;
+        }
+        const QPointF point(coordinates[i].longitude(), coordinates[i].latitude());
+        for (const int fenceIndex: _cells[cellIndex]) {
+            if (_fences[fenceIndex].bounds.contains(point)) {
+                candidates[fenceIndex].append(i);
+            }
+        }
+    }
+
+    for (int fenceIndex=0; fenceIndex<_fences.count(); fenceIndex++) {
+        const Fence_t& fence = _fences[fenceIndex];
+        const QList<qsizetype>& fenceCandidates = candidates[fenceIndex];
+        if (fenceCandidates.isEmpty()) {
+            continue;
+        }
+
+        QList<bool>& inside = fence.inclusion ? insideInclusion : insideExclusion;
+        if (fence.polygon) {
+            QList<QGeoCoordinate> candidateCoordinates;
+            candidateCoordinates.reserve(fenceCandidates.count());
+            for (const qsizetype i: fenceCandidates) {
+                candidateCoordinates.append(coordinates[i]);
+            }
+            const QList<bool> contains = fence.polygon->containsCoordinates(candidateCoordinates);
+            for (qsizetype j=0; j<fenceCandidates.count(); j++) {
+                inside[fenceCandidates[j]] |= contains[j];
+            }
+        } else {
+            for (const qsizetype i: fenceCandidates) {
+                inside[i] |= fence.center.distanceTo(coordinates[i]) <= fence.radius;
+            }
+        }
+    }
+
+    QList<FenceStatus_t> statuses(count, FenceStatusInside);
+    for (qsizetype i=0; i<count; i++) {
+        if (insideExclusion[i]) {
+            statuses[i] = FenceStatusInsideExclusion;
+        } else if (_hasInclusion && !insideInclusion[i]) {
+            statuses[i] = FenceStatusOutsideInclusion;
+        }
+    }
+
+    return statuses;
+}
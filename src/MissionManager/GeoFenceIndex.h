@@ -0,0 +1,61 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QList>
+#include <QtCore/QRectF>
+#include <QtPositioning/QGeoCoordinate>
+
+class QGCFenceCircle;
+class QGCFencePolygon;
+
+/// Spatial index over the polygons and circles of a fence. Fences are bucketed into a uniform latitude/longitude grid
+/// by their bounding boxes, so a coordinate is only tested against the few fences around it. Polygons are tested
+/// through QGCMapPolygon which caches their projection.
+///
+/// The index holds on to the polygons, it must be rebuilt when the fence changes.
+class GeoFenceIndex
+{
+public:
+    typedef enum {
+        FenceStatusInside,              ///< Within an inclusion fence (or there are none) and outside all exclusion fences
+        FenceStatusOutsideInclusion,    ///< Outside of all inclusion fences
+        FenceStatusInsideExclusion,     ///< Within an exclusion fence
+    } FenceStatus_t;
+
+    void build(const QList<const QGCFencePolygon*>& polygons, const QList<QGCFenceCircle*>& circles);
+    void clear(void);
+
+    bool isEmpty(void) const { return _fences.isEmpty(); }
+
+    FenceStatus_t           classify(const QGeoCoordinate& coordinate) const;
+    QList<FenceStatus_t>    classify(const QList<QGeoCoordinate>& coordinates) const;
+
+private:
+    typedef struct {
+        QRectF                  bounds;     ///< x: longitude, y: latitude
+        bool                    inclusion;
+        const QGCFencePolygon*  polygon;    ///< nullptr for circles
+        QGeoCoordinate          center;
+        double                  radius;
+    } Fence_t;
+
+    int _cellIndex(const QGeoCoordinate& coordinate) const;
+
+    QList<Fence_t>      _fences;
+    QList<QList<int>>   _cells;             ///< Indices into _fences of the fences overlapping each cell
+    QRectF              _gridBounds;
+    int                 _columns =          0;
+    int                 _rows =             0;
+    bool                _hasInclusion =     false;
+
+    static constexpr int    _maxCellsPerAxis =  256;
+    static constexpr double _boundsMargin =     0.01;   ///< Fraction the bounds are grown by, projected polygon edges may bulge past their vertices
+};
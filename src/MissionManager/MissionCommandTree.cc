@@ -15,6 +15,7 @@
 #include "QGCLoggingCategory.h"
 #include "Vehicle.h"
 
+#include <QtCore/QElapsedTimer>
 #include <QtCore/qapplicationstatic.h>
 #include <QtQml/QtQml>
 
@@ -30,22 +31,21 @@ MissionCommandTree::MissionCommandTree(bool unitTest, QObject *parent)
     (void) qmlRegisterUncreatableType<MissionCommandTree>("QGroundControl", 1, 0, "MissionCommandTree", "Reference only");
 
     if (unitTest) {
-        // Load unit testing tree
-        _staticCommandTree[MAV_AUTOPILOT_GENERIC][QGCMAVLink::VehicleClassGeneric] = new MissionCommandList(":/unittest/UT-MavCmdInfoCommon.json", true, this);
-        _staticCommandTree[MAV_AUTOPILOT_GENERIC][QGCMAVLink::VehicleClassFixedWing] = new MissionCommandList(":/unittest/UT-MavCmdInfoFixedWing.json", false, this);
-        _staticCommandTree[MAV_AUTOPILOT_GENERIC][QGCMAVLink::VehicleClassMultiRotor] = new MissionCommandList(":/unittest/UT-MavCmdInfoMultiRotor.json", false, this);
-        _staticCommandTree[MAV_AUTOPILOT_GENERIC][QGCMAVLink::VehicleClassVTOL] = new MissionCommandList(":/unittest/UT-MavCmdInfoVTOL.json", false, this);
-        _staticCommandTree[MAV_AUTOPILOT_GENERIC][QGCMAVLink::VehicleClassSub] = new MissionCommandList(":/unittest/UT-MavCmdInfoSub.json", false, this);
-        _staticCommandTree[MAV_AUTOPILOT_GENERIC][QGCMAVLink::VehicleClassRoverBoat] = new MissionCommandList(":/unittest/UT-MavCmdInfoRover.json", false, this);
+        // Unit testing tree
+        _staticCommandFiles[MAV_AUTOPILOT_GENERIC][QGCMAVLink::VehicleClassGeneric] = QStringLiteral(":/unittest/UT-MavCmdInfoCommon.json");
+        _staticCommandFiles[MAV_AUTOPILOT_GENERIC][QGCMAVLink::VehicleClassFixedWing] = QStringLiteral(":/unittest/UT-MavCmdInfoFixedWing.json");
+        _staticCommandFiles[MAV_AUTOPILOT_GENERIC][QGCMAVLink::VehicleClassMultiRotor] = QStringLiteral(":/unittest/UT-MavCmdInfoMultiRotor.json");
+        _staticCommandFiles[MAV_AUTOPILOT_GENERIC][QGCMAVLink::VehicleClassVTOL] = QStringLiteral(":/unittest/UT-MavCmdInfoVTOL.json");
+        _staticCommandFiles[MAV_AUTOPILOT_GENERIC][QGCMAVLink::VehicleClassSub] = QStringLiteral(":/unittest/UT-MavCmdInfoSub.json");
+        _staticCommandFiles[MAV_AUTOPILOT_GENERIC][QGCMAVLink::VehicleClassRoverBoat] = QStringLiteral(":/unittest/UT-MavCmdInfoRover.json");
     } else {
-        // Load all levels of hierarchy
+        // All levels of hierarchy
         for (const QGCMAVLink::FirmwareClass_t firmwareClass: FirmwarePluginManager::instance()->supportedFirmwareClasses()) {
             const FirmwarePlugin *const plugin = FirmwarePluginManager::instance()->firmwarePluginForAutopilot(QGCMAVLink::firmwareClassToAutopilot(firmwareClass), MAV_TYPE_QUADROTOR);
             for (const QGCMAVLink::VehicleClass_t vehicleClass: QGCMAVLink::allVehicleClasses()) {
                 const QString overrideFile = plugin->missionCommandOverrides(vehicleClass);
                 if (!overrideFile.isEmpty()) {
-                    const bool baseCommandList = ((firmwareClass == QGCMAVLink::FirmwareClassGeneric) && (vehicleClass == QGCMAVLink::VehicleClassGeneric));
-                    _staticCommandTree[firmwareClass][vehicleClass] = new MissionCommandList(overrideFile, baseCommandList, this);
+                    _staticCommandFiles[firmwareClass][vehicleClass] = overrideFile;
                 }
             }
         }
@@ -55,6 +55,10 @@ MissionCommandTree::MissionCommandTree(bool unitTest, QObject *parent)
 MissionCommandTree::~MissionCommandTree()
 {
     // qCDebug(MissionCommandTreeLog) << Q_FUNC_INFO << this;
+
+    for (const QMap<QGCMAVLink::VehicleClass_t, MissionCommandList*> &vehicleClassLists: std::as_const(_staticCommandTree)) {
+        qDeleteAll(vehicleClassLists);
+    }
 }
 
 MissionCommandTree *MissionCommandTree::instance()
@@ -62,7 +66,29 @@ MissionCommandTree *MissionCommandTree::instance()
     return _missionCommandTreeInstance();
 }
 
-void MissionCommandTree::_collapseHierarchy(const MissionCommandList *cmdList, QMap<MAV_CMD, MissionCommandUIInfo*> &collapsedTree) const
+MissionCommandList *MissionCommandTree::_commandList(QGCMAVLink::FirmwareClass_t firmwareClass, QGCMAVLink::VehicleClass_t vehicleClass) const
+{
+    if (_staticCommandTree.contains(firmwareClass) && _staticCommandTree[firmwareClass].contains(vehicleClass)) {
+        return _staticCommandTree[firmwareClass][vehicleClass];
+    }
+
+    MissionCommandList *commandList = nullptr;
+    const QString jsonFilename = _staticCommandFiles.value(firmwareClass).value(vehicleClass);
+    if (!jsonFilename.isEmpty()) {
+        QElapsedTimer timer;
+        timer.start();
+        const bool baseCommandList = ((firmwareClass == QGCMAVLink::FirmwareClassGeneric) && (vehicleClass == QGCMAVLink::VehicleClassGeneric));
+        commandList = new MissionCommandList(jsonFilename, baseCommandList);
+        qCDebug(MissionCommandTreeLog) << "Loaded" << jsonFilename << "commands:msecs" << commandList->commandIds().count() << timer.elapsed();
+    }
+
+    // Levels without a file are remembered as well, so the lookup is only done once
+    _staticCommandTree[firmwareClass][vehicleClass] = commandList;
+
+    return commandList;
+}
+
+void MissionCommandTree::_collapseHierarchy(const MissionCommandList *cmdList, QMap<MAV_CMD, MissionCommandUIInfo*> &collapsedTree)
 {
     if (!cmdList) {
         return;
@@ -72,9 +98,14 @@ void MissionCommandTree::_collapseHierarchy(const MissionCommandList *cmdList, Q
         MissionCommandUIInfo *const uiInfo = cmdList->getUIInfo(command);
         if (uiInfo) {
             if (collapsedTree.contains(command)) {
-                collapsedTree[command]->_overrideInfo(uiInfo);
+                // Copy on write, entries which still point into the static tree are owned by their command list
+                MissionCommandUIInfo *&collapsedInfo = collapsedTree[command];
+                if (collapsedInfo->parent() != this) {
+                    collapsedInfo = new MissionCommandUIInfo(*collapsedInfo, this);
+                }
+                collapsedInfo->_overrideInfo(uiInfo);
             } else {
-                collapsedTree[command] = new MissionCommandUIInfo(*uiInfo);
+                collapsedTree[command] = uiInfo;
             }
         }
     }
@@ -95,20 +126,20 @@ void MissionCommandTree::_buildAllCommands(Vehicle *vehicle, QGCMAVLink::Vehicle
     QMap<MAV_CMD, MissionCommandUIInfo*> &collapsedTree = _allCommands[firmwareClass][vehicleClass];
 
     // Base of the tree is all commands
-    _collapseHierarchy(_staticCommandTree[MAV_AUTOPILOT_GENERIC][QGCMAVLink::VehicleClassGeneric], collapsedTree);
+    _collapseHierarchy(_commandList(QGCMAVLink::FirmwareClassGeneric, QGCMAVLink::VehicleClassGeneric), collapsedTree);
 
     // Add the overrides for specific vehicle types
     if (vehicleClass != QGCMAVLink::VehicleClassGeneric) {
-        _collapseHierarchy(_staticCommandTree[QGCMAVLink::FirmwareClassGeneric][vehicleClass], collapsedTree);
+        _collapseHierarchy(_commandList(QGCMAVLink::FirmwareClassGeneric, vehicleClass), collapsedTree);
     }
 
     // Add the overrides for specific firmware class, all vehicles
     if (firmwareClass != QGCMAVLink::FirmwareClassGeneric) {
-        _collapseHierarchy(_staticCommandTree[firmwareClass][QGCMAVLink::VehicleClassGeneric], collapsedTree);
+        _collapseHierarchy(_commandList(firmwareClass, QGCMAVLink::VehicleClassGeneric), collapsedTree);
 
         // Add overrides for specific vehicle class
         if (vehicleClass != QGCMAVLink::VehicleClassGeneric) {
-            _collapseHierarchy(_staticCommandTree[firmwareClass][vehicleClass], collapsedTree);
+            _collapseHierarchy(_commandList(firmwareClass, vehicleClass), collapsedTree);
         }
     }
 
@@ -139,39 +170,39 @@ QStringList MissionCommandTree::_availableCategoriesForVehicle(Vehicle *vehicle)
 
 QString MissionCommandTree::friendlyName(MAV_CMD command) const
 {
-    const MissionCommandList *const commandList = _staticCommandTree[QGCMAVLink::FirmwareClassGeneric][QGCMAVLink::VehicleClassGeneric];
-    const MissionCommandUIInfo *const uiInfo = commandList->getUIInfo(command);
+    const MissionCommandList *const commandList = _commandList(QGCMAVLink::FirmwareClassGeneric, QGCMAVLink::VehicleClassGeneric);
+    const MissionCommandUIInfo *const uiInfo = commandList ? commandList->getUIInfo(command) : nullptr;
 
     return uiInfo ? uiInfo->friendlyName() : QStringLiteral("MAV_CMD(%1)").arg(static_cast<int>(command));
 }
 
 QString MissionCommandTree::rawName(MAV_CMD command) const
 {
-    const MissionCommandList *const commandList = _staticCommandTree[QGCMAVLink::FirmwareClassGeneric][QGCMAVLink::VehicleClassGeneric];
-    const MissionCommandUIInfo *const uiInfo = commandList->getUIInfo(command);
+    const MissionCommandList *const commandList = _commandList(QGCMAVLink::FirmwareClassGeneric, QGCMAVLink::VehicleClassGeneric);
+    const MissionCommandUIInfo *const uiInfo = commandList ? commandList->getUIInfo(command) : nullptr;
 
     return uiInfo ? uiInfo->rawName() : QStringLiteral("MAV_CMD(%1)").arg(static_cast<int>(command));
 }
 
 bool MissionCommandTree::isLandCommand(MAV_CMD command) const
 {
-    const MissionCommandList *const commandList = _staticCommandTree[QGCMAVLink::FirmwareClassGeneric][QGCMAVLink::VehicleClassGeneric];
-    const MissionCommandUIInfo *const uiInfo = commandList->getUIInfo(command);
+    const MissionCommandList *const commandList = _commandList(QGCMAVLink::FirmwareClassGeneric, QGCMAVLink::VehicleClassGeneric);
+    const MissionCommandUIInfo *const uiInfo = commandList ? commandList->getUIInfo(command) : nullptr;
 
     return (uiInfo && uiInfo->isLandCommand());
 }
 
 bool MissionCommandTree::isTakeoffCommand(MAV_CMD command) const
 {
-    const MissionCommandList *const commandList = _staticCommandTree[QGCMAVLink::FirmwareClassGeneric][QGCMAVLink::VehicleClassGeneric];
-    const MissionCommandUIInfo *const uiInfo = commandList->getUIInfo(command);
+    const MissionCommandList *const commandList = _commandList(QGCMAVLink::FirmwareClassGeneric, QGCMAVLink::VehicleClassGeneric);
+    const MissionCommandUIInfo *const uiInfo = commandList ? commandList->getUIInfo(command) : nullptr;
 
     return (uiInfo && uiInfo->isTakeoffCommand());
 }
 
 const QList<MAV_CMD> &MissionCommandTree::allCommandIds() const
 {
-    return _staticCommandTree[QGCMAVLink::FirmwareClassGeneric][QGCMAVLink::VehicleClassGeneric]->commandIds();
+    return _commandList(QGCMAVLink::FirmwareClassGeneric, QGCMAVLink::VehicleClassGeneric)->commandIds();
 }
 
 const MissionCommandUIInfo *MissionCommandTree::getUIInfo(Vehicle* vehicle, QGCMAVLink::VehicleClass_t vtolMode,  MAV_CMD command)
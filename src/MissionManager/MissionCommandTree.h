@@ -36,7 +36,8 @@ class Vehicle;
 ///             Known Firmware, Rover
 ///         Any Firmware, Sub
 ///             Known Firmware, Sub
-/// For known firmwares, the override files are requested from the FirmwarePlugin.
+/// For known firmwares, the override files are requested from the FirmwarePlugin. The json files of each level are only loaded when a
+/// vehicle class which needs them is first used, so startup does not pay for firmware/vehicle combinations which are never flown.
 ///
 /// When ui info is requested for a specific vehicle the static hierarchy in _staticCommandTree is collapsed into the set of available commands in
 /// _allCommands taking into account the appropriate set of overrides for the MAV_AUTOPILOT/MAV_TYPE combination associated with the vehicle.
@@ -85,17 +86,24 @@ private:
     /// Add the next level of the hierarchy to a collapsed tree.
     ///     @param cmdList          List of mission commands to collapse into ui info
     ///     @param collapsedTree    Tree we are collapsing into
-    void _collapseHierarchy(const MissionCommandList *cmdList, QMap<MAV_CMD, MissionCommandUIInfo*> &collapsedTree) const;
+    void _collapseHierarchy(const MissionCommandList *cmdList, QMap<MAV_CMD, MissionCommandUIInfo*> &collapsedTree);
+    /// Returns the command list for the level of the hierarchy, loading it on first use
+    ///     @return nullptr if there is no json file for the level
+    MissionCommandList *_commandList(QGCMAVLink::FirmwareClass_t firmwareClass, QGCMAVLink::VehicleClass_t vehicleClass) const;
     void _buildAllCommands(Vehicle *vehicle, QGCMAVLink::VehicleClass_t vtolMode);
     QStringList _availableCategoriesForVehicle(Vehicle *vehicle);
     void _firmwareAndVehicleClassInfo(Vehicle *vehicle, QGCMAVLink::VehicleClass_t vtolMode, QGCMAVLink::FirmwareClass_t &firmwareClass, QGCMAVLink::VehicleClass_t &vehicleClass) const;
 
     const QString _allCommandsCategory = tr("All commands");    ///< Category which contains all available commands
 
-    /// Full hierarchy
-    QMap<QGCMAVLink::FirmwareClass_t, QMap<QGCMAVLink::VehicleClass_t, MissionCommandList*>> _staticCommandTree;
+    /// Json file for each level of the hierarchy
+    QMap<QGCMAVLink::FirmwareClass_t, QMap<QGCMAVLink::VehicleClass_t, QString>> _staticCommandFiles;
 
-    /// Collapsed hierarchy for specific vehicle type
+    /// Full hierarchy, levels are loaded from _staticCommandFiles on first use
+    mutable QMap<QGCMAVLink::FirmwareClass_t, QMap<QGCMAVLink::VehicleClass_t, MissionCommandList*>> _staticCommandTree;
+
+    /// Collapsed hierarchy for specific vehicle type. Entries which no level overrides point into the static tree, only overridden
+    /// entries are copies owned by this object.
     QMap<QGCMAVLink::FirmwareClass_t, QMap<QGCMAVLink::VehicleClass_t, QMap<MAV_CMD, MissionCommandUIInfo*>>> _allCommands;
 
     /// Collapsed hierarchy for specific vehicle type
@@ -768,7 +768,9 @@ bool MissionController::_loadJsonMissionFileV2(const QJsonObject& json, QmlObjec
 
     // Read mission items
 
-    int nextSequenceNumber = 1; // Start with 1 since home is in 0
+    int                         nextSequenceNumber = 1; // Start with 1 since home is in 0
+    QHash<int, int>             doJumpIdToSequenceNumber;
+    QList<SimpleMissionItem*>   doJumpItems;
     const QJsonArray rgMissionItems(json[_jsonItemsKey].toArray());
     for (int i=0; i<rgMissionItems.count(); i++) {
         // Convert to QJsonObject
@@ -790,9 +792,16 @@ bool MissionController::_loadJsonMissionFileV2(const QJsonObject& json, QmlObjec
         QString itemType = itemObject[VisualMissionItem::jsonTypeKey].toString();
 
         if (itemType == VisualMissionItem::jsonTypeSimpleItemValue) {
-            SimpleMissionItem* simpleItem = new SimpleMissionItem(_masterController, _flyView, true /* forLoad */);
+            // Takeoff commands are loaded straight into a TakeoffMissionItem when the command is known up front
+            SimpleMissionItem* simpleItem;
+            const QJsonValue commandValue = itemObject[MissionItem::_jsonCommandKey];
+            if (commandValue.isDouble() && TakeoffMissionItem::isTakeoffCommand(static_cast<MAV_CMD>(commandValue.toInt()))) {
+                simpleItem = new TakeoffMissionItem(_masterController, _flyView, settingsItem, true /* forLoad */);
+            } else {
+                simpleItem = new SimpleMissionItem(_masterController, _flyView, true /* forLoad */);
+            }
             if (simpleItem->load(itemObject, nextSequenceNumber, errorString)) {
-                if (TakeoffMissionItem::isTakeoffCommand(static_cast<MAV_CMD>(simpleItem->command()))) {
+                if (!qobject_cast<TakeoffMissionItem*>(simpleItem) && TakeoffMissionItem::isTakeoffCommand(static_cast<MAV_CMD>(simpleItem->command()))) {
                     // This needs to be a TakeoffMissionItem
                     TakeoffMissionItem* takeoffItem = new TakeoffMissionItem(_masterController, _flyView, settingsItem, true /* forLoad */);
                     takeoffItem->load(itemObject, nextSequenceNumber, errorString);
@@ -802,7 +811,16 @@ bool MissionController::_loadJsonMissionFileV2(const QJsonObject& json, QmlObjec
                 qCDebug(MissionControllerLog) << "Loading simple item: nextSequenceNumber:command" << nextSequenceNumber << simpleItem->command();
                 nextSequenceNumber = simpleItem->lastSequenceNumber() + 1;
                 visualItems->append(simpleItem);
+
+                // First item with a given doJumpId wins, same as a front to back search
+                if (!doJumpIdToSequenceNumber.contains(simpleItem->missionItem().doJumpId())) {
+                    doJumpIdToSequenceNumber[simpleItem->missionItem().doJumpId()] = simpleItem->sequenceNumber();
+                }
+                if (simpleItem->command() == MAV_CMD_DO_JUMP) {
+                    doJumpItems.append(simpleItem);
+                }
             } else {
+                simpleItem->deleteLater();
                 return false;
             }
         } else if (itemType == VisualMissionItem::jsonTypeComplexItemValue) {
@@ -818,6 +836,7 @@ bool MissionController::_loadJsonMissionFileV2(const QJsonObject& json, QmlObjec
                 qCDebug(MissionControllerLog) << "Loading Survey: nextSequenceNumber" << nextSequenceNumber;
                 SurveyComplexItem* surveyItem = new SurveyComplexItem(_masterController, _flyView, QString() /* kmlFile */);
                 if (!surveyItem->load(itemObject, nextSequenceNumber++, errorString)) {
+                    surveyItem->deleteLater();
                     return false;
                 }
                 nextSequenceNumber = surveyItem->lastSequenceNumber() + 1;
@@ -827,6 +846,7 @@ bool MissionController::_loadJsonMissionFileV2(const QJsonObject& json, QmlObjec
                 qCDebug(MissionControllerLog) << "Loading Fixed Wing Landing Pattern: nextSequenceNumber" << nextSequenceNumber;
                 FixedWingLandingComplexItem* landingItem = new FixedWingLandingComplexItem(_masterController, _flyView);
                 if (!landingItem->load(itemObject, nextSequenceNumber++, errorString)) {
+                    landingItem->deleteLater();
                     return false;
                 }
                 nextSequenceNumber = landingItem->lastSequenceNumber() + 1;
@@ -836,6 +856,7 @@ bool MissionController::_loadJsonMissionFileV2(const QJsonObject& json, QmlObjec
                 qCDebug(MissionControllerLog) << "Loading VTOL Landing Pattern: nextSequenceNumber" << nextSequenceNumber;
                 VTOLLandingComplexItem* landingItem = new VTOLLandingComplexItem(_masterController, _flyView);
                 if (!landingItem->load(itemObject, nextSequenceNumber++, errorString)) {
+                    landingItem->deleteLater();
                     return false;
                 }
                 nextSequenceNumber = landingItem->lastSequenceNumber() + 1;
@@ -845,6 +866,7 @@ bool MissionController::_loadJsonMissionFileV2(const QJsonObject& json, QmlObjec
                 qCDebug(MissionControllerLog) << "Loading Structure Scan: nextSequenceNumber" << nextSequenceNumber;
                 StructureScanComplexItem* structureItem = new StructureScanComplexItem(_masterController, _flyView, QString() /* kmlFile */);
                 if (!structureItem->load(itemObject, nextSequenceNumber++, errorString)) {
+                    structureItem->deleteLater();
                     return false;
                 }
                 nextSequenceNumber = structureItem->lastSequenceNumber() + 1;
@@ -854,6 +876,7 @@ bool MissionController::_loadJsonMissionFileV2(const QJsonObject& json, QmlObjec
                 qCDebug(MissionControllerLog) << "Loading Corridor Scan: nextSequenceNumber" << nextSequenceNumber;
                 CorridorScanComplexItem* corridorItem = new CorridorScanComplexItem(_masterController, _flyView, QString() /* kmlFile */);
                 if (!corridorItem->load(itemObject, nextSequenceNumber++, errorString)) {
+                    corridorItem->deleteLater();
                     return false;
                 }
                 nextSequenceNumber = corridorItem->lastSequenceNumber() + 1;
@@ -869,28 +892,14 @@ bool MissionController::_loadJsonMissionFileV2(const QJsonObject& json, QmlObjec
     }
 
     // Fix up the DO_JUMP commands jump sequence number by finding the item with the matching doJumpId
-    for (int i=0; i<visualItems->count(); i++) {
-        if (visualItems->value<VisualMissionItem*>(i)->isSimpleItem()) {
-            SimpleMissionItem* doJumpItem = visualItems->value<SimpleMissionItem*>(i);
-            if (doJumpItem->command() == MAV_CMD_DO_JUMP) {
-                bool found = false;
-                int findDoJumpId = static_cast<int>(doJumpItem->missionItem().param1());
-                for (int j=0; j<visualItems->count(); j++) {
-                    if (visualItems->value<VisualMissionItem*>(j)->isSimpleItem()) {
-                        SimpleMissionItem* targetItem = visualItems->value<SimpleMissionItem*>(j);
-                        if (targetItem->missionItem().doJumpId() == findDoJumpId) {
-                            doJumpItem->missionItem().setParam1(targetItem->sequenceNumber());
-                            found = true;
-                            break;
-                        }
-                    }
-                }
-                if (!found) {
-                    errorString = tr("Could not find doJumpId: %1").arg(findDoJumpId);
-                    return false;
-                }
-            }
+    for (SimpleMissionItem* doJumpItem: doJumpItems) {
+        int findDoJumpId = static_cast<int>(doJumpItem->missionItem().param1());
+        auto it = doJumpIdToSequenceNumber.constFind(findDoJumpId);
+        if (it == doJumpIdToSequenceNumber.cend()) {
+            errorString = tr("Could not find doJumpId: %1").arg(findDoJumpId);
+            return false;
         }
+        doJumpItem->missionItem().setParam1(it.value());
     }
 
     return true;
@@ -959,6 +968,7 @@ bool MissionController::_loadTextMissionFile(QTextStream& stream, QmlObjectListM
                 }
                 firstItem = false;
             } else {
+                item->deleteLater();
                 errorString = tr("The mission file is corrupted.");
                 return false;
             }
@@ -981,6 +991,13 @@ bool MissionController::_loadTextMissionFile(QTextStream& stream, QmlObjectListM
     return true;
 }
 
+/// Frees the items of a failed load, the current mission is left untouched
+void MissionController::_deleteLoadedVisualItems(QmlObjectListModel* loadedVisualItems)
+{
+    loadedVisualItems->clearAndDeleteContents();
+    loadedVisualItems->deleteLater();
+}
+
 void MissionController::_initLoadedVisualItems(QmlObjectListModel* loadedVisualItems)
 {
     if (_visualItems) {
@@ -1016,6 +1033,7 @@ bool MissionController::load(const QJsonObject& json, QString& errorString)
     QmlObjectListModel* loadedVisualItems = new QmlObjectListModel(this);
 
     if (!_loadJsonMissionFileV2(json, loadedVisualItems, errorStr)) {
+        _deleteLoadedVisualItems(loadedVisualItems);
         errorString = errorMessage.arg(errorStr);
         return false;
     }
@@ -1039,6 +1057,7 @@ bool MissionController::loadJsonFile(QFile& file, QString& errorString)
     QJsonObject json = jsonDoc.object();
     QmlObjectListModel* loadedVisualItems = new QmlObjectListModel(this);
     if (!_loadItemsFromJson(json, loadedVisualItems, errorStr)) {
+        _deleteLoadedVisualItems(loadedVisualItems);
         errorString = errorMessage.arg(errorStr);
         return false;
     }
@@ -1059,6 +1078,7 @@ bool MissionController::loadTextFile(QFile& file, QString& errorString)
 
     QmlObjectListModel* loadedVisualItems = new QmlObjectListModel(this);
     if (!_loadTextMissionFile(stream, loadedVisualItems, errorStr)) {
+        _deleteLoadedVisualItems(loadedVisualItems);
         errorString = errorMessage.arg(errorStr);
         return false;
     }
@@ -1179,18 +1199,21 @@ FlightPathSegment* MissionController::_createFlightPathSegmentWorker(VisualItemP
     connect(pair.second, &VisualMissionItem::coordinateChanged,     segment,    &FlightPathSegment::setCoordinate2);
     connect(pair.second, &VisualMissionItem::amslEntryAltChanged,   segment,    &FlightPathSegment::setCoord2AMSLAlt);
 
-    connect(pair.second, &VisualMissionItem::coordinateChanged,         this,       &MissionController::_recalcMissionFlightStatusSignal, Qt::QueuedConnection);
+    // Only the items at either end of the segment need their flight status recalculated
+    VisualMissionItem* firstItem =  pair.first;
+    VisualMissionItem* secondItem = pair.second;
+    connect(pair.second, &VisualMissionItem::coordinateChanged,         segment,    [this, secondItem]() { _setFlightStatusDirty(secondItem); });
 
     connect(segment,    &FlightPathSegment::totalDistanceChanged,       this,       &MissionController::recalcTerrainProfile,             Qt::QueuedConnection);
-    connect(segment,    &FlightPathSegment::coord1AMSLAltChanged,       this,       &MissionController::_recalcMissionFlightStatusSignal, Qt::QueuedConnection);
-    connect(segment,    &FlightPathSegment::coord2AMSLAltChanged,       this,       &MissionController::_recalcMissionFlightStatusSignal, Qt::QueuedConnection);
+    connect(segment,    &FlightPathSegment::coord1AMSLAltChanged,       this,       [this, firstItem]() { _setFlightStatusDirty(firstItem); });
+    connect(segment,    &FlightPathSegment::coord2AMSLAltChanged,       this,       [this, secondItem]() { _setFlightStatusDirty(secondItem); });
     connect(segment,    &FlightPathSegment::amslTerrainHeightsChanged,  this,       &MissionController::recalcTerrainProfile,             Qt::QueuedConnection);
     connect(segment,    &FlightPathSegment::terrainCollisionChanged,    this,       &MissionController::recalcTerrainProfile,             Qt::QueuedConnection);
 
     return segment;
 }
 
-FlightPathSegment* MissionController::_addFlightPathSegment(FlightPathSegmentHashTable& prevItemPairHashTable, VisualItemPair& pair, bool mavlinkTerrainFrame)
+FlightPathSegment* MissionController::_addFlightPathSegment(FlightPathSegmentHashTable& prevItemPairHashTable, VisualItemPair& pair, bool mavlinkTerrainFrame, QObjectList& segments)
 {
     FlightPathSegment* segment = nullptr;
 
@@ -1202,7 +1225,7 @@ FlightPathSegment* MissionController::_addFlightPathSegment(FlightPathSegmentHas
         _flightPathSegmentHashTable[pair] = segment;
     }
 
-    _simpleFlightPathSegments.append(segment);
+    segments.append(segment);
 
     return segment;
 }
@@ -1256,7 +1279,9 @@ void MissionController::_recalcFlightPathSegments(void)
 
     qCDebug(MissionControllerLog) << "_recalcFlightPathSegments homePositionValid" << homePositionValid;
 
-    FlightPathSegmentHashTable oldSegmentTable = _flightPathSegmentHashTable;
+    FlightPathSegmentHashTable  oldSegmentTable = _flightPathSegmentHashTable;
+    QObjectList                 simpleFlightPathSegments;
+    QObjectList                 directionArrows;
 
     _missionContainsVTOLTakeoff = false;
     _flightPathSegmentHashTable.clear();
@@ -1266,12 +1291,7 @@ void MissionController::_recalcFlightPathSegments(void)
     // This is due to the initial implementation being buggy and incomplete with respect to correctly generating the line set.
     // So for now we leave the code for displaying them in, but none are ever added until we have time to implement the correct support.
 
-    _simpleFlightPathSegments.beginReset();
-    _directionArrows.beginReset();
     _incompleteComplexItemLines.beginReset();
-
-    _simpleFlightPathSegments.clear();
-    _directionArrows.clear();
     _incompleteComplexItemLines.clearAndDeleteContents();
 
     // Mission Settings item needs to start with no segment
@@ -1361,10 +1381,10 @@ void MissionController::_recalcFlightPathSegments(void)
                     if (!_flyView || addDirectionArrow) {
                         SimpleMissionItem* simpleItem = qobject_cast<SimpleMissionItem*>(lastFlyThroughVI);
                         bool mavlinkTerrainFrame = simpleItem ? simpleItem->missionItem().frame() == MAV_FRAME_GLOBAL_TERRAIN_ALT : false;
-                        FlightPathSegment* segment = _addFlightPathSegment(oldSegmentTable, lastSegmentVisualItemPair, mavlinkTerrainFrame);
+                        FlightPathSegment* segment = _addFlightPathSegment(oldSegmentTable, lastSegmentVisualItemPair, mavlinkTerrainFrame, simpleFlightPathSegments);
                         segment->setSpecialVisual(roiActive);
                         if (addDirectionArrow) {
-                            _directionArrows.append(segment);
+                            directionArrows.append(segment);
                         }
                         if (visualItem->isCurrentItem() && _delayedSplitSegmentUpdate) {
                             _splitSegment = segment;
@@ -1390,7 +1410,7 @@ void MissionController::_recalcFlightPathSegments(void)
         if (_flyView) {
             _waypointPath.append(QVariant::fromValue(_settingsItem->coordinate()));
         }
-        FlightPathSegment* segment = _addFlightPathSegment(oldSegmentTable, lastSegmentVisualItemPair, false /* mavlinkTerrainFrame */);
+        FlightPathSegment* segment = _addFlightPathSegment(oldSegmentTable, lastSegmentVisualItemPair, false /* mavlinkTerrainFrame */, simpleFlightPathSegments);
         segment->setSpecialVisual(roiActive);
         lastFlyThroughVI->setSimpleFlighPathSegment(segment);
     }
@@ -1421,17 +1441,19 @@ void MissionController::_recalcFlightPathSegments(void)
             _flightPathSegmentHashTable[lastSegmentVisualItemPair] = coordVector;
         }
 
-        _directionArrows.append(coordVector);
+        directionArrows.append(coordVector);
     }
 
-    _simpleFlightPathSegments.endReset();
-    _directionArrows.endReset();
+    // Segments which are reused keep their rows, so only the rows for changed segments are signalled to the views
+    (void) _simpleFlightPathSegments.replaceAll(simpleFlightPathSegments);
+    (void) _directionArrows.replaceAll(directionArrows);
     _incompleteComplexItemLines.endReset();
 
     // Anything left in the old table is an obsolete line object that can go
     qDeleteAll(oldSegmentTable);
 
-    emit _recalcMissionFlightStatusSignal();
+    // Item pairing may have changed anywhere in the mission
+    _setAllFlightStatusDirty();
 
     if (_waypointPath.count() == 0) {
         // MapPolyLine has a bug where if you change from a path which has elements to an empty path the line drawn
@@ -1508,42 +1530,153 @@ void MissionController::_addTimeDistance(bool vtolInHover, double hoverTime, dou
     }
 }
 
+/// The linear indexOf is no worse than the recalc it schedules, see _recalcMissionFlightStatus
+void MissionController::_setFlightStatusDirty(VisualMissionItem* item)
+{
+    int index = _visualItems ? _visualItems->indexOf(item) : -1;
+    if (index == -1) {
+        _setAllFlightStatusDirty();
+        return;
+    }
+
+    _flightStatusDirtyFirst =   qMin(_flightStatusDirtyFirst, index);
+    _flightStatusDirtyLast =    qMax(_flightStatusDirtyLast, index);
+    emit _recalcMissionFlightStatusSignal();
+}
+
+void MissionController::_setAllFlightStatusDirty(void)
+{
+    _flightStatusDirtyFirst =   0;
+    _flightStatusDirtyLast =    INT_MAX;
+    emit _recalcMissionFlightStatusSignal();
+}
+
+/// The walk records its state prior to each item in _flightStatusCheckpoints. A recalc restarts at the checkpoint for the first
+/// dirty item. Once past the last dirty item, if the state matches the previous walk in everything but the running totals, the
+/// remaining items would produce the same results as before. At that point the walk stops and the totals are carried through the
+/// remaining checkpoints as offsets. Battery estimates depend on absolute running totals, so those missions always walk to the end.
+/// An edit still costs O(n) in the number of items: the resume check and the offset pass over the tail visit every item, since each
+/// item publishes its own distance from start. What is saved is the per item work (geodesic distances, setMissionFlightStatus).
 void MissionController::_recalcMissionFlightStatus()
 {
     if (!_visualItems->count()) {
         return;
     }
 
-    bool                firstCoordinateItem =           true;
-    VisualMissionItem*  lastFlyThroughVI =   qobject_cast<VisualMissionItem*>(_visualItems->get(0));
+    int itemCount =     _visualItems->count();
+    int dirtyFirst =    _flightStatusDirtyFirst;
+    int dirtyLast =     _flightStatusDirtyLast;
 
-    bool homePositionValid = _settingsItem->coordinate().isValid();
+    // Items marked dirty by the walk itself are picked up by the next recalc
+    _flightStatusDirtyFirst =   INT_MAX;
+    _flightStatusDirtyLast =    -1;
 
-    qCDebug(MissionControllerLog) << "_recalcMissionFlightStatus";
+    if (dirtyFirst > dirtyLast) {
+        return;
+    }
 
-    // If home position is valid we can calculate distances between all waypoints.
-    // If home position is not valid we can only calculate distances between waypoints which are
-    // both relative altitude.
+    bool resume = dirtyFirst > 0 && _flightStatusCheckpoints.count() == itemCount + 1;
+    for (int i=0; resume && i<itemCount; i++) {
+        resume = _flightStatusCheckpoints[i].item == _visualItems->get(i);
+    }
+    int startIndex = resume ? qMin(dirtyFirst, itemCount - 1) : 0;
 
-    // No values for first item
-    lastFlyThroughVI->setAltDifference(0);
-    lastFlyThroughVI->setAzimuth(0);
-    lastFlyThroughVI->setDistance(0);
-    lastFlyThroughVI->setDistanceFromStart(0);
+    bool                firstCoordinateItem =           true;
+    VisualMissionItem*  lastFlyThroughVI =   qobject_cast<VisualMissionItem*>(_visualItems->get(0));
+    int                 lastFlyThroughIndex =           0;
 
-    _minAMSLAltitude = _maxAMSLAltitude = qQNaN();
+    bool homePositionValid = _settingsItem->coordinate().isValid();
 
-    _resetMissionFlightStatus();
+    qCDebug(MissionControllerLog) << "_recalcMissionFlightStatus startIndex:itemCount" << startIndex << itemCount;
+
+    double previousMinAMSLAltitude = _minAMSLAltitude;
+    double previousMaxAMSLAltitude = _maxAMSLAltitude;
 
     bool   linkStartToHome =            false;
     bool   foundRTL =                   false;
     double totalHorizontalDistance =    0;
 
-    for (int i=0; i<_visualItems->count(); i++) {
+    if (resume) {
+        const FlightStatusCheckpoint_t& checkpoint = _flightStatusCheckpoints[startIndex];
+
+        _missionFlightStatus =      checkpoint.status;
+        lastFlyThroughVI =          checkpoint.lastFlyThroughVI;
+        lastFlyThroughIndex =       checkpoint.lastFlyThroughIndex;
+        firstCoordinateItem =       checkpoint.firstCoordinateItem;
+        linkStartToHome =           checkpoint.linkStartToHome;
+        foundRTL =                  checkpoint.foundRTL;
+        totalHorizontalDistance =   checkpoint.totalHorizontalDistance;
+        _minAMSLAltitude =          checkpoint.minAMSLAltitude;
+        _maxAMSLAltitude =          checkpoint.maxAMSLAltitude;
+    } else {
+        // If home position is valid we can calculate distances between all waypoints.
+        // If home position is not valid we can only calculate distances between waypoints which are
+        // both relative altitude.
+
+        // No values for first item
+        lastFlyThroughVI->setAltDifference(0);
+        lastFlyThroughVI->setAzimuth(0);
+        lastFlyThroughVI->setDistance(0);
+        lastFlyThroughVI->setDistanceFromStart(0);
+
+        _minAMSLAltitude = _maxAMSLAltitude = qQNaN();
+
+        _resetMissionFlightStatus();
+
+        _flightStatusCheckpoints.resize(itemCount + 1);
+    }
+
+    auto sameValue = [](double value1, double value2) {
+        return value1 == value2 || (qIsNaN(value1) && qIsNaN(value2));
+    };
+
+    auto saveCheckpoint = [&](FlightStatusCheckpoint_t& checkpoint, VisualMissionItem* item) {
+        checkpoint.item =                       item;
+        checkpoint.status =                     _missionFlightStatus;
+        checkpoint.lastFlyThroughVI =           lastFlyThroughVI;
+        checkpoint.lastFlyThroughIndex =        lastFlyThroughIndex;
+        checkpoint.firstCoordinateItem =        firstCoordinateItem;
+        checkpoint.linkStartToHome =            linkStartToHome;
+        checkpoint.foundRTL =                   foundRTL;
+        checkpoint.totalHorizontalDistance =    totalHorizontalDistance;
+        checkpoint.minAMSLAltitude =            _minAMSLAltitude;
+        checkpoint.maxAMSLAltitude =            _maxAMSLAltitude;
+        checkpoint.itemDistanceFromStart =      qQNaN();
+        checkpoint.itemMaxTelemetryDistance =   0;
+        checkpoint.itemMinAMSLAltitude =        qQNaN();
+        checkpoint.itemMaxAMSLAltitude =        qQNaN();
+    };
+
+    // True if items from here on would produce the same results as the previous walk, apart from the running totals
+    auto inStepWithPreviousWalk = [&](const FlightStatusCheckpoint_t& checkpoint) {
+        const MissionFlightStatus_t& previous = checkpoint.status;
+        return checkpoint.lastFlyThroughVI == lastFlyThroughVI &&
+                (lastFlyThroughIndex < dirtyFirst || lastFlyThroughIndex > dirtyLast) &&
+                checkpoint.firstCoordinateItem == firstCoordinateItem &&
+                checkpoint.linkStartToHome == linkStartToHome &&
+                checkpoint.foundRTL == foundRTL &&
+                previous.vtolMode == _missionFlightStatus.vtolMode &&
+                sameValue(previous.vehicleYaw,      _missionFlightStatus.vehicleYaw) &&
+                sameValue(previous.gimbalYaw,       _missionFlightStatus.gimbalYaw) &&
+                sameValue(previous.gimbalPitch,     _missionFlightStatus.gimbalPitch) &&
+                sameValue(previous.cruiseSpeed,     _missionFlightStatus.cruiseSpeed) &&
+                sameValue(previous.hoverSpeed,      _missionFlightStatus.hoverSpeed) &&
+                sameValue(previous.vehicleSpeed,    _missionFlightStatus.vehicleSpeed);
+    };
+
+    int walkEndIndex = itemCount;
+    for (int i=startIndex; i<itemCount; i++) {
         VisualMissionItem*  item =          qobject_cast<VisualMissionItem*>(_visualItems->get(i));
         SimpleMissionItem*  simpleItem =    qobject_cast<SimpleMissionItem*>(item);
         ComplexMissionItem* complexItem =   qobject_cast<ComplexMissionItem*>(item);
 
+        FlightStatusCheckpoint_t& checkpoint = _flightStatusCheckpoints[i];
+        if (resume && i > startIndex && i > dirtyLast && _missionFlightStatus.mAhBattery == 0 && inStepWithPreviousWalk(checkpoint)) {
+            walkEndIndex = i;
+            break;
+        }
+        saveCheckpoint(checkpoint, item);
+
         if (simpleItem && simpleItem->mavCommand() == MAV_CMD_NAV_RETURN_TO_LAUNCH) {
             foundRTL = true;
         }
@@ -1609,12 +1742,15 @@ void MissionController::_recalcMissionFlightStatus()
                 // Keep track of the min/max AMSL altitude for entire mission so we can calculate altitude percentages in terrain status display
                 if (simpleItem) {
                     double amslAltitude = item->amslEntryAlt();
+                    checkpoint.itemMinAMSLAltitude = checkpoint.itemMaxAMSLAltitude = amslAltitude;
                     _minAMSLAltitude = std::fmin(_minAMSLAltitude, amslAltitude);
                     _maxAMSLAltitude = std::fmax(_maxAMSLAltitude, amslAltitude);
                 } else {
                     // Complex item
                     double complexMinAMSLAltitude = complexItem->minAMSLAltitude();
                     double complexMaxAMSLAltitude = complexItem->maxAMSLAltitude();
+                    checkpoint.itemMinAMSLAltitude = complexMinAMSLAltitude;
+                    checkpoint.itemMaxAMSLAltitude = complexMaxAMSLAltitude;
                     _minAMSLAltitude = std::fmin(_minAMSLAltitude, complexMinAMSLAltitude);
                     _maxAMSLAltitude = std::fmax(_maxAMSLAltitude, complexMaxAMSLAltitude);
                 }
@@ -1646,8 +1782,10 @@ void MissionController::_recalcMissionFlightStatus()
                         item->setAzimuth(azimuth);
                         item->setDistance(distance);
                         item->setDistanceFromStart(totalHorizontalDistance);
+                        checkpoint.itemDistanceFromStart = totalHorizontalDistance;
 
-                        _missionFlightStatus.maxTelemetryDistance = qMax(_missionFlightStatus.maxTelemetryDistance, _calcDistanceToHome(item, _settingsItem));
+                        checkpoint.itemMaxTelemetryDistance = _calcDistanceToHome(item, _settingsItem);
+                        _missionFlightStatus.maxTelemetryDistance = qMax(_missionFlightStatus.maxTelemetryDistance, checkpoint.itemMaxTelemetryDistance);
 
                         // Calculate time/distance
                         double hoverTime = distance / _missionFlightStatus.hoverSpeed;
@@ -1658,7 +1796,8 @@ void MissionController::_recalcMissionFlightStatus()
                     if (complexItem) {
                         // Add in distance/time inside complex items as well
                         double distance = complexItem->complexDistance();
-                        _missionFlightStatus.maxTelemetryDistance = qMax(_missionFlightStatus.maxTelemetryDistance, complexItem->greatestDistanceTo(complexItem->exitCoordinate()));
+                        checkpoint.itemMaxTelemetryDistance = qMax(checkpoint.itemMaxTelemetryDistance, complexItem->greatestDistanceTo(complexItem->exitCoordinate()));
+                        _missionFlightStatus.maxTelemetryDistance = qMax(_missionFlightStatus.maxTelemetryDistance, checkpoint.itemMaxTelemetryDistance);
 
                         double hoverTime = distance / _missionFlightStatus.hoverSpeed;
                         double cruiseTime = distance / _missionFlightStatus.cruiseSpeed;
@@ -1669,6 +1808,7 @@ void MissionController::_recalcMissionFlightStatus()
 
 
                     lastFlyThroughVI = item;
+                    lastFlyThroughIndex = i;
                 }
             }
         }
@@ -1717,6 +1857,56 @@ void MissionController::_recalcMissionFlightStatus()
             }
         }
     }
+
+    if (walkEndIndex == itemCount) {
+        saveCheckpoint(_flightStatusCheckpoints[itemCount], nullptr);
+    } else {
+        // The remaining items are unchanged, carry the new running totals through their checkpoints
+        const MissionFlightStatus_t& previous = _flightStatusCheckpoints[walkEndIndex].status;
+
+        double totalDistanceOffset =            _missionFlightStatus.totalDistance - previous.totalDistance;
+        double totalTimeOffset =                _missionFlightStatus.totalTime - previous.totalTime;
+        double hoverDistanceOffset =            _missionFlightStatus.hoverDistance - previous.hoverDistance;
+        double hoverTimeOffset =                _missionFlightStatus.hoverTime - previous.hoverTime;
+        double cruiseDistanceOffset =           _missionFlightStatus.cruiseDistance - previous.cruiseDistance;
+        double cruiseTimeOffset =               _missionFlightStatus.cruiseTime - previous.cruiseTime;
+        double totalHorizontalDistanceOffset =  totalHorizontalDistance - _flightStatusCheckpoints[walkEndIndex].totalHorizontalDistance;
+        double maxTelemetryDistance =           _missionFlightStatus.maxTelemetryDistance;
+
+        for (int i=walkEndIndex; i<=itemCount; i++) {
+            FlightStatusCheckpoint_t& checkpoint = _flightStatusCheckpoints[i];
+
+            checkpoint.status.totalDistance +=      totalDistanceOffset;
+            checkpoint.status.totalTime +=          totalTimeOffset;
+            checkpoint.status.hoverDistance +=      hoverDistanceOffset;
+            checkpoint.status.hoverTime +=          hoverTimeOffset;
+            checkpoint.status.cruiseDistance +=     cruiseDistanceOffset;
+            checkpoint.status.cruiseTime +=         cruiseTimeOffset;
+            checkpoint.status.maxTelemetryDistance = maxTelemetryDistance;
+            checkpoint.totalHorizontalDistance +=   totalHorizontalDistanceOffset;
+            checkpoint.minAMSLAltitude =            _minAMSLAltitude;
+            checkpoint.maxAMSLAltitude =            _maxAMSLAltitude;
+
+            if (i == itemCount) {
+                break;
+            }
+
+            if (!qIsNaN(checkpoint.itemDistanceFromStart)) {
+                checkpoint.itemDistanceFromStart += totalHorizontalDistanceOffset;
+                qobject_cast<VisualMissionItem*>(_visualItems->get(i))->setDistanceFromStart(checkpoint.itemDistanceFromStart);
+            }
+            maxTelemetryDistance =  qMax(maxTelemetryDistance, checkpoint.itemMaxTelemetryDistance);
+            _minAMSLAltitude =      std::fmin(_minAMSLAltitude, checkpoint.itemMinAMSLAltitude);
+            _maxAMSLAltitude =      std::fmax(_maxAMSLAltitude, checkpoint.itemMaxAMSLAltitude);
+        }
+
+        const FlightStatusCheckpoint_t& finalCheckpoint = _flightStatusCheckpoints[itemCount];
+        _missionFlightStatus =      finalCheckpoint.status;
+        lastFlyThroughVI =          finalCheckpoint.lastFlyThroughVI;
+        linkStartToHome =           finalCheckpoint.linkStartToHome;
+        foundRTL =                  finalCheckpoint.foundRTL;
+    }
+
     lastFlyThroughVI->setMissionVehicleYaw(_missionFlightStatus.vehicleYaw);
 
     // Add the information for the final segment back to home
@@ -1753,9 +1943,15 @@ void MissionController::_recalcMissionFlightStatus()
     emit minAMSLAltitudeChanged         (_minAMSLAltitude);
     emit maxAMSLAltitudeChanged         (_maxAMSLAltitude);
 
-    // Walk the list again calculating altitude percentages
+    // Walk the list again calculating altitude percentages. If the altitude range is unchanged only the items walked above can have changed.
+    int altPercentFirst = 0;
+    int altPercentEnd =   itemCount;
+    if (resume && sameValue(previousMinAMSLAltitude, _minAMSLAltitude) && sameValue(previousMaxAMSLAltitude, _maxAMSLAltitude)) {
+        altPercentFirst =   startIndex;
+        altPercentEnd =     walkEndIndex;
+    }
     double altRange = _maxAMSLAltitude - _minAMSLAltitude;
-    for (int i=0; i<_visualItems->count(); i++) {
+    for (int i=altPercentFirst; i<altPercentEnd; i++) {
         VisualMissionItem* item = qobject_cast<VisualMissionItem*>(_visualItems->get(i));
 
         if (item->specifiesCoordinate()) {
@@ -1939,13 +2135,13 @@ void MissionController::_initVisualItem(VisualMissionItem* visualItem)
     setDirty(false);
 
     connect(visualItem, &VisualMissionItem::specifiesCoordinateChanged,                 this, &MissionController::_recalcFlightPathSegmentsSignal,  Qt::QueuedConnection);
-    connect(visualItem, &VisualMissionItem::specifiedFlightSpeedChanged,                this, &MissionController::_recalcMissionFlightStatusSignal, Qt::QueuedConnection);
-    connect(visualItem, &VisualMissionItem::specifiedGimbalYawChanged,                  this, &MissionController::_recalcMissionFlightStatusSignal, Qt::QueuedConnection);
-    connect(visualItem, &VisualMissionItem::specifiedGimbalPitchChanged,                this, &MissionController::_recalcMissionFlightStatusSignal, Qt::QueuedConnection);
-    connect(visualItem, &VisualMissionItem::specifiedVehicleYawChanged,                 this, &MissionController::_recalcMissionFlightStatusSignal, Qt::QueuedConnection);
-    connect(visualItem, &VisualMissionItem::terrainAltitudeChanged,                     this, &MissionController::_recalcMissionFlightStatusSignal, Qt::QueuedConnection);
-    connect(visualItem, &VisualMissionItem::additionalTimeDelayChanged,                 this, &MissionController::_recalcMissionFlightStatusSignal, Qt::QueuedConnection);
-    connect(visualItem, &VisualMissionItem::currentVTOLModeChanged,                     this, &MissionController::_recalcMissionFlightStatusSignal, Qt::QueuedConnection);
+    connect(visualItem, &VisualMissionItem::specifiedFlightSpeedChanged,                this, [this, visualItem]() { _setFlightStatusDirty(visualItem); });
+    connect(visualItem, &VisualMissionItem::specifiedGimbalYawChanged,                  this, [this, visualItem]() { _setFlightStatusDirty(visualItem); });
+    connect(visualItem, &VisualMissionItem::specifiedGimbalPitchChanged,                this, [this, visualItem]() { _setFlightStatusDirty(visualItem); });
+    connect(visualItem, &VisualMissionItem::specifiedVehicleYawChanged,                 this, [this, visualItem]() { _setFlightStatusDirty(visualItem); });
+    connect(visualItem, &VisualMissionItem::terrainAltitudeChanged,                     this, [this, visualItem]() { _setFlightStatusDirty(visualItem); });
+    connect(visualItem, &VisualMissionItem::additionalTimeDelayChanged,                 this, [this, visualItem]() { _setFlightStatusDirty(visualItem); });
+    connect(visualItem, &VisualMissionItem::currentVTOLModeChanged,                     this, [this, visualItem]() { _setFlightStatusDirty(visualItem); });
     connect(visualItem, &VisualMissionItem::lastSequenceNumberChanged,                  this, &MissionController::_recalcSequence);
 
     if (visualItem->isSimpleItem()) {
@@ -1959,10 +2155,10 @@ void MissionController::_initVisualItem(VisualMissionItem* visualItem)
     } else {
         ComplexMissionItem* complexItem = qobject_cast<ComplexMissionItem*>(visualItem);
         if (complexItem) {
-            connect(complexItem, &ComplexMissionItem::complexDistanceChanged,       this, &MissionController::_recalcMissionFlightStatusSignal, Qt::QueuedConnection);
-            connect(complexItem, &ComplexMissionItem::greatestDistanceToChanged,    this, &MissionController::_recalcMissionFlightStatusSignal, Qt::QueuedConnection);
-            connect(complexItem, &ComplexMissionItem::minAMSLAltitudeChanged,       this, &MissionController::_recalcMissionFlightStatusSignal, Qt::QueuedConnection);
-            connect(complexItem, &ComplexMissionItem::maxAMSLAltitudeChanged,       this, &MissionController::_recalcMissionFlightStatusSignal, Qt::QueuedConnection);
+            connect(complexItem, &ComplexMissionItem::complexDistanceChanged,       this, [this, visualItem]() { _setFlightStatusDirty(visualItem); });
+            connect(complexItem, &ComplexMissionItem::greatestDistanceToChanged,    this, [this, visualItem]() { _setFlightStatusDirty(visualItem); });
+            connect(complexItem, &ComplexMissionItem::minAMSLAltitudeChanged,       this, [this, visualItem]() { _setFlightStatusDirty(visualItem); });
+            connect(complexItem, &ComplexMissionItem::maxAMSLAltitudeChanged,       this, [this, visualItem]() { _setFlightStatusDirty(visualItem); });
             connect(complexItem, &ComplexMissionItem::isIncompleteChanged,          this, &MissionController::_recalcFlightPathSegmentsSignal,  Qt::QueuedConnection);
         } else {
             qWarning() << "ComplexMissionItem not found";
@@ -2007,8 +2203,8 @@ void MissionController::_managerVehicleChanged(Vehicle* managerVehicle)
     connect(_missionManager, &MissionManager::lastCurrentIndexChanged,  this, &MissionController::resumeMissionIndexChanged);
     connect(_missionManager, &MissionManager::resumeMissionReady,       this, &MissionController::resumeMissionReady);
     connect(_missionManager, &MissionManager::resumeMissionUploadFail,  this, &MissionController::resumeMissionUploadFail);
-    connect(_managerVehicle, &Vehicle::defaultCruiseSpeedChanged,       this, &MissionController::_recalcMissionFlightStatusSignal, Qt::QueuedConnection);
-    connect(_managerVehicle, &Vehicle::defaultHoverSpeedChanged,        this, &MissionController::_recalcMissionFlightStatusSignal, Qt::QueuedConnection);
+    connect(_managerVehicle, &Vehicle::defaultCruiseSpeedChanged,       this, &MissionController::_setAllFlightStatusDirty);
+    connect(_managerVehicle, &Vehicle::defaultHoverSpeedChanged,        this, &MissionController::_setAllFlightStatusDirty);
     connect(_managerVehicle, &Vehicle::vehicleTypeChanged,              this, &MissionController::complexMissionItemNamesChanged);
 
     emit complexMissionItemNamesChanged();
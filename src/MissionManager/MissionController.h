@@ -13,6 +13,8 @@
 #include <QtCore/QFile>
 #include <QtCore/QLoggingCategory>
 
+#include <climits>
+
 #include "PlanElementController.h"
 #include "QmlObjectListModel.h"
 #include "QGCGeoBoundingCube.h"
@@ -349,7 +351,8 @@ private:
     void                    _updateBatteryInfo                  (int waypointIndex);
     bool                    _loadItemsFromJson                  (const QJsonObject& json, QmlObjectListModel* visualItems, QString& errorString);
     void                    _initLoadedVisualItems              (QmlObjectListModel* loadedVisualItems);
-    FlightPathSegment*      _addFlightPathSegment               (FlightPathSegmentHashTable& prevItemPairHashTable, VisualItemPair& pair, bool mavlinkTerrainFrame);
+    void                    _deleteLoadedVisualItems            (QmlObjectListModel* loadedVisualItems);
+    FlightPathSegment*      _addFlightPathSegment               (FlightPathSegmentHashTable& prevItemPairHashTable, VisualItemPair& pair, bool mavlinkTerrainFrame, QObjectList& segments);
     void                    _addTimeDistance                    (bool vtolInHover, double hoverTime, double cruiseTime, double extraTime, double distance, int seqNum);
     VisualMissionItem*      _insertSimpleMissionItemWorker      (QGeoCoordinate coordinate, MAV_CMD command, int visualItemIndex, bool makeCurrentItem);
     void                    _insertComplexMissionItemWorker     (const QGeoCoordinate& mapCenterCoordinate, ComplexMissionItem* complexItem, int visualItemIndex, bool makeCurrentItem);
@@ -358,12 +361,33 @@ private:
     FlightPathSegment*      _createFlightPathSegmentWorker      (VisualItemPair& pair, bool mavlinkTerrainFrame);
     void                    _allItemsRemoved                    (void);
     void                    _firstItemAdded                     (void);
+    void                    _setFlightStatusDirty               (VisualMissionItem* item);
+    void                    _setAllFlightStatusDirty            (void);
 
     static double           _calcDistanceToHome                 (VisualMissionItem* currentItem, VisualMissionItem* homeItem);
     static double           _normalizeLat                       (double lat);
     static double           _normalizeLon                       (double lon);
     static bool             _convertToMissionItems              (QmlObjectListModel* visualMissionItems, QList<MissionItem*>& rgMissionItems, QObject* missionItemParent);
 
+    /// State of the flight status walk prior to processing an item, plus what the item itself contributed. Used to restart
+    /// _recalcMissionFlightStatus at the first changed item and to stop it once the walk is back in step with the previous one.
+    typedef struct {
+        VisualMissionItem*      item;                       ///< Item this entry was recorded for, nullptr for the entry after the last item
+        MissionFlightStatus_t   status;
+        VisualMissionItem*      lastFlyThroughVI;
+        int                     lastFlyThroughIndex;
+        bool                    firstCoordinateItem;
+        bool                    linkStartToHome;
+        bool                    foundRTL;
+        double                  totalHorizontalDistance;
+        double                  minAMSLAltitude;
+        double                  maxAMSLAltitude;
+        double                  itemDistanceFromStart;      ///< NaN if the item has no distance from start
+        double                  itemMaxTelemetryDistance;
+        double                  itemMinAMSLAltitude;
+        double                  itemMaxAMSLAltitude;
+    } FlightStatusCheckpoint_t;
+
 private:
     Vehicle*                    _controllerVehicle =            nullptr;
     Vehicle*                    _managerVehicle =               nullptr;
@@ -402,6 +426,9 @@ private:
     double                      _minAMSLAltitude =              0;
     double                      _maxAMSLAltitude =              0;
     bool                        _missionContainsVTOLTakeoff =   false;
+    int                         _flightStatusDirtyFirst =       0;          ///< First visual item index which needs a flight status recalc
+    int                         _flightStatusDirtyLast =        INT_MAX;    ///< Last visual item index which needs a flight status recalc, first > last for none
+    QList<FlightStatusCheckpoint_t> _flightStatusCheckpoints;               ///< One per visual item plus the final state
 
     QGroundControlQmlGlobal::AltMode _globalAltMode = QGroundControlQmlGlobal::AltitudeModeRelative;
 
@@ -421,4 +448,6 @@ private:
     static constexpr const char* _jsonMavAutopilotKey =           "MAV_AUTOPILOT";
 
     static constexpr int   _missionFileVersion =            2;
+
+    friend class MissionControllerTest;
 };
@@ -0,0 +1,446 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "PlanBatchGenerator.h"
+#include "PlanMasterController.h"
+#include "MissionController.h"
+#include "SurveyComplexItem.h"
+#include "CorridorScanComplexItem.h"
+#include "StructureScanComplexItem.h"
+#include "VisualMissionItem.h"
+#include "ShapeFileHelper.h"
+#include "JsonHelper.h"
+#include "Vehicle.h"
+#include "SettingsManager.h"
+#include "PlanViewSettings.h"
+#include "QGCLoggingCategory.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QEventLoop>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QSet>
+#include <QtCore/QThread>
+#include <QtPositioning/QGeoPath>
+#include <QtPositioning/QGeoRectangle>
+
+QGC_LOGGING_CATEGORY(PlanBatchGeneratorLog, "PlanBatchGeneratorLog")
+
+PlanBatchGenerator::PlanBatchGenerator(QObject* parent)
+    : QObject           (parent)
+    , _firmwareType     (Vehicle::MAV_AUTOPILOT_TRACK)
+    , _vehicleType      (Vehicle::MAV_TYPE_TRACK)
+    , _maxPlansInFlight (qMax(1, QThread::idealThreadCount()))
+{
+    _timeoutTimer.setInterval(_timeoutCheckMsecs);
+    connect(&_timeoutTimer, &QTimer::timeout, this, &PlanBatchGenerator::_checkPlans);
+}
+
+PlanBatchGenerator::~PlanBatchGenerator()
+{
+    for (const ActivePlan_t& activePlan : _activePlans) {
+        delete activePlan.masterController;
+    }
+}
+
+void PlanBatchGenerator::setVehicleType(MAV_AUTOPILOT firmwareType, MAV_TYPE vehicleType)
+{
+    _firmwareType = firmwareType;
+    _vehicleType = vehicleType;
+}
+
+bool PlanBatchGenerator::loadJobFile(const QString& filename, QString& errorString)
+{
+    _jobs.clear();
+
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        errorString = file.errorString() + QStringLiteral(" ") + filename;
+        return false;
+    }
+
+    QJsonDocument jsonDoc;
+    if (!JsonHelper::isJsonFile(file.readAll(), jsonDoc, errorString)) {
+        return false;
+    }
+
+    const QJsonObject json = jsonDoc.object();
+    int version;
+    if (!JsonHelper::validateExternalQGCJsonFile(json, jsonFileTypeValue, _jobFileVersion, _jobFileVersion, version, errorString)) {
+        return false;
+    }
+
+    QList<JsonHelper::KeyValidateInfo> keyInfoList = {
+        { jsonFirmwareTypeKey,  QJsonValue::Double, false },
+        { jsonVehicleTypeKey,   QJsonValue::Double, false },
+        { jsonPresetsKey,       QJsonValue::Object, false },
+        { jsonJobsKey,          QJsonValue::Array,  true },
+    };
+    if (!JsonHelper::validateKeys(json, keyInfoList, errorString)) {
+        return false;
+    }
+
+    // Without a vehicle type the plans follow the offline editing settings, as in the Plan view
+    setVehicleType(static_cast<MAV_AUTOPILOT>(json[jsonFirmwareTypeKey].toInt(Vehicle::MAV_AUTOPILOT_TRACK)),
+                   static_cast<MAV_TYPE>(json[jsonVehicleTypeKey].toInt(Vehicle::MAV_TYPE_TRACK)));
+
+    const QJsonObject presetsObject = json[jsonPresetsKey].toObject();
+    const QDir jobFileDir = QFileInfo(filename).absoluteDir();
+    const QJsonArray jobsArray = json[jsonJobsKey].toArray();
+
+    QList<Job_t> jobs;
+    jobs.reserve(jobsArray.count());
+    // Plan files are named after their job, names are compared case insensitive as the output file system may be too
+    QSet<QString> jobNames;
+    for (int i=0; i<jobsArray.count(); i++) {
+        Job_t job;
+        if (!_loadJob(jobsArray[i].toObject(), presetsObject, jobFileDir, job, errorString)) {
+            errorString = tr("Job %1: %2").arg(i + 1).arg(errorString);
+            return false;
+        }
+        const QString foldedName = job.name.toCaseFolded();
+        if (jobNames.contains(foldedName)) {
+            errorString = tr("Job %1: Duplicate name '%2'").arg(i + 1).arg(job.name);
+            return false;
+        }
+        jobNames.insert(foldedName);
+        jobs.append(job);
+    }
+    _jobs = jobs;
+
+    qCDebug(PlanBatchGeneratorLog) << "loadJobFile jobs:presets" << _jobs.count() << presetsObject.count();
+
+    return true;
+}
+
+bool PlanBatchGenerator::_loadJob(const QJsonObject& jobObject, const QJsonObject& presetsObject, const QDir& jobFileDir, Job_t& job, QString& errorString)
+{
+    QList<JsonHelper::KeyValidateInfo> keyInfoList = {
+        { jsonNameKey,          QJsonValue::String, true },
+        { jsonCoordinatesKey,   QJsonValue::Array,  false },
+        { jsonShapeFileKey,     QJsonValue::String, false },
+    };
+    if (!JsonHelper::validateKeys(jobObject, keyInfoList, errorString)) {
+        return false;
+    }
+
+    job.name = jobObject[jsonNameKey].toString();
+    if (!_validateJobName(job.name, errorString)) {
+        return false;
+    }
+
+    // The preset is either the name of one from the presets object or given inline
+    const QJsonValue presetValue = jobObject[jsonPresetKey];
+    if (presetValue.isString()) {
+        if (!presetsObject.contains(presetValue.toString())) {
+            errorString = tr("Preset '%1' not found").arg(presetValue.toString());
+            return false;
+        }
+        job.preset = presetsObject[presetValue.toString()].toObject();
+    } else if (presetValue.isObject()) {
+        job.preset = presetValue.toObject();
+    } else {
+        errorString = tr("Key '%1' must be a preset name or object").arg(jsonPresetKey);
+        return false;
+    }
+
+    if (jobObject.contains(jsonCoordinatesKey)) {
+        if (!JsonHelper::loadGeoCoordinateArray(jobObject[jsonCoordinatesKey], false /* altitudeRequired */, job.coordinates, errorString)) {
+            return false;
+        }
+    } else if (jobObject.contains(jsonShapeFileKey)) {
+        job.shapeFile = jobFileDir.absoluteFilePath(jobObject[jsonShapeFileKey].toString());
+    } else {
+        errorString = tr("Either '%1' or '%2' must be specified").arg(jsonCoordinatesKey).arg(jsonShapeFileKey);
+        return false;
+    }
+
+    return true;
+}
+
+int PlanBatchGenerator::run(void)
+{
+    _results.clear();
+    _nextJobIndex = 0;
+    _plansPerSecond = 0;
+
+    if (!_outputDirectory.isEmpty() && !QDir().mkpath(_outputDirectory)) {
+        qCWarning(PlanBatchGeneratorLog) << "Unable to create output directory" << _outputDirectory;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QEventLoop eventLoop;
+    connect(this, &PlanBatchGenerator::finished, &eventLoop, &QEventLoop::quit);
+
+    _timeoutTimer.start();
+    _startPlans();
+    if (!_activePlans.isEmpty()) {
+        (void) eventLoop.exec();
+    }
+    _timeoutTimer.stop();
+
+    int failedCount = 0;
+    for (const Result_t& result : _results) {
+        if (result.planFile.isEmpty()) {
+            failedCount++;
+        }
+    }
+
+    const double seconds = timer.elapsed() / 1000.0;
+    const int savedCount = _results.count() - failedCount;
+    if (seconds > 0) {
+        _plansPerSecond = savedCount / seconds;
+    }
+
+    // Only survey transects are built off the GUI thread, corridor and structure scans are built one after the other
+    int surveyCount = 0;
+    for (const Job_t& job : _jobs) {
+        if (job.preset[ComplexMissionItem::jsonComplexItemTypeKey].toString() == SurveyComplexItem::jsonComplexItemTypeValue) {
+            surveyCount++;
+        }
+    }
+
+    qCInfo(PlanBatchGeneratorLog) << "Generated" << savedCount << "of" << _jobs.count() << "plans in" << seconds << "seconds,"
+                                  << _plansPerSecond << "plans/second." << surveyCount << "surveys built on up to" << _maxPlansInFlight << "threads,"
+                                  << (_jobs.count() - surveyCount) << "corridor and structure scans built sequentially on the GUI thread";
+
+    return failedCount;
+}
+
+void PlanBatchGenerator::_startPlans(void)
+{
+    bool planStarted = false;
+    while ((_activePlans.count() < _maxPlansInFlight) && (_nextJobIndex < _jobs.count())) {
+        const int jobIndex = _nextJobIndex++;
+        QString errorString;
+        if (_startPlan(jobIndex, errorString)) {
+            planStarted = true;
+        } else {
+            _addResult(jobIndex, QString(), errorString);
+        }
+    }
+
+    if (_activePlans.isEmpty()) {
+        emit finished();
+    } else if (planStarted) {
+        // Items which built their transects synchronously are ready right away
+        (void) QMetaObject::invokeMethod(this, &PlanBatchGenerator::_checkPlans, Qt::QueuedConnection);
+    }
+}
+
+bool PlanBatchGenerator::_startPlan(int jobIndex, QString& errorString)
+{
+    const Job_t& job = _jobs[jobIndex];
+
+    QString itemName;
+    const QString complexItemType = job.preset[ComplexMissionItem::jsonComplexItemTypeKey].toString();
+    if (complexItemType == SurveyComplexItem::jsonComplexItemTypeValue) {
+        itemName = SurveyComplexItem::name;
+    } else if (complexItemType == CorridorScanComplexItem::jsonComplexItemTypeValue) {
+        itemName = CorridorScanComplexItem::name;
+    } else if (complexItemType == StructureScanComplexItem::jsonComplexItemTypeValue) {
+        itemName = StructureScanComplexItem::name;
+    } else {
+        errorString = tr("Unsupported complex item type '%1'").arg(complexItemType);
+        return false;
+    }
+
+    const bool polyline = (itemName == CorridorScanComplexItem::name);
+    QList<QGeoCoordinate> coordinates;
+    if (!_loadShape(job, polyline, coordinates, errorString)) {
+        return false;
+    }
+
+    PlanMasterController* masterController = new PlanMasterController(_firmwareType, _vehicleType, this);
+    masterController->start();
+
+    // Inserted at the center of the shape, which is where the planned home position ends up as well
+    const QGeoCoordinate center = QGeoPath(coordinates).boundingGeoRectangle().center();
+    ComplexMissionItem* complexItem = qobject_cast<ComplexMissionItem*>(masterController->missionController()->insertComplexMissionItem(itemName, center, -1));
+    if (!complexItem) {
+        delete masterController;
+        errorString = tr("Unable to create %1").arg(itemName);
+        return false;
+    }
+
+    TransectStyleComplexItem* transectStyleItem = qobject_cast<TransectStyleComplexItem*>(complexItem);
+    if (transectStyleItem) {
+        transectStyleItem->setForceRebuildTransectsJob(true);
+    }
+
+    // The preset goes first while there is no shape yet, so the transects are only built once
+    if (!complexItem->applyPreset(job.preset, errorString)) {
+        delete masterController;
+        return false;
+    }
+
+    if (SurveyComplexItem* surveyItem = qobject_cast<SurveyComplexItem*>(complexItem)) {
+        QGCMapPolygon* polygon = surveyItem->surveyAreaPolygon();
+        polygon->beginReset();
+        polygon->clear();
+        polygon->appendVertices(coordinates);
+        polygon->endReset();
+    } else if (StructureScanComplexItem* structureItem = qobject_cast<StructureScanComplexItem*>(complexItem)) {
+        QGCMapPolygon* polygon = structureItem->structurePolygon();
+        polygon->beginReset();
+        polygon->clear();
+        polygon->appendVertices(coordinates);
+        polygon->endReset();
+    } else if (CorridorScanComplexItem* corridorItem = qobject_cast<CorridorScanComplexItem*>(complexItem)) {
+        corridorItem->corridorPolyline()->setPath(coordinates);
+    }
+
+    connect(complexItem, &VisualMissionItem::readyForSaveStateChanged, this, &PlanBatchGenerator::_checkPlans, Qt::QueuedConnection);
+    if (transectStyleItem) {
+        connect(transectStyleItem, &TransectStyleComplexItem::rebuildingTransectsChanged, this, &PlanBatchGenerator::_checkPlans, Qt::QueuedConnection);
+    }
+
+    ActivePlan_t activePlan;
+    activePlan.jobIndex = jobIndex;
+    activePlan.masterController = masterController;
+    activePlan.complexItem = complexItem;
+    activePlan.deadline = QDeadlineTimer(_planTimeoutMsecs);
+    _activePlans.append(activePlan);
+
+    qCDebug(PlanBatchGeneratorLog) << "_startPlan" << job.name << itemName << coordinates.count();
+
+    return true;
+}
+
+bool PlanBatchGenerator::_loadShape(const Job_t& job, bool polyline, QList<QGeoCoordinate>& coordinates, QString& errorString)
+{
+    // Same opt-in simplification the Plan view applies to imported shapes
+    const int vertexBudget = SettingsManager::instance()->planViewSettings()->simplifyImportedShapes()->rawValue().toBool() ? ShapeFileHelper::simplifiedVertexBudget : 0;
+
+    if (!job.coordinates.isEmpty()) {
+        coordinates = job.coordinates;
+    } else if (polyline) {
+        if (!ShapeFileHelper::loadPolylineFromFile(job.shapeFile, coordinates, errorString, vertexBudget)) {
+            return false;
+        }
+    } else if (!ShapeFileHelper::loadPolygonFromFile(job.shapeFile, coordinates, errorString, vertexBudget)) {
+        return false;
+    }
+
+    const int minCount = polyline ? 2 : 3;
+    if (coordinates.count() < minCount) {
+        errorString = tr("Shape needs at least %1 vertices, %2 given").arg(minCount).arg(coordinates.count());
+        return false;
+    }
+
+    return true;
+}
+
+bool PlanBatchGenerator::_planReady(const ActivePlan_t& activePlan) const
+{
+    const TransectStyleComplexItem* transectStyleItem = qobject_cast<const TransectStyleComplexItem*>(activePlan.complexItem);
+    if (transectStyleItem && transectStyleItem->rebuildingTransects()) {
+        return false;
+    }
+
+    return activePlan.masterController->readyForSaveState() == VisualMissionItem::ReadyForSave;
+}
+
+void PlanBatchGenerator::_checkPlans(void)
+{
+    // Iterated backwards since finished plans are removed
+    for (int i=_activePlans.count()-1; i>=0; i--) {
+        const ActivePlan_t& activePlan = _activePlans[i];
+
+        if (_planReady(activePlan)) {
+            QString planFile;
+            QString errorString;
+            if (!_savePlan(activePlan, planFile, errorString)) {
+                planFile.clear();
+            }
+            _finishPlan(i, planFile, errorString);
+        } else if (activePlan.deadline.hasExpired()) {
+            const bool waitingForTerrain = activePlan.masterController->readyForSaveState() == VisualMissionItem::NotReadyForSaveTerrain;
+            _finishPlan(i, QString(), waitingForTerrain ? tr("Timed out waiting for terrain heights") : tr("Timed out waiting for the plan to be ready for save"));
+        }
+    }
+
+    if (_activePlans.count() < _maxPlansInFlight) {
+        _startPlans();
+    }
+}
+
+/// The job name is used as the plan file name, so it must stay a plain file name within the output directory
+bool PlanBatchGenerator::_validateJobName(const QString& name, QString& errorString)
+{
+    static const QString invalidCharacters = QStringLiteral("/\\:*?\"<>|");
+
+    if (name.trimmed().isEmpty() || (name == QStringLiteral(".")) || (name == QStringLiteral(".."))) {
+        errorString = tr("Invalid name '%1'").arg(name);
+        return false;
+    }
+    for (const QChar& character : name) {
+        if (invalidCharacters.contains(character) || (character.unicode() < 0x20)) {
+            errorString = tr("Name '%1' must not contain %2 or control characters").arg(name, invalidCharacters);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool PlanBatchGenerator::_savePlan(const ActivePlan_t& activePlan, QString& planFile, QString& errorString)
+{
+    // Jobs given through setJobs have not been through loadJobFile
+    if (!_validateJobName(_jobs[activePlan.jobIndex].name, errorString)) {
+        return false;
+    }
+
+    const QDir outputDir(_outputDirectory);
+    planFile = outputDir.absoluteFilePath(QStringLiteral("%1.%2").arg(_jobs[activePlan.jobIndex].name, activePlan.masterController->fileExtension()));
+
+    QFile file(planFile);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        errorString = file.errorString() + QStringLiteral(" ") + planFile;
+        return false;
+    }
+
+    if (file.write(activePlan.masterController->saveToJson().toJson()) < 0) {
+        errorString = file.errorString() + QStringLiteral(" ") + planFile;
+        return false;
+    }
+
+    return true;
+}
+
+void PlanBatchGenerator::_finishPlan(int activePlanIndex, const QString& planFile, const QString& errorString)
+{
+    const ActivePlan_t activePlan = _activePlans.takeAt(activePlanIndex);
+
+    // Queued checks may still be pending for the items, they find the plan gone
+    disconnect(activePlan.complexItem, nullptr, this, nullptr);
+    activePlan.masterController->deleteLater();
+
+    _addResult(activePlan.jobIndex, planFile, errorString);
+}
+
+void PlanBatchGenerator::_addResult(int jobIndex, const QString& planFile, const QString& errorString)
+{
+    Result_t result;
+    result.name = _jobs[jobIndex].name;
+    result.planFile = planFile;
+    result.errorString = errorString;
+    _results.append(result);
+
+    if (planFile.isEmpty()) {
+        qCWarning(PlanBatchGeneratorLog) << "Plan" << result.name << "failed:" << errorString;
+    } else {
+        qCDebug(PlanBatchGeneratorLog) << "Plan saved" << planFile;
+    }
+}
@@ -0,0 +1,125 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QJsonObject>
+#include <QtCore/QList>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QObject>
+#include <QtCore/QTimer>
+#include <QtPositioning/QGeoCoordinate>
+
+#include "QGCMAVLink.h"
+
+Q_DECLARE_LOGGING_CATEGORY(PlanBatchGeneratorLog)
+
+class QDir;
+class PlanMasterController;
+class ComplexMissionItem;
+
+/// Generates plan files without a user interface. Each job adds a survey, corridor scan or structure scan to an empty
+/// offline plan and applies preset settings to it, the same way the Plan view does, so the transects match the ones
+/// built there. The plan is saved once the item is ready for save.
+///
+/// Several plans are kept in flight at once, but only survey transects are built off the GUI thread, by the rebuild jobs
+/// of the items. Corridor and structure scans build their transects on the GUI thread, so they are generated one after
+/// the other. No QML is involved.
+class PlanBatchGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    PlanBatchGenerator(QObject* parent = nullptr);
+    ~PlanBatchGenerator();
+
+    typedef struct {
+        QString                 name;           ///< Base name of the plan file
+        QJsonObject             preset;         ///< Preset as saved by ComplexMissionItem::savePreset, selects the item type
+        QList<QGeoCoordinate>   coordinates;    ///< Polygon, or polyline for corridor scans
+        QString                 shapeFile;      ///< KML or SHP file the shape is loaded from if there are no coordinates
+    } Job_t;
+
+    typedef struct {
+        QString name;
+        QString planFile;       ///< Empty if the plan could not be generated
+        QString errorString;
+    } Result_t;
+
+    /// Loads the jobs, presets and vehicle type from a job file, replacing any previous jobs
+    /// @return false: load failed, errorString set
+    bool loadJobFile(const QString& filename, QString& errorString);
+
+    void setJobs            (const QList<Job_t>& jobs) { _jobs = jobs; }
+    void setVehicleType     (MAV_AUTOPILOT firmwareType, MAV_TYPE vehicleType);
+    void setOutputDirectory (const QString& outputDirectory) { _outputDirectory = outputDirectory; }
+    void setMaxPlansInFlight(int maxPlansInFlight) { _maxPlansInFlight = qMax(1, maxPlansInFlight); }
+    void setPlanTimeoutMsecs(int planTimeoutMsecs) { _planTimeoutMsecs = planTimeoutMsecs; }
+
+    const QList<Job_t>& jobs(void) const { return _jobs; }
+
+    /// Generates the plans for all jobs, running an event loop until the last one is done
+    /// @return Number of plans which could not be generated
+    int run(void);
+
+    const QList<Result_t>&  results         (void) const { return _results; }
+    double                  plansPerSecond  (void) const { return _plansPerSecond; }
+
+    static constexpr const char* jsonFileTypeValue =    "PlanBatch";
+
+    static constexpr const char* jsonFirmwareTypeKey =  "firmwareType";
+    static constexpr const char* jsonVehicleTypeKey =   "vehicleType";
+    static constexpr const char* jsonPresetsKey =       "presets";
+    static constexpr const char* jsonJobsKey =          "jobs";
+    static constexpr const char* jsonNameKey =          "name";
+    static constexpr const char* jsonPresetKey =        "preset";
+    static constexpr const char* jsonCoordinatesKey =   "coordinates";
+    static constexpr const char* jsonShapeFileKey =     "shapeFile";
+
+signals:
+    void finished(void);
+
+private slots:
+    void _checkPlans(void);
+
+private:
+    typedef struct {
+        int                     jobIndex;
+        PlanMasterController*   masterController;
+        ComplexMissionItem*     complexItem;
+        QDeadlineTimer          deadline;
+    } ActivePlan_t;
+
+    void _startPlans        (void);
+    bool _startPlan         (int jobIndex, QString& errorString);
+    bool _planReady         (const ActivePlan_t& activePlan) const;
+    bool _savePlan          (const ActivePlan_t& activePlan, QString& planFile, QString& errorString);
+    void _finishPlan        (int activePlanIndex, const QString& planFile, const QString& errorString);
+    void _addResult         (int jobIndex, const QString& planFile, const QString& errorString);
+
+    static bool _loadShape  (const Job_t& job, bool polyline, QList<QGeoCoordinate>& coordinates, QString& errorString);
+    static bool _loadJob    (const QJsonObject& jobObject, const QJsonObject& presetsObject, const QDir& jobFileDir, Job_t& job, QString& errorString);
+    static bool _validateJobName(const QString& name, QString& errorString);
+
+    QList<Job_t>        _jobs;
+    QList<ActivePlan_t> _activePlans;
+    QList<Result_t>     _results;
+    QString             _outputDirectory;
+    MAV_AUTOPILOT       _firmwareType;
+    MAV_TYPE            _vehicleType;
+    int                 _maxPlansInFlight;
+    int                 _planTimeoutMsecs =     60000;  ///< Mostly spent waiting for terrain heights
+    int                 _nextJobIndex =         0;
+    double              _plansPerSecond =       0;
+    QTimer              _timeoutTimer;
+
+    static constexpr int _jobFileVersion =          1;
+    static constexpr int _timeoutCheckMsecs =       1000;
+};
@@ -14,6 +14,10 @@
 #include "QGCApplication.h"
 #include "MissionCommandTree.h"
 #include "QGCLoggingCategory.h"
+#include "SettingsManager.h"
+#include "PlanViewSettings.h"
+
+#include <algorithm>
 
 QGC_LOGGING_CATEGORY(PlanManagerLog, "PlanManagerLog")
 
@@ -41,6 +45,11 @@ PlanManager::~PlanManager()
 
 }
 
+int PlanManager::transferWindow(void) const
+{
+    return qMax(1, SettingsManager::instance()->planViewSettings()->missionTransferWindow()->rawValue().toInt());
+}
+
 void PlanManager::_writeMissionItemsWorker(void)
 {
     _lastMissionRequest = -1;
@@ -148,6 +157,7 @@ void PlanManager::_requestList(void)
     qCDebug(PlanManagerLog) << QStringLiteral("_requestList %1 _planType:_retryCount").arg(_planTypeString()) << _planType << _retryCount;
 
     _itemIndicesToRead.clear();
+    _itemIndicesRequested.clear();
     _clearMissionItems();
 
     SharedLinkInterfacePtr  sharedLink = _vehicle->vehicleLinkManager()->primaryLink().lock();
@@ -196,7 +206,7 @@ void PlanManager::_ackTimeout(void)
         } else {
             _retryCount++;
             qCDebug(PlanManagerLog) << tr("Retrying %1 MISSION_REQUEST retry Count").arg(_planTypeString()) << _retryCount;
-            _requestNextMissionItem();
+            _requestNextMissionItem(true /* retry */);
         }
         break;
     case AckMissionRequest:
@@ -310,6 +320,11 @@ void PlanManager::_readTransactionComplete(void)
         _vehicle->sendMessageOnLinkThreadSafe(sharedLink.get(), message);
     }
 
+    // Items arrive in any order when requests are pipelined
+    std::sort(_missionItems.begin(), _missionItems.end(), [](const MissionItem* item1, const MissionItem* item2) {
+        return item1->sequenceNumber() < item2->sequenceNumber();
+    });
+
     _finishTransaction(true);
 }
 
@@ -342,32 +357,49 @@ void PlanManager::_handleMissionCount(const mavlink_message_t& message)
             _itemIndicesToRead << i;
         }
         _missionItemCountToRead = missionCount.count;
-        _requestNextMissionItem();
+        _requestNextMissionItem(false /* retry */);
     }
 }
 
-void PlanManager::_requestNextMissionItem(void)
+/// Requests the lowest items still to be read until transferWindow() requests are outstanding. With a window of 1 this
+/// is the strictly sequential protocol.
+///     @param retry true: Outstanding requests timed out, request the items which are still missing again
+void PlanManager::_requestNextMissionItem(bool retry)
 {
     if (_itemIndicesToRead.count() == 0) {
         _sendError(InternalError, tr("Internal Error: Call to Vehicle _requestNextMissionItem with no more indices to read"));
         return;
     }
 
-    qCDebug(PlanManagerLog) << QStringLiteral("_requestNextMissionItem %1 sequenceNumber:retry").arg(_planTypeString()) << _itemIndicesToRead[0] << _retryCount;
+    if (retry) {
+        _itemIndicesRequested.clear();
+    }
 
     SharedLinkInterfacePtr sharedLink = _vehicle->vehicleLinkManager()->primaryLink().lock();
-    if (sharedLink) {
-        mavlink_message_t       message;
+    const int window = transferWindow();
 
-        mavlink_msg_mission_request_int_pack_chan(MAVLinkProtocol::instance()->getSystemId(),
-                                                  MAVLinkProtocol::getComponentId(),
-                                                  sharedLink->mavlinkChannel(),
-                                                  &message,
-                                                  _vehicle->id(),
-                                                  MAV_COMP_ID_AUTOPILOT1,
-                                                  _itemIndicesToRead[0],
-                                                  _planType);
-        _vehicle->sendMessageOnLinkThreadSafe(sharedLink.get(), message);
+    for (int i=0; i<_itemIndicesToRead.count() && _itemIndicesRequested.count() < window; i++) {
+        const int seq = _itemIndicesToRead[i];
+        if (_itemIndicesRequested.contains(seq)) {
+            continue;
+        }
+
+        qCDebug(PlanManagerLog) << QStringLiteral("_requestNextMissionItem %1 sequenceNumber:retry").arg(_planTypeString()) << seq << _retryCount;
+
+        if (sharedLink) {
+            mavlink_message_t       message;
+
+            mavlink_msg_mission_request_int_pack_chan(MAVLinkProtocol::instance()->getSystemId(),
+                                                      MAVLinkProtocol::getComponentId(),
+                                                      sharedLink->mavlinkChannel(),
+                                                      &message,
+                                                      _vehicle->id(),
+                                                      MAV_COMP_ID_AUTOPILOT1,
+                                                      seq,
+                                                      _planType);
+            _vehicle->sendMessageOnLinkThreadSafe(sharedLink.get(), message);
+        }
+        _itemIndicesRequested.append(seq);
     }
     _startAckTimeout(AckMissionItem);
 }
@@ -439,6 +471,7 @@ void PlanManager::_handleMissionItem(const mavlink_message_t& message)
     
     if (_itemIndicesToRead.contains(seq)) {
         _itemIndicesToRead.removeOne(seq);
+        _itemIndicesRequested.removeOne(seq);
 
         MissionItem* item = new MissionItem(seq,
                                             command,
@@ -467,13 +500,13 @@ void PlanManager::_handleMissionItem(const mavlink_message_t& message)
         return;
     }
 
-    emit progressPctChanged((double)seq / (double)_missionItemCountToRead);
+    emit progressPctChanged((double)(_missionItemCountToRead - _itemIndicesToRead.count()) / (double)_missionItemCountToRead);
     
     _retryCount = 0;
     if (_itemIndicesToRead.count() == 0) {
         _readTransactionComplete();
     } else {
-        _requestNextMissionItem();
+        _requestNextMissionItem(false /* retry */);
     }
 }
 
@@ -521,8 +554,24 @@ void PlanManager::_handleMissionRequest(const mavlink_message_t& message)
         _itemIndicesToWrite.removeOne(missionRequestSeq);
     }
     
-    MissionItem* item = _writeMissionItems[missionRequestSeq];
-    qCDebug(PlanManagerLog) << QStringLiteral("_handleMissionRequest %1 sequenceNumber:command").arg(_planTypeString()) << missionRequestSeq << item->command();
+    _sendMissionItem(missionRequestSeq);
+
+    // Stream the items following the requested one so the vehicle has them before it asks for them
+    const int window = transferWindow();
+    for (int seq=missionRequestSeq + 1; seq<missionRequestSeq + window && seq<_writeMissionItems.count(); seq++) {
+        if (_itemIndicesToWrite.contains(seq)) {
+            _itemIndicesToWrite.removeOne(seq);
+            _sendMissionItem(seq);
+        }
+    }
+
+    _startAckTimeout(AckMissionRequest);
+}
+
+void PlanManager::_sendMissionItem(int seq)
+{
+    MissionItem* item = _writeMissionItems[seq];
+    qCDebug(PlanManagerLog) << QStringLiteral("_sendMissionItem %1 sequenceNumber:command").arg(_planTypeString()) << seq << item->command();
 
     SharedLinkInterfacePtr sharedLink = _vehicle->vehicleLinkManager()->primaryLink().lock();
     if (sharedLink) {
@@ -534,10 +583,10 @@ void PlanManager::_handleMissionRequest(const mavlink_message_t& message)
                                                &messageOut,
                                                _vehicle->id(),
                                                MAV_COMP_ID_AUTOPILOT1,
-                                               missionRequestSeq,
+                                               seq,
                                                item->frame(),
                                                item->command(),
-                                               missionRequestSeq == 0,
+                                               seq == 0,
                                                item->autoContinue(),
                                                item->param1(),
                                                item->param2(),
@@ -549,7 +598,6 @@ void PlanManager::_handleMissionRequest(const mavlink_message_t& message)
                                                _planType);
         _vehicle->sendMessageOnLinkThreadSafe(sharedLink.get(), messageOut);
     }
-    _startAckTimeout(AckMissionRequest);
 }
 
 void PlanManager::_handleMissionAck(const mavlink_message_t& message)
@@ -807,6 +855,7 @@ void PlanManager::_finishTransaction(bool success, bool apmGuidedItemWrite)
     _disconnectFromMavlink();
 
     _itemIndicesToRead.clear();
+    _itemIndicesRequested.clear();
     _itemIndicesToWrite.clear();
 
     // First thing we do is clear the transaction. This way inProgesss is off when we signal transaction complete.
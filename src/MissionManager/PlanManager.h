@@ -53,6 +53,9 @@ public:
     ///     Signals removeAllComplete when done
     void removeAll(void);
 
+    /// Maximum number of mission items in flight at once during a transfer, from the missionTransferWindow setting
+    int transferWindow(void) const;
+
     /// Error codes returned in error signal
     typedef enum {
         InternalError,
@@ -113,7 +116,8 @@ protected:
     void _handleMissionItem(const mavlink_message_t& message);
     void _handleMissionRequest(const mavlink_message_t& message);
     void _handleMissionAck(const mavlink_message_t& message);
-    void _requestNextMissionItem(void);
+    void _requestNextMissionItem(bool retry);
+    void _sendMissionItem(int seq);
     void _clearMissionItems(void);
     void _sendError(ErrorCode_t errorCode, const QString& errorMsg);
     QString _ackTypeToString(AckType_t ackType);
@@ -144,6 +148,7 @@ protected:
     QList<int>          _itemIndicesToRead;     ///< List of mission items which still need to be requested from vehicle
     int                 _lastMissionRequest;    ///< Index of item last requested by MISSION_REQUEST
     int                 _missionItemCountToRead;///< Count of all mission items to read
+    QList<int>          _itemIndicesRequested;  ///< Items requested from vehicle which have not arrived yet
 
     QList<MissionItem*> _missionItems;          ///< Set of mission items on vehicle
     QList<MissionItem*> _writeMissionItems;     ///< Set of mission items currently being written to vehicle
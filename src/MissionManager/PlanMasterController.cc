@@ -43,11 +43,10 @@ PlanMasterController::PlanMasterController(QObject* parent)
     _commonInit();
 }
 
-#ifdef QT_DEBUG
 PlanMasterController::PlanMasterController(MAV_AUTOPILOT firmwareType, MAV_TYPE vehicleType, QObject* parent)
     : QObject               (parent)
     , _multiVehicleMgr      (MultiVehicleManager::instance())
-    , _controllerVehicle    (new Vehicle(firmwareType, vehicleType))
+    , _controllerVehicle    (new Vehicle(firmwareType, vehicleType, this))
     , _managerVehicle       (_controllerVehicle)
     , _missionController    (this)
     , _geoFenceController   (this)
@@ -55,7 +54,6 @@ PlanMasterController::PlanMasterController(MAV_AUTOPILOT firmwareType, MAV_TYPE
 {
     _commonInit();
 }
-#endif
 
 void PlanMasterController::_commonInit(void)
 {
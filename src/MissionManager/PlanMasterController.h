@@ -31,10 +31,8 @@ class PlanMasterController : public QObject
     
 public:
     PlanMasterController(QObject* parent = nullptr);
-#ifdef QT_DEBUG
-    // Used by test code to create master controller with specific firmware/vehicle type
+    // Used by test code and batch plan generation to create master controller with specific firmware/vehicle type
     PlanMasterController(MAV_AUTOPILOT firmwareType, MAV_TYPE vehicleType, QObject* parent = nullptr);
-#endif
 
     ~PlanMasterController();
 
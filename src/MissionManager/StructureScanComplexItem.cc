@@ -197,12 +197,22 @@ void StructureScanComplexItem::setSequenceNumber(int sequenceNumber)
 }
 
 bool StructureScanComplexItem::load(const QJsonObject& complexObject, int sequenceNumber, QString& errorString)
+{
+    return _loadWorker(complexObject, sequenceNumber, errorString, false /* forPresets */);
+}
+
+bool StructureScanComplexItem::applyPreset(const QJsonObject& presetObject, QString& errorString)
+{
+    return _loadWorker(presetObject, 0, errorString, true /* forPresets */);
+}
+
+bool StructureScanComplexItem::_loadWorker(const QJsonObject& complexObject, int sequenceNumber, QString& errorString, bool forPresets)
 {
     QList<JsonHelper::KeyValidateInfo> keyInfoList = {
         { JsonHelper::jsonVersionKey,                   QJsonValue::Double, true },
         { VisualMissionItem::jsonTypeKey,               QJsonValue::String, true },
         { ComplexMissionItem::jsonComplexItemTypeKey,   QJsonValue::String, true },
-        { QGCMapPolygon::jsonPolygonKey,                QJsonValue::Array,  true },
+        { QGCMapPolygon::jsonPolygonKey,                QJsonValue::Array,  !forPresets },
         { scanBottomAltName,                            QJsonValue::Double, true },
         { structureHeightName,                          QJsonValue::Double, true },
         { layersName,                                   QJsonValue::Double, true },
@@ -215,7 +225,9 @@ bool StructureScanComplexItem::load(const QJsonObject& complexObject, int sequen
         return false;
     }
 
-    _structurePolygon.clear();
+    if (!forPresets) {
+        _structurePolygon.clear();
+    }
 
     QString itemType = complexObject[VisualMissionItem::jsonTypeKey].toString();
     QString complexType = complexObject[ComplexMissionItem::jsonComplexItemTypeKey].toString();
@@ -230,10 +242,12 @@ bool StructureScanComplexItem::load(const QJsonObject& complexObject, int sequen
         return false;
     }
 
-    setSequenceNumber(sequenceNumber);
+    if (!forPresets) {
+        setSequenceNumber(sequenceNumber);
+    }
 
     // Load CameraCalc first since it will trigger camera name change which will trounce gimbal angles
-    if (!_cameraCalc.load(complexObject[_jsonCameraCalcKey].toObject(), false /* v1FollowTerrain */, errorString, false /* forPresets */)) {
+    if (!_cameraCalc.load(complexObject[_jsonCameraCalcKey].toObject(), false /* v1FollowTerrain */, errorString, forPresets)) {
         return false;
     }
 
@@ -244,7 +258,7 @@ bool StructureScanComplexItem::load(const QJsonObject& complexObject, int sequen
     _entranceAltFact.setRawValue        (complexObject[startFromTopName].toDouble());
     _gimbalPitchFact.setRawValue        (complexObject[gimbalPitchName].toDouble());
 
-    if (!_structurePolygon.loadFromJson(complexObject, true /* required */, errorString)) {
+    if (!forPresets && !_structurePolygon.loadFromJson(complexObject, true /* required */, errorString)) {
         _structurePolygon.clear();
         return false;
     }
@@ -67,6 +67,7 @@ public:
     double  complexDistance     (void) const final { return _scanDistance; }
     int     lastSequenceNumber  (void) const final;
     bool    load                (const QJsonObject& complexObject, int sequenceNumber, QString& errorString) final;
+    bool    applyPreset         (const QJsonObject& presetObject, QString& errorString) final;
     double  greatestDistanceTo  (const QGeoCoordinate &other) const final;
     QString mapVisualQML        (void) const final { return QStringLiteral("StructureScanMapVisual.qml"); }
 
@@ -138,6 +139,7 @@ private slots:
 private:
     void    _setCameraShots                 (int cameraShots);
     double  _triggerDistance                (void) const;
+    bool    _loadWorker                     (const QJsonObject& complexObject, int sequenceNumber, QString& errorString, bool forPresets);
 
     QMap<QString, FactMetaData*> _metaDataMap;
 
@@ -19,11 +19,18 @@
 #include "QGCApplication.h"
 #include "Vehicle.h"
 #include "QGCLoggingCategory.h"
+#include "TransectRouteOptimizer.h"
+#include "earcut.hpp"
 
 #include <QtGui/QPolygonF>
+#include <QtCore/QHash>
 #include <QtCore/QJsonArray>
 #include <QtCore/QLineF>
 
+#include <algorithm>
+#include <array>
+#include <vector>
+
 QGC_LOGGING_CATEGORY(SurveyComplexItemLog, "SurveyComplexItemLog")
 
 const QString SurveyComplexItem::name(SurveyComplexItem::tr("Survey"));
@@ -34,6 +41,7 @@ SurveyComplexItem::SurveyComplexItem(PlanMasterController* masterController, boo
     , _gridAngleFact            (settingsGroup, _metaDataMap[gridAngleName])
     , _flyAlternateTransectsFact(settingsGroup, _metaDataMap[flyAlternateTransectsName])
     , _splitConcavePolygonsFact (settingsGroup, _metaDataMap[splitConcavePolygonsName])
+    , _optimizeTransectOrderFact(settingsGroup, _metaDataMap[optimizeTransectOrderName])
     , _entryPoint               (EntryLocationTopLeft)
 {
     _editorQml = "qrc:/qml/SurveyItemEditor.qml";
@@ -51,11 +59,13 @@ SurveyComplexItem::SurveyComplexItem(PlanMasterController* masterController, boo
     connect(&_gridAngleFact,            &Fact::valueChanged,                        this, &SurveyComplexItem::_setDirty);
     connect(&_flyAlternateTransectsFact,&Fact::valueChanged,                        this, &SurveyComplexItem::_setDirty);
     connect(&_splitConcavePolygonsFact, &Fact::valueChanged,                        this, &SurveyComplexItem::_setDirty);
+    connect(&_optimizeTransectOrderFact,&Fact::valueChanged,                        this, &SurveyComplexItem::_setDirty);
     connect(this,                       &SurveyComplexItem::refly90DegreesChanged,  this, &SurveyComplexItem::_setDirty);
 
     connect(&_gridAngleFact,            &Fact::valueChanged,                        this, &SurveyComplexItem::_rebuildTransects);
     connect(&_flyAlternateTransectsFact,&Fact::valueChanged,                        this, &SurveyComplexItem::_rebuildTransects);
     connect(&_splitConcavePolygonsFact, &Fact::valueChanged,                        this, &SurveyComplexItem::_rebuildTransects);
+    connect(&_optimizeTransectOrderFact,&Fact::valueChanged,                        this, &SurveyComplexItem::_rebuildTransects);
     connect(this,                       &SurveyComplexItem::refly90DegreesChanged,  this, &SurveyComplexItem::_rebuildTransects);
 
     connect(&_surveyAreaPolygon,        &QGCMapPolygon::isValidChanged,             this, &SurveyComplexItem::_updateWizardMode);
@@ -94,6 +104,7 @@ void SurveyComplexItem::_saveCommon(QJsonObject& saveObject)
     saveObject[_jsonGridAngleKey] =                             _gridAngleFact.rawValue().toDouble();
     saveObject[_jsonFlyAlternateTransectsKey] =                 _flyAlternateTransectsFact.rawValue().toBool();
     saveObject[_jsonSplitConcavePolygonsKey] =                  _splitConcavePolygonsFact.rawValue().toBool();
+    saveObject[_jsonOptimizeTransectOrderKey] =                 _optimizeTransectOrderFact.rawValue().toBool();
     saveObject[_jsonEntryPointKey] =                            _entryPoint;
 
     // Polygon shape
@@ -105,10 +116,16 @@ void SurveyComplexItem::loadPreset(const QString& name)
     QString errorString;
 
     QJsonObject presetObject = _loadPresetJson(name);
-    if (!_loadV4V5(presetObject, 0, errorString, 5, true /* forPresets */)) {
+    if (!applyPreset(presetObject, errorString)) {
         qgcApp()->showAppMessage(QStringLiteral("Internal Error: Preset load failed. Name: %1 Error: %2").arg(name).arg(errorString));
     }
+}
+
+bool SurveyComplexItem::applyPreset(const QJsonObject& presetObject, QString& errorString)
+{
+    const bool success = _loadV4V5(presetObject, 0, errorString, 5, true /* forPresets */);
     _rebuildTransects();
+    return success;
 }
 
 bool SurveyComplexItem::load(const QJsonObject& complexObject, int sequenceNumber, QString& errorString)
@@ -202,6 +219,7 @@ bool SurveyComplexItem::_loadV4V5(const QJsonObject& complexObject, int sequence
 
     _gridAngleFact.setRawValue              (complexObject[_jsonGridAngleKey].toDouble());
     _flyAlternateTransectsFact.setRawValue  (complexObject[_jsonFlyAlternateTransectsKey].toBool(false));
+    _optimizeTransectOrderFact.setRawValue  (complexObject[_jsonOptimizeTransectOrderKey].toBool(false));
 
     if (version == 5) {
         _splitConcavePolygonsFact.setRawValue   (complexObject[_jsonSplitConcavePolygonsKey].toBool(true));
@@ -426,7 +444,7 @@ bool SurveyComplexItem::_gridAngleIsNorthSouthTransects()
     return gridAngle < 45.0 || (gridAngle > 360.0 - 45.0) || (gridAngle > 90.0 + 45.0 && gridAngle < 270.0 - 45.0);
 }
 
-void SurveyComplexItem::_adjustTransectsToEntryPointLocation(QList<QList<QGeoCoordinate>>& transects)
+void SurveyComplexItem::_adjustTransectsToEntryPointLocation(QList<QList<QGeoCoordinate>>& transects, int entryPoint)
 {
     if (transects.count() == 0) {
         return;
@@ -435,10 +453,10 @@ void SurveyComplexItem::_adjustTransectsToEntryPointLocation(QList<QList<QGeoCoo
     bool reversePoints = false;
     bool reverseTransects = false;
 
-    if (_entryPoint == EntryLocationBottomLeft || _entryPoint == EntryLocationBottomRight) {
+    if (entryPoint == EntryLocationBottomLeft || entryPoint == EntryLocationBottomRight) {
         reversePoints = true;
     }
-    if (_entryPoint == EntryLocationTopRight || _entryPoint == EntryLocationBottomRight) {
+    if (entryPoint == EntryLocationTopRight || entryPoint == EntryLocationBottomRight) {
         reverseTransects = true;
     }
 
@@ -451,7 +469,7 @@ void SurveyComplexItem::_adjustTransectsToEntryPointLocation(QList<QList<QGeoCoo
         _reverseTransectOrder(transects);
     }
 
-    qCDebug(SurveyComplexItemLog) << "_adjustTransectsToEntryPointLocation Modified entry point:entryLocation" << transects.first().first() << _entryPoint;
+    qCDebug(SurveyComplexItemLog) << "_adjustTransectsToEntryPointLocation Modified entry point:entryLocation" << transects.first().first() << entryPoint;
 }
 
 QPointF SurveyComplexItem::_rotatePoint(const QPointF& point, const QPointF& origin, double angle)
@@ -526,48 +544,83 @@ void SurveyComplexItem::_intersectLinesWithRect(const QList<QLineF>& lineList, c
     }
 }
 
+/// Intersects the parallel transect lines with the polygon edges. The lines are sorted by their offset across the
+/// transect direction, so each edge only visits the lines it actually spans instead of every line.
 void SurveyComplexItem::_intersectLinesWithPolygon(const QList<QLineF>& lineList, const QPolygonF& polygon, QList<QLineF>& resultLines)
 {
     resultLines.clear();
 
-    for (int i=0; i<lineList.count(); i++) {
-        const QLineF& line = lineList[i];
-        QList<QPointF> intersections;
+    if (lineList.isEmpty() || (polygon.count() < 2)) {
+        return;
+    }
 
-        // Intersect the line with all the polygon edges
-        for (int j=0; j<polygon.count()-1; j++) {
-            QPointF intersectPoint;
-            QLineF polygonLine = QLineF(polygon[j], polygon[j+1]);
+    // Unit vectors along and across the transects
+    const QLineF unitLine = lineList.first().unitVector();
+    const QPointF direction = unitLine.p2() - unitLine.p1();
+    const QPointF normal(-direction.y(), direction.x());
+    const auto dot = [](const QPointF& a, const QPointF& b) { return (a.x() * b.x()) + (a.y() * b.y()); };
 
-            auto intersect = line.intersects(polygonLine, &intersectPoint);
-            if (intersect == QLineF::BoundedIntersection) {
-                if (!intersections.contains(intersectPoint)) {
-                    intersections.append(intersectPoint);
-                }
-            }
+    QList<std::pair<double, qsizetype>> lineOffsets;
+    lineOffsets.reserve(lineList.count());
+    for (qsizetype i=0; i<lineList.count(); i++) {
+        lineOffsets.append({ dot(lineList[i].p1(), normal), i });
+    }
+    std::sort(lineOffsets.begin(), lineOffsets.end());
+
+    // Only the intersections furthest apart along each line form the transect
+    struct LineExtent_t {
+        double  minDistance =   qInf();
+        double  maxDistance =   -qInf();
+        QPointF minPoint;
+        QPointF maxPoint;
+        int     minEdge =       0;
+        int     maxEdge =       0;
+    };
+    QList<LineExtent_t> lineExtents(lineList.count());
+
+    for (int j=0; j<polygon.count()-1; j++) {
+        const QPointF& edgeStart = polygon[j];
+        const QPointF& edgeEnd = polygon[j+1];
+        const double startOffset = dot(edgeStart, normal);
+        const double endOffset = dot(edgeEnd, normal);
+        if (startOffset == endOffset) {
+            // Edge runs parallel to the transects
+            continue;
         }
 
-        // We now have one or more intersection points all along the same line. Find the two
-        // which are furthest away from each other to form the transect.
-        if (intersections.count() > 1) {
-            QPointF firstPoint;
-            QPointF secondPoint;
-            double currentMaxDistance = 0;
-
-            for (int i=0; i<intersections.count(); i++) {
-                for (int j=0; j<intersections.count(); j++) {
-                    QLineF lineTest(intersections[i], intersections[j]);
-                    \
-                    double newMaxDistance = lineTest.length();
-                    if (newMaxDistance > currentMaxDistance) {
-                        firstPoint = intersections[i];
-                        secondPoint = intersections[j];
-                        currentMaxDistance = newMaxDistance;
-                    }
-                }
+        auto it = std::lower_bound(lineOffsets.cbegin(), lineOffsets.cend(), std::make_pair(qMin(startOffset, endOffset), qsizetype(0)));
+        for (; (it != lineOffsets.cend()) && (it->first <= qMax(startOffset, endOffset)); ++it) {
+            const QLineF& line = lineList[it->second];
+            const double t = (it->first - startOffset) / (endOffset - startOffset);
+            const QPointF intersectPoint = edgeStart + ((edgeEnd - edgeStart) * t);
+
+            const double distance = dot(intersectPoint - line.p1(), direction);
+            if ((distance < 0) || (distance > line.length())) {
+                continue;
+            }
+
+            // Ties keep the earlier edge so the transect direction follows the polygon vertex order
+            LineExtent_t& extent = lineExtents[it->second];
+            if (distance < extent.minDistance) {
+                extent.minDistance = distance;
+                extent.minPoint = intersectPoint;
+                extent.minEdge = j;
             }
+            if (distance > extent.maxDistance) {
+                extent.maxDistance = distance;
+                extent.maxPoint = intersectPoint;
+                extent.maxEdge = j;
+            }
+        }
+    }
 
-            resultLines += QLineF(firstPoint, secondPoint);
+    for (const LineExtent_t& extent : lineExtents) {
+        if (extent.minDistance < extent.maxDistance) {
+            if (extent.minEdge <= extent.maxEdge) {
+                resultLines += QLineF(extent.minPoint, extent.maxPoint);
+            } else {
+                resultLines += QLineF(extent.maxPoint, extent.minPoint);
+            }
         }
     }
 }
@@ -627,65 +680,154 @@ double SurveyComplexItem::_turnaroundDistance(void) const
     return _turnAroundDistanceFact.rawValue().toDouble();
 }
 
-void SurveyComplexItem::_rebuildTransectsPhase1(void)
+void SurveyComplexItem::_clearLoadedMissionItems(void)
 {
-    _rebuildTransectsPhase1WorkerSinglePolygon(false /* refly */);
-    if (_refly90DegreesFact.rawValue().toBool()) {
-        _rebuildTransectsPhase1WorkerSinglePolygon(true /* refly */);
+    // If the transects are getting rebuilt then any previously loaded mission items are now invalid
+    if (_loadedMissionItemsParent) {
+        _loadedMissionItems.clear();
+        _loadedMissionItemsParent->deleteLater();
+        _loadedMissionItemsParent = nullptr;
     }
 }
 
-void SurveyComplexItem::_rebuildTransectsPhase1WorkerSinglePolygon(bool refly)
+SurveyComplexItem::TransectParams_t SurveyComplexItem::_transectParams(void) const
 {
-    if (_ignoreRecalc) {
-        return;
+    TransectParams_t params;
+
+    params.polygon = _surveyAreaPolygon.coordinateList();
+    params.gridAngle = _gridAngleFact.rawValue().toDouble();
+    params.gridSpacing = _cameraCalc.adjustedFootprintSide()->rawValue().toDouble();
+    if (params.gridSpacing < 0.5) {
+        // We can't let gridSpacing get too small otherwise we will end up with too many transects.
+        // So we limit to 0.5 meter spacing as min and set to huge value which will cause a single
+        // transect to be added.
+        params.gridSpacing = 100000;
     }
+    params.refly90Degrees = _refly90DegreesFact.rawValue().toBool();
+    params.flyAlternateTransects = _flyAlternateTransectsFact.rawValue().toBool();
+    params.optimizeTransectOrder = _optimizeTransectOrderFact.rawValue().toBool();
+    params.entryPoint = _entryPoint;
+    params.hoverAndCapture = triggerCamera() && hoverAndCaptureEnabled();
+    params.triggerDistance = triggerDistance();
+    params.turnAroundDistance = _hasTurnaround() ? _turnAroundDistanceFact.rawValue().toDouble() : 0;
 
-    // If the transects are getting rebuilt then any previously loaded mission items are now invalid
-    if (_loadedMissionItemsParent) {
-        _loadedMissionItems.clear();
-        _loadedMissionItemsParent->deleteLater();
-        _loadedMissionItemsParent = nullptr;
+    return params;
+}
+
+double SurveyComplexItem::_transectWorkEstimate(const TransectParams_t& params)
+{
+    if (params.polygon.count() < 3) {
+        return 0;
     }
 
-    if (_surveyAreaPolygon.count() < 3) {
-        return;
+    double minLat = params.polygon.first().latitude();
+    double maxLat = minLat;
+    double minLon = params.polygon.first().longitude();
+    double maxLon = minLon;
+    for (const QGeoCoordinate& vertex : params.polygon) {
+        minLat = qMin(minLat, vertex.latitude());
+        maxLat = qMax(maxLat, vertex.latitude());
+        minLon = qMin(minLon, vertex.longitude());
+        maxLon = qMax(maxLon, vertex.longitude());
     }
 
-    // Convert polygon to NED
+    const double height = QGeoCoordinate(minLat, minLon).distanceTo(QGeoCoordinate(maxLat, minLon));
+    const double width = QGeoCoordinate(minLat, minLon).distanceTo(QGeoCoordinate(minLat, maxLon));
 
-    QList<QPointF> polygonPoints;
-    QGeoCoordinate tangentOrigin = _surveyAreaPolygon.pathModel().value<QGCQGeoCoordinate*>(0)->coordinate();
-    qCDebug(SurveyComplexItemLog) << "_rebuildTransectsPhase1 Convert polygon to NED - _surveyAreaPolygon.count():tangentOrigin" << _surveyAreaPolygon.count() << tangentOrigin;
-    for (int i=0; i<_surveyAreaPolygon.count(); i++) {
-        double y, x, down;
-        QGeoCoordinate vertex = _surveyAreaPolygon.pathModel().value<QGCQGeoCoordinate*>(i)->coordinate();
-        if (i == 0) {
-            // This avoids a nan calculation that comes out of convertGeoToNed
-            x = y = 0;
-        } else {
-            QGCGeo::convertGeoToNed(vertex, tangentOrigin, y, x, down);
+    // Every generated line is intersected with every polygon edge
+    const double lineCount = (qMax(width, height) + 2000.0) / params.gridSpacing;
+    return lineCount * params.polygon.count() * (params.refly90Degrees ? 2 : 1);
+}
+
+void SurveyComplexItem::_rebuildTransectsPhase1(void)
+{
+    _clearLoadedMissionItems();
+    _transects = _buildTransects(_transectParams(), std::function<bool(double)>());
+}
+
+TransectStyleComplexItem::RebuildTransectsJob_t SurveyComplexItem::_rebuildTransectsJob(void)
+{
+    const TransectParams_t params = _transectParams();
+    // Ordering the transects is never done on the GUI thread, whatever the survey size
+    const bool optimizeOrder = params.optimizeTransectOrder && !params.flyAlternateTransects;
+    if (!_forceRebuildTransectsJob && !optimizeOrder && (_transectWorkEstimate(params) < _rebuildTransectsJobMinWork)) {
+        return RebuildTransectsJob_t();
+    }
+
+    _clearLoadedMissionItems();
+
+    return [params](const std::function<bool(double)>& progress) {
+        return _buildTransects(params, progress);
+    };
+}
+
+QList<QList<TransectStyleComplexItem::CoordInfo_t>> SurveyComplexItem::_buildTransects(const TransectParams_t& params, const std::function<bool(double)>& progress)
+{
+    QList<QList<CoordInfo_t>> transects;
+
+    if (params.polygon.count() < 3) {
+        return transects;
+    }
+
+    const double passCount = params.refly90Degrees ? 2 : 1;
+    const auto passProgress = [&progress, passCount](int pass) -> std::function<bool(double)> {
+        if (!progress) {
+            return std::function<bool(double)>();
+        }
+        return [&progress, passCount, pass](double fraction) {
+            return progress((pass + fraction) / passCount);
+        };
+    };
+
+    if (!_buildTransectsSinglePolygon(params, false /* refly */, transects, passProgress(0))) {
+        return QList<QList<CoordInfo_t>>();
+    }
+    if (params.refly90Degrees && !transects.isEmpty()) {
+        if (!_buildTransectsSinglePolygon(params, true /* refly */, transects, passProgress(1))) {
+            return QList<QList<CoordInfo_t>>();
         }
-        polygonPoints += QPointF(x, y);
-        qCDebug(SurveyComplexItemLog) << "_rebuildTransectsPhase1 vertex:x:y" << vertex << polygonPoints.last().x() << polygonPoints.last().y();
     }
 
-    // Generate transects
+    return transects;
+}
 
-    double gridAngle = _gridAngleFact.rawValue().toDouble();
-    double gridSpacing = _cameraCalc.adjustedFootprintSide()->rawValue().toDouble();
-    if (gridSpacing < 0.5) {
-        // We can't let gridSpacing get too small otherwise we will end up with too many transects.
-        // So we limit to 0.5 meter spacing as min and set to huge value which will cause a single
-        // transect to be added.
-        gridSpacing = 100000;
+/// Generates the transects for one pass over the polygon and appends them to transects. Only uses params, so
+/// it is safe to call from a worker thread.
+///     @param progress Called with the completed fraction of the pass, returning false cancels generation
+///     @return false if generation was cancelled
+bool SurveyComplexItem::_buildTransectsSinglePolygon(const TransectParams_t& params, bool refly, QList<QList<CoordInfo_t>>& transects, const std::function<bool(double)>& progress)
+{
+    // Convert polygon to NED
+
+    const qsizetype vertexCount = params.polygon.count();
+    const QGeoCoordinate tangentOrigin = params.polygon.first();
+    const QGCGeo::NedOrigin nedOrigin(tangentOrigin);
+    qCDebug(SurveyComplexItemLog) << "_rebuildTransectsPhase1 Convert polygon to NED - polygon.count():tangentOrigin" << vertexCount << tangentOrigin;
+
+    QList<double> latitudes(vertexCount);
+    QList<double> longitudes(vertexCount);
+    for (qsizetype i=0; i<vertexCount; i++) {
+        latitudes[i] = params.polygon[i].latitude();
+        longitudes[i] = params.polygon[i].longitude();
     }
+    QList<double> north(vertexCount);
+    QList<double> east(vertexCount);
+    nedOrigin.convertGeoToNed(latitudes.constData(), longitudes.constData(), nullptr, north.data(), east.data(), nullptr, vertexCount);
 
-    gridAngle = _clampGridAngle90(gridAngle);
+    QList<QPointF> polygonPoints;
+    for (qsizetype i=0; i<vertexCount; i++) {
+        // The origin vertex is pinned to 0,0 which avoids a nan calculation that comes out of convertGeoToNed
+        polygonPoints += (i == 0) ? QPointF(0, 0) : QPointF(east[i], north[i]);
+        qCDebug(SurveyComplexItemLog) << "_rebuildTransectsPhase1 vertex:x:y" << params.polygon[i] << polygonPoints.last().x() << polygonPoints.last().y();
+    }
+
+    // Generate transects
+
+    double gridAngle = _clampGridAngle90(params.gridAngle);
     gridAngle += refly ? 90 : 0;
     qCDebug(SurveyComplexItemLog) << "_rebuildTransectsPhase1 Clamped grid angle" << gridAngle;
 
-    qCDebug(SurveyComplexItemLog) << "_rebuildTransectsPhase1 gridSpacing:gridAngle:refly" << gridSpacing << gridAngle << refly;
+    qCDebug(SurveyComplexItemLog) << "_rebuildTransectsPhase1 gridSpacing:gridAngle:refly" << params.gridSpacing << gridAngle << refly;
 
     // Convert polygon to bounding rect
 
@@ -717,13 +859,21 @@ void SurveyComplexItem::_rebuildTransectsPhase1WorkerSinglePolygon(bool refly)
         double transectYBottom = boundingCenter.y() + halfWidth;
 
         lineList += QLineF(_rotatePoint(QPointF(transectX, transectYTop), boundingCenter, gridAngle), _rotatePoint(QPointF(transectX, transectYBottom), boundingCenter, gridAngle));
-        transectX += gridSpacing;
+        transectX += params.gridSpacing;
     }
 
-    // Now intersect the lines with the polygon
+    // Now intersect the lines with the polygon. This is where the bulk of the time goes for large surveys, so it
+    // is done in chunks with a cancellation check in between.
     QList<QLineF> intersectLines;
 #if 1
-    _intersectLinesWithPolygon(lineList, polygon, intersectLines);
+    for (qsizetype chunkStart=0; chunkStart<lineList.count(); chunkStart+=_intersectLinesChunkSize) {
+        if (progress && !progress(static_cast<double>(chunkStart) / lineList.count())) {
+            return false;
+        }
+        QList<QLineF> chunkLines;
+        _intersectLinesWithPolygon(lineList.mid(chunkStart, _intersectLinesChunkSize), polygon, chunkLines);
+        intersectLines += chunkLines;
+    }
 #else
     // This is handy for debugging grid problems, not for release
     intersectLines = lineList;
@@ -733,7 +883,6 @@ void SurveyComplexItem::_rebuildTransectsPhase1WorkerSinglePolygon(bool refly)
     //      Create a single transect which goes through the center of the polygon
     //      Intersect it with the polygon
     if (intersectLines.count() < 2) {
-        _surveyAreaPolygon.center();
         QLineF firstLine = lineList.first();
         QPointF lineCenter = firstLine.pointAt(0.5);
         QPointF centerOffset = boundingCenter - lineCenter;
@@ -750,45 +899,45 @@ void SurveyComplexItem::_rebuildTransectsPhase1WorkerSinglePolygon(bool refly)
     _adjustLineDirection(intersectLines, resultLines);
 
     // Convert from NED to Geo
-    QList<QList<QGeoCoordinate>> transects;
+    QList<QList<QGeoCoordinate>> geoTransects;
     for (const QLineF& line : resultLines) {
         QGeoCoordinate          coord;
         QList<QGeoCoordinate>   transect;
 
-        QGCGeo::convertNedToGeo(line.p1().y(), line.p1().x(), 0, tangentOrigin, coord);
+        nedOrigin.convertNedToGeo(line.p1().y(), line.p1().x(), 0, coord);
         transect.append(coord);
-        QGCGeo::convertNedToGeo(line.p2().y(), line.p2().x(), 0, tangentOrigin, coord);
+        nedOrigin.convertNedToGeo(line.p2().y(), line.p2().x(), 0, coord);
         transect.append(coord);
 
-        transects.append(transect);
+        geoTransects.append(transect);
     }
 
-    _adjustTransectsToEntryPointLocation(transects);
+    _adjustTransectsToEntryPointLocation(geoTransects, params.entryPoint);
 
-    if (refly) {
-        _optimizeTransectsForShortestDistance(_transects.last().last().coord, transects);
+    if (refly && !geoTransects.isEmpty()) {
+        _optimizeTransectsForShortestDistance(transects.last().last().coord, geoTransects);
     }
 
-    if (_flyAlternateTransectsFact.rawValue().toBool()) {
+    if (params.flyAlternateTransects) {
         QList<QList<QGeoCoordinate>> alternatingTransects;
-        for (int i=0; i<transects.count(); i++) {
+        for (int i=0; i<geoTransects.count(); i++) {
             if (!(i & 1)) {
-                alternatingTransects.append(transects[i]);
+                alternatingTransects.append(geoTransects[i]);
             }
         }
-        for (int i=transects.count()-1; i>0; i--) {
+        for (int i=geoTransects.count()-1; i>0; i--) {
             if (i & 1) {
-                alternatingTransects.append(transects[i]);
+                alternatingTransects.append(geoTransects[i]);
             }
         }
-        transects = alternatingTransects;
+        geoTransects = alternatingTransects;
     }
 
     // Adjust to lawnmower pattern
     bool reverseVertices = false;
-    for (int i=0; i<transects.count(); i++) {
+    for (int i=0; i<geoTransects.count(); i++) {
         // We must reverse the vertices for every other transect in order to make a lawnmower pattern
-        QList<QGeoCoordinate> transectVertices = transects[i];
+        QList<QGeoCoordinate> transectVertices = geoTransects[i];
         if (reverseVertices) {
             reverseVertices = false;
             QList<QGeoCoordinate> reversedVertices;
@@ -799,11 +948,18 @@ void SurveyComplexItem::_rebuildTransectsPhase1WorkerSinglePolygon(bool refly)
         } else {
             reverseVertices = true;
         }
-        transects[i] = transectVertices;
+        geoTransects[i] = transectVertices;
     }
 
-    // Convert to CoordInfo transects and append to _transects
-    for (const QList<QGeoCoordinate>& transect : transects) {
+    // Alternate transects are spaced out for the turn radius on purpose, so they are left alone
+    if (params.optimizeTransectOrder && !params.flyAlternateTransects && !geoTransects.isEmpty()) {
+        const QGeoCoordinate start = transects.isEmpty() ? geoTransects.first().first() : transects.last().last().coord;
+        const double savedDistance = TransectRouteOptimizer::optimizeTransects(geoTransects, start, _optimizeTransectOrderEvaluations, _optimizeTransectOrderMaxMsecs);
+        qCDebug(SurveyComplexItemLog) << "_rebuildTransectsPhase1 optimized transect order, transit distance saved" << savedDistance;
+    }
+
+    // Convert to CoordInfo transects and append to transects
+    for (const QList<QGeoCoordinate>& transect : geoTransects) {
         QGeoCoordinate                                  coord;
         QList<TransectStyleComplexItem::CoordInfo_t>    coordInfoTransect;
         TransectStyleComplexItem::CoordInfo_t           coordInfo;
@@ -814,14 +970,14 @@ void SurveyComplexItem::_rebuildTransectsPhase1WorkerSinglePolygon(bool refly)
         coordInfoTransect.append(coordInfo);
 
         // For hover and capture we need points for each camera location within the transect
-        if (triggerCamera() && hoverAndCaptureEnabled()) {
+        if (params.hoverAndCapture) {
             double transectLength = transect[0].distanceTo(transect[1]);
             double transectAzimuth = transect[0].azimuthTo(transect[1]);
-            if (triggerDistance() < transectLength) {
-                int cInnerHoverPoints = static_cast<int>(floor(transectLength / triggerDistance()));
+            if (params.triggerDistance < transectLength) {
+                int cInnerHoverPoints = static_cast<int>(floor(transectLength / params.triggerDistance));
                 qCDebug(SurveyComplexItemLog) << "cInnerHoverPoints" << cInnerHoverPoints;
                 for (int i=0; i<cInnerHoverPoints; i++) {
-                    QGeoCoordinate hoverCoord = transect[0].atDistanceAndAzimuth(triggerDistance() * (i + 1), transectAzimuth);
+                    QGeoCoordinate hoverCoord = transect[0].atDistanceAndAzimuth(params.triggerDistance * (i + 1), transectAzimuth);
                     TransectStyleComplexItem::CoordInfo_t coordInfo = { hoverCoord, CoordTypeInteriorHoverTrigger };
                     coordInfoTransect.insert(1 + i, coordInfo);
                 }
@@ -829,29 +985,34 @@ void SurveyComplexItem::_rebuildTransectsPhase1WorkerSinglePolygon(bool refly)
         }
 
         // Extend the transect ends for turnaround
-        if (_hasTurnaround()) {
+        if (params.turnAroundDistance > 0) {
             QGeoCoordinate turnaroundCoord;
-            double turnAroundDistance = _turnAroundDistanceFact.rawValue().toDouble();
 
             double azimuth = transect[0].azimuthTo(transect[1]);
-            turnaroundCoord = transect[0].atDistanceAndAzimuth(-turnAroundDistance, azimuth);
+            turnaroundCoord = transect[0].atDistanceAndAzimuth(-params.turnAroundDistance, azimuth);
             turnaroundCoord.setAltitude(qQNaN());
             TransectStyleComplexItem::CoordInfo_t coordInfo = { turnaroundCoord, CoordTypeTurnaround };
             coordInfoTransect.prepend(coordInfo);
 
             azimuth = transect.last().azimuthTo(transect[transect.count() - 2]);
-            turnaroundCoord = transect.last().atDistanceAndAzimuth(-turnAroundDistance, azimuth);
+            turnaroundCoord = transect.last().atDistanceAndAzimuth(-params.turnAroundDistance, azimuth);
             turnaroundCoord.setAltitude(qQNaN());
             coordInfo = { turnaroundCoord, CoordTypeTurnaround };
             coordInfoTransect.append(coordInfo);
         }
 
-        _transects.append(coordInfoTransect);
+        transects.append(coordInfoTransect);
     }
+
+    if (progress) {
+        (void) progress(1.0);
+    }
+
+    return true;
 }
 
 #if 0
-    // Splitting polygons is not supported since this code would get stuck in a infinite loop
+    // Splitting polygons is not supported since the transects of the convex pieces are not stitched together yet
     // Code is left here in case someone wants to try to resurrect it
 
 void SurveyComplexItem::_rebuildTransectsPhase1WorkerSplitPolygons(bool refly)
@@ -875,6 +1036,7 @@ void SurveyComplexItem::_rebuildTransectsPhase1WorkerSplitPolygons(bool refly)
 
     QList<QPointF> polygonPoints;
     QGeoCoordinate tangentOrigin = _surveyAreaPolygon.pathModel().value<QGCQGeoCoordinate*>(0)->coordinate();
+    const QGCGeo::NedOrigin nedOrigin(tangentOrigin);
     qCDebug(SurveyComplexItemLog) << "_rebuildTransectsPhase1 Convert polygon to NED - _surveyAreaPolygon.count():tangentOrigin" << _surveyAreaPolygon.count() << tangentOrigin;
     for (int i=0; i<_surveyAreaPolygon.count(); i++) {
         double y, x, down;
@@ -883,7 +1045,7 @@ void SurveyComplexItem::_rebuildTransectsPhase1WorkerSplitPolygons(bool refly)
             // This avoids a nan calculation that comes out of convertGeoToNed
             x = y = 0;
         } else {
-            convertGeoToNed(vertex, tangentOrigin, y, x, down);
+            nedOrigin.convertGeoToNed(vertex, y, x, down);
         }
         polygonPoints += QPointF(x, y);
         qCDebug(SurveyComplexItemLog) << "_rebuildTransectsPhase1 vertex:x:y" << vertex << polygonPoints.last().x() << polygonPoints.last().y();
@@ -928,154 +1090,115 @@ void SurveyComplexItem::_rebuildTransectsPhase1WorkerSplitPolygons(bool refly)
         _rebuildTransectsFromPolygon(refly, *p, tangentOrigin, vMatch);
     }
 }
+#endif
 
+/// Decomposes a simple polygon into convex pieces with Hertel-Mehlhorn: the polygon is triangulated with earcut and then
+/// every diagonal whose removal keeps both of its end vertices convex is removed. This yields at most four times the
+/// minimum number of pieces.
+///     @param polygon Polygon vertices in either winding order, a closing vertex equal to the first one is ignored
+///     @param decomposedPolygons Convex pieces with counter-clockwise winding are appended to this list
 void SurveyComplexItem::_PolygonDecomposeConvex(const QPolygonF& polygon, QList<QPolygonF>& decomposedPolygons)
 {
-	// this follows "Mark Keil's Algorithm" https://mpen.ca/406/keil
-    int decompSize = std::numeric_limits<int>::max();
-    if (polygon.size() < 3) return;
-    if (polygon.size() == 3) {
-        decomposedPolygons << polygon;
+    QPolygonF vertices = polygon;
+    if ((vertices.count() > 1) && (vertices.first() == vertices.last())) {
+        vertices.removeLast();
+    }
+    if (vertices.count() < 3) {
         return;
     }
 
-    QList<QPolygonF> decomposedPolygonsMin{};
-
-    for (auto vertex = polygon.begin(); vertex != polygon.end(); ++vertex)
-    {
-        // is vertex reflex?
-        bool vertexIsReflex = _VertexIsReflex(polygon, vertex);
-
-        if (!vertexIsReflex) continue;
-
-        for (auto vertexOther = polygon.begin(); vertexOther != polygon.end(); ++vertexOther)
-        {
-            auto vertexBefore = vertex == polygon.begin() ? polygon.end() - 1 : vertex - 1;
-            auto vertexAfter = vertex == polygon.end() - 1 ? polygon.begin() : vertex + 1;
-            if (vertexOther == vertex) continue;
-            if (vertexAfter == vertexOther) continue;
-            if (vertexBefore == vertexOther) continue;
-            bool canSee = _VertexCanSeeOther(polygon, vertex, vertexOther);
-            if (!canSee) continue;
-
-            QPolygonF polyLeft;
-            auto v = vertex;
-            auto polyLeftContainsReflex = false;
-            while ( v != vertexOther) {
-                if (v != vertex && _VertexIsReflex(polygon, v)) {
-                    polyLeftContainsReflex = true;
-                }
-                polyLeft << *v;
-                ++v;
-                if (v == polygon.end()) v = polygon.begin();
-            }
-            polyLeft << *vertexOther;
-            auto polyLeftValid = !(polyLeftContainsReflex && polyLeft.size() == 3);
-
-            QPolygonF polyRight;
-            v = vertexOther;
-            auto polyRightContainsReflex = false;
-            while ( v != vertex) {
-                if (v != vertex && _VertexIsReflex(polygon, v)) {
-                    polyRightContainsReflex = true;
-                }
-                polyRight << *v;
-                ++v;
-                if (v == polygon.end()) v = polygon.begin();
-            }
-            polyRight << *vertex;
-            auto polyRightValid = !(polyRightContainsReflex && polyRight.size() == 3);
-
-            if (!polyLeftValid || ! polyRightValid) {
-//                decompSize = std::numeric_limits<int>::max();
-                continue;
-            }
+    std::vector<std::vector<std::array<double, 2>>> rings(1);
+    rings[0].reserve(vertices.count());
+    for (const QPointF& vertex : vertices) {
+        rings[0].push_back({ vertex.x(), vertex.y() });
+    }
+    const std::vector<uint32_t> indices = mapbox::earcut<uint32_t>(rings);
 
-            // recursion
-            QList<QPolygonF> polyLeftDecomposed{};
-            _PolygonDecomposeConvex(polyLeft, polyLeftDecomposed);
+    const auto cross = [&vertices](uint32_t a, uint32_t b, uint32_t c) {
+        const QPointF ab = vertices[b] - vertices[a];
+        const QPointF ac = vertices[c] - vertices[a];
+        return (ab.x() * ac.y()) - (ab.y() * ac.x());
+    };
 
-            QList<QPolygonF> polyRightDecomposed{};
-            _PolygonDecomposeConvex(polyRight, polyRightDecomposed);
+    // Half edges of the counter-clockwise triangles, merging two pieces unlinks a diagonal pair
+    struct HalfEdge_t {
+        uint32_t    origin;
+        int         next;
+        int         prev;
+        int         twin;
+        bool        removed;
+    };
+    QList<HalfEdge_t> halfEdges;
+    halfEdges.reserve(static_cast<qsizetype>(indices.size()));
+    QHash<quint64, int> edgeIndex;
+    edgeIndex.reserve(static_cast<qsizetype>(indices.size()));
+
+    for (size_t i=0; i+2<indices.size(); i+=3) {
+        uint32_t triangle[3] = { indices[i], indices[i + 1], indices[i + 2] };
+        if (cross(triangle[0], triangle[1], triangle[2]) < 0) {
+            std::swap(triangle[1], triangle[2]);
+        }
 
-            // compositon
-            auto subSize = polyLeftDecomposed.size() + polyRightDecomposed.size();
-            if ((polyLeftContainsReflex && polyLeftDecomposed.size() == 1)
-                    || (polyRightContainsReflex && polyRightDecomposed.size() == 1))
-            {
-                // don't accept polygons that contian reflex vertices and were not split
-                subSize = std::numeric_limits<int>::max();
-            }
-            if (subSize < decompSize) {
-                decompSize = subSize;
-                decomposedPolygonsMin = polyLeftDecomposed + polyRightDecomposed;
+        const int first = static_cast<int>(halfEdges.count());
+        for (int k=0; k<3; k++) {
+            const uint32_t origin = triangle[k];
+            const uint32_t dest = triangle[(k + 1) % 3];
+            const int index = first + k;
+
+            int twin = -1;
+            const auto twinIt = edgeIndex.constFind((static_cast<quint64>(dest) << 32) | origin);
+            if (twinIt != edgeIndex.cend()) {
+                twin = twinIt.value();
+                halfEdges[twin].twin = index;
             }
+            (void) edgeIndex.insert((static_cast<quint64>(origin) << 32) | dest, index);
+            halfEdges.append({ origin, first + ((k + 1) % 3), first + ((k + 2) % 3), twin, false });
         }
-
-    }
-
-    // assemble output
-    if (decomposedPolygonsMin.size() > 0) {
-        decomposedPolygons << decomposedPolygonsMin;
-    } else {
-        decomposedPolygons << polygon;
     }
 
-    return;
-}
+    // Each diagonal is visited once, from the half edge created last
+    for (int i=0; i<halfEdges.count(); i++) {
+        const int twin = halfEdges[i].twin;
+        if ((twin < 0) || (twin > i)) {
+            continue;
+        }
 
-bool SurveyComplexItem::_VertexCanSeeOther(const QPolygonF& polygon, const QPointF* vertexA, const QPointF* vertexB) {
-    if (vertexA == vertexB) return false;
-    auto vertexAAfter = vertexA + 1 == polygon.end() ? polygon.begin() : vertexA + 1;
-    auto vertexABefore = vertexA == polygon.begin() ? polygon.end() - 1 : vertexA - 1;
-    if (vertexAAfter == vertexB) return false;
-    if (vertexABefore == vertexB) return false;
-//    qCDebug(SurveyComplexItemLog) << "_VertexCanSeeOther false after first checks ";
-
-    bool visible = true;
-//    auto diff = *vertexA - *vertexB;
-    QLineF lineAB{*vertexA, *vertexB};
-    auto distanceAB = lineAB.length();//sqrtf(diff.x() * diff.x() + diff.y()*diff.y());
-
-//    qCDebug(SurveyComplexItemLog) << "_VertexCanSeeOther distanceAB " << distanceAB;
-    for (auto vertexC = polygon.begin(); vertexC != polygon.end(); ++vertexC)
-    {
-        if (vertexC == vertexA) continue;
-        if (vertexC == vertexB) continue;
-        auto vertexD = vertexC + 1 == polygon.end() ? polygon.begin() : vertexC + 1;
-        if (vertexD == vertexA) continue;
-        if (vertexD == vertexB) continue;
-        QLineF lineCD(*vertexC, *vertexD);
-        QPointF intersection{};
-
-        auto intersects = lineAB.intersects(lineCD, &intersection);
-        if (intersects == QLineF::IntersectType::BoundedIntersection) {
-//            auto diffIntersection = *vertexA - intersection;
-//            auto distanceIntersection = sqrtf(diffIntersection.x() * diffIntersection.x() + diffIntersection.y()*diffIntersection.y());
-//            qCDebug(SurveyComplexItemLog) << "*vertexA " << *vertexA << "*vertexB " << *vertexB  << " intersection " << intersection;
-
-            QLineF lineIntersection{*vertexA, intersection};
-            auto distanceIntersection = lineIntersection.length();//sqrtf(diff.x() * diff.x() + diff.y()*diff.y());
-            qCDebug(SurveyComplexItemLog) << "_VertexCanSeeOther distanceIntersection " << distanceIntersection;
-            if (distanceIntersection < distanceAB) {
-                visible = false;
-                break;
-            }
+        const HalfEdge_t edge = halfEdges[i];
+        const HalfEdge_t twinEdge = halfEdges[twin];
+        const uint32_t a = edge.origin;
+        const uint32_t b = twinEdge.origin;
+
+        // Without the diagonal a is reached along edge.prev and left along twin.next, likewise for b
+        const uint32_t beforeA = halfEdges[edge.prev].origin;
+        const uint32_t afterA = halfEdges[halfEdges[twinEdge.next].next].origin;
+        const uint32_t beforeB = halfEdges[twinEdge.prev].origin;
+        const uint32_t afterB = halfEdges[halfEdges[edge.next].next].origin;
+        if ((cross(beforeA, a, afterA) < 0) || (cross(beforeB, b, afterB) < 0)) {
+            continue;
         }
 
+        halfEdges[edge.prev].next = twinEdge.next;
+        halfEdges[twinEdge.next].prev = edge.prev;
+        halfEdges[twinEdge.prev].next = edge.next;
+        halfEdges[edge.next].prev = twinEdge.prev;
+        halfEdges[i].removed = true;
+        halfEdges[twin].removed = true;
     }
 
-    return visible;
-}
-
-bool SurveyComplexItem::_VertexIsReflex(const QPolygonF& polygon, QList<QPointF>::const_iterator& vertexIter) {
-    auto vertexBefore = vertex == polygon.begin() ? polygon.end() - 1 : vertex - 1;
-    auto vertexAfter = vertex == polygon.end() - 1 ? polygon.begin() : vertex + 1;
-    auto area = (((vertex->x() - vertexBefore->x())*(vertexAfter->y() - vertexBefore->y()))-((vertexAfter->x() - vertexBefore->x())*(vertex->y() - vertexBefore->y())));
-    return area > 0;
+    QList<bool> visited(halfEdges.count(), false);
+    for (int i=0; i<halfEdges.count(); i++) {
+        if (halfEdges[i].removed || visited[i]) {
+            continue;
+        }
 
+        QPolygonF piece;
+        for (int edge=i; !visited[edge]; edge=halfEdges[edge].next) {
+            visited[edge] = true;
+            piece << vertices[halfEdges[edge].origin];
+        }
+        decomposedPolygons << piece;
+    }
 }
-#endif
 
 void SurveyComplexItem::_rebuildTransectsFromPolygon(bool refly, const QPolygonF& polygon, const QGeoCoordinate& tangentOrigin, const QPointF* const transitionPoint)
 {
@@ -1147,12 +1270,13 @@ void SurveyComplexItem::_rebuildTransectsFromPolygon(bool refly, const QPolygonF
     _adjustLineDirection(intersectLines, resultLines);
 
     // Convert from NED to Geo
+    const QGCGeo::NedOrigin nedOrigin(tangentOrigin);
     QList<QList<QGeoCoordinate>> transects;
 
     if (transitionPoint != nullptr) {
         QList<QGeoCoordinate>   transect;
         QGeoCoordinate          coord;
-        QGCGeo::convertNedToGeo(transitionPoint->y(), transitionPoint->x(), 0, tangentOrigin, coord);
+        nedOrigin.convertNedToGeo(transitionPoint->y(), transitionPoint->x(), 0, coord);
         transect.append(coord);
         transect.append(coord); //TODO
         transects.append(transect);
@@ -1162,15 +1286,15 @@ void SurveyComplexItem::_rebuildTransectsFromPolygon(bool refly, const QPolygonF
         QList<QGeoCoordinate>   transect;
         QGeoCoordinate          coord;
 
-        QGCGeo::convertNedToGeo(line.p1().y(), line.p1().x(), 0, tangentOrigin, coord);
+        nedOrigin.convertNedToGeo(line.p1().y(), line.p1().x(), 0, coord);
         transect.append(coord);
-        QGCGeo::convertNedToGeo(line.p2().y(), line.p2().x(), 0, tangentOrigin, coord);
+        nedOrigin.convertNedToGeo(line.p2().y(), line.p2().x(), 0, coord);
         transect.append(coord);
 
         transects.append(transect);
     }
 
-    _adjustTransectsToEntryPointLocation(transects);
+    _adjustTransectsToEntryPointLocation(transects, _entryPoint);
 
     if (refly) {
         _optimizeTransectsForShortestDistance(_transects.last().last().coord, transects);
@@ -23,6 +23,8 @@ class SurveyComplexItem : public TransectStyleComplexItem
 {
     Q_OBJECT
 
+    friend class SurveyComplexItemTest;
+
 public:
     /// @param flyView true: Created for use in the Fly View, false: Created for use in the Plan View
     /// @param kmlOrShpFile Polygon comes from this file, empty for default polygon
@@ -31,11 +33,13 @@ public:
     Q_PROPERTY(Fact*            gridAngle              READ gridAngle              CONSTANT)
     Q_PROPERTY(Fact*            flyAlternateTransects  READ flyAlternateTransects  CONSTANT)
     Q_PROPERTY(Fact*            splitConcavePolygons   READ splitConcavePolygons   CONSTANT)
+    Q_PROPERTY(Fact*            optimizeTransectOrder  READ optimizeTransectOrder  CONSTANT)
     Q_PROPERTY(QGeoCoordinate   centerCoordinate       READ centerCoordinate       WRITE setCenterCoordinate)
 
     Fact* gridAngle             (void) { return &_gridAngleFact; }
     Fact* flyAlternateTransects (void) { return &_flyAlternateTransectsFact; }
     Fact* splitConcavePolygons  (void) { return &_splitConcavePolygonsFact; }
+    Fact* optimizeTransectOrder (void) { return &_optimizeTransectOrderFact; }
 
     Q_INVOKABLE void rotateEntryPoint(void);
 
@@ -46,6 +50,7 @@ public:
     QString         presetsSettingsGroup(void) { return settingsGroup; }
     void            savePreset          (const QString& name);
     void            loadPreset          (const QString& name);
+    bool            applyPreset         (const QJsonObject& presetObject, QString& errorString) final;
     bool            isSurveyItem        (void) const final { return true; }
     QGeoCoordinate  centerCoordinate    (void) const { return _surveyAreaPolygon.center(); }
     void            setCenterCoordinate (const QGeoCoordinate& coordinate) { _surveyAreaPolygon.setCenter(coordinate); }
@@ -82,6 +87,7 @@ public:
     static constexpr const char* gridEntryLocationName =      "GridEntryLocation";
     static constexpr const char* flyAlternateTransectsName =  "FlyAlternateTransects";
     static constexpr const char* splitConcavePolygonsName =   "SplitConcavePolygons";
+    static constexpr const char* optimizeTransectOrderName =  "OptimizeTransectOrder";
 
 signals:
     void refly90DegreesChanged(bool refly90Degrees);
@@ -94,6 +100,9 @@ private slots:
     void _recalcCameraShots             (void) final;
 
 private:
+    // Overrides from TransectStyleComplexItem
+    RebuildTransectsJob_t _rebuildTransectsJob(void) final;
+
     enum CameraTriggerCode {
         CameraTriggerNone,
         CameraTriggerOn,
@@ -101,21 +110,35 @@ private:
         CameraTriggerHoverAndCapture
     };
 
-    QPointF _rotatePoint(const QPointF& point, const QPointF& origin, double angle);
+    /// Inputs to transect generation, captured on the GUI thread so the transects can be built on a worker thread
+    struct TransectParams_t {
+        QList<QGeoCoordinate>   polygon;
+        double                  gridAngle =             0;
+        double                  gridSpacing =           0;
+        bool                    refly90Degrees =        false;
+        bool                    flyAlternateTransects = false;
+        bool                    optimizeTransectOrder = false;
+        int                     entryPoint =            EntryLocationTopLeft;
+        bool                    hoverAndCapture =       false;
+        double                  triggerDistance =       0;
+        double                  turnAroundDistance =    0;  ///< 0 for no turnaround
+    };
+
+    static QPointF _rotatePoint(const QPointF& point, const QPointF& origin, double angle);
     void _intersectLinesWithRect(const QList<QLineF>& lineList, const QRectF& boundRect, QList<QLineF>& resultLines);
-    void _intersectLinesWithPolygon(const QList<QLineF>& lineList, const QPolygonF& polygon, QList<QLineF>& resultLines);
-    void _adjustLineDirection(const QList<QLineF>& lineList, QList<QLineF>& resultLines);
+    static void _intersectLinesWithPolygon(const QList<QLineF>& lineList, const QPolygonF& polygon, QList<QLineF>& resultLines);
+    static void _adjustLineDirection(const QList<QLineF>& lineList, QList<QLineF>& resultLines);
     bool _nextTransectCoord(const QList<QGeoCoordinate>& transectPoints, int pointIndex, QGeoCoordinate& coord);
     bool _appendMissionItemsWorker(QList<MissionItem*>& items, QObject* missionItemParent, int& seqNum, bool hasRefly, bool buildRefly);
-    void _optimizeTransectsForShortestDistance(const QGeoCoordinate& distanceCoord, QList<QList<QGeoCoordinate>>& transects);
+    static void _optimizeTransectsForShortestDistance(const QGeoCoordinate& distanceCoord, QList<QList<QGeoCoordinate>>& transects);
     qreal _ccw(QPointF pt1, QPointF pt2, QPointF pt3);
     qreal _dp(QPointF pt1, QPointF pt2);
     void _swapPoints(QList<QPointF>& points, int index1, int index2);
-    void _reverseTransectOrder(QList<QList<QGeoCoordinate>>& transects);
-    void _reverseInternalTransectPoints(QList<QList<QGeoCoordinate>>& transects);
-    void _adjustTransectsToEntryPointLocation(QList<QList<QGeoCoordinate>>& transects);
+    static void _reverseTransectOrder(QList<QList<QGeoCoordinate>>& transects);
+    static void _reverseInternalTransectPoints(QList<QList<QGeoCoordinate>>& transects);
+    static void _adjustTransectsToEntryPointLocation(QList<QList<QGeoCoordinate>>& transects, int entryPoint);
     bool _gridAngleIsNorthSouthTransects();
-    double _clampGridAngle90(double gridAngle);
+    static double _clampGridAngle90(double gridAngle);
     bool _imagesEverywhere(void) const;
     bool _triggerCamera(void) const;
     bool _hasTurnaround(void) const;
@@ -125,21 +148,23 @@ private:
     bool _loadV4V5(const QJsonObject& complexObject, int sequenceNumber, QString& errorString, int version, bool forPresets);
     void _saveCommon(QJsonObject& complexObject);
     void _rebuildTransectsPhase1Worker(bool refly);
-    void _rebuildTransectsPhase1WorkerSinglePolygon(bool refly);
+    void _clearLoadedMissionItems(void);
+    TransectParams_t _transectParams(void) const;
+    /// Rough count of line/edge intersections needed to build the transects
+    static double _transectWorkEstimate(const TransectParams_t& params);
+    static QList<QList<CoordInfo_t>> _buildTransects(const TransectParams_t& params, const std::function<bool(double)>& progress);
+    static bool _buildTransectsSinglePolygon(const TransectParams_t& params, bool refly, QList<QList<CoordInfo_t>>& transects, const std::function<bool(double)>& progress);
     /// Adds to the _transects array from one polygon
     void _rebuildTransectsFromPolygon(bool refly, const QPolygonF& polygon, const QGeoCoordinate& tangentOrigin, const QPointF* const transitionPoint);
 
+    // Decompose polygon into list of convex sub polygons
+    static void _PolygonDecomposeConvex(const QPolygonF& polygon, QList<QPolygonF>& decomposedPolygons);
+
 #if 0
-    // Splitting polygons is not supported since this code would get stuck in a infinite loop
+    // Splitting polygons is not supported since the transects of the convex pieces are not stitched together yet
     // Code is left here in case someone wants to try to resurrect it
 
     void _rebuildTransectsPhase1WorkerSplitPolygons(bool refly);
-
-    // Decompose polygon into list of convex sub polygons
-    void _PolygonDecomposeConvex(const QPolygonF& polygon, QList<QPolygonF>& decomposedPolygons);
-    // return true if vertex a can see vertex b
-    bool _VertexCanSeeOther(const QPolygonF& polygon, const QPointF* vertexA, const QPointF* vertexB);
-    bool _VertexIsReflex(const QPolygonF& polygon, QList<QPointF>::const_iterator& vertexIter);
 #endif
 
     QMap<QString, FactMetaData*> _metaDataMap;
@@ -147,8 +172,14 @@ private:
     SettingsFact    _gridAngleFact;
     SettingsFact    _flyAlternateTransectsFact;
     SettingsFact    _splitConcavePolygonsFact;
+    SettingsFact    _optimizeTransectOrderFact;
     int             _entryPoint;
 
+    static constexpr double _rebuildTransectsJobMinWork =   200000; ///< Smaller surveys are built synchronously
+    static constexpr int    _intersectLinesChunkSize =      64;     ///< Lines intersected between cancellation checks
+    static constexpr qint64 _optimizeTransectOrderEvaluations = 20000000;  ///< Move evaluations per start when ordering the transects of one pass
+    static constexpr int    _optimizeTransectOrderMaxMsecs =    5000;       ///< Safety cap only, the order depends on the evaluation budget
+
     static constexpr const char* _jsonGridAngleKey =          "angle";
     static constexpr const char* _jsonEntryPointKey =         "entryLocation";
 
@@ -179,4 +210,5 @@ private:
     static constexpr const char* _jsonV3Refly90DegreesKey =               "refly90Degrees";
     static constexpr const char* _jsonFlyAlternateTransectsKey =          "flyAlternateTransects";
     static constexpr const char* _jsonSplitConcavePolygonsKey =           "splitConcavePolygons";
+    static constexpr const char* _jsonOptimizeTransectOrderKey =          "optimizeTransectOrder";
 };
@@ -0,0 +1,318 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TransectRouteOptimizer.h"
+#include "QGCGeo.h"
+#include "QGCLoggingCategory.h"
+
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QThread>
+#include <QtCore/QtMath>
+
+#include <algorithm>
+
+QGC_LOGGING_CATEGORY(TransectRouteOptimizerLog, "TransectRouteOptimizerLog")
+
+TransectRouteOptimizer::TransectRouteOptimizer(const QList<QPointF>& entries, const QList<QPointF>& exits, const QPointF& start)
+    : _entries  (entries)
+    , _exits    (exits)
+    , _start    (start)
+{
+    Q_ASSERT(_entries.count() == _exits.count());
+}
+
+double TransectRouteOptimizer::_distance(const QPointF& p1, const QPointF& p2)
+{
+    return qSqrt(((p2.x() - p1.x()) * (p2.x() - p1.x())) + ((p2.y() - p1.y()) * (p2.y() - p1.y())));
+}
+
+double TransectRouteOptimizer::transitDistance(const Route_t& route) const
+{
+    double distance = 0;
+    QPointF previous = _start;
+    for (const Visit_t& visit : route) {
+        distance += _distance(previous, _in(visit));
+        previous = _out(visit);
+    }
+    return distance;
+}
+
+/// Nearest neighbour route. Seed 0 always takes the nearest transect, other seeds pick randomly among the few nearest
+/// ones to give the parallel improvement runs different starting points.
+TransectRouteOptimizer::Route_t TransectRouteOptimizer::_greedyRoute(quint32 seed) const
+{
+    static constexpr int candidateCount = 3;
+
+    const int transectCount = _entries.count();
+    QRandomGenerator random(seed);
+    QList<bool> visited(transectCount, false);
+    Route_t route;
+    route.reserve(transectCount);
+
+    QPointF position = _start;
+    for (int step=0; step<transectCount; step++) {
+        // Keep the nearest few candidates sorted by distance
+        Visit_t candidates[candidateCount];
+        double candidateDistances[candidateCount];
+        int foundCount = 0;
+
+        for (int i=0; i<transectCount; i++) {
+            if (visited[i]) {
+                continue;
+            }
+            for (const bool reversed : { false, true }) {
+                const Visit_t visit = { i, reversed };
+                const double distance = _distance(position, _in(visit));
+
+                int insertIndex = foundCount;
+                while (insertIndex > 0 && distance < candidateDistances[insertIndex - 1]) {
+                    insertIndex--;
+                }
+                if (insertIndex >= candidateCount) {
+                    continue;
+                }
+                for (int j=qMin(foundCount, candidateCount - 1); j>insertIndex; j--) {
+                    candidates[j] = candidates[j - 1];
+                    candidateDistances[j] = candidateDistances[j - 1];
+                }
+                candidates[insertIndex] = visit;
+                candidateDistances[insertIndex] = distance;
+                foundCount = qMin(foundCount + 1, candidateCount);
+            }
+        }
+
+        const Visit_t& next = candidates[(seed == 0) ? 0 : random.bounded(foundCount)];
+        visited[next.transect] = true;
+        route.append(next);
+        position = _out(next);
+    }
+
+    return route;
+}
+
+/// Reverses a section of the route, which also flips the direction of every transect within it.
+/// @return true if the route was improved
+bool TransectRouteOptimizer::_improveTwoOpt(Route_t& route, Budget_t& budget) const
+{
+    const int count = route.count();
+    bool improved = false;
+
+    for (int i=0; i<count; i++) {
+        if (_budgetExhausted(budget)) {
+            break;
+        }
+        budget.evaluationsLeft -= count - i;
+
+        const QPointF previousOut = (i == 0) ? _start : _out(route[i - 1]);
+        const QPointF sectionIn = _in(route[i]);
+        const double previousEdge = _distance(previousOut, sectionIn);
+
+        for (int j=i; j<count; j++) {
+            const QPointF sectionOut = _out(route[j]);
+
+            // Edges within the section keep their length when it is reversed
+            double delta = _distance(previousOut, sectionOut) - previousEdge;
+            if (j < count - 1) {
+                const QPointF nextIn = _in(route[j + 1]);
+                delta += _distance(sectionIn, nextIn) - _distance(sectionOut, nextIn);
+            }
+
+            if (delta < -_minImprovement) {
+                std::reverse(route.begin() + i, route.begin() + j + 1);
+                for (int k=i; k<=j; k++) {
+                    route[k].reversed = !route[k].reversed;
+                }
+                improved = true;
+                break;
+            }
+        }
+    }
+
+    return improved;
+}
+
+/// Moves a short chain of transects to another place in the route, optionally reversed.
+/// @return true if the route was improved
+bool TransectRouteOptimizer::_improveOrOpt(Route_t& route, Budget_t& budget) const
+{
+    const int count = route.count();
+    bool improved = false;
+
+    for (int chainLength=1; chainLength<=_maxOrOptChainLength && chainLength<count; chainLength++) {
+        for (int i=0; i+chainLength<=count; i++) {
+            if (_budgetExhausted(budget)) {
+                return improved;
+            }
+            budget.evaluationsLeft -= 2 * (count + 1);
+
+            const int last = i + chainLength - 1;
+            const QPointF previousOut = (i == 0) ? _start : _out(route[i - 1]);
+            double removeGain = _distance(previousOut, _in(route[i]));
+            if (last < count - 1) {
+                const QPointF nextIn = _in(route[last + 1]);
+                removeGain += _distance(_out(route[last]), nextIn) - _distance(previousOut, nextIn);
+            }
+
+            bool moved = false;
+            for (int flip=0; flip<2 && !moved; flip++) {
+                const QPointF chainIn = flip ? _out(route[last]) : _in(route[i]);
+                const QPointF chainOut = flip ? _in(route[i]) : _out(route[last]);
+
+                // Insert after position p of the current route, -1 being the start
+                for (int p=-1; p<count; p++) {
+                    if (p >= i - 1 && p <= last) {
+                        continue;
+                    }
+
+                    const QPointF insertOut = (p < 0) ? _start : _out(route[p]);
+                    double insertCost = _distance(insertOut, chainIn);
+                    if (p + 1 < count) {
+                        const QPointF insertIn = _in(route[p + 1]);
+                        insertCost += _distance(chainOut, insertIn) - _distance(insertOut, insertIn);
+                    }
+
+                    if (insertCost - removeGain < -_minImprovement) {
+                        Route_t chain = route.mid(i, chainLength);
+                        if (flip) {
+                            std::reverse(chain.begin(), chain.end());
+                            for (Visit_t& visit : chain) {
+                                visit.reversed = !visit.reversed;
+                            }
+                        }
+                        route.remove(i, chainLength);
+                        const int insertIndex = (p < i) ? p + 1 : p + 1 - chainLength;
+                        for (int k=0; k<chainLength; k++) {
+                            route.insert(insertIndex + k, chain[k]);
+                        }
+                        improved = true;
+                        moved = true;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    return improved;
+}
+
+void TransectRouteOptimizer::_improve(Route_t& route, Budget_t& budget) const
+{
+    while (!_budgetExhausted(budget)) {
+        const bool twoOptImproved = _improveTwoOpt(route, budget);
+        const bool orOptImproved = _improveOrOpt(route, budget);
+        if (!twoOptImproved && !orOptImproved) {
+            break;
+        }
+    }
+}
+
+TransectRouteOptimizer::Route_t TransectRouteOptimizer::optimize(const Route_t& initialRoute, qint64 evaluationBudget, int maxMsecs) const
+{
+    if (initialRoute.count() < 2) {
+        return initialRoute;
+    }
+
+    typedef struct {
+        quint32 seed;
+        Route_t route;
+        double  distance;
+        bool    timedOut;
+    } Run_t;
+
+    // The initial route is improved along with the greedy ones, so the result is never worse than it
+    QList<Run_t> runs(_runCount);
+    for (int i=0; i<_runCount; i++) {
+        runs[i].seed = static_cast<quint32>(i - 1);
+    }
+    runs[0].route = initialRoute;
+
+    const QDeadlineTimer deadline(maxMsecs);
+    QElapsedTimer timer;
+    timer.start();
+
+    const auto improveRun = [this, evaluationBudget, &deadline](Run_t& run) {
+        if (run.route.isEmpty()) {
+            run.route = _greedyRoute(run.seed);
+        }
+        Budget_t budget = { evaluationBudget, deadline };
+        _improve(run.route, budget);
+        run.timedOut = (budget.evaluationsLeft > 0) && budget.deadline.hasExpired();
+        run.distance = transitDistance(run.route);
+    };
+
+    // The GUI thread never blocks on the pool, the runs are done in turn there instead
+    const QCoreApplication* app = QCoreApplication::instance();
+    if (app && (QThread::currentThread() == app->thread())) {
+        for (Run_t& run : runs) {
+            improveRun(run);
+        }
+    } else {
+        QtConcurrent::blockingMap(runs, improveRun);
+    }
+
+    // Earliest run wins ties so the result is stable
+    int bestIndex = 0;
+    for (int i=1; i<runs.count(); i++) {
+        if (runs[i].distance < runs[bestIndex].distance - _minImprovement) {
+            bestIndex = i;
+        }
+    }
+
+    const bool timedOut = std::any_of(runs.cbegin(), runs.cend(), [](const Run_t& run) { return run.timedOut; });
+    if (timedOut) {
+        qCWarning(TransectRouteOptimizerLog) << "optimize reached the time cap, transect order may differ between runs" << initialRoute.count() << maxMsecs;
+    }
+    qCDebug(TransectRouteOptimizerLog) << "optimize transects:msecs" << initialRoute.count() << timer.elapsed()
+                                       << "distance initial:optimized" << transitDistance(initialRoute) << runs[bestIndex].distance;
+
+    return runs[bestIndex].route;
+}
+
+double TransectRouteOptimizer::optimizeTransects(QList<QList<QGeoCoordinate>>& transects, const QGeoCoordinate& start, qint64 evaluationBudget, int maxMsecs)
+{
+    if (transects.count() < 2) {
+        return 0;
+    }
+
+    const QGCGeo::NedOrigin nedOrigin(start);
+    const auto toLocal = [&nedOrigin](const QGeoCoordinate& coord) {
+        double north, east, down;
+        nedOrigin.convertGeoToNed(coord, north, east, down);
+        return QPointF(east, north);
+    };
+
+    QList<QPointF> entries;
+    QList<QPointF> exits;
+    Route_t initialRoute;
+    for (int i=0; i<transects.count(); i++) {
+        entries.append(toLocal(transects[i].first()));
+        exits.append(toLocal(transects[i].last()));
+        initialRoute.append({ i, false });
+    }
+
+    const TransectRouteOptimizer optimizer(entries, exits, QPointF(0, 0));
+    const Route_t route = optimizer.optimize(initialRoute, evaluationBudget, maxMsecs);
+
+    QList<QList<QGeoCoordinate>> optimizedTransects;
+    optimizedTransects.reserve(transects.count());
+    for (const Visit_t& visit : route) {
+        QList<QGeoCoordinate> transect = transects[visit.transect];
+        if (visit.reversed) {
+            std::reverse(transect.begin(), transect.end());
+        }
+        optimizedTransects.append(transect);
+    }
+    transects = optimizedTransects;
+
+    return optimizer.transitDistance(initialRoute) - optimizer.transitDistance(route);
+}
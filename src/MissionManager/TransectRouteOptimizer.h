@@ -0,0 +1,82 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QList>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QPointF>
+#include <QtPositioning/QGeoCoordinate>
+
+Q_DECLARE_LOGGING_CATEGORY(TransectRouteOptimizerLog)
+
+/// Orders a set of transects such that the distance flown between them is as short as possible. Each transect can be
+/// flown in either direction, so this is a travelling salesman problem with a direction choice per transect. The route
+/// is open: it starts at a given point and ends at the exit of the last transect.
+///
+/// A greedy route plus the initial route are improved with 2-opt and Or-opt moves. A fixed number of seeded starts are
+/// improved and the shortest result wins. Each start is limited to a fixed number of move evaluations, so the same
+/// transects always give the same route whatever the machine or its load. The starts run in parallel when not called
+/// on the GUI thread.
+class TransectRouteOptimizer
+{
+public:
+    typedef struct {
+        int     transect;   ///< Index into the transect list
+        bool    reversed;   ///< true: Transect is flown from exit to entry
+    } Visit_t;
+
+    typedef QList<Visit_t> Route_t;
+
+    /// @param entries Entry point of each transect in a local planar frame in meters
+    /// @param exits Exit point of each transect in the same frame
+    /// @param start Point the route starts from
+    TransectRouteOptimizer(const QList<QPointF>& entries, const QList<QPointF>& exits, const QPointF& start);
+
+    /// Distance flown between the start and the transects, not counting the transects themselves
+    double transitDistance(const Route_t& route) const;
+
+    /// @param evaluationBudget Move evaluations allowed per start, the route only depends on this
+    /// @param maxMsecs Safety cap on the wall time, the route is no longer reproducible if it is reached
+    /// @return Route which is never longer than initialRoute
+    Route_t optimize(const Route_t& initialRoute, qint64 evaluationBudget, int maxMsecs) const;
+
+    /// Reorders and reverses the transects in place
+    ///     @param transects Transects as lists of coordinates, the first and last coordinate are the entry and exit
+    ///     @param start Coordinate the route starts from
+    /// @return Transit distance saved in meters
+    static double optimizeTransects(QList<QList<QGeoCoordinate>>& transects, const QGeoCoordinate& start, qint64 evaluationBudget, int maxMsecs);
+
+private:
+    typedef struct {
+        qint64          evaluationsLeft;
+        QDeadlineTimer  deadline;
+    } Budget_t;
+
+    static bool _budgetExhausted(const Budget_t& budget) { return (budget.evaluationsLeft <= 0) || budget.deadline.hasExpired(); }
+
+    QPointF _in (const Visit_t& visit) const { return visit.reversed ? _exits[visit.transect] : _entries[visit.transect]; }
+    QPointF _out(const Visit_t& visit) const { return visit.reversed ? _entries[visit.transect] : _exits[visit.transect]; }
+
+    Route_t _greedyRoute        (quint32 seed) const;
+    void    _improve            (Route_t& route, Budget_t& budget) const;
+    bool    _improveTwoOpt      (Route_t& route, Budget_t& budget) const;
+    bool    _improveOrOpt       (Route_t& route, Budget_t& budget) const;
+
+    static double _distance(const QPointF& p1, const QPointF& p2);
+
+    QList<QPointF>  _entries;
+    QList<QPointF>  _exits;
+    QPointF         _start;
+
+    static constexpr int    _maxOrOptChainLength =  3;
+    static constexpr int    _runCount =             4;      ///< Fixed so the route does not depend on the core count
+    static constexpr double _minImprovement =       1e-6;   ///< Meters, smaller gains are treated as noise
+};
@@ -19,8 +19,10 @@
 #include "FirmwarePlugin.h"
 #include "KMLPlanDomDocument.h"
 #include "Vehicle.h"
+#include "QGCGeo.h"
 #include "QGCLoggingCategory.h"
 
+#include <QtConcurrent/QtConcurrentRun>
 #include <QtCore/QJsonArray>
 
 QGC_LOGGING_CATEGORY(TransectStyleComplexItemLog, "TransectStyleComplexItemLog")
@@ -41,6 +43,12 @@ TransectStyleComplexItem::TransectStyleComplexItem(PlanMasterController* masterC
     _terrainPolyPathQueryTimer.setSingleShot(true);
     connect(&_terrainPolyPathQueryTimer, &QTimer::timeout, this, &TransectStyleComplexItem::_reallyQueryTransectsPathHeightInfo);
 
+    connect(&_rebuildTransectsWatcher, &QFutureWatcherBase::finished,                  this, &TransectStyleComplexItem::_rebuildTransectsJobFinished);
+    connect(&_rebuildTransectsWatcher, &QFutureWatcherBase::progressValueChanged,      this, [this](int progressValue) {
+        _setRebuildTransectsProgress(static_cast<double>(progressValue) / _rebuildTransectsProgressSteps);
+    });
+    connect(&_terrainAdjustWatcher,    &QFutureWatcherBase::finished,                  this, &TransectStyleComplexItem::_terrainAdjustJobFinished);
+
     // The follow is used to compress multiple recalc calls in a row to into a single call.
     connect(this, &TransectStyleComplexItem::_updateFlightPathSegmentsSignal, this, &TransectStyleComplexItem::_updateFlightPathSegmentsDontCallDirectly,   Qt::QueuedConnection);
     qgcApp()->addCompressedSignal(QMetaMethod::fromSignal(&TransectStyleComplexItem::_updateFlightPathSegmentsSignal));
@@ -128,6 +136,9 @@ void TransectStyleComplexItem::setDirty(bool dirty)
 
 void TransectStyleComplexItem::_save(QJsonObject& complexObject)
 {
+    _waitForRebuildTransectsJob();
+    _waitForTerrainAdjustJob();
+
     QJsonObject innerObject;
 
     innerObject[JsonHelper::jsonVersionKey] =       2;
@@ -388,11 +399,118 @@ void TransectStyleComplexItem::_rebuildTransects(void)
         return;
     }
 
+    const RebuildTransectsJob_t job = _rebuildTransectsJob();
+    if (job) {
+        // The current transects stay in place until the job delivers the new ones
+        _startRebuildTransectsJob(job);
+        return;
+    }
+
+    _cancelRebuildTransectsJob();
+
     _transects.clear();
     _rgPathHeightInfo.clear();
     _rgFlightPathCoordInfo.clear();
 
     _rebuildTransectsPhase1();
+    _rebuildTransectsPhase2();
+}
+
+void TransectStyleComplexItem::_startRebuildTransectsJob(const RebuildTransectsJob_t& job)
+{
+    // A job still running for older inputs is stopped, its result would be discarded anyway
+    if (_rebuildingTransects) {
+        _rebuildTransectsWatcher.cancel();
+    }
+
+    const quint64 version = ++_rebuildTransectsVersion;
+    qCDebug(TransectStyleComplexItemLog) << "_startRebuildTransectsJob version" << version;
+
+    _setRebuildTransectsProgress(0);
+    _setRebuildingTransects(true);
+
+    _rebuildTransectsWatcher.setFuture(QtConcurrent::run([job, version](QPromise<RebuildTransectsResult_t>& promise) {
+        promise.setProgressRange(0, _rebuildTransectsProgressSteps);
+
+        const auto progress = [&promise](double fraction) {
+            if (promise.isCanceled()) {
+                return false;
+            }
+            promise.setProgressValue(qRound(fraction * _rebuildTransectsProgressSteps));
+            return true;
+        };
+
+        RebuildTransectsResult_t result;
+        result.version = version;
+        result.transects = job(progress);
+        if (!promise.isCanceled()) {
+            (void) promise.addResult(result);
+        }
+    }));
+}
+
+void TransectStyleComplexItem::_cancelRebuildTransectsJob(void)
+{
+    if (!_rebuildingTransects) {
+        return;
+    }
+
+    // Bumping the version discards the result should the job already have delivered it
+    _rebuildTransectsVersion++;
+    _rebuildTransectsWatcher.cancel();
+    _setRebuildingTransects(false);
+}
+
+void TransectStyleComplexItem::_rebuildTransectsJobFinished(void)
+{
+    if (!_rebuildingTransects) {
+        // Already applied by _waitForRebuildTransectsJob
+        return;
+    }
+
+    const QFuture<RebuildTransectsResult_t> future = _rebuildTransectsWatcher.future();
+    if (future.isCanceled() || (future.resultCount() == 0) || (future.result().version != _rebuildTransectsVersion)) {
+        qCDebug(TransectStyleComplexItemLog) << "_rebuildTransectsJobFinished discarding stale result";
+        return;
+    }
+
+    // Applied in one go so nothing ever sees a partially built set of transects
+    _transects = future.result().transects;
+    _rgPathHeightInfo.clear();
+    _rgFlightPathCoordInfo.clear();
+    _setRebuildingTransects(false);
+
+    _rebuildTransectsPhase2();
+}
+
+void TransectStyleComplexItem::_waitForRebuildTransectsJob(void)
+{
+    if (_rebuildingTransects) {
+        _rebuildTransectsWatcher.waitForFinished();
+        _rebuildTransectsJobFinished();
+    }
+}
+
+void TransectStyleComplexItem::_setRebuildingTransects(bool rebuildingTransects)
+{
+    if (rebuildingTransects != _rebuildingTransects) {
+        _rebuildingTransects = rebuildingTransects;
+        emit rebuildingTransectsChanged(_rebuildingTransects);
+    }
+}
+
+void TransectStyleComplexItem::_setRebuildTransectsProgress(double progress)
+{
+    if (!QGC::fuzzyCompare(progress, _rebuildTransectsProgress)) {
+        _rebuildTransectsProgress = progress;
+        emit rebuildTransectsProgressChanged(_rebuildTransectsProgress);
+    }
+}
+
+void TransectStyleComplexItem::_rebuildTransectsPhase2(void)
+{
+    // A terrain adjust still running was based on the old transects
+    _cancelTerrainAdjustJob();
 
     _minAMSLAltitude = _maxAMSLAltitude = qQNaN();
 
@@ -660,8 +778,8 @@ TransectStyleComplexItem::ReadyForSaveState TransectStyleComplexItem::readyForSa
             // We have loaded mission items. Everything is ready to go.
             terrainReady = true;
         } else {
-            // Survey is currently being designed. We aren't ready if we don't have terrain heights yet.
-            terrainReady = _rgPathHeightInfo.count();
+            // Survey is currently being designed. We aren't ready if we don't have terrain heights yet, or they are still being applied.
+            terrainReady = _rgPathHeightInfo.count() && !_adjustingForTerrain;
         }
     } else {
         // Not following terrain so always ready on terrain
@@ -685,17 +803,9 @@ void TransectStyleComplexItem::_adjustForAvailableTerrainData(void)
         // No additional work needed
         return;
     case QGroundControlQmlGlobal::AltitudeModeCalcAboveTerrain:
-        _buildFlightPathCoordInfoFromPathHeightInfoForCalcAboveTerrain();
-        _adjustForMaxRates();
-        _adjustForTolerance();
-        _minAMSLAltitude = qQNaN();
-        _maxAMSLAltitude = qQNaN();
-        for (const CoordInfo_t& coordInfo: _rgFlightPathCoordInfo) {
-            _minAMSLAltitude = std::fmin(_minAMSLAltitude, coordInfo.coord.altitude());
-            _maxAMSLAltitude = std::fmax(_maxAMSLAltitude, coordInfo.coord.altitude());
-        }
-        emit lastSequenceNumberChanged(lastSequenceNumber());
-        break;
+        // The flight path is finished by _applyTerrainAdjustResult once the job is done
+        _startTerrainAdjustJob();
+        return;
     case QGroundControlQmlGlobal::AltitudeModeTerrainFrame:
         if (_loadedMissionItems.count()) {
             _buildFlightPathCoordInfoFromMissionItems();
@@ -705,6 +815,11 @@ void TransectStyleComplexItem::_adjustForAvailableTerrainData(void)
         break;
     }
 
+    _flightPathAdjustedForTerrain();
+}
+
+void TransectStyleComplexItem::_flightPathAdjustedForTerrain(void)
+{
     _amslEntryAltChanged();
     _amslExitAltChanged();
     emit _updateFlightPathSegmentsSignal();
@@ -751,15 +866,11 @@ int TransectStyleComplexItem::_maxPathHeight(const TerrainPathQuery::PathHeightI
     return maxIndex;
 }
 
-void TransectStyleComplexItem::_adjustForMaxRates(void)
+void TransectStyleComplexItem::_adjustForMaxRates(TerrainFlightPath_t& path, double maxClimbRate, double maxDescentRate, double flightSpeed)
 {
-    double maxClimbRate     = _terrainAdjustMaxClimbRateFact.rawValue().toDouble();
-    double maxDescentRate   = _terrainAdjustMaxDescentRateFact.rawValue().toDouble();
-    double flightSpeed      = _vehicleSpeed;
-
     if (qIsNaN(flightSpeed) || (maxClimbRate == 0 && maxDescentRate == 0)) {
         if (qIsNaN(flightSpeed)) {
-            qWarning() << "TransectStyleComplexItem::_adjustForMaxRates called with flightSpeed = NaN";
+            qCWarning(TransectStyleComplexItemLog) << "_adjustForMaxRates called with flightSpeed = NaN";
         }
         return;
     }
@@ -767,81 +878,70 @@ void TransectStyleComplexItem::_adjustForMaxRates(void)
         return;
     }
 
+    double* const altitudes = path.altitudes.data();
+    const double* const distances = path.distances.constData();
+    const qsizetype count = path.altitudes.count();
+
+    // Both passes only ever raise altitudes. Raising a point to meet the climb rate into its successor can only
+    // make the climb into the point itself steeper, so walking backwards every point is settled in a single pass.
+    // The same holds for the descent rate walking forwards.
     if (maxClimbRate > 0) {
-        bool climbRateAdjusted;
-        do {
-            //qDebug() << "climb rate pass";
-            climbRateAdjusted = false;
-            for (int i=0; i<_rgFlightPathCoordInfo.count() - 1; i++) {
-                QGeoCoordinate& fromCoord   = _rgFlightPathCoordInfo[i].coord;
-                QGeoCoordinate& toCoord     = _rgFlightPathCoordInfo[i+1].coord;
-
-                double altDifference    = toCoord.altitude() - fromCoord.altitude();
-                double distance         = fromCoord.distanceTo(toCoord);
-                double seconds          = distance / flightSpeed;
-                double climbRate        = altDifference / seconds;
-
-                //qDebug() << QString("Index:%1 altDifference:%2 distance:%3 seconds:%4 climbRate:%5").arg(i).arg(altDifference).arg(distance).arg(seconds).arg(climbRate);
-
-                if (climbRate > 0 && climbRate - maxClimbRate > 0.1) {
-                    double maxAltitudeDelta = maxClimbRate * seconds;
-                    fromCoord.setAltitude(toCoord.altitude() - maxAltitudeDelta);
-                    //qDebug() << "Adjusting";
-                    climbRateAdjusted = true;
-                }
+        for (qsizetype i=count - 2; i>=0; i--) {
+            const double seconds    = distances[i+1] / flightSpeed;
+            const double climbRate  = (altitudes[i+1] - altitudes[i]) / seconds;
+
+            if (climbRate > 0 && climbRate - maxClimbRate > 0.1) {
+                altitudes[i] = altitudes[i+1] - (maxClimbRate * seconds);
             }
-        } while (climbRateAdjusted);
+        }
     }
 
     if (maxDescentRate > 0) {
-        bool descentRateAdjusted;
         maxDescentRate = -maxDescentRate;
-        do {
-            //qDebug() << "descent rate pass";
-            descentRateAdjusted = false;
-            for (int i=0; i<_rgFlightPathCoordInfo.count() - 1; i++) {
-                QGeoCoordinate& fromCoord   = _rgFlightPathCoordInfo[i].coord;
-                QGeoCoordinate& toCoord     = _rgFlightPathCoordInfo[i+1].coord;
-
-                double altDifference    = toCoord.altitude() - fromCoord.altitude();
-                double distance         = fromCoord.distanceTo(toCoord);
-                double seconds          = distance / flightSpeed;
-                double descentRate      = altDifference / seconds;
-
-                //qDebug() << QString("Index:%1 altDifference:%2 distance:%3 seconds:%4 descentRate:%5").arg(i).arg(altDifference).arg(distance).arg(seconds).arg(descentRate);
-
-                if (descentRate < 0 && descentRate - maxDescentRate < -0.1) {
-                    double maxAltitudeDelta = maxDescentRate * seconds;
-                    toCoord.setAltitude(fromCoord.altitude() + maxAltitudeDelta);
-                    //qDebug() << "Adjusting";
-                    descentRateAdjusted = true;
-                }
+        for (qsizetype i=0; i<count - 1; i++) {
+            const double seconds        = distances[i+1] / flightSpeed;
+            const double descentRate    = (altitudes[i+1] - altitudes[i]) / seconds;
+
+            if (descentRate < 0 && descentRate - maxDescentRate < -0.1) {
+                altitudes[i+1] = altitudes[i] + (maxDescentRate * seconds);
             }
-        } while (descentRateAdjusted);
+        }
     }
 }
 
-void TransectStyleComplexItem::_adjustForTolerance(void)
+void TransectStyleComplexItem::_adjustForTolerance(TerrainFlightPath_t& path, double tolerance)
 {
-    QList<CoordInfo_t>  adjustedFlightPath;
-    double              tolerance           = _terrainAdjustToleranceFact.rawValue().toDouble();
-    CoordInfo_t&        lastCoordInfo       = _rgFlightPathCoordInfo.first();
+    const qsizetype count = path.altitudes.count();
+    if (count == 0) {
+        return;
+    }
 
-    adjustedFlightPath.append(lastCoordInfo);
+    // Compacted in place, distances are summed up over the points which are dropped
+    qsizetype   keptCount       = 1;
+    double      lastAltitude    = path.altitudes[0];
+    double      distance        = 0;
 
-    int coordIndex = 1;
-    while (coordIndex < _rgFlightPathCoordInfo.count()) {
+    for (qsizetype i=1; i<count; i++) {
         // Walk forward until we fall out of tolerence. When we fall out of tolerance add that point.
         // We always add non-interstitial points no matter what.
-        const CoordInfo_t& nextCoordInfo = _rgFlightPathCoordInfo[coordIndex];
-        if (nextCoordInfo.coordType != CoordTypeInteriorTerrainAdded || qAbs(lastCoordInfo.coord.altitude() - nextCoordInfo.coord.altitude()) > tolerance) {
-            adjustedFlightPath.append(nextCoordInfo);
-            lastCoordInfo = nextCoordInfo;
+        distance += path.distances[i];
+        if (path.coordTypes[i] != CoordTypeInteriorTerrainAdded || qAbs(lastAltitude - path.altitudes[i]) > tolerance) {
+            path.latitudes[keptCount]   = path.latitudes[i];
+            path.longitudes[keptCount]  = path.longitudes[i];
+            path.altitudes[keptCount]   = path.altitudes[i];
+            path.distances[keptCount]   = distance;
+            path.coordTypes[keptCount]  = path.coordTypes[i];
+            lastAltitude = path.altitudes[i];
+            distance = 0;
+            keptCount++;
         }
-        coordIndex++;
     }
 
-    _rgFlightPathCoordInfo = adjustedFlightPath;
+    path.latitudes.resize(keptCount);
+    path.longitudes.resize(keptCount);
+    path.altitudes.resize(keptCount);
+    path.distances.resize(keptCount);
+    path.coordTypes.resize(keptCount);
 }
 
 void TransectStyleComplexItem::_buildFlightPathCoordInfoFromTransects(void)
@@ -869,83 +969,230 @@ void TransectStyleComplexItem::_buildFlightPathCoordInfoFromTransects(void)
     }
 }
 
-void TransectStyleComplexItem::_buildFlightPathCoordInfoFromPathHeightInfoForCalcAboveTerrain(void)
+bool TransectStyleComplexItem::_buildTerrainFlightPath(const QList<QList<CoordInfo_t>>& transects, const QList<TerrainPathQuery::PathHeightInfo_t>& rgPathHeightInfo, double distanceToSurface, TerrainFlightPath_t& path)
 {
-    _minAMSLAltitude = _maxAMSLAltitude = qQNaN();
+    path = TerrainFlightPath_t();
 
-    if (_rgPathHeightInfo.count() == 0) {
-        qCWarning(TransectStyleComplexItemLog) << "TransectStyleComplexItem::_buildFlightPathCoordInfoFromPathHeightInfo terrain height needed but _rgPathHeightInfo.count() == 0";
-        return;
+    // The terrain query has one path per pair of consecutive transect points, which includes the turn segments
+    QList<double> vertexLatitudes;
+    QList<double> vertexLongitudes;
+    qsizetype pointCount = 0;
+    for (const QList<CoordInfo_t>& transect: transects) {
+        for (const CoordInfo_t& coordInfo: transect) {
+            vertexLatitudes.append(coordInfo.coord.latitude());
+            vertexLongitudes.append(coordInfo.coord.longitude());
+        }
+    }
+    if (vertexLatitudes.count() < 2 || rgPathHeightInfo.count() != vertexLatitudes.count() - 1) {
+        qCWarning(TransectStyleComplexItemLog) << "_buildTerrainFlightPath path height count does not match transects" << rgPathHeightInfo.count() << vertexLatitudes.count();
+        return false;
     }
+    for (const TerrainPathQuery::PathHeightInfo_t& pathHeightInfo: rgPathHeightInfo) {
+        if (pathHeightInfo.heights.count() < 2) {
+            qCWarning(TransectStyleComplexItemLog) << "_buildTerrainFlightPath path without heights";
+            return false;
+        }
+        pointCount += pathHeightInfo.heights.count() - 1;
+    }
+    pointCount++;
+
+    // Interstitial points are placed in a local plane around the first point, which is accurate to well below
+    // the terrain resolution over the extent of a survey
+    const QGCGeo::NedOrigin nedOrigin(QGeoCoordinate(vertexLatitudes.first(), vertexLongitudes.first(), 0));
+    QList<double> vertexNorth(vertexLatitudes.count());
+    QList<double> vertexEast(vertexLatitudes.count());
+    nedOrigin.convertGeoToNed(vertexLatitudes.constData(), vertexLongitudes.constData(), nullptr, vertexNorth.data(), vertexEast.data(), nullptr, vertexLatitudes.count());
+
+    QList<double> north;
+    QList<double> east;
+    north.reserve(pointCount);
+    east.reserve(pointCount);
+    path.latitudes.reserve(pointCount);
+    path.longitudes.reserve(pointCount);
+    path.altitudes.reserve(pointCount);
+    path.coordTypes.reserve(pointCount);
+
+    const auto appendVertex = [&](qsizetype vertexIndex, double terrainHeight, CoordType coordType) {
+        north.append(vertexNorth[vertexIndex]);
+        east.append(vertexEast[vertexIndex]);
+        path.latitudes.append(vertexLatitudes[vertexIndex]);
+        path.longitudes.append(vertexLongitudes[vertexIndex]);
+        path.altitudes.append(terrainHeight + distanceToSurface);
+        path.coordTypes.append(coordType);
+    };
 
-    double distanceToSurface = _cameraCalc.distanceToSurface()->rawValue().toDouble();
+    // Add interstitial points at max resolution of our terrain data
+    const auto appendInterstitials = [&](qsizetype fromVertexIndex, const QList<double>& heights) {
+        const double fromNorth  = vertexNorth[fromVertexIndex];
+        const double fromEast   = vertexEast[fromVertexIndex];
+        const double deltaNorth = vertexNorth[fromVertexIndex + 1] - fromNorth;
+        const double deltaEast  = vertexEast[fromVertexIndex + 1] - fromEast;
+        const qsizetype cHeights = heights.count();
+
+        for (qsizetype heightIndex=1; heightIndex<cHeights - 1; heightIndex++) {
+            const double percentTowardsTo = static_cast<double>(heightIndex) / (cHeights - 1);
+            north.append(fromNorth + (deltaNorth * percentTowardsTo));
+            east.append(fromEast + (deltaEast * percentTowardsTo));
+            path.latitudes.append(qQNaN());
+            path.longitudes.append(qQNaN());
+            path.altitudes.append(heights[heightIndex] + distanceToSurface);
+            path.coordTypes.append(CoordTypeInteriorTerrainAdded);
+        }
+    };
 
-    _rgFlightPathCoordInfo.clear();
-    int pathHeightIndex = 0;
-    for (int transectIndex=0; transectIndex<_transects.count(); transectIndex++) {
-        const QList<CoordInfo_t>& transect = _transects[transectIndex];
+    qsizetype vertexIndex = 0;
+    for (int transectIndex=0; transectIndex<transects.count(); transectIndex++) {
+        const QList<CoordInfo_t>& transect = transects[transectIndex];
 
         // Build flight path for transect
         for (int transectCoordIndex=0; transectCoordIndex<transect.count() - 1; transectCoordIndex++) {
-            CoordInfo_t fromCoordInfo   = transect[transectCoordIndex];
-            CoordInfo_t toCoordInfo     = transect[transectCoordIndex+1];
-
-            const auto& pathHeightInfo = _rgPathHeightInfo[pathHeightIndex++];
-
-            fromCoordInfo.coord.setAltitude(distanceToSurface + pathHeightInfo.heights.first());
-            toCoordInfo.coord.setAltitude(distanceToSurface + pathHeightInfo.heights.last());
+            const QList<double>& heights = rgPathHeightInfo[vertexIndex].heights;
 
             if (transectCoordIndex == 0) {
-                _rgFlightPathCoordInfo.append(fromCoordInfo);
+                appendVertex(vertexIndex, heights.first(), transect[transectCoordIndex].coordType);
             }
+            appendInterstitials(vertexIndex, heights);
+            appendVertex(vertexIndex + 1, heights.last(), transect[transectCoordIndex + 1].coordType);
+            vertexIndex++;
+        }
 
-            // Add interstitial points at max resolution of our terrain data
-            int cHeights = pathHeightInfo.heights.count();
+        // Add terrain interstitial points to the turn segment if not the last transect
+        if (!transect.isEmpty() && vertexIndex < rgPathHeightInfo.count()) {
+            appendInterstitials(vertexIndex, rgPathHeightInfo[vertexIndex].heights);
+            vertexIndex++;
+        }
+    }
 
-            double azimuth  = fromCoordInfo.coord.azimuthTo(toCoordInfo.coord);
-            double distance = fromCoordInfo.coord.distanceTo(toCoordInfo.coord);
+    const qsizetype count = north.count();
+    if (count == 0) {
+        return false;
+    }
 
-            for (int pathHeightIndex=1; pathHeightIndex<cHeights - 1; pathHeightIndex++) {
-                double interstitialTerrainHeight = pathHeightInfo.heights[pathHeightIndex];
-                double percentTowardsTo = (1.0 / (cHeights - 1)) * pathHeightIndex;
+    QList<double> latitudes(count);
+    QList<double> longitudes(count);
+    nedOrigin.convertNedToGeo(north.constData(), east.constData(), nullptr, latitudes.data(), longitudes.data(), nullptr, count);
 
-                CoordInfo_t interstitialCoordInfo;
-                interstitialCoordInfo.coordType = CoordTypeInteriorTerrainAdded;
-                interstitialCoordInfo.coord     = fromCoordInfo.coord.atDistanceAndAzimuth(distance * percentTowardsTo, azimuth);
-                interstitialCoordInfo.coord.setAltitude(interstitialTerrainHeight + distanceToSurface);
+    // Transect points keep their exact coordinates, only the interstitial ones come from the local plane
+    for (qsizetype i=0; i<count; i++) {
+        if (qIsNaN(path.latitudes[i])) {
+            path.latitudes[i]   = latitudes[i];
+            path.longitudes[i]  = longitudes[i];
+        }
+    }
 
-                _rgFlightPathCoordInfo.append(interstitialCoordInfo);
-            }
+    path.distances.resize(count);
+    path.distances[0] = 0;
+    for (qsizetype i=1; i<count; i++) {
+        const double deltaNorth = north[i] - north[i-1];
+        const double deltaEast  = east[i] - east[i-1];
+        path.distances[i] = std::sqrt((deltaNorth * deltaNorth) + (deltaEast * deltaEast));
+    }
 
-            _rgFlightPathCoordInfo.append(toCoordInfo);
-        }
+    return true;
+}
 
-        // Build flight path for turnaround
-        // Add terrain interstitial points to the turn segment if not the last transect
-        if (transectIndex != _transects.count() - 1) {
-            const auto& pathHeightInfo = _rgPathHeightInfo[pathHeightIndex++];
+TransectStyleComplexItem::TerrainAdjustResult_t TransectStyleComplexItem::_calcAboveTerrainFlightPath(const QList<QList<CoordInfo_t>>& transects, const QList<TerrainPathQuery::PathHeightInfo_t>& rgPathHeightInfo, const TerrainAdjustParams_t& params)
+{
+    TerrainAdjustResult_t result;
 
-            int cHeights = pathHeightInfo.heights.count();
+    TerrainFlightPath_t path;
+    if (!_buildTerrainFlightPath(transects, rgPathHeightInfo, params.distanceToSurface, path)) {
+        return result;
+    }
+    _adjustForMaxRates(path, params.maxClimbRate, params.maxDescentRate, params.flightSpeed);
+    _adjustForTolerance(path, params.tolerance);
 
-            CoordInfo_t fromCoordInfo   = _transects[transectIndex].last();
-            CoordInfo_t toCoordInfo     = _transects[transectIndex+1].first();
+    const qsizetype count = path.altitudes.count();
+    result.flightPath.reserve(count);
+    for (qsizetype i=0; i<count; i++) {
+        result.flightPath.append({ QGeoCoordinate(path.latitudes[i], path.longitudes[i], path.altitudes[i]), path.coordTypes[i] });
+        result.minAMSLAltitude = std::fmin(result.minAMSLAltitude, path.altitudes[i]);
+        result.maxAMSLAltitude = std::fmax(result.maxAMSLAltitude, path.altitudes[i]);
+    }
 
-            double azimuth  = fromCoordInfo.coord.azimuthTo(toCoordInfo.coord);
-            double distance = fromCoordInfo.coord.distanceTo(toCoordInfo.coord);
+    return result;
+}
 
-            for (int pathHeightIndex=1; pathHeightIndex<cHeights - 1; pathHeightIndex++) {
-                double interstitialTerrainHeight = pathHeightInfo.heights[pathHeightIndex];
-                double percentTowardsTo = (1.0 / (cHeights - 1)) * pathHeightIndex;
+void TransectStyleComplexItem::_startTerrainAdjustJob(void)
+{
+    if (_rgPathHeightInfo.count() == 0) {
+        qCWarning(TransectStyleComplexItemLog) << "_startTerrainAdjustJob terrain height needed but _rgPathHeightInfo.count() == 0";
+        _cancelTerrainAdjustJob();
+        return;
+    }
+
+    // A job still running for older terrain data is stopped, its result would be discarded anyway
+    if (_adjustingForTerrain) {
+        _terrainAdjustWatcher.cancel();
+    }
 
-                CoordInfo_t interstitialCoordInfo;
-                interstitialCoordInfo.coordType = CoordTypeInteriorTerrainAdded;
-                interstitialCoordInfo.coord     = fromCoordInfo.coord.atDistanceAndAzimuth(distance * percentTowardsTo, azimuth);
-                interstitialCoordInfo.coord.setAltitude(interstitialTerrainHeight + distanceToSurface);
+    const quint64 version = ++_terrainAdjustVersion;
+    qCDebug(TransectStyleComplexItemLog) << "_startTerrainAdjustJob version" << version;
 
-                _rgFlightPathCoordInfo.append(interstitialCoordInfo);
-            }
-        }
+    TerrainAdjustParams_t params;
+    params.distanceToSurface    = _cameraCalc.distanceToSurface()->rawValue().toDouble();
+    params.maxClimbRate         = _terrainAdjustMaxClimbRateFact.rawValue().toDouble();
+    params.maxDescentRate       = _terrainAdjustMaxDescentRateFact.rawValue().toDouble();
+    params.flightSpeed          = _vehicleSpeed;
+    params.tolerance            = _terrainAdjustToleranceFact.rawValue().toDouble();
+
+    _adjustingForTerrain = true;
+    emit readyForSaveStateChanged();
+
+    _terrainAdjustWatcher.setFuture(QtConcurrent::run([transects = _transects, rgPathHeightInfo = _rgPathHeightInfo, params, version]() {
+        TerrainAdjustResult_t result = _calcAboveTerrainFlightPath(transects, rgPathHeightInfo, params);
+        result.version = version;
+        return result;
+    }));
+}
+
+void TransectStyleComplexItem::_cancelTerrainAdjustJob(void)
+{
+    if (!_adjustingForTerrain) {
+        return;
     }
+
+    // Bumping the version discards the result should the job already have delivered it
+    _terrainAdjustVersion++;
+    _terrainAdjustWatcher.cancel();
+    _adjustingForTerrain = false;
+    emit readyForSaveStateChanged();
+}
+
+void TransectStyleComplexItem::_terrainAdjustJobFinished(void)
+{
+    if (!_adjustingForTerrain) {
+        // Already applied by _waitForTerrainAdjustJob
+        return;
+    }
+
+    const QFuture<TerrainAdjustResult_t> future = _terrainAdjustWatcher.future();
+    if (future.isCanceled() || (future.resultCount() == 0) || (future.result().version != _terrainAdjustVersion)) {
+        qCDebug(TransectStyleComplexItemLog) << "_terrainAdjustJobFinished discarding stale result";
+        return;
+    }
+
+    _applyTerrainAdjustResult(future.result());
+}
+
+void TransectStyleComplexItem::_waitForTerrainAdjustJob(void)
+{
+    if (_adjustingForTerrain) {
+        _terrainAdjustWatcher.waitForFinished();
+        _terrainAdjustJobFinished();
+    }
+}
+
+void TransectStyleComplexItem::_applyTerrainAdjustResult(const TerrainAdjustResult_t& result)
+{
+    _rgFlightPathCoordInfo  = result.flightPath;
+    _minAMSLAltitude        = result.minAMSLAltitude;
+    _maxAMSLAltitude        = result.maxAMSLAltitude;
+    _adjustingForTerrain    = false;
+
+    emit lastSequenceNumberChanged(lastSequenceNumber());
+    emit readyForSaveStateChanged();
+    _flightPathAdjustedForTerrain();
 }
 
 void TransectStyleComplexItem::_buildFlightPathCoordInfoFromPathHeightInfoForTerrainFrame(void)
@@ -1108,6 +1355,9 @@ void TransectStyleComplexItem::_handleHoverAndCaptureEnabled(QVariant enabled)
 
 void TransectStyleComplexItem::appendMissionItems(QList<MissionItem*>& items, QObject* missionItemParent)
 {
+    _waitForRebuildTransectsJob();
+    _waitForTerrainAdjustJob();
+
     if (_loadedMissionItems.count()) {
         // We have mission items from the loaded plan, use those
         _appendLoadedMissionItems(items, missionItemParent);
@@ -16,8 +16,11 @@
 #include "CameraCalc.h"
 #include "TerrainQuery.h"
 
+#include <QtCore/QFutureWatcher>
 #include <QtCore/QLoggingCategory>
 
+#include <functional>
+
 Q_DECLARE_LOGGING_CATEGORY(TransectStyleComplexItemLog)
 
 class PlanMasterController;
@@ -41,6 +44,8 @@ public:
     Q_PROPERTY(double           coveredArea                 READ coveredArea                                        NOTIFY coveredAreaChanged)
     Q_PROPERTY(bool             hoverAndCaptureAllowed      READ hoverAndCaptureAllowed                             CONSTANT)
     Q_PROPERTY(QVariantList     visualTransectPoints        READ visualTransectPoints                               NOTIFY visualTransectPointsChanged)
+    Q_PROPERTY(bool             rebuildingTransects         READ rebuildingTransects                                NOTIFY rebuildingTransectsChanged)
+    Q_PROPERTY(double           rebuildTransectsProgress    READ rebuildTransectsProgress                           NOTIFY rebuildTransectsProgressChanged)
 
     Q_PROPERTY(Fact*            terrainAdjustTolerance      READ terrainAdjustTolerance                             CONSTANT)
     Q_PROPERTY(Fact*            terrainAdjustMaxDescentRate READ terrainAdjustMaxDescentRate                        CONSTANT)
@@ -63,6 +68,11 @@ public:
     int             cameraShots             (void) const { return _cameraShots; }
     double          coveredArea             (void) const;
     bool            hoverAndCaptureAllowed  (void) const;
+    bool            rebuildingTransects     (void) const { return _rebuildingTransects; }
+    double          rebuildTransectsProgress(void) const { return _rebuildTransectsProgress; }
+
+    /// Builds the transects off the GUI thread whatever their size, so many items can build at once
+    void            setForceRebuildTransectsJob(bool force) { _forceRebuildTransectsJob = force; }
 
     virtual double  timeBetweenShots        (void) { return 0; } // Most be overridden. Implementation here is needed for unit testing.
 
@@ -124,6 +134,8 @@ signals:
     void timeBetweenShotsChanged        (void);
     void visualTransectPointsChanged    (void);
     void coveredAreaChanged             (void);
+    void rebuildingTransectsChanged     (bool rebuildingTransects);
+    void rebuildTransectsProgressChanged(double rebuildTransectsProgress);
     void _updateFlightPathSegmentsSignal(void);
 
 protected slots:
@@ -173,6 +185,50 @@ protected:
         CoordType       coordType;
     } CoordInfo_t;
 
+    /// Builds transects on a worker thread. Polled with the progress so far (0-1), stops early returning nothing once it returns false.
+    using RebuildTransectsJob_t = std::function<QList<QList<CoordInfo_t>>(const std::function<bool(double)>& progress)>;
+
+    /// Subclasses with expensive transect generation return a job which builds the transects off the GUI thread. The job
+    /// must only use data it captured, not the item. An empty job builds the transects with _rebuildTransectsPhase1 right away.
+    virtual RebuildTransectsJob_t _rebuildTransectsJob(void) { return RebuildTransectsJob_t(); }
+    /// Applies a running rebuild job right away, for callers which need up to date transects
+    void _waitForRebuildTransectsJob(void);
+
+    bool _forceRebuildTransectsJob = false;     ///< true: _rebuildTransectsJob returns a job even for cheap transects
+
+    typedef struct {
+        double distanceToSurface;
+        double maxClimbRate;        ///< 0: No limit
+        double maxDescentRate;      ///< 0: No limit, positive value
+        double flightSpeed;
+        double tolerance;
+    } TerrainAdjustParams_t;
+
+    /// AltitudeModeCalcAboveTerrain flight path as structure of arrays, element i of each list belongs to point i
+    typedef struct {
+        QList<double>       latitudes;
+        QList<double>       longitudes;
+        QList<double>       altitudes;      ///< AMSL
+        QList<double>       distances;      ///< Meters from the previous point, 0 for the first point
+        QList<CoordType>    coordTypes;
+    } TerrainFlightPath_t;
+
+    struct TerrainAdjustResult_t {
+        quint64             version = 0;
+        QList<CoordInfo_t>  flightPath;
+        double              minAMSLAltitude = qQNaN();
+        double              maxAMSLAltitude = qQNaN();
+    };
+
+    /// Calculates the terrain following flight path from the transects and the terrain heights along them. Only uses its
+    /// parameters so it can run on a worker thread.
+    static TerrainAdjustResult_t _calcAboveTerrainFlightPath(const QList<QList<CoordInfo_t>>& transects, const QList<TerrainPathQuery::PathHeightInfo_t>& rgPathHeightInfo, const TerrainAdjustParams_t& params);
+    static bool _buildTerrainFlightPath (const QList<QList<CoordInfo_t>>& transects, const QList<TerrainPathQuery::PathHeightInfo_t>& rgPathHeightInfo, double distanceToSurface, TerrainFlightPath_t& path);
+    static void _adjustForMaxRates      (TerrainFlightPath_t& path, double maxClimbRate, double maxDescentRate, double flightSpeed);
+    static void _adjustForTolerance     (TerrainFlightPath_t& path, double tolerance);
+    /// Applies a running terrain adjust job right away, for callers which need an up to date flight path
+    void _waitForTerrainAdjustJob(void);
+
     QVariantList                                _visualTransectPoints;                          ///< Used to draw the flight path visuals on the screen
     QList<QList<CoordInfo_t>>                   _transects;
     QList<TerrainPathQuery::PathHeightInfo_t>   _rgPathHeightInfo;                              ///< Path height for each segment includes turn segments
@@ -214,6 +270,8 @@ protected:
 
 private slots:
     void _reallyQueryTransectsPathHeightInfo        (void);
+    void _rebuildTransectsJobFinished               (void);
+    void _terrainAdjustJobFinished                  (void);
     void _handleHoverAndCaptureEnabled              (QVariant enabled);
     void _updateFlightPathSegmentsDontCallDirectly  (void);
     void _segmentTerrainCollisionChanged            (bool terrainCollision) final;
@@ -231,19 +289,42 @@ private:
     void    _queryMissionItemCoordHeights                                   (void);
     void    _adjustForAvailableTerrainData                                  (void);
     void    _buildFlightPathCoordInfoFromTransects                          (void);
-    void    _buildFlightPathCoordInfoFromPathHeightInfoForCalcAboveTerrain  (void);
     void    _buildFlightPathCoordInfoFromPathHeightInfoForTerrainFrame      (void);
     void    _buildFlightPathCoordInfoFromMissionItems                       (void);
-    void    _adjustForMaxRates                                              (void);
-    void    _adjustForTolerance                                             (void);
+    void    _flightPathAdjustedForTerrain                                   (void);
     double  _altitudeBetweenCoords                                          (const QGeoCoordinate& fromCoord, const QGeoCoordinate& toCoord, double percentTowardsTo);
     int     _maxPathHeight                                                  (const TerrainPathQuery::PathHeightInfo_t& pathHeightInfo, int fromIndex, int toIndex, double& maxHeight);
     BuildMissionItemsState_t _buildMissionItemsState                        (void) const;
+    void    _startRebuildTransectsJob                                       (const RebuildTransectsJob_t& job);
+    void    _cancelRebuildTransectsJob                                      (void);
+    /// Everything after the transects are built: flight path, visuals, distances and camera shots
+    void    _rebuildTransectsPhase2                                         (void);
+    void    _setRebuildingTransects                                         (bool rebuildingTransects);
+    void    _setRebuildTransectsProgress                                    (double progress);
+    void    _startTerrainAdjustJob                                          (void);
+    void    _cancelTerrainAdjustJob                                         (void);
+    void    _applyTerrainAdjustResult                                       (const TerrainAdjustResult_t& result);
+
+    struct RebuildTransectsResult_t {
+        quint64                     version = 0;
+        QList<QList<CoordInfo_t>>   transects;
+    };
 
     TerrainPolyPathQuery*       _currentTerrainPolyPathQuery        = nullptr;
     TerrainAtCoordinateQuery*   _currentTerrainAtCoordinateQuery    = nullptr;
     QTimer                      _terrainPolyPathQueryTimer;
 
+    QFutureWatcher<RebuildTransectsResult_t>    _rebuildTransectsWatcher;
+    quint64                                     _rebuildTransectsVersion    = 0;    ///< Results of older jobs are discarded
+    bool                                        _rebuildingTransects        = false;
+    double                                      _rebuildTransectsProgress   = 0;
+
+    QFutureWatcher<TerrainAdjustResult_t>       _terrainAdjustWatcher;
+    quint64                                     _terrainAdjustVersion       = 0;    ///< Results of older jobs are discarded
+    bool                                        _adjustingForTerrain        = false;
+
+    static constexpr int _rebuildTransectsProgressSteps = 100;
+
     // Deprecated json keys
     static constexpr const char* _jsonTerrainFollowKeyDeprecated       = "FollowTerrain";
 };
@@ -201,7 +201,7 @@ Item {
             }
             switch (_missionController.sendToVehiclePreCheck()) {
                 case MissionController.SendToVehiclePreCheckStateOk:
-                    sendToVehicle()
+                    sendToVehicleCheckFence()
                     break
                 case MissionController.SendToVehiclePreCheckStateActiveMission:
                     mainWindow.showMessageDialog(qsTr("Send To Vehicle"), qsTr("Current mission must be paused prior to uploading a new Plan"))
@@ -218,6 +218,20 @@ Item {
             }
         }
 
+        function sendToVehicleCheckFence() {
+            var missionItemBreachCount = _geoFenceController.missionItemsBreachingFence().length
+            var rallyPointBreachCount = _geoFenceController.rallyPointsBreachingFence().length
+            if (missionItemBreachCount === 0 && rallyPointBreachCount === 0) {
+                sendToVehicle()
+                return
+            }
+            mainWindow.showMessageDialog(qsTr("Plan Upload"),
+                                         qsTr("%1 mission item(s) and %2 rally point(s) are outside of the GeoFence.\n\n").arg(missionItemBreachCount).arg(rallyPointBreachCount) +
+                                         qsTr("Click 'Ok' to upload the Plan anyway."),
+                                         Dialog.Ok | Dialog.Cancel,
+                                         function() { _planMasterController.sendToVehicle() })
+        }
+
         function loadFromSelectedFile() {
             fileDialog.title =          qsTr("Select Plan File")
             fileDialog.planFiles =      true
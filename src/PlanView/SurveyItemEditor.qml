@@ -95,6 +95,12 @@ TransectStyleComplexItemEditor {
                         fact:       missionItem.flyAlternateTransects,
                         enabled:    true,
                         visible:    _vehicle ? (_vehicle.fixedWing || _vehicle.vtol) : false
+                    },
+                    {
+                        text:       qsTr("Optimize transect order"),
+                        fact:       missionItem.optimizeTransectOrder,
+                        enabled:    !missionItem.flyAlternateTransects.rawValue,
+                        visible:    true
                     }
                 ]
             }
@@ -106,10 +112,10 @@ TransectStyleComplexItemEditor {
         title:          qsTr("Select Polygon File")
 
         onAcceptedForLoad: (file) => {
+            close()
             missionItem.surveyAreaPolygon.loadKMLOrSHPFile(file)
             missionItem.resetState = false
             //editorMap.mapFitFunctions.fitMapViewportTomissionItems()
-            close()
         }
     }
 }
@@ -49,6 +49,7 @@
 #include "MissionManager.h"
 #include "MultiVehicleManager.h"
 #include "ParameterManager.h"
+#include "PlanBatchGenerator.h"
 #include "PositionManager.h"
 #include "QGCCameraManager.h"
 #include "QGCConfig.h"
@@ -112,13 +113,17 @@ QGCApplication::QGCApplication(int &argc, char* argv[], bool unitTesting)
     bool fClearCache = false;           // Clear parameter/airframe caches
     bool logging = false;               // Turn on logging
     QString loggingOptions;
+    bool planBatch = false;             // Generate plans from a job file without user interface
+    bool planBatchOutput = false;       // Output directory given, it is stored in _planBatchOutputDir
 
     CmdLineOpt_t rgCmdLineOptions[] = {
-        { "--clear-settings",   &fClearSettingsOptions, nullptr },
-        { "--clear-cache",      &fClearCache,           nullptr },
-        { "--logging",          &logging,               &loggingOptions },
-        { "--fake-mobile",      &_fakeMobile,           nullptr },
-        { "--log-output",       &_logOutput,            nullptr },
+        { "--clear-settings",       &fClearSettingsOptions, nullptr },
+        { "--clear-cache",          &fClearCache,           nullptr },
+        { "--logging",              &logging,               &loggingOptions },
+        { "--fake-mobile",          &_fakeMobile,           nullptr },
+        { "--log-output",           &_logOutput,            nullptr },
+        { "--plan-batch",           &planBatch,             &_planBatchJobFile },
+        { "--plan-batch-output",    &planBatchOutput,       &_planBatchOutputDir },
         // Add additional command line option flags here
     };
 
@@ -319,11 +324,26 @@ void QGCApplication::init()
         qWarning() << "Could not load /fonts/opensans-demibold font";
     }
 
-    if (!_runningUnitTests) {
+    if (!_runningUnitTests && !runningPlanBatch()) {
         _initForNormalAppBoot();
     }
 }
 
+int QGCApplication::runPlanBatch()
+{
+    PlanBatchGenerator planBatchGenerator;
+
+    QString errorString;
+    if (!planBatchGenerator.loadJobFile(_planBatchJobFile, errorString)) {
+        qCWarning(QGCApplicationLog) << "Plan batch job file load failed" << _planBatchJobFile << errorString;
+        return -1;
+    }
+
+    planBatchGenerator.setOutputDirectory(_planBatchOutputDir.isEmpty() ? QFileInfo(_planBatchJobFile).absolutePath() : _planBatchOutputDir);
+
+    return (planBatchGenerator.run() == 0) ? 0 : 1;
+}
+
 void QGCApplication::_initForNormalAppBoot()
 {
 #ifdef QGC_GST_STREAMING
@@ -495,6 +515,9 @@ void QGCApplication::showAppMessage(const QString& message, const QString& title
     } else if (runningUnitTests()) {
         // Unit tests can run without UI
         qCDebug(QGCApplicationLog) << "QGCApplication::showAppMessage unittest title:message" << dialogTitle << message;
+    } else if (runningPlanBatch()) {
+        // Plan batch runs never have a UI
+        qCWarning(QGCApplicationLog) << dialogTitle << message;
     } else {
         // UI isn't ready yet
         _delayedAppMessages.append(QPair<QString, QString>(dialogTitle, message));
@@ -74,6 +74,14 @@ public:
     /// @brief Returns true if Qt debug output should be logged to a file
     bool logOutput(void) const{ return _logOutput; }
 
+    /// @brief Returns true if plans are generated from a job file instead of showing the user interface
+    bool runningPlanBatch(void) const{ return !_planBatchJobFile.isEmpty(); }
+
+    /// @brief Generates the plans from the --plan-batch job file. main() selects the offscreen platform for these runs
+    /// unless QT_QPA_PLATFORM is set, so no display is needed.
+    /// @return exit code, 0 if all plans were generated
+    int runPlanBatch(void);
+
     /// Used to report a missing Parameter. Warning will be displayed to user. Method may be called
     /// multiple times.
     void reportMissingParameter(int componentId, const QString& name);
@@ -161,6 +169,8 @@ private:
 
     QQmlApplicationEngine* _qmlAppEngine        = nullptr;
     bool                _logOutput              = false;    ///< true: Log Qt debug output to file
+    QString             _planBatchJobFile;                  ///< Job file for plan generation without user interface
+    QString             _planBatchOutputDir;                ///< Directory generated plans are saved to, job file directory if empty
     bool				_fakeMobile             = false;    ///< true: Fake ui into displaying mobile interface
     bool                _settingsUpgraded       = false;    ///< true: Settings format has been upgrade to new version
     int                 _majorVersion           = 0;
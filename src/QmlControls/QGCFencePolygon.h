@@ -43,6 +43,10 @@ public:
 signals:
     void inclusionChanged   (bool inclusion);
 
+protected:
+    /// Fences are never simplified, a breach check against a simplified fence would not match what the vehicle enforces
+    int _importVertexBudget(void) const final { return 0; }
+
 private slots:
     void _setDirty(void);
 
@@ -14,8 +14,13 @@
 #include "QGCApplication.h"
 #include "ShapeFileHelper.h"
 #include "KMLDomDocument.h"
+#include "SettingsManager.h"
+#include "PlanViewSettings.h"
 
+#include <QtCore/QEventLoop>
 #include <QtCore/QLineF>
+#include <QtCore/QPointer>
+#include <QtConcurrent/QtConcurrentRun>
 
 QGCMapPolygon::QGCMapPolygon(QObject* parent)
     : QObject               (parent)
@@ -46,9 +51,14 @@ void QGCMapPolygon::_init(void)
     connect(&_polygonModel, &QmlObjectListModel::dirtyChanged, this, &QGCMapPolygon::_polygonModelDirtyChanged);
     connect(&_polygonModel, &QmlObjectListModel::countChanged, this, &QGCMapPolygon::_polygonModelCountChanged);
 
+    connect(this, &QGCMapPolygon::pathChanged,  this, &QGCMapPolygon::_invalidateProjectedPolygon);
     connect(this, &QGCMapPolygon::pathChanged,  this, &QGCMapPolygon::_updateCenter);
     connect(this, &QGCMapPolygon::countChanged, this, &QGCMapPolygon::isValidChanged);
     connect(this, &QGCMapPolygon::countChanged, this, &QGCMapPolygon::isEmptyChanged);
+
+    connect(&_importWatcher, &QFutureWatcherBase::progressValueChanged, this, [this](int progressValue) {
+        _setImportProgress(static_cast<double>(progressValue) / _importProgressSteps);
+    });
 }
 
 const QGCMapPolygon& QGCMapPolygon::operator=(const QGCMapPolygon& other)
@@ -80,6 +90,7 @@ void QGCMapPolygon::clear(void)
     // we work around it by using the code above to remove all but the last point which in turn
     // will cause the polygon to go away.
     _polygonPath.clear();
+    _invalidateProjectedPolygon();
 
     _polygonModel.clearAndDeleteContents();
 
@@ -92,6 +103,7 @@ void QGCMapPolygon::adjustVertex(int vertexIndex, const QGeoCoordinate coordinat
 {
     _polygonPath[vertexIndex] = QVariant::fromValue(coordinate);
     _polygonModel.value<QGCQGeoCoordinate*>(vertexIndex)->setCoordinate(coordinate);
+    _invalidateProjectedPolygon();
     if (!_centerDrag) {
         // When dragging center we don't signal path changed until all vertices are updated
         emit pathChanged();
@@ -148,15 +160,64 @@ QPolygonF QGCMapPolygon::_toPolygonF(void) const
     return polygon;
 }
 
+void QGCMapPolygon::_invalidateProjectedPolygon(void)
+{
+    _projectedPolygonValid = false;
+    emit verticesChanged();
+}
+
+void QGCMapPolygon::_updateProjectedPolygon(void) const
+{
+    if (!_projectedPolygonValid) {
+        _projectedPolygon = _toPolygonF();
+        _projectedBounds = _projectedPolygon.boundingRect();
+        _projectedPolygonValid = true;
+    }
+}
+
 bool QGCMapPolygon::containsCoordinate(const QGeoCoordinate& coordinate) const
 {
     if (_polygonPath.count() > 2) {
-        return _toPolygonF().containsPoint(_pointFFromCoord(coordinate), Qt::OddEvenFill);
+        _updateProjectedPolygon();
+        const QPointF point = _pointFFromCoord(coordinate);
+        return _projectedBounds.contains(point) && _projectedPolygon.containsPoint(point, Qt::OddEvenFill);
     } else {
         return false;
     }
 }
 
+QList<bool> QGCMapPolygon::containsCoordinates(const QList<QGeoCoordinate>& coordinates) const
+{
+    const qsizetype count = coordinates.count();
+    QList<bool> contains(count, false);
+
+    if (_polygonPath.count() <= 2 || count == 0) {
+        return contains;
+    }
+
+    _updateProjectedPolygon();
+
+    QList<double> latitudes(count);
+    QList<double> longitudes(count);
+    for (qsizetype i=0; i<count; i++) {
+        latitudes[i] = coordinates[i].latitude();
+        longitudes[i] = coordinates[i].longitude();
+    }
+
+    // Same tangent plane as _pointFFromCoord
+    QList<double> north(count);
+    QList<double> east(count);
+    const QGCGeo::NedOrigin tangentOrigin(_polygonPath[0].value<QGeoCoordinate>());
+    tangentOrigin.convertGeoToNed(latitudes.constData(), longitudes.constData(), nullptr, north.data(), east.data(), nullptr, count);
+
+    for (qsizetype i=0; i<count; i++) {
+        const QPointF point(east[i], -north[i]);
+        contains[i] = _projectedBounds.contains(point) && _projectedPolygon.containsPoint(point, Qt::OddEvenFill);
+    }
+
+    return contains;
+}
+
 void QGCMapPolygon::setPath(const QList<QGeoCoordinate>& path)
 {
     _polygonPath.clear();
@@ -400,19 +461,24 @@ QList<QPointF> QGCMapPolygon::nedPolygon(void) const
 {
     QList<QPointF>  nedPolygon;
 
-    if (count() > 0) {
-        QGeoCoordinate  tangentOrigin = vertexCoordinate(0);
-
-        for (int i=0; i<_polygonModel.count(); i++) {
-            double y, x, down;
-            QGeoCoordinate vertex = vertexCoordinate(i);
-            if (i == 0) {
-                // This avoids a nan calculation that comes out of convertGeoToNed
-                x = y = 0;
-            } else {
-                QGCGeo::convertGeoToNed(vertex, tangentOrigin, y, x, down);
-            }
-            nedPolygon += QPointF(x, y);
+    const int vertexCount = count();
+    if (vertexCount > 0) {
+        QList<double> latitudes(vertexCount);
+        QList<double> longitudes(vertexCount);
+        for (int i=0; i<vertexCount; i++) {
+            const QGeoCoordinate vertex = vertexCoordinate(i);
+            latitudes[i] = vertex.latitude();
+            longitudes[i] = vertex.longitude();
+        }
+
+        // The first vertex is the tangent origin and comes out as exactly 0
+        QList<double> y(vertexCount);
+        QList<double> x(vertexCount);
+        QGCGeo::convertGeoToNed(latitudes.constData(), longitudes.constData(), nullptr, vertexCoordinate(0), y.data(), x.data(), nullptr, vertexCount);
+
+        nedPolygon.reserve(vertexCount);
+        for (int i=0; i<vertexCount; i++) {
+            nedPolygon += QPointF(x[i], y[i]);
         }
     }
 
@@ -452,7 +518,7 @@ void QGCMapPolygon::offset(double distance)
 
         // Intersect the offset edges to generate new vertices
         QPointF         newVertex;
-        QGeoCoordinate  tangentOrigin = vertexCoordinate(0);
+        const QGCGeo::NedOrigin tangentOrigin(vertexCoordinate(0));
         for (int i=0; i<rgOffsetEdges.count(); i++) {
             int prevIndex = i == 0 ? rgOffsetEdges.count() - 1 : i - 1;
             auto intersect = rgOffsetEdges[prevIndex].intersects(rgOffsetEdges[i], &newVertex);
@@ -462,7 +528,7 @@ void QGCMapPolygon::offset(double distance)
                 return;
             }
             QGeoCoordinate coord;
-            QGCGeo::convertNedToGeo(newVertex.y(), newVertex.x(), 0, tangentOrigin, coord);
+            tangentOrigin.convertNedToGeo(newVertex.y(), newVertex.x(), 0, coord);
             rgNewPolygon.append(coord);
         }
     }
@@ -476,21 +542,94 @@ void QGCMapPolygon::offset(double distance)
 
 bool QGCMapPolygon::loadKMLOrSHPFile(const QString& file)
 {
-    QString errorString;
-    QList<QGeoCoordinate> rgCoords;
-    if (!ShapeFileHelper::loadPolygonFromFile(file, rgCoords, errorString)) {
-        qgcApp()->showAppMessage(errorString);
+    if (_importing) {
+        qgcApp()->showAppMessage(tr("A polygon file is already being loaded."));
+        return false;
+    }
+
+    const int vertexBudget = _importVertexBudget();
+    _importCancelled = false;
+    _setImportProgress(0);
+    _setImporting(true);
+
+    // Large files take a while to parse, the event loop keeps the UI responsive so progress is shown and the load can be cancelled
+    QPointer<QGCMapPolygon> self(this);
+    QEventLoop eventLoop;
+    (void) connect(&_importWatcher, &QFutureWatcherBase::finished, &eventLoop, &QEventLoop::quit);
+    (void) connect(this, &QObject::destroyed, &eventLoop, &QEventLoop::quit);
+    _importWatcher.setFuture(QtConcurrent::run([file, vertexBudget](QPromise<ImportResult_t>& promise) {
+        promise.setProgressRange(0, _importProgressSteps);
+
+        const auto progress = [&promise](double fraction) {
+            if (promise.isCanceled()) {
+                return false;
+            }
+            promise.setProgressValue(qRound(fraction * _importProgressSteps));
+            return true;
+        };
+
+        ImportResult_t result;
+        result.success = ShapeFileHelper::loadPolygonFromFile(file, result.coords, result.errorString, vertexBudget, &result.sourceVertexCount, progress);
+        (void) promise.addResult(result);
+    }));
+    (void) eventLoop.exec();
+
+    if (!self) {
+        return false;
+    }
+    _setImporting(false);
+    // A load finishing while a cancel request is still queued is discarded as well
+    if (_importCancelled || (_importWatcher.future().resultCount() == 0)) {
+        return false;
+    }
+
+    const ImportResult_t result = _importWatcher.result();
+    if (!result.success) {
+        qgcApp()->showAppMessage(result.errorString);
         return false;
     }
 
     _beginResetIfNotActive();
     clear();
-    appendVertices(rgCoords);
+    appendVertices(result.coords);
     _endResetIfNotActive();
 
+    if (vertexBudget > 0 && result.coords.count() < result.sourceVertexCount) {
+        qgcApp()->showAppMessage(tr("Imported polygon was simplified from %1 to %2 vertices.").arg(result.sourceVertexCount).arg(result.coords.count()));
+    }
+
     return true;
 }
 
+void QGCMapPolygon::cancelImport(void)
+{
+    if (_importing) {
+        _importCancelled = true;
+        _importWatcher.cancel();
+    }
+}
+
+void QGCMapPolygon::_setImporting(bool importing)
+{
+    if (importing != _importing) {
+        _importing = importing;
+        emit importingChanged(importing);
+    }
+}
+
+void QGCMapPolygon::_setImportProgress(double importProgress)
+{
+    if (importProgress != _importProgress) {
+        _importProgress = importProgress;
+        emit importProgressChanged(importProgress);
+    }
+}
+
+int QGCMapPolygon::_importVertexBudget(void) const
+{
+    return SettingsManager::instance()->planViewSettings()->simplifyImportedShapes()->rawValue().toBool() ? ShapeFileHelper::simplifiedVertexBudget : 0;
+}
+
 double QGCMapPolygon::area(void) const
 {
     // https://www.mathopenref.com/coordpolygonarea2.html
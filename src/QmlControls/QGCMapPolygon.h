@@ -9,7 +9,9 @@
 
 #pragma once
 
+#include <QtCore/QFutureWatcher>
 #include <QtCore/QObject>
+#include <QtCore/QRectF>
 #include <QtPositioning/QGeoCoordinate>
 #include <QtCore/QVariantList>
 #include <QtGui/QPolygonF>
@@ -44,6 +46,8 @@ public:
     Q_PROPERTY(bool                 traceMode       READ traceMode      WRITE setTraceMode      NOTIFY traceModeChanged)
     Q_PROPERTY(bool                 showAltColor    READ showAltColor   WRITE setShowAltColor   NOTIFY showAltColorChanged)
     Q_PROPERTY(int                  selectedVertex  READ selectedVertex WRITE selectVertex      NOTIFY selectedVertexChanged)
+    Q_PROPERTY(bool                 importing       READ importing                              NOTIFY importingChanged)
+    Q_PROPERTY(double               importProgress  READ importProgress                         NOTIFY importProgressChanged)
 
     Q_INVOKABLE void clear(void);
     Q_INVOKABLE void appendVertex(const QGeoCoordinate& coordinate);
@@ -63,13 +67,20 @@ public:
     /// Returns true if the specified coordinate is within the polygon
     Q_INVOKABLE bool containsCoordinate(const QGeoCoordinate& coordinate) const;
 
+    /// Batch version of containsCoordinate, the coordinates are projected in one go
+    QList<bool> containsCoordinates(const QList<QGeoCoordinate>& coordinates) const;
+
     /// Offsets the current polygon edges by the specified distance in meters
     Q_INVOKABLE void offset(double distance);
 
-    /// Loads a polygon from a KML/SH{ file
-    /// @return true: success
+    /// Loads a polygon from a KML/SHP file. Detailed shapes are simplified to _importVertexBudget() vertices.
+    /// The file is read on a worker thread while events are processed, progress is reported through importProgress.
+    /// @return true: success, false: load failed or was cancelled
     Q_INVOKABLE bool loadKMLOrSHPFile(const QString& file);
 
+    /// Cancels a loadKMLOrSHPFile in progress, the polygon is left unchanged
+    Q_INVOKABLE void cancelImport(void);
+
     /// Returns the path in a list of QGeoCoordinate's format
     QList<QGeoCoordinate> coordinateList(void) const;
 
@@ -114,6 +125,8 @@ public:
     bool            traceMode   (void) const { return _traceMode; }
     bool            showAltColor(void) const { return _showAltColor; }
     int             selectedVertex()   const { return _selectedVertexIndex; }
+    bool            importing   (void) const { return _importing; }
+    double          importProgress(void) const { return _importProgress; }
 
     QVariantList        path        (void) const { return _polygonPath; }
     QmlObjectListModel* qmlPathModel(void) { return &_polygonModel; }
@@ -133,6 +146,7 @@ public:
 signals:
     void countChanged       (int count);
     void pathChanged        (void);
+    void verticesChanged    (void);     ///< Signalled on every vertex change, pathChanged is deferred while the center is dragged
     void dirtyChanged       (bool dirty);
     void cleared            (void);
     void centerChanged      (QGeoCoordinate center);
@@ -143,19 +157,37 @@ signals:
     void traceModeChanged   (bool traceMode);
     void showAltColorChanged(bool showAltColor);
     void selectedVertexChanged(int index);
+    void importingChanged   (bool importing);
+    void importProgressChanged(double importProgress);
+
+protected:
+    /// Simplifying is opt-in through the simplifyImportedShapes setting
+    /// @return Maximum number of vertices for polygons loaded from KML/SHP files, 0 to keep all vertices
+    virtual int _importVertexBudget(void) const;
 
 private slots:
     void _polygonModelCountChanged(int count);
     void _polygonModelDirtyChanged(bool dirty);
     void _updateCenter(void);
+    void _invalidateProjectedPolygon(void);
 
 private:
     void            _init                   (void);
     QPolygonF       _toPolygonF             (void) const;
+    void            _updateProjectedPolygon (void) const;
     QGeoCoordinate  _coordFromPointF        (const QPointF& point) const;
     QPointF         _pointFFromCoord        (const QGeoCoordinate& coordinate) const;
     void            _beginResetIfNotActive  (void);
     void            _endResetIfNotActive    (void);
+    void            _setImporting           (bool importing);
+    void            _setImportProgress      (double importProgress);
+
+    typedef struct {
+        bool                    success = false;
+        QList<QGeoCoordinate>   coords;
+        QString                 errorString;
+        qsizetype               sourceVertexCount = 0;
+    } ImportResult_t;
 
     QVariantList        _polygonPath;
     QmlObjectListModel  _polygonModel;
@@ -168,4 +200,16 @@ private:
     bool                _traceMode =            false;
     bool                _showAltColor =         false;
     int                 _selectedVertexIndex =  -1;
+
+    // Projection used for hit testing, rebuilt on first use after the path changed
+    mutable QPolygonF   _projectedPolygon;
+    mutable QRectF      _projectedBounds;
+    mutable bool        _projectedPolygonValid = false;
+
+    QFutureWatcher<ImportResult_t>  _importWatcher;
+    bool                            _importing =        false;
+    bool                            _importCancelled =  false;
+    double                          _importProgress =   0;
+
+    static constexpr int _importProgressSteps = 100;
 };
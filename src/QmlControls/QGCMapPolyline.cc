@@ -14,6 +14,8 @@
 #include "QGCApplication.h"
 #include "KMLHelper.h"
 #include "QGCLoggingCategory.h"
+#include "SettingsManager.h"
+#include "PlanViewSettings.h"
 
 #include <QtCore/QLineF>
 
@@ -269,19 +271,24 @@ QList<QPointF> QGCMapPolyline::nedPolyline(void)
 {
     QList<QPointF>  nedPolyline;
 
-    if (count() > 0) {
-        QGeoCoordinate  tangentOrigin = vertexCoordinate(0);
-
-        for (int i=0; i<_polylinePath.count(); i++) {
-            double y, x, down;
-            QGeoCoordinate vertex = vertexCoordinate(i);
-            if (i == 0) {
-                // This avoids a nan calculation that comes out of convertGeoToNed
-                x = y = 0;
-            } else {
-                QGCGeo::convertGeoToNed(vertex, tangentOrigin, y, x, down);
-            }
-            nedPolyline += QPointF(x, y);
+    const int vertexCount = count();
+    if (vertexCount > 0) {
+        QList<double> latitudes(vertexCount);
+        QList<double> longitudes(vertexCount);
+        for (int i=0; i<vertexCount; i++) {
+            const QGeoCoordinate vertex = vertexCoordinate(i);
+            latitudes[i] = vertex.latitude();
+            longitudes[i] = vertex.longitude();
+        }
+
+        // The first vertex is the tangent origin and comes out as exactly 0
+        QList<double> y(vertexCount);
+        QList<double> x(vertexCount);
+        QGCGeo::convertGeoToNed(latitudes.constData(), longitudes.constData(), nullptr, vertexCoordinate(0), y.data(), x.data(), nullptr, vertexCount);
+
+        nedPolyline.reserve(vertexCount);
+        for (int i=0; i<vertexCount; i++) {
+            nedPolyline += QPointF(x[i], y[i]);
         }
     }
 
@@ -318,11 +325,11 @@ QList<QGeoCoordinate> QGCMapPolyline::offsetPolyline(double distance)
             rgOffsetEdges.append(offsetEdge);
         }
 
-        QGeoCoordinate  tangentOrigin = vertexCoordinate(0);
+        const QGCGeo::NedOrigin tangentOrigin(vertexCoordinate(0));
 
         // Add first vertex
         QGeoCoordinate coord;
-        QGCGeo::convertNedToGeo(rgOffsetEdges[0].p1().y(), rgOffsetEdges[0].p1().x(), 0, tangentOrigin, coord);
+        tangentOrigin.convertNedToGeo(rgOffsetEdges[0].p1().y(), rgOffsetEdges[0].p1().x(), 0, coord);
         rgNewPolyline.append(coord);
 
         // Intersect the offset edges to generate new central vertices
@@ -333,13 +340,13 @@ QList<QGeoCoordinate> QGCMapPolyline::offsetPolyline(double distance)
                 // Two lines are colinear
                 newVertex = rgOffsetEdges[i].p2();
             }
-            QGCGeo::convertNedToGeo(newVertex.y(), newVertex.x(), 0, tangentOrigin, coord);
+            tangentOrigin.convertNedToGeo(newVertex.y(), newVertex.x(), 0, coord);
             rgNewPolyline.append(coord);
         }
 
         // Add last vertex
         int lastIndex = rgOffsetEdges.count() - 1;
-        QGCGeo::convertNedToGeo(rgOffsetEdges[lastIndex].p2().y(), rgOffsetEdges[lastIndex].p2().x(), 0, tangentOrigin, coord);
+        tangentOrigin.convertNedToGeo(rgOffsetEdges[lastIndex].p2().y(), rgOffsetEdges[lastIndex].p2().x(), 0, coord);
         rgNewPolyline.append(coord);
     }
 
@@ -352,7 +359,9 @@ bool QGCMapPolyline::loadKMLFile(const QString& kmlFile)
 
     QString errorString;
     QList<QGeoCoordinate> rgCoords;
-    if (!KMLHelper::loadPolylineFromFile(kmlFile, rgCoords, errorString)) {
+    qsizetype sourceVertexCount = 0;
+    const int vertexBudget = SettingsManager::instance()->planViewSettings()->simplifyImportedShapes()->rawValue().toBool() ? ShapeFileHelper::simplifiedVertexBudget : 0;
+    if (!KMLHelper::loadPolylineFromFile(kmlFile, rgCoords, errorString, vertexBudget, &sourceVertexCount)) {
         qgcApp()->showAppMessage(errorString);
         return false;
     }
@@ -362,6 +371,10 @@ bool QGCMapPolyline::loadKMLFile(const QString& kmlFile)
 
     _endResetIfNotActive();
 
+    if (vertexBudget > 0 && rgCoords.count() < sourceVertexCount) {
+        qgcApp()->showAppMessage(tr("Imported polyline was simplified from %1 to %2 vertices.").arg(sourceVertexCount).arg(rgCoords.count()));
+    }
+
     return true;
 }
 
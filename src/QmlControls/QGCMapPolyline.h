@@ -52,7 +52,7 @@ public:
     /// @return Offset set of vertices
     QList<QGeoCoordinate> offsetPolyline(double distance);
 
-    /// Loads a polyline from a KML file
+    /// Loads a polyline from a KML file. Detailed lines are simplified if the simplifyImportedShapes setting is enabled.
     /// @return true: success
     Q_INVOKABLE bool loadKMLFile(const QString& kmlFile);
 
@@ -14,8 +14,11 @@
 #include "QmlObjectListModel.h"
 
 #include <QtCore/QDebug>
+#include <QtCore/QSet>
 #include <QtQml/QQmlEngine>
 
+#include <algorithm>
+
 QmlObjectListModel::QmlObjectListModel(QObject* parent)
     : QAbstractListModel        (parent)
     , _dirty                    (false)
@@ -124,16 +127,27 @@ bool QmlObjectListModel::removeRows(int position, int rows, const QModelIndex& p
 
 void QmlObjectListModel::move(int from, int to)
 {
-    if(0 <= from && from < count() && 0 <= to && to < count() && from != to) {
-        // Workaround to allow move item to the bottom. Done according to
-        // beginMoveRows() documentation and implementation specificity:
-        // https://doc.qt.io/qt-5/qabstractitemmodel.html#beginMoveRows
-        // (see 3rd picture explanation there)
-        if(from == to - 1) {
-            to = from++;
-        }
-        beginMoveRows(QModelIndex(), from, from, QModelIndex(), to);
-        _objectList.move(from, to);
+    moveRange(from, 1, to);
+}
+
+void QmlObjectListModel::moveRange(int from, int count, int to)
+{
+    const int listCount = _objectList.count();
+    if (from < 0 || count <= 0 || from + count > listCount || to < 0 || to + count > listCount || from == to) {
+        return;
+    }
+
+    // beginMoveRows wants the row in the unchanged list which the items are moved in front of:
+    // https://doc.qt.io/qt-6/qabstractitemmodel.html#beginMoveRows
+    if (!_externalBeginResetModel) {
+        beginMoveRows(QModelIndex(), from, from + count - 1, QModelIndex(), (to > from) ? to + count : to);
+    }
+    if (to < from) {
+        std::rotate(_objectList.begin() + to, _objectList.begin() + from, _objectList.begin() + from + count);
+    } else {
+        std::rotate(_objectList.begin() + from, _objectList.begin() + from + count, _objectList.begin() + to + count);
+    }
+    if (!_externalBeginResetModel) {
         endMoveRows();
     }
 }
@@ -166,65 +180,168 @@ void QmlObjectListModel::clear()
     }
 }
 
+const QMetaMethod& QmlObjectListModel::_childDirtyChangedSlot()
+{
+    static const QMetaMethod slot = staticMetaObject.method(staticMetaObject.indexOfSlot("_childDirtyChanged(bool)"));
+    return slot;
+}
+
+void QmlObjectListModel::_connectDirtyChanged(QObject* object, int index)
+{
+    static const QByteArray signature = QMetaObject::normalizedSignature("dirtyChanged(bool)");
+
+    // Look for a dirtyChanged signal on the object
+    const int signalIndex = object->metaObject()->indexOfSignal(signature.constData());
+    if (signalIndex != -1 && (!_skipDirtyFirstItem || index != 0)) {
+        QObject::connect(object, object->metaObject()->method(signalIndex), this, _childDirtyChangedSlot());
+    }
+}
+
+void QmlObjectListModel::_disconnectDirtyChanged(QObject* object, int index)
+{
+    static const QByteArray signature = QMetaObject::normalizedSignature("dirtyChanged(bool)");
+
+    const int signalIndex = object->metaObject()->indexOfSignal(signature.constData());
+    if (signalIndex != -1 && (!_skipDirtyFirstItem || index != 0)) {
+        QObject::disconnect(object, object->metaObject()->method(signalIndex), this, _childDirtyChangedSlot());
+    }
+}
+
+void QmlObjectListModel::_emitCountChanged()
+{
+    if (!_externalBeginResetModel) {
+        emit countChanged(count());
+    }
+}
+
+void QmlObjectListModel::_emitDirtyChanged()
+{
+    if (_externalBeginResetModel) {
+        _dirtyChangedPending = true;
+    } else {
+        emit dirtyChanged(_dirty);
+    }
+}
+
 QObject* QmlObjectListModel::removeAt(int i)
 {
-    QObject* removedObject = _objectList[i];
-    if(removedObject) {
-        // Look for a dirtyChanged signal on the object
-        if (_objectList[i]->metaObject()->indexOfSignal(QMetaObject::normalizedSignature("dirtyChanged(bool)")) != -1) {
-            if (!_skipDirtyFirstItem || i != 0) {
-                QObject::disconnect(_objectList[i], SIGNAL(dirtyChanged(bool)), this, SLOT(_childDirtyChanged(bool)));
-            }
+    return removeRange(i, 1).value(0);
+}
+
+QObjectList QmlObjectListModel::removeRange(int i, int count)
+{
+    if (i < 0 || count < 0 || i + count > _objectList.count()) {
+        qWarning() << "Invalid range index:count:listCount" << i << count << _objectList.count();
+        return QObjectList();
+    }
+    if (count == 0) {
+        return QObjectList();
+    }
+
+    const QObjectList removedObjects = _objectList.mid(i, count);
+    for (int j=0; j<count; j++) {
+        if (removedObjects[j]) {
+            _disconnectDirtyChanged(removedObjects[j], i + j);
         }
     }
-    removeRows(i, 1);
+
+    if (!_externalBeginResetModel) {
+        beginRemoveRows(QModelIndex(), i, i + count - 1);
+    }
+    _objectList.remove(i, count);
+    if (!_externalBeginResetModel) {
+        endRemoveRows();
+    }
+
+    _emitCountChanged();
     setDirty(true);
-    return removedObject;
+
+    return removedObjects;
 }
 
 void QmlObjectListModel::insert(int i, QObject* object)
+{
+    insert(i, QList<QObject*>({ object }));
+}
+
+void QmlObjectListModel::insert(int i, QList<QObject*> objects)
 {
     if (i < 0 || i > _objectList.count()) {
         qWarning() << "Invalid index index:count" << i << _objectList.count();
+        return;
     }
-    if(object) {
-        QQmlEngine::setObjectOwnership(object, QQmlEngine::CppOwnership);
-        // Look for a dirtyChanged signal on the object
-        if (object->metaObject()->indexOfSignal(QMetaObject::normalizedSignature("dirtyChanged(bool)")) != -1) {
-            if (!_skipDirtyFirstItem || i != 0) {
-                QObject::connect(object, SIGNAL(dirtyChanged(bool)), this, SLOT(_childDirtyChanged(bool)));
-            }
+    if (objects.isEmpty()) {
+        return;
+    }
+
+    for (int j=0; j<objects.count(); j++) {
+        QObject* object = objects[j];
+        if (object) {
+            QQmlEngine::setObjectOwnership(object, QQmlEngine::CppOwnership);
+            _connectDirtyChanged(object, i + j);
         }
     }
-    _objectList.insert(i, object);
-    insertRows(i, 1);
+
+    if (!_externalBeginResetModel) {
+        beginInsertRows(QModelIndex(), i, i + objects.count() - 1);
+    }
+    _objectList.insert(i, objects.count(), nullptr);
+    std::copy(objects.cbegin(), objects.cend(), _objectList.begin() + i);
+    if (!_externalBeginResetModel) {
+        endInsertRows();
+    }
+
+    _emitCountChanged();
     setDirty(true);
 }
 
-void QmlObjectListModel::insert(int i, QList<QObject*> objects)
+QObjectList QmlObjectListModel::replaceAll(const QObjectList& newList)
 {
-    if (i < 0 || i > _objectList.count()) {
-        qWarning() << "Invalid index index:count" << i << _objectList.count();
+    QObjectList removedObjects;
+
+    // Remove the objects which are not in the new list, a contiguous range at a time from the back so indices stay valid
+    const QSet<QObject*> newObjects(newList.cbegin(), newList.cend());
+    int last = _objectList.count() - 1;
+    while (last >= 0) {
+        if (newObjects.contains(_objectList[last])) {
+            last--;
+            continue;
+        }
+        int first = last;
+        while (first > 0 && !newObjects.contains(_objectList[first - 1])) {
+            first--;
+        }
+        removedObjects.append(removeRange(first, last - first + 1));
+        last = first - 1;
     }
 
-    int j = i;
-    for (QObject* object: objects) {
-        QQmlEngine::setObjectOwnership(object, QQmlEngine::CppOwnership);
+    // What is left is a subset of the new list, so walking the new list only needs insertions and moves
+    const QSet<QObject*> currentObjects(_objectList.cbegin(), _objectList.cend());
+    int index = 0;
+    while (index < newList.count()) {
+        if (index < _objectList.count() && _objectList[index] == newList[index]) {
+            index++;
+            continue;
+        }
 
-        // Look for a dirtyChanged signal on the object
-        if (object->metaObject()->indexOfSignal(QMetaObject::normalizedSignature("dirtyChanged(bool)")) != -1) {
-            if (!_skipDirtyFirstItem || j != 0) {
-                QObject::connect(object, SIGNAL(dirtyChanged(bool)), this, SLOT(_childDirtyChanged(bool)));
+        int runLength = 1;
+        if (currentObjects.contains(newList[index])) {
+            // Items before index already match, so the object can only be further back
+            const int from = _objectList.indexOf(newList[index], index + 1);
+            while (from + runLength < _objectList.count() && index + runLength < newList.count() && _objectList[from + runLength] == newList[index + runLength]) {
+                runLength++;
             }
+            moveRange(from, runLength, index);
+        } else {
+            while (index + runLength < newList.count() && !currentObjects.contains(newList[index + runLength])) {
+                runLength++;
+            }
+            insert(index, newList.mid(index, runLength));
         }
-
-        _objectList.insert(j, object);
-        j++;
+        index += runLength;
     }
 
-    insertRows(i, objects.count());
-
-    setDirty(true);
+    return removedObjects;
 }
 
 void QmlObjectListModel::append(QObject* object)
@@ -268,7 +385,7 @@ void QmlObjectListModel::setDirty(bool dirty)
                 }
             }
         }
-        emit dirtyChanged(_dirty);
+        _emitDirtyChanged();
     }
 }
 
@@ -277,7 +394,7 @@ void QmlObjectListModel::_childDirtyChanged(bool dirty)
     _dirty |= dirty;
     // We want to emit dirtyChanged even if the actual value of _dirty didn't change. It can be a useful
     // signal to know when a child has changed dirty state
-    emit dirtyChanged(_dirty);
+    _emitDirtyChanged();
 }
 
 void QmlObjectListModel::deleteListAndContents()
@@ -304,6 +421,8 @@ void QmlObjectListModel::beginReset()
         qWarning() << "QmlObjectListModel::beginReset already set";
     }
     _externalBeginResetModel = true;
+    _countAtBeginReset = count();
+    _dirtyChangedPending = false;
     beginResetModel();
 }
 
@@ -314,4 +433,12 @@ void QmlObjectListModel::endReset()
     }
     _externalBeginResetModel = false;
     endResetModel();
+
+    if (count() != _countAtBeginReset) {
+        emit countChanged(count());
+    }
+    if (_dirtyChangedPending) {
+        _dirtyChangedPending = false;
+        emit dirtyChanged(_dirty);
+    }
 }
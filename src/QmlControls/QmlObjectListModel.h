@@ -11,6 +11,7 @@
 #pragma once
 
 #include <QtCore/QAbstractListModel>
+#include <QtCore/QMetaMethod>
 
 class QmlObjectListModel : public QAbstractListModel
 {
@@ -46,9 +47,21 @@ public:
     bool        contains            (const QObject* object) { return _objectList.indexOf(object) != -1; }
     int         indexOf             (const QObject* object) { return _objectList.indexOf(object); }
 
+    /// Removes count items starting at index i with a single row removal
+    /// @return The removed objects, ownership passes to the caller
+    QObjectList removeRange         (int i, int count);
+
     /// Moves an item to a new position
     void move(int from, int to);
 
+    /// Moves count items starting at index from with a single row move, such that the first of them ends up at index to
+    void moveRange(int from, int count, int to);
+
+    /// Updates the list to match newList using row removals, insertions and moves of whole ranges, rather than a model
+    /// reset. Views keep the delegates of objects which are in both lists. Objects must not appear more than once.
+    /// @return Objects which are no longer in the list, ownership passes to the caller
+    QObjectList replaceAll(const QObjectList& newList);
+
     QObject*    operator[]          (int i);
     const QObject* operator[]       (int i) const;
     template<class T> T value       (int index) { return qobject_cast<T>(_objectList[index]); }
@@ -60,6 +73,8 @@ public:
     /// Clears the list and calls deleteLater on each entry
     void clearAndDeleteContents     ();
 
+    /// Row, count and dirty signals of changes made between beginReset and endReset are replaced by the model reset
+    /// and a single countChanged/dirtyChanged signal from endReset.
     void beginReset                 ();
     void endReset                   ();
 
@@ -80,11 +95,20 @@ private:
     QHash<int, QByteArray> roleNames(void) const override;
 
 private:
+    void _connectDirtyChanged       (QObject* object, int index);
+    void _disconnectDirtyChanged    (QObject* object, int index);
+    void _emitCountChanged          ();
+    void _emitDirtyChanged          ();
+
+    static const QMetaMethod& _childDirtyChangedSlot();
+
     QList<QObject*> _objectList;
     
     bool _dirty;
     bool _skipDirtyFirstItem;
     bool _externalBeginResetModel;
+    int  _countAtBeginReset =   0;
+    bool _dirtyChangedPending = false;  ///< dirtyChanged deferred until endReset
         
     static constexpr int ObjectRole = Qt::UserRole;
     static constexpr int TextRole = Qt::UserRole + 1;
@@ -65,3 +65,23 @@ QByteArray CopernicusElevationProvider::serialize(const QByteArray &image) const
 {
     return TerrainTileCopernicus::serializeFromData(image);
 }
+
+QGCTileSet LocalDemElevationProvider::getTileCount(int zoom, double topleftLon,
+                                                   double topleftLat, double bottomRightLon,
+                                                   double bottomRightLat) const
+{
+    Q_UNUSED(zoom); Q_UNUSED(topleftLon); Q_UNUSED(topleftLat); Q_UNUSED(bottomRightLon); Q_UNUSED(bottomRightLat);
+    return QGCTileSet();
+}
+
+QByteArray LocalDemElevationProvider::serialize(const QByteArray &image) const
+{
+    Q_UNUSED(image);
+    return QByteArray();
+}
+
+QString LocalDemElevationProvider::_getURL(int x, int y, int zoom) const
+{
+    Q_UNUSED(x); Q_UNUSED(y); Q_UNUSED(zoom);
+    return QString();
+}
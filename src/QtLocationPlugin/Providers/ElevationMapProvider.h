@@ -59,3 +59,30 @@ private:
 
     const QString _mapUrl = QString(kProviderURL) + QStringLiteral("/api/v1/carpet?points=%1,%2,%3,%4");
 };
+
+/// Elevation from DEM files in the local elevation directory. Queries are answered by
+/// TerrainQueryLocalDem directly from the files, there are no tiles to download or cache.
+class LocalDemElevationProvider : public ElevationProvider
+{
+public:
+    LocalDemElevationProvider()
+        : ElevationProvider(
+            kProviderKey,
+            QStringLiteral(""),
+            QStringLiteral("bin"),
+            0,
+            QGeoMapType::TerrainMap) {}
+
+    bool isLocalProvider() const final { return true; }
+
+    QGCTileSet getTileCount(int zoom, double topleftLon,
+                            double topleftLat, double bottomRightLon,
+                            double bottomRightLat) const final;
+
+    QByteArray serialize(const QByteArray &image) const final;
+
+    static constexpr const char *kProviderKey = "Local DEM";
+
+private:
+    QString _getURL(int x, int y, int zoom) const final;
+};
@@ -0,0 +1,296 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "LocalTileMapProvider.h"
+#include "SettingsManager.h"
+#include "AppSettings.h"
+#include "FlightMapSettings.h"
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlError>
+#include <QtSql/QSqlQuery>
+
+#include <mutex>
+
+Q_GLOBAL_STATIC(LocalTileSource, _localTileSource)
+
+LocalTileSource *LocalTileSource::instance()
+{
+    return _localTileSource();
+}
+
+LocalTileSource::~LocalTileSource()
+{
+    // Other threads closed their connections when they exited, only the destroying thread's are left
+    _closeFiles();
+    if (_threadConnections.hasLocalData()) {
+        _threadConnections.setLocalData(nullptr);
+    }
+}
+
+LocalTileSource::ThreadConnections::~ThreadConnections()
+{
+    close();
+}
+
+void LocalTileSource::ThreadConnections::close()
+{
+    for (const QString &connectionName : std::as_const(connectionNames)) {
+        QSqlDatabase::removeDatabase(connectionName);
+    }
+    connectionNames.clear();
+}
+
+void LocalTileSource::setDirectory(const QString &directory)
+{
+    QMutexLocker lock(&_mutex);
+
+    if (directory == _directory) {
+        return;
+    }
+
+    _directory = directory;
+    _scanDirectory();
+}
+
+void LocalTileSource::rescan()
+{
+    QMutexLocker lock(&_mutex);
+
+    _scanDirectory();
+}
+
+void LocalTileSource::_scanDirectory()
+{
+    _closeFiles();
+
+    if (_directory.isEmpty()) {
+        return;
+    }
+
+    const QDir dir(_directory);
+    const QFileInfoList fileInfos = dir.entryInfoList({QStringLiteral("*.mbtiles"), QStringLiteral("*.gpkg")}, QDir::Files | QDir::Readable, QDir::Name);
+    for (const QFileInfo &fileInfo : fileInfos) {
+        TileFile tileFile;
+        if (_openFile(fileInfo.absoluteFilePath(), tileFile)) {
+            qCDebug(MapProviderLog) << "Local tiles:" << tileFile.path << "zoom" << tileFile.minZoom << "-" << tileFile.maxZoom;
+            _files.append(tileFile);
+        }
+    }
+}
+
+QStringList LocalTileSource::files() const
+{
+    QMutexLocker lock(const_cast<QMutex*>(&_mutex));
+
+    QStringList paths;
+    for (const TileFile &tileFile : _files) {
+        paths.append(tileFile.path);
+    }
+    return paths;
+}
+
+QByteArray LocalTileSource::tile(int x, int y, int zoom)
+{
+    // Only the file list and this thread's connections are looked up under the lock. The connections belong to this
+    // thread and are only closed by it, so the queries run unlocked and reads on different threads don't wait on each other.
+    QList<TileRead_t> reads;
+    {
+        QMutexLocker lock(&_mutex);
+
+        for (const TileFile &tileFile : std::as_const(_files)) {
+            if ((zoom < tileFile.minZoom) || (zoom > tileFile.maxZoom)) {
+                continue;
+            }
+
+            QString connectionName;
+            if (_connect(tileFile, connectionName)) {
+                reads.append({ tileFile, connectionName });
+            }
+        }
+    }
+
+    for (const TileRead_t &read : std::as_const(reads)) {
+        const QByteArray image = _readTile(read.tileFile, read.connectionName, x, y, zoom);
+        if (!image.isEmpty()) {
+            return image;
+        }
+    }
+
+    return QByteArray();
+}
+
+bool LocalTileSource::_connect(const TileFile &tileFile, QString &connectionName)
+{
+    static QAtomicInt nextThreadId;
+
+    if (!_threadConnections.hasLocalData()) {
+        ThreadConnections* const threadConnections = new ThreadConnections;
+        threadConnections->prefix = QStringLiteral("%1_%2").arg(kConnectionPrefix).arg(nextThreadId.fetchAndAddRelaxed(1));
+        threadConnections->generation = _generation;
+        _threadConnections.setLocalData(threadConnections);
+    }
+
+    ThreadConnections* const threadConnections = _threadConnections.localData();
+    if (threadConnections->generation != _generation) {
+        threadConnections->close();
+        threadConnections->generation = _generation;
+    }
+
+    connectionName = QStringLiteral("%1_%2").arg(threadConnections->prefix, tileFile.connectionName);
+    if (QSqlDatabase::contains(connectionName)) {
+        return QSqlDatabase::database(connectionName, false).isOpen();
+    }
+
+    threadConnections->connectionNames.append(connectionName);
+    QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+    db.setDatabaseName(tileFile.path);
+    db.setConnectOptions(QStringLiteral("QSQLITE_OPEN_READONLY"));
+    if (!db.open()) {
+        qCWarning(MapProviderLog) << "Failed to open local tiles:" << tileFile.path << db.lastError().text();
+        return false;
+    }
+
+    // Tile blobs are read straight out of the page cache instead of being copied through read() calls
+    const qint64 mmapSize = qMin(QFileInfo(tileFile.path).size(), kMaxMmapSize);
+    QSqlQuery query(db);
+    (void) query.exec(QStringLiteral("PRAGMA mmap_size = %1").arg(mmapSize));
+    (void) query.exec(QStringLiteral("PRAGMA query_only = 1"));
+
+    return true;
+}
+
+bool LocalTileSource::_openFile(const QString &path, TileFile &tileFile)
+{
+    tileFile.path = path;
+    tileFile.connectionName = QString::number(_nextConnectionId++);
+    tileFile.format = path.endsWith(QStringLiteral(".gpkg"), Qt::CaseInsensitive) ? Format::GeoPackage : Format::MBTiles;
+
+    QString connectionName;
+    if (!_connect(tileFile, connectionName)) {
+        return false;
+    }
+
+    const QSqlDatabase db = QSqlDatabase::database(connectionName, false);
+    QSqlQuery query(db);
+
+    if (tileFile.format == Format::MBTiles) {
+        if (!db.tables(QSql::AllTables).contains(QStringLiteral("tiles"))) {
+            qCWarning(MapProviderLog) << "Not an MBTiles file:" << path;
+            return false;
+        }
+
+        tileFile.tableName = QStringLiteral("tiles");
+        if (query.exec(QStringLiteral("SELECT name, value FROM metadata WHERE name IN ('minzoom', 'maxzoom')"))) {
+            while (query.next()) {
+                const QString name = query.value(0).toString();
+                bool ok = false;
+                const int value = query.value(1).toInt(&ok);
+                if (!ok) {
+                    continue;
+                }
+                if (name == QStringLiteral("minzoom")) {
+                    tileFile.minZoom = value;
+                } else {
+                    tileFile.maxZoom = value;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Only web mercator tile matrix sets covering the whole world map 1:1 onto XYZ tile addressing
+    static constexpr const char *gpkgTablesSql =
+        "SELECT c.table_name FROM gpkg_contents c "
+        "JOIN gpkg_tile_matrix_set s ON c.table_name = s.table_name "
+        "WHERE c.data_type = 'tiles' AND s.srs_id = 3857 "
+        "AND ABS(s.min_x + 20037508.342789244) < 1 AND ABS(s.max_y - 20037508.342789244) < 1";
+    if (!query.exec(QString::fromLatin1(gpkgTablesSql)) || !query.next()) {
+        qCWarning(MapProviderLog) << "No web mercator tile table in GeoPackage:" << path;
+        return false;
+    }
+    tileFile.tableName = query.value(0).toString();
+
+    query.prepare(QStringLiteral("SELECT MIN(zoom_level), MAX(zoom_level) FROM gpkg_tile_matrix WHERE table_name = ? AND matrix_width = (1 << zoom_level)"));
+    query.addBindValue(tileFile.tableName);
+    if (!query.exec() || !query.next() || query.value(0).isNull()) {
+        qCWarning(MapProviderLog) << "No XYZ aligned zoom levels in GeoPackage:" << path;
+        return false;
+    }
+    tileFile.minZoom = query.value(0).toInt();
+    tileFile.maxZoom = query.value(1).toInt();
+
+    return true;
+}
+
+QByteArray LocalTileSource::_readTile(const TileFile &tileFile, const QString &connectionName, int x, int y, int zoom)
+{
+    QSqlQuery query(QSqlDatabase::database(connectionName, false));
+    query.setForwardOnly(true);
+    (void) query.prepare(QStringLiteral("SELECT tile_data FROM \"%1\" WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?").arg(tileFile.tableName));
+    query.addBindValue(zoom);
+    query.addBindValue(x);
+    // MBTiles rows use TMS addressing with the origin in the bottom left
+    query.addBindValue((tileFile.format == Format::MBTiles) ? ((1 << zoom) - 1 - y) : y);
+    if (!query.exec() || !query.next()) {
+        return QByteArray();
+    }
+
+    return query.value(0).toByteArray();
+}
+
+void LocalTileSource::_closeFiles()
+{
+    _files.clear();
+
+    // Connections of other threads are left to them, they see the new generation on their next read
+    _generation++;
+    if (_threadConnections.hasLocalData()) {
+        _threadConnections.localData()->close();
+    }
+}
+
+QByteArray LocalTileMapProvider::readLocalTile(int x, int y, int zoom) const
+{
+    return LocalTileSource::instance()->tile(x, y, zoom);
+}
+
+void LocalTileMapProvider::followSettings()
+{
+    static std::once_flag directoryFollowsSettings;
+    std::call_once(directoryFollowsSettings, []() {
+        LocalTileSource* const source = LocalTileSource::instance();
+        AppSettings* const appSettings = SettingsManager::instance()->appSettings();
+        FlightMapSettings* const flightMapSettings = SettingsManager::instance()->flightMapSettings();
+
+        source->setDirectory(appSettings->localTilesSavePath());
+        (void) QObject::connect(appSettings, &AppSettings::savePathsChanged, appSettings, [source, appSettings]() {
+            source->setDirectory(appSettings->localTilesSavePath());
+        });
+
+        // Selecting the provider again is how files copied in while running are picked up
+        const auto rescanIfSelected = [source, flightMapSettings]() {
+            const QString mapName = flightMapSettings->mapProvider()->rawValue().toString() + QStringLiteral(" ") + flightMapSettings->mapType()->rawValue().toString();
+            if (mapName == QLatin1String(kMapName)) {
+                source->rescan();
+            }
+        };
+        (void) QObject::connect(flightMapSettings->mapProvider(), &Fact::rawValueChanged, appSettings, rescanIfSelected);
+        (void) QObject::connect(flightMapSettings->mapType(), &Fact::rawValueChanged, appSettings, rescanIfSelected);
+    });
+}
+
+QString LocalTileMapProvider::_getURL(int x, int y, int zoom) const
+{
+    Q_UNUSED(x); Q_UNUSED(y); Q_UNUSED(zoom);
+    return QString();
+}
@@ -0,0 +1,115 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "MapProvider.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QThreadStorage>
+
+/// Read-only access to prepared tile packages (MBTiles and GeoPackage) in the local tiles directory.
+/// Files are opened read-only with SQLite memory mapped I/O and queried in place, nothing is imported
+/// into the tile cache database. Each thread reading tiles gets its own connections, which are closed by
+/// that thread when the files are replaced or when the thread exits.
+class LocalTileSource
+{
+    friend class LocalTileSourceTest;
+public:
+    LocalTileSource() = default;
+    ~LocalTileSource();
+
+    static LocalTileSource *instance();
+
+    /// Scans directory for *.mbtiles and *.gpkg files, replacing any previously opened files. Does nothing
+    /// if the directory is unchanged, the file system is not touched in that case.
+    void setDirectory(const QString &directory);
+    /// Scans the current directory again to pick up files added or removed since the last scan
+    void rescan();
+    QStringList files() const;
+
+    /// Returns the tile image in XYZ (slippy map) tile coordinates, or an empty array if no package contains it
+    QByteArray tile(int x, int y, int zoom);
+
+private:
+    enum class Format {
+        MBTiles,
+        GeoPackage
+    };
+
+    struct TileFile {
+        QString path;
+        QString connectionName;
+        QString tableName;
+        Format format = Format::MBTiles;
+        int minZoom = 0;
+        int maxZoom = MAX_MAP_ZOOM;
+    };
+
+    /// Connections opened by one thread, QSqlDatabase connections may only be used and removed by that thread
+    struct ThreadConnections {
+        ~ThreadConnections();
+        void close();
+
+        QString prefix;
+        int generation = 0;
+        QStringList connectionNames;
+    };
+
+    struct TileRead_t {
+        TileFile tileFile;
+        QString connectionName;                         ///< Connection of the reading thread to tileFile
+    };
+
+    bool _openFile(const QString &path, TileFile &tileFile);
+    /// Must be called with _mutex held
+    bool _connect(const TileFile &tileFile, QString &connectionName);
+    /// Runs without _mutex, on a connection of the calling thread
+    static QByteArray _readTile(const TileFile &tileFile, const QString &connectionName, int x, int y, int zoom);
+    void _scanDirectory();
+    void _closeFiles();
+
+    QMutex _mutex;
+    QString _directory;
+    QList<TileFile> _files;
+    int _nextConnectionId = 0;
+    int _generation = 0;                                ///< Bumped whenever _files is replaced, stale thread connections are closed on next use
+    QThreadStorage<ThreadConnections*> _threadConnections;
+
+    static constexpr const char *kConnectionPrefix = "QGCLocalTileSource";
+    static constexpr qint64 kMaxMmapSize = 0x7fff0000; ///< SQLITE_MAX_MMAP_SIZE default, larger requests are clamped by SQLite
+};
+
+class LocalTileMapProvider : public MapProvider
+{
+public:
+    LocalTileMapProvider()
+        : MapProvider(
+            kMapName,
+            QStringLiteral(""),
+            QStringLiteral("png"),
+            AVERAGE_TILE_SIZE,
+            QGeoMapType::SatelliteMapDay) {}
+
+    bool isLocalProvider() const final { return true; }
+    QByteArray readLocalTile(int x, int y, int zoom) const final;
+
+    /// Points the shared source at the local tiles directory from the settings. It is scanned again when the
+    /// save path changes or this provider is selected. Must be called from the GUI thread.
+    static void followSettings();
+
+    static constexpr const char *kMapName = "Local Imagery";
+
+private:
+    QString _getURL(int x, int y, int zoom) const final;
+};
@@ -30,6 +30,7 @@ MapProvider::MapProvider(
     , _mapStyle(mapStyle)
     , _language(!QLocale::system().uiLanguages().isEmpty() ? QLocale::system().uiLanguages().constFirst() : "en")
     , _mapId(_mapIdIndex++)
+    , _providerId(qChecksum(mapName.toUtf8()))
 {
     // qCDebug(MapProviderLog) << Q_FUNC_INFO << this << _mapId;
 }
@@ -55,6 +55,8 @@ public:
     QGeoMapType::MapStyle getMapStyle() const { return _mapStyle; }
     const QString& getMapName() const { return _mapName; }
     int getMapId() const { return _mapId; }
+    /// Stable id derived from the map name, used in the packed tile keys of the cache database
+    quint16 getProviderId() const { return _providerId; }
     const QString& getReferrer() const { return _referrer; }
     virtual QByteArray getToken() const { return QByteArray(); }
 
@@ -64,6 +66,10 @@ public:
     virtual bool isElevationProvider() const { return false; }
     virtual bool isBingProvider() const { return false; }
 
+    /// Local providers serve tiles from files on disk through readLocalTile instead of over the network
+    virtual bool isLocalProvider() const { return false; }
+    virtual QByteArray readLocalTile(int x, int y, int zoom) const { Q_UNUSED(x); Q_UNUSED(y); Q_UNUSED(zoom); return QByteArray(); }
+
     virtual QGCTileSet getTileCount(int zoom, double topleftLon,
                                     double topleftLat, double bottomRightLon,
                                     double bottomRightLat) const;
@@ -81,6 +87,7 @@ protected:
     const QGeoMapType::MapStyle _mapStyle;
     const QString _language;
     const int _mapId;
+    const quint16 _providerId;
 
 private:
     static int _mapIdIndex;
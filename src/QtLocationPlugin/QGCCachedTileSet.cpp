@@ -87,7 +87,7 @@ void QGCCachedTileSet::createDownloadTask()
 void QGCCachedTileSet::resumeDownloadTask()
 {
     _cancelPending = false;
-    QGCUpdateTileDownloadStateTask* const task = new QGCUpdateTileDownloadStateTask(_id, QGCTile::StatePending, "*");
+    QGCUpdateTileDownloadStateTask* const task = new QGCUpdateTileDownloadStateTask(_id, QGCTile::StatePending, QGCUpdateTileDownloadStateTask::kAllTiles);
     getQGCMapEngine()->addTask(task);
     createDownloadTask();
 }
@@ -163,14 +163,14 @@ void QGCCachedTileSet::_prepareDownload()
         const int mapId = UrlFactory::getQtMapIdFromProviderType(tile->type());
         QNetworkRequest request = QGeoTileFetcherQGC::getNetworkRequest(mapId, tile->x(), tile->y(), tile->z());
         request.setOriginatingObject(this);
-        request.setAttribute(QNetworkRequest::User, tile->hash());
+        request.setAttribute(QNetworkRequest::User, tile->key());
 
         QNetworkReply* const reply = _networkManager->get(request);
         reply->setParent(this);
         QGCFileDownload::setIgnoreSSLErrorsIfNeeded(*reply);
         (void) connect(reply, &QNetworkReply::finished, this, &QGCCachedTileSet::_networkReplyFinished);
         (void) connect(reply, &QNetworkReply::errorOccurred, this, &QGCCachedTileSet::_networkReplyError);
-        (void) _replies.insert(tile->hash(), reply);
+        (void) _replies.insert(tile->key(), reply);
 
         delete tile;
         if (!_batchRequested && !_noMoreTiles && (_tilesToDownload.count() < (QGeoTileFetcherQGC::concurrentDownloads(_type) * 10))) {
@@ -197,18 +197,19 @@ void QGCCachedTileSet::_networkReplyFinished()
         return;
     }
 
-    const QString hash = reply->request().attribute(QNetworkRequest::User).toString();
-    if (hash.isEmpty()) {
-        qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Empty Hash";
+    const QVariant tileKeyVariant = reply->request().attribute(QNetworkRequest::User);
+    if (!tileKeyVariant.isValid()) {
+        qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Empty Tile Key";
         return;
     }
+    const quint64 tileKey = tileKeyVariant.toULongLong();
 
-    if (_replies.contains(hash)) {
-        (void) _replies.remove(hash);
+    if (_replies.contains(tileKey)) {
+        (void) _replies.remove(tileKey);
     } else {
-        qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Reply not in list: " << hash;
+        qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Reply not in list: " << tileKey;
     }
-    qCDebug(QGCCachedTileSetLog) << "Tile fetched:" << hash;
+    qCDebug(QGCCachedTileSetLog) << "Tile fetched:" << tileKey;
 
     QByteArray image = reply->readAll();
     if (image.isEmpty()) {
@@ -216,7 +217,7 @@ void QGCCachedTileSet::_networkReplyFinished()
         return;
     }
 
-    const QString type = UrlFactory::tileHashToType(hash);
+    const QString type = UrlFactory::tileKeyToType(tileKey);
     const SharedMapProvider mapProvider = UrlFactory::getMapProviderFromProviderType(type);
     Q_CHECK_PTR(mapProvider);
 
@@ -235,9 +236,9 @@ void QGCCachedTileSet::_networkReplyFinished()
         return;
     }
 
-    QGeoFileTileCacheQGC::cacheTile(type, hash, image, format, _id);
+    QGeoFileTileCacheQGC::cacheTile(type, tileKey, image, format, _id);
 
-    QGCUpdateTileDownloadStateTask* const task = new QGCUpdateTileDownloadStateTask(_id, QGCTile::StateComplete, hash);
+    QGCUpdateTileDownloadStateTask* const task = new QGCUpdateTileDownloadStateTask(_id, QGCTile::StateComplete, tileKey);
     getQGCMapEngine()->addTask(task);
 
     setSavedTileSize(_savedTileSize + image.size());
@@ -262,23 +263,24 @@ void QGCCachedTileSet::_networkReplyError(QNetworkReply::NetworkError error)
 
     setErrorCount(_errorCount + 1);
 
-    const QString hash = reply->request().attribute(QNetworkRequest::User).toString();
-    if (hash.isEmpty()) {
-        qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Empty Hash";
+    const QVariant tileKeyVariant = reply->request().attribute(QNetworkRequest::User);
+    if (!tileKeyVariant.isValid()) {
+        qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Empty Tile Key";
         return;
     }
+    const quint64 tileKey = tileKeyVariant.toULongLong();
 
-    if (_replies.contains(hash)) {
-        (void) _replies.remove(hash);
+    if (_replies.contains(tileKey)) {
+        (void) _replies.remove(tileKey);
     } else {
-        qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Reply not in list:" << hash;
+        qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Reply not in list:" << tileKey;
     }
 
     if (error != QNetworkReply::OperationCanceledError) {
         qCWarning(QGCCachedTileSetLog) << Q_FUNC_INFO << "Error:" << reply->errorString();
     }
 
-    QGCUpdateTileDownloadStateTask* const task = new QGCUpdateTileDownloadStateTask(_id, QGCTile::StateError, hash);
+    QGCUpdateTileDownloadStateTask* const task = new QGCUpdateTileDownloadStateTask(_id, QGCTile::StateError, tileKey);
     getQGCMapEngine()->addTask(task);
 
     _prepareDownload();
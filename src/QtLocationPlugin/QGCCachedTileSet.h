@@ -187,7 +187,7 @@ private:
     bool _cancelPending = false;
     QDateTime _creationDate;
 
-    QHash<QString, QNetworkReply*> _replies;
+    QHash<quint64, QNetworkReply*> _replies;
     QQueue<QGCTile*> _tilesToDownload;
     QGCMapEngineManager *_manager = nullptr;
     QNetworkAccessManager *_networkManager = nullptr;
@@ -19,6 +19,7 @@
 #include "QGCMapEngine.h"
 #include "QGCCachedTileSet.h"
 #include "QGCTileCacheWorker.h"
+#include "QGCTilePrefetcher.h"
 #include "QGeoFileTileCacheQGC.h"
 #include "QGCMapTasks.h"
 #include "QGCTileSet.h"
@@ -42,6 +43,7 @@ QGCMapEngine *getQGCMapEngine()
 QGCMapEngine::QGCMapEngine(QObject *parent)
     : QObject(parent)
     , m_worker(new QGCCacheWorker(this))
+    , m_prefetcher(new QGCTilePrefetcher(this))
 {
     // qCDebug(QGCMapEngineLog) << Q_FUNC_INFO << this;
 
@@ -26,6 +26,7 @@ Q_DECLARE_LOGGING_CATEGORY(QGCMapEngineLog)
 
 class QGCMapTask;
 class QGCCacheWorker;
+class QGCTilePrefetcher;
 
 class QGCMapEngine : public QObject
 {
@@ -38,6 +39,8 @@ public:
     void init(const QString &databasePath);
     bool addTask(QGCMapTask *task);
 
+    QGCTilePrefetcher *prefetcher() const { return m_prefetcher; }
+
     static QGCMapEngine *instance();
 
 signals:
@@ -49,6 +52,7 @@ private slots:
 
 private:
     QGCCacheWorker *m_worker = nullptr;
+    QGCTilePrefetcher *m_prefetcher = nullptr;
     bool m_prunning = false;
 };
 
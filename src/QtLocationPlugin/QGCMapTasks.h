@@ -48,13 +48,43 @@ public:
     };
     Q_ENUM(TaskType);
 
+    /// Queued tasks of higher priority are always run before those of lower priority
+    enum TaskPriority {
+        PriorityLow,        ///< Bulk work such as import, export, pruning and prefetching
+        PriorityNormal,
+        PriorityHigh        ///< Interactive work the user is waiting on
+    };
+    Q_ENUM(TaskPriority);
+
     explicit QGCMapTask(TaskType type, QObject *parent = nullptr)
         : QObject(parent)
         , m_type(type)
+        , m_priority(defaultPriority(type))
     {}
     virtual ~QGCMapTask() = default;
 
     TaskType type() const { return m_type; }
+    TaskPriority priority() const { return m_priority; }
+    void setPriority(TaskPriority priority) { m_priority = priority; }
+
+    static TaskPriority defaultPriority(TaskType type)
+    {
+        switch (type) {
+        case taskInit:
+        case taskFetchTile:
+        case taskFetchTileSets:
+        case taskCreateTileSet:
+        case taskDeleteTileSet:
+        case taskRenameTileSet:
+            return PriorityHigh;
+        case taskPruneCache:
+        case taskExport:
+        case taskImport:
+            return PriorityLow;
+        default:
+            return PriorityNormal;
+        }
+    }
 
     void setError(const QString &errorString = QString())
     {
@@ -66,6 +96,7 @@ signals:
 
 private:
     const TaskType m_type = TaskType::taskInit;
+    TaskPriority m_priority = TaskPriority::PriorityNormal;
 };
 
 //-----------------------------------------------------------------------------
@@ -131,9 +162,9 @@ class QGCFetchTileTask : public QGCMapTask
     Q_OBJECT
 
 public:
-    explicit QGCFetchTileTask(const QString &hash, QObject *parent = nullptr)
+    explicit QGCFetchTileTask(quint64 tileKey, QObject *parent = nullptr)
         : QGCMapTask(QGCMapTask::taskFetchTile, parent)
-        , m_hash(hash)
+        , m_tileKey(tileKey)
     {}
     ~QGCFetchTileTask() = default;
 
@@ -142,13 +173,13 @@ public:
         emit tileFetched(tile);
     }
 
-    QString hash() const { return m_hash; }
+    quint64 tileKey() const { return m_tileKey; }
 
 signals:
     void tileFetched(QGCCacheTile *tile);
 
 private:
-    const QString m_hash;
+    const quint64 m_tileKey = 0;
 };
 
 //-----------------------------------------------------------------------------
@@ -210,22 +241,25 @@ class QGCUpdateTileDownloadStateTask : public QGCMapTask
     Q_OBJECT
 
 public:
-    QGCUpdateTileDownloadStateTask(quint64 setID, QGCTile::TileState state, const QString &hash, QObject *parent = nullptr)
+    QGCUpdateTileDownloadStateTask(quint64 setID, QGCTile::TileState state, quint64 tileKey, QObject *parent = nullptr)
         : QGCMapTask(QGCMapTask::taskUpdateTileDownloadState, parent)
         , m_setID(setID)
         , m_state(state)
-        , m_hash(hash)
+        , m_tileKey(tileKey)
     {}
     ~QGCUpdateTileDownloadStateTask() = default;
 
-    QString hash() const { return m_hash; }
+    /// Pass as tileKey to update the state of every tile in the set
+    static constexpr quint64 kAllTiles = UINT64_MAX;
+
+    quint64 tileKey() const { return m_tileKey; }
     quint64 setID() const { return m_setID; }
     QGCTile::TileState state() const { return m_state; }
 
 private:
     const quint64 m_setID = 0;
     const QGCTile::TileState m_state = QGCTile::StatePending;
-    const QString m_hash;
+    const quint64 m_tileKey = 0;
 };
 
 //-----------------------------------------------------------------------------
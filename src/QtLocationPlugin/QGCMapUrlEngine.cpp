@@ -21,8 +21,11 @@
 #include "EsriMapProvider.h"
 #include "MapboxMapProvider.h"
 #include "ElevationMapProvider.h"
+#include "LocalTileMapProvider.h"
 #include <QGCLoggingCategory.h>
 
+#include <QtCore/QHash>
+
 QGC_LOGGING_CATEGORY(QGCMapUrlEngineLog, "qgc.qtlocationplugin.qgcmapurlengine")
 
 const QList<SharedMapProvider> UrlFactory::_providers = {
@@ -72,7 +75,11 @@ const QList<SharedMapProvider> UrlFactory::_providers = {
 
     std::make_shared<CustomURLMapProvider>(),
 
-    std::make_shared<CopernicusElevationProvider>()
+    std::make_shared<CopernicusElevationProvider>(),
+
+    // Appended last so the map ids (and cached tile hashes) of the providers above are unchanged
+    std::make_shared<LocalTileMapProvider>(),
+    std::make_shared<LocalDemElevationProvider>()
 };
 
 QString UrlFactory::getImageFormat(int qtMapId, QByteArrayView image)
@@ -271,14 +278,97 @@ int UrlFactory::hashFromProviderType(QStringView type)
     return static_cast<int>(hash);
 }
 
-QString UrlFactory::tileHashToType(QStringView tileHash)
+quint64 UrlFactory::packTileKey(quint16 providerId, int x, int y, int z)
+{
+    quint64 index;
+    if ((x < (1 << z)) && (y < (1 << z))) {
+        const quint64 levelOffset = ((Q_UINT64_C(1) << (2 * z)) - 1) / 3;
+        index = levelOffset + (static_cast<quint64>(y) << z) + static_cast<quint64>(x);
+    } else {
+        index = kTileKeyGridBase + (static_cast<quint64>(z) << (2 * kTileKeyGridBits)) + (static_cast<quint64>(y) << kTileKeyGridBits) + static_cast<quint64>(x);
+    }
+    return (static_cast<quint64>(providerId) << kTileKeyProviderShift) | index;
+}
+
+quint64 UrlFactory::getTileKey(QStringView type, int x, int y, int z)
+{
+    return packTileKey(getProviderIdFromProviderType(type), x, y, z);
+}
+
+quint16 UrlFactory::getProviderIdFromProviderType(QStringView type)
+{
+    // Tiles of providers sharing an id would overwrite each other in the cache
+    static const bool providerIdsChecked = providerIdsUnique();
+    Q_ASSERT(providerIdsChecked);
+    Q_UNUSED(providerIdsChecked);
+
+    const SharedMapProvider provider = getMapProviderFromProviderType(type);
+    if (!provider) {
+        return 0;
+    }
+
+    return provider->getProviderId();
+}
+
+bool UrlFactory::providerIdsUnique()
+{
+    bool unique = true;
+    QHash<quint16, QString> providerNames;
+    for (const SharedMapProvider &provider : _providers) {
+        const quint16 providerId = provider->getProviderId();
+        if (providerNames.contains(providerId)) {
+            qCCritical(QGCMapUrlEngineLog) << Q_FUNC_INFO << "provider id collision:" << providerId << providerNames[providerId] << provider->getMapName();
+            unique = false;
+        } else {
+            providerNames[providerId] = provider->getMapName();
+        }
+    }
+
+    return unique;
+}
+
+QString UrlFactory::tileKeyToType(quint64 tileKey)
 {
-    const int providerHash = tileHash.mid(0,10).toInt();
-    return providerTypeFromHash(providerHash);
+    const quint16 providerId = tileKeyToProviderId(tileKey);
+    for (const SharedMapProvider &provider : _providers) {
+        if (provider->getProviderId() == providerId) {
+            return provider->getMapName();
+        }
+    }
+
+    qCWarning(QGCMapUrlEngineLog) << Q_FUNC_INFO << "provider not found from tile key:" << tileKey;
+    return QStringLiteral("");
 }
 
-QString UrlFactory::getTileHash(QStringView type, int x, int y, int z)
+quint64 UrlFactory::tileKeyFromLegacyHash(QStringView tileHash)
 {
-    const int hash = hashFromProviderType(type);
-    return QString::asprintf("%010d%08d%08d%03d", hash, x, y, z);
+    // Legacy hashes were formatted as "%010d%08d%08d%03d" from provider hash, x, y and z
+    if (tileHash.size() != 29) {
+        return kInvalidTileKey;
+    }
+
+    bool ok = false;
+    const int providerHash = tileHash.mid(0, 10).toInt(&ok);
+    if (!ok) {
+        return kInvalidTileKey;
+    }
+    const int x = tileHash.mid(10, 8).toInt(&ok);
+    if (!ok) {
+        return kInvalidTileKey;
+    }
+    const int y = tileHash.mid(18, 8).toInt(&ok);
+    if (!ok) {
+        return kInvalidTileKey;
+    }
+    const int z = tileHash.mid(26, 3).toInt(&ok);
+    if (!ok || (z < 0) || (z > MAX_MAP_ZOOM)) {
+        return kInvalidTileKey;
+    }
+
+    const QString type = providerTypeFromHash(providerHash);
+    if (type.isEmpty()) {
+        return kInvalidTileKey;
+    }
+
+    return getTileKey(type, x, y, z);
 }
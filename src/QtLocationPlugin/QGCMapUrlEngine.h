@@ -54,8 +54,29 @@ public:
     static QString providerTypeFromHash(int hash);
 
     static int hashFromProviderType(QStringView type);
-    static QString tileHashToType(QStringView tileHash);
-    static QString getTileHash(QStringView type, int x, int y, int z);
+
+    /// Tile keys pack the provider id into the top bits and the tile's position in a quadtree
+    /// ordering of all zoom levels (4^z tiles per level) into the low 47 bits:
+    ///     key = providerId << 47 | ((4^z - 1) / 3 + y * 2^z + x)
+    /// Zoom levels up to 23 fit in 47 bits and keys are always positive, so they can be stored
+    /// directly as SQLite integer primary keys. Providers whose tiles are not a quadtree (the elevation
+    /// providers address a fixed degree grid with x and y beyond 2^z) are packed above the zoom 23 range:
+    ///     key = providerId << 47 | (kTileKeyGridBase + z << 40 + y << 20 + x)
+    static quint64 getTileKey(QStringView type, int x, int y, int z);
+    static quint64 packTileKey(quint16 providerId, int x, int y, int z);
+    static quint16 tileKeyToProviderId(quint64 tileKey) { return static_cast<quint16>(tileKey >> kTileKeyProviderShift); }
+    static QString tileKeyToType(quint64 tileKey);
+    static quint16 getProviderIdFromProviderType(QStringView type);
+    /// Provider ids are a CRC-16 of the map name, returns false and logs the names if two providers share one
+    static bool providerIdsUnique();
+
+    /// Converts a string tile hash from databases created before packed tile keys, returns kInvalidTileKey on failure
+    static quint64 tileKeyFromLegacyHash(QStringView tileHash);
+
+    static constexpr quint64 kInvalidTileKey = UINT64_MAX;
+    static constexpr int kTileKeyProviderShift = 47;
+    static constexpr quint64 kTileKeyGridBase = ((Q_UINT64_C(1) << (2 * 24)) - 1) / 3;   ///< First index past zoom level 23
+    static constexpr int kTileKeyGridBits = 20;
 
 private:
     static const QList<std::shared_ptr<const MapProvider>> _providers;
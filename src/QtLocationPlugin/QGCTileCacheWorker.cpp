@@ -20,15 +20,19 @@
 #include "QGCCachedTileSet.h"
 #include "QGCMapTasks.h"
 #include "QGCMapUrlEngine.h"
+#include "MapProvider.h"
 #include "QGCLoggingCategory.h"
 
 #include <QtCore/QDateTime>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QFile>
+#include <QtCore/QSemaphore>
 #include <QtCore/QSettings>
+#include <QtCore/QStringList>
 #include <QtSql/QSqlDatabase>
 #include <QtSql/QSqlQuery>
 #include <QtSql/QSqlError>
+#include <QtSql/QSqlRecord>
 
 QByteArray QGCCacheWorker::_bingNoTileImage;
 
@@ -38,17 +42,27 @@ QGCCacheWorker::QGCCacheWorker(QObject* parent)
     : QThread(parent)
 {
     // qCDebug(QGCTileCacheWorkerLog) << Q_FUNC_INFO << this;
+
+    // Read connections belong to the thread which opened them, so pool threads are kept for the worker's lifetime
+    _readPool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 2, kMaxReadThreads));
+    _readPool.setExpiryTimeout(-1);
 }
 
 QGCCacheWorker::~QGCCacheWorker()
 {
+    _readPool.waitForDone();
+    _closeReadDBs();
+
     // qCDebug(QGCTileCacheWorkerLog) << Q_FUNC_INFO << this;
 }
 
 void QGCCacheWorker::stop()
 {
     QMutexLocker lock(&_taskQueueMutex);
-    qDeleteAll(_taskQueue);
+    for (QQueue<QGCMapTask*> &queue : _taskQueues) {
+        qDeleteAll(queue);
+        queue.clear();
+    }
     lock.unlock();
 
     if(this->isRunning()) {
@@ -64,9 +78,14 @@ bool QGCCacheWorker::enqueueTask(QGCMapTask *task)
         return false;
     }
 
-    // TODO: Prepend Stop Task Instead?
+    // Lookups only read, so they bypass the write queue and are never stuck behind bulk work
+    if (task->type() == QGCMapTask::taskFetchTile) {
+        _readPool.start([this, task]() { _runReadTask(task); }, task->priority());
+        return true;
+    }
+
     QMutexLocker lock(&_taskQueueMutex);
-    _taskQueue.enqueue(task);
+    _taskQueues[task->priority()].enqueue(task);
     lock.unlock();
 
     if (isRunning()) {
@@ -78,6 +97,27 @@ bool QGCCacheWorker::enqueueTask(QGCMapTask *task)
     return true;
 }
 
+QGCMapTask *QGCCacheWorker::_dequeueTask()
+{
+    for (auto it = _taskQueues.rbegin(); it != _taskQueues.rend(); ++it) {
+        if (!it->isEmpty()) {
+            return it->dequeue();
+        }
+    }
+
+    return nullptr;
+}
+
+qsizetype QGCCacheWorker::_queuedTaskCount() const
+{
+    qsizetype count = 0;
+    for (const QQueue<QGCMapTask*> &queue : _taskQueues) {
+        count += queue.count();
+    }
+
+    return count;
+}
+
 //-----------------------------------------------------------------------------
 void
 QGCCacheWorker::run()
@@ -97,14 +137,14 @@ QGCCacheWorker::run()
 
     QMutexLocker lock(&_taskQueueMutex);
     while (true) {
-        if (!_taskQueue.isEmpty()) {
-            QGCMapTask* const task = _taskQueue.dequeue();
+        QGCMapTask* const task = _dequeueTask();
+        if (task) {
             lock.unlock();
             _runTask(task);
             lock.relock();
             task->deleteLater();
 
-            const qsizetype count = _taskQueue.count();
+            const qsizetype count = _queuedTaskCount();
             if (count > 100) {
                 _updateTimeout = kLongTimeout;
             } else if (count < 25) {
@@ -120,7 +160,7 @@ QGCCacheWorker::run()
             }
         } else {
             (void) _waitc.wait(lock.mutex(), 5000);
-            if (_taskQueue.isEmpty()) {
+            if (_queuedTaskCount() == 0) {
                 break;
             }
         }
@@ -177,6 +217,21 @@ void QGCCacheWorker::_runTask(QGCMapTask *task)
     }
 }
 
+void QGCCacheWorker::_runReadTask(QGCMapTask *task)
+{
+    // Only wait briefly on a reset or replacing import, _closeReadDBs needs every pool thread to make progress.
+    // A busy database is not a cache miss, the caller may retry or go to the network.
+    if (_readLock.tryLockForRead(kReadLockTimeoutMsecs)) {
+        _getTile(task);
+        _readLock.unlock();
+    } else {
+        qCDebug(QGCTileCacheWorkerLog) << "_runReadTask() (DB busy) KEY:" << static_cast<QGCFetchTileTask*>(task)->tileKey();
+        task->setError(kCacheBusyError);
+    }
+
+    task->deleteLater();
+}
+
 //-----------------------------------------------------------------------------
 void
 QGCCacheWorker::_deleteBingNoTileTiles()
@@ -199,13 +254,13 @@ QGCCacheWorker::_deleteBingNoTileTiles()
     QSqlQuery query(*_db);
     QString s;
     //-- Select tiles in default set only, sorted by oldest.
-    s = QString("SELECT tileID, tile, hash FROM Tiles WHERE LENGTH(tile) = %1").arg(noTileBytes.length());
+    s = QString("SELECT tileID, tile FROM Tiles WHERE LENGTH(tile) = %1").arg(noTileBytes.length());
     QList<quint64> idsToDelete;
     if (query.exec(s)) {
         while(query.next()) {
             if (query.value(1).toByteArray() == noTileBytes) {
                 idsToDelete.append(query.value(0).toULongLong());
-                qCDebug(QGCTileCacheWorkerLog) << "_deleteBingNoTileTiles HASH:" << query.value(2).toString();
+                qCDebug(QGCTileCacheWorkerLog) << "_deleteBingNoTileTiles KEY:" << query.value(0).toULongLong();
             }
         }
         for (const quint64 tileId: idsToDelete) {
@@ -258,22 +313,22 @@ QGCCacheWorker::_saveTile(QGCMapTask *mtask)
     if(_valid) {
         QGCSaveTileTask* task = static_cast<QGCSaveTileTask*>(mtask);
         QSqlQuery query(*_db);
-        query.prepare("INSERT INTO Tiles(hash, format, tile, size, type, date) VALUES(?, ?, ?, ?, ?, ?)");
-        query.addBindValue(task->tile()->hash());
+        query.prepare("INSERT INTO Tiles(tileID, format, tile, size, type, date) VALUES(?, ?, ?, ?, ?, ?)");
+        query.addBindValue(task->tile()->key());
         query.addBindValue(task->tile()->format());
         query.addBindValue(task->tile()->img());
         query.addBindValue(task->tile()->img().size());
         query.addBindValue(task->tile()->type());
         query.addBindValue(QDateTime::currentDateTime().toSecsSinceEpoch());
         if(query.exec()) {
-            quint64 tileID = query.lastInsertId().toULongLong();
+            quint64 tileID = task->tile()->key();
             quint64 setID = task->tile()->tileSet() == UINT64_MAX ? _getDefaultTileSet() : task->tile()->tileSet();
             QString s = QString("INSERT INTO SetTiles(tileID, setID) VALUES(%1, %2)").arg(tileID).arg(setID);
             query.prepare(s);
             if(!query.exec()) {
                 qWarning() << "Map Cache SQL error (add tile into SetTiles):" << query.lastError().text();
             }
-            qCDebug(QGCTileCacheWorkerLog) << "_saveTile() HASH:" << task->tile()->hash();
+            qCDebug(QGCTileCacheWorkerLog) << "_saveTile() KEY:" << tileID;
         } else {
             //-- Tile was already there.
             //   QtLocation some times requests the same tile twice in a row. The first is saved, the second is already there.
@@ -292,21 +347,23 @@ QGCCacheWorker::_getTile(QGCMapTask* mtask)
     }
     bool found = false;
     QGCFetchTileTask* task = static_cast<QGCFetchTileTask*>(mtask);
-    QSqlQuery query(*_db);
-    QString s = QString("SELECT tile, format, type FROM Tiles WHERE hash = \"%1\"").arg(task->hash());
-    if(query.exec(s)) {
+    QSqlQuery query(_readDB());
+    query.setForwardOnly(true);
+    query.prepare("SELECT tile, format, type FROM Tiles WHERE tileID = ?");
+    query.addBindValue(task->tileKey());
+    if(query.exec()) {
         if(query.next()) {
             const QByteArray& arrray   = query.value(0).toByteArray();
             const QString& format  = query.value(1).toString();
             const QString& type = query.value(2).toString();
-            qCDebug(QGCTileCacheWorkerLog) << "_getTile() (Found in DB) HASH:" << task->hash();
-            QGCCacheTile* tile = new QGCCacheTile(task->hash(), arrray, format, type);
+            qCDebug(QGCTileCacheWorkerLog) << "_getTile() (Found in DB) KEY:" << task->tileKey();
+            QGCCacheTile* tile = new QGCCacheTile(task->tileKey(), arrray, format, type);
             task->setTileFetched(tile);
             found = true;
         }
     }
     if(!found) {
-        qCDebug(QGCTileCacheWorkerLog) << "_getTile() (NOT in DB) HASH:" << task->hash();
+        qCDebug(QGCTileCacheWorkerLog) << "_getTile() (NOT in DB) KEY:" << task->tileKey();
         task->setError("Tile not in cache database");
     }
 }
@@ -435,17 +492,14 @@ QGCCacheWorker::_updateTotals()
 }
 
 //-----------------------------------------------------------------------------
-quint64 QGCCacheWorker::_findTile(const QString &hash)
+bool QGCCacheWorker::_findTile(quint64 tileKey)
 {
-    quint64 tileID = 0;
     QSqlQuery query(*_db);
-    QString s = QString("SELECT tileID FROM Tiles WHERE hash = \"%1\"").arg(hash);
+    QString s = QString("SELECT 1 FROM Tiles WHERE tileID = %1").arg(tileKey);
     if(query.exec(s)) {
-        if(query.next()) {
-            tileID = query.value(0).toULongLong();
-        }
+        return query.next();
     }
-    return tileID;
+    return false;
 }
 
 //-----------------------------------------------------------------------------
@@ -484,17 +538,18 @@ QGCCacheWorker::_createTileSet(QGCMapTask *mtask)
                     task->tileSet()->topleftLon(), task->tileSet()->topleftLat(),
                     task->tileSet()->bottomRightLon(), task->tileSet()->bottomRightLat(), task->tileSet()->type());
                 QString type = task->tileSet()->type();
+                const quint16 providerId = UrlFactory::getProviderIdFromProviderType(type);
+                const int mapId = UrlFactory::getQtMapIdFromProviderType(type);
                 for(int x = set.tileX0; x <= set.tileX1; x++) {
                     for(int y = set.tileY0; y <= set.tileY1; y++) {
                         //-- See if tile is already downloaded
-                        QString hash = UrlFactory::getTileHash(type, x, y, z);
-                        quint64 tileID = _findTile(hash);
-                        if(!tileID) {
+                        const quint64 tileKey = UrlFactory::packTileKey(providerId, x, y, z);
+                        if(!_findTile(tileKey)) {
                             //-- Set to download
-                            query.prepare("INSERT OR IGNORE INTO TilesDownload(setID, hash, type, x, y, z, state) VALUES(?, ?, ?, ?, ? ,? ,?)");
+                            query.prepare("INSERT OR IGNORE INTO TilesDownload(setID, tileKey, type, x, y, z, state) VALUES(?, ?, ?, ?, ? ,? ,?)");
                             query.addBindValue(setID);
-                            query.addBindValue(hash);
-                            query.addBindValue(UrlFactory::getQtMapIdFromProviderType(type));
+                            query.addBindValue(tileKey);
+                            query.addBindValue(mapId);
                             query.addBindValue(x);
                             query.addBindValue(y);
                             query.addBindValue(z);
@@ -507,12 +562,12 @@ QGCCacheWorker::_createTileSet(QGCMapTask *mtask)
                                 actual_count++;
                         } else {
                             //-- Tile already in the database. No need to dowload.
-                            QString s = QString("INSERT OR IGNORE INTO SetTiles(tileID, setID) VALUES(%1, %2)").arg(tileID).arg(setID);
+                            QString s = QString("INSERT OR IGNORE INTO SetTiles(tileID, setID) VALUES(%1, %2)").arg(tileKey).arg(setID);
                             query.prepare(s);
                             if(!query.exec()) {
                                 qWarning() << "Map Cache SQL error (add tile into SetTiles):" << query.lastError().text();
                             }
-                            qCDebug(QGCTileCacheWorkerLog) << "_createTileSet() Already Cached HASH:" << hash;
+                            qCDebug(QGCTileCacheWorkerLog) << "_createTileSet() Already Cached KEY:" << tileKey;
                         }
                     }
                 }
@@ -537,12 +592,12 @@ QGCCacheWorker::_getTileDownloadList(QGCMapTask* mtask)
     QQueue<QGCTile*> tiles;
     QGCGetTileDownloadListTask* task = static_cast<QGCGetTileDownloadListTask*>(mtask);
     QSqlQuery query(*_db);
-    QString s = QString("SELECT hash, type, x, y, z FROM TilesDownload WHERE setID = %1 AND state = 0 LIMIT %2").arg(task->setID()).arg(task->count());
+    QString s = QString("SELECT tileKey, type, x, y, z FROM TilesDownload WHERE setID = %1 AND state = 0 LIMIT %2").arg(task->setID()).arg(task->count());
     if(query.exec(s)) {
         while(query.next()) {
             QGCTile* tile = new QGCTile;
             // tile->setTileSet(task->setID());
-            tile->setHash(query.value("hash").toString());
+            tile->setKey(query.value("tileKey").toULongLong());
             tile->setType(UrlFactory::getProviderTypeFromQtMapId(query.value("type").toInt()));
             tile->setX(query.value("x").toInt());
             tile->setY(query.value("y").toInt());
@@ -550,7 +605,7 @@ QGCCacheWorker::_getTileDownloadList(QGCMapTask* mtask)
             tiles.enqueue(tile);
         }
         for(int i = 0; i < tiles.size(); i++) {
-            s = QString("UPDATE TilesDownload SET state = %1 WHERE setID = %2 and hash = \"%3\"").arg(static_cast<int>(QGCTile::StateDownloading)).arg(task->setID()).arg(tiles[i]->hash());
+            s = QString("UPDATE TilesDownload SET state = %1 WHERE setID = %2 and tileKey = %3").arg(static_cast<int>(QGCTile::StateDownloading)).arg(task->setID()).arg(tiles[i]->key());
             if(!query.exec(s)) {
                 qWarning() << "Map Cache SQL error (set TilesDownload state):" << query.lastError().text();
             }
@@ -570,12 +625,12 @@ QGCCacheWorker::_updateTileDownloadState(QGCMapTask* mtask)
     QSqlQuery query(*_db);
     QString s;
     if(task->state() == QGCTile::StateComplete) {
-        s = QString("DELETE FROM TilesDownload WHERE setID = %1 AND hash = \"%2\"").arg(task->setID()).arg(task->hash());
+        s = QString("DELETE FROM TilesDownload WHERE setID = %1 AND tileKey = %2").arg(task->setID()).arg(task->tileKey());
     } else {
-        if(task->hash() == "*") {
+        if(task->tileKey() == QGCUpdateTileDownloadStateTask::kAllTiles) {
             s = QString("UPDATE TilesDownload SET state = %1 WHERE setID = %2").arg(static_cast<int>(task->state())).arg(task->setID());
         } else {
-            s = QString("UPDATE TilesDownload SET state = %1 WHERE setID = %2 AND hash = \"%3\"").arg(static_cast<int>(task->state())).arg(task->setID()).arg(task->hash());
+            s = QString("UPDATE TilesDownload SET state = %1 WHERE setID = %2 AND tileKey = %3").arg(static_cast<int>(task->state())).arg(task->setID()).arg(task->tileKey());
         }
     }
     if(!query.exec(s)) {
@@ -594,14 +649,14 @@ QGCCacheWorker::_pruneCache(QGCMapTask* mtask)
     QSqlQuery query(*_db);
     QString s;
     //-- Select tiles in default set only, sorted by oldest.
-    s = QString("SELECT tileID, size, hash FROM Tiles WHERE tileID IN (SELECT A.tileID FROM SetTiles A join SetTiles B on A.tileID = B.tileID WHERE B.setID = %1 GROUP by A.tileID HAVING COUNT(A.tileID) = 1) ORDER BY DATE ASC LIMIT 128").arg(_getDefaultTileSet());
+    s = QString("SELECT tileID, size FROM Tiles WHERE tileID IN (SELECT A.tileID FROM SetTiles A join SetTiles B on A.tileID = B.tileID WHERE B.setID = %1 GROUP by A.tileID HAVING COUNT(A.tileID) = 1) ORDER BY DATE ASC LIMIT 128").arg(_getDefaultTileSet());
     qint64 amount = (qint64)task->amount();
     QList<quint64> tlist;
     if(query.exec(s)) {
         while(query.next() && amount >= 0) {
             tlist << query.value(0).toULongLong();
             amount -= query.value(1).toULongLong();
-            qCDebug(QGCTileCacheWorkerLog) << "_pruneCache() HASH:" << query.value(2).toString();
+            qCDebug(QGCTileCacheWorkerLog) << "_pruneCache() KEY:" << query.value(0).toULongLong();
         }
         while(tlist.count()) {
             s = QString("DELETE FROM Tiles WHERE tileID = %1").arg(tlist[0]);
@@ -667,6 +722,7 @@ QGCCacheWorker::_resetCacheDatabase(QGCMapTask* mtask)
         return;
     }
     QGCResetTask* task = static_cast<QGCResetTask*>(mtask);
+    QWriteLocker lock(&_readLock);
     QSqlQuery query(*_db);
     QString s;
     s = QString("DROP TABLE Tiles");
@@ -681,6 +737,71 @@ QGCCacheWorker::_resetCacheDatabase(QGCMapTask* mtask)
     task->setResetCompleted();
 }
 
+//-----------------------------------------------------------------------------
+bool
+QGCCacheWorker::_attachDB(const QString& path)
+{
+    QSqlQuery query(*_db);
+    query.prepare(QString("ATTACH DATABASE ? AS %1").arg(kTransferSchema));
+    query.addBindValue(path);
+    if(!query.exec()) {
+        qWarning() << "Map Cache SQL error (attach database):" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCCacheWorker::_detachDB()
+{
+    QSqlQuery query(*_db);
+    if(!query.exec(QString("DETACH DATABASE %1").arg(kTransferSchema))) {
+        qWarning() << "Map Cache SQL error (detach database):" << query.lastError().text();
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool
+QGCCacheWorker::_copySetTiles(const QString& source, quint64 sourceSetID, const QString& target, quint64 targetSetID, quint64& tilesAdded, const std::function<void(quint64)>& progress)
+{
+    //-- Copies in key ranges of kBulkCopyRows so progress can be reported. Each range is located through the
+    //   SetTiles (setID, tileID) index and copied with set based statements.
+    QSqlQuery query(*_db);
+    const qint64 now = QDateTime::currentDateTime().toSecsSinceEpoch();
+    qint64 lastTileID = -1;
+    while(true) {
+        QString s = QString("SELECT MAX(tileID), COUNT(tileID) FROM (SELECT tileID FROM %1.SetTiles WHERE setID = %2 AND tileID > %3 ORDER BY tileID LIMIT %4)")
+            .arg(source).arg(sourceSetID).arg(lastTileID).arg(kBulkCopyRows);
+        if(!query.exec(s) || !query.next()) {
+            qWarning() << "Map Cache SQL error (bulk copy range):" << query.lastError().text();
+            return false;
+        }
+        const quint64 rows = query.value(1).toULongLong();
+        if(!rows) {
+            return true;
+        }
+        const qint64 upperTileID = query.value(0).toLongLong();
+        const QString range = QString("FROM %1.SetTiles S JOIN %1.Tiles T ON T.tileID = S.tileID WHERE S.setID = %2 AND S.tileID > %3 AND S.tileID <= %4")
+            .arg(source).arg(sourceSetID).arg(lastTileID).arg(upperTileID);
+        s = QString("INSERT OR IGNORE INTO %1.Tiles(tileID, format, tile, size, type, date) SELECT T.tileID, T.format, T.tile, T.size, T.type, %2 %3")
+            .arg(target).arg(now).arg(range);
+        if(!query.exec(s)) {
+            qWarning() << "Map Cache SQL error (bulk copy tiles):" << query.lastError().text();
+            return false;
+        }
+        tilesAdded += qMax(query.numRowsAffected(), 0);
+        s = QString("INSERT INTO %1.SetTiles(tileID, setID) SELECT DISTINCT S.tileID, %2 %3 AND NOT EXISTS (SELECT 1 FROM %1.SetTiles M WHERE M.setID = %2 AND M.tileID = S.tileID)")
+            .arg(target).arg(targetSetID).arg(range);
+        if(!query.exec(s)) {
+            qWarning() << "Map Cache SQL error (bulk copy set tiles):" << query.lastError().text();
+            return false;
+        }
+        progress(rows);
+        lastTileID = upperTileID;
+    }
+}
+
 //-----------------------------------------------------------------------------
 void
 QGCCacheWorker::_importSets(QGCMapTask* mtask)
@@ -691,10 +812,14 @@ QGCCacheWorker::_importSets(QGCMapTask* mtask)
     QGCImportTileTask* task = static_cast<QGCImportTileTask*>(mtask);
     //-- If replacing, simply copy over it
     if(task->replace()) {
-        //-- Close and delete old database
+        //-- Close and delete old database, no reader may hold it open or leave its WAL behind
+        QWriteLocker lock(&_readLock);
+        _closeReadDBs();
         _disconnectDB();
         QFile file(_databasePath);
         file.remove();
+        QFile::remove(_databasePath + "-wal");
+        QFile::remove(_databasePath + "-shm");
         //-- Copy given database
         QFile::copy(task->path(), _databasePath);
         task->setProgress(25);
@@ -704,159 +829,165 @@ QGCCacheWorker::_importSets(QGCMapTask* mtask)
             _connectDB();
         }
         task->setProgress(100);
-    } else {
-        //-- Open imported set
-        QSqlDatabase* dbImport = new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE", kExportSession));
-        dbImport->setDatabaseName(task->path());
-        dbImport->setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-        if (dbImport->open()) {
-            QSqlQuery query(*dbImport);
-            //-- Prepare progress report
-            quint64 tileCount = 0;
-            quint64 currentCount = 0;
-            int lastProgress = -1;
-            QString s;
-            s = QString("SELECT COUNT(tileID) FROM Tiles");
-            if(query.exec(s)) {
-                if(query.next()) {
-                    //-- Total number of tiles in imported database
-                    tileCount  = query.value(0).toULongLong();
-                }
-            }
-            if(tileCount) {
-                //-- Iterate Tile Sets
-                s = QString("SELECT * FROM TileSets ORDER BY defaultSet DESC, name ASC");
-                if(query.exec(s)) {
-                    while(query.next()) {
-                        QString name            = query.value("name").toString();
-                        quint64 setID           = query.value("setID").toULongLong();
-                        QString mapType         = query.value("typeStr").toString();
-                        double  topleftLat      = query.value("topleftLat").toDouble();
-                        double  topleftLon      = query.value("topleftLon").toDouble();
-                        double  bottomRightLat  = query.value("bottomRightLat").toDouble();
-                        double  bottomRightLon  = query.value("bottomRightLon").toDouble();
-                        int     minZoom         = query.value("minZoom").toInt();
-                        int     maxZoom         = query.value("maxZoom").toInt();
-                        int     type            = query.value("type").toInt();
-                        quint32 numTiles        = query.value("numTiles").toUInt();
-                        int     defaultSet      = query.value("defaultSet").toInt();
-                        quint64 insertSetID     = _getDefaultTileSet();
-                        //-- If not default set, create new one
-                        if(!defaultSet) {
-                            //-- Check if we have this tile set already
-                            if(_findTileSetID(name, insertSetID)) {
-                                int testCount = 0;
-                                //-- Set with this name already exists. Make name unique.
-                                while (true) {
-                                    auto testName = QString::asprintf("%s %02d", name.toLatin1().data(), ++testCount);
-                                    if(!_findTileSetID(testName, insertSetID) || testCount > 99) {
-                                        name = testName;
-                                        break;
-                                    }
-                                }
-                            }
-                            //-- Create new set
-                            QSqlQuery cQuery(*_db);
-                            cQuery.prepare("INSERT INTO TileSets("
-                                "name, typeStr, topleftLat, topleftLon, bottomRightLat, bottomRightLon, minZoom, maxZoom, type, numTiles, defaultSet, date"
-                                ") VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-                            cQuery.addBindValue(name);
-                            cQuery.addBindValue(mapType);
-                            cQuery.addBindValue(topleftLat);
-                            cQuery.addBindValue(topleftLon);
-                            cQuery.addBindValue(bottomRightLat);
-                            cQuery.addBindValue(bottomRightLon);
-                            cQuery.addBindValue(minZoom);
-                            cQuery.addBindValue(maxZoom);
-                            cQuery.addBindValue(type);
-                            cQuery.addBindValue(numTiles);
-                            cQuery.addBindValue(defaultSet);
-                            cQuery.addBindValue(QDateTime::currentDateTime().toSecsSinceEpoch());
-                            if(!cQuery.exec()) {
-                                task->setError("Error adding imported tile set to database");
+        task->setImportCompleted();
+        return;
+    }
+    //-- Check imported database, databases exported before packed tile keys are migrated on a copy
+    QString importPath = task->path();
+    const QString migratedPath = _databasePath + QStringLiteral(".import");
+    bool opened = false;
+    bool migrated = false;
+    {
+        QSqlDatabase dbImport = QSqlDatabase::addDatabase("QSQLITE", kExportSession);
+        dbImport.setDatabaseName(importPath);
+        opened = dbImport.open();
+        if(opened && _isLegacyDB(dbImport)) {
+            dbImport.close();
+            QFile::remove(migratedPath);
+            dbImport.setDatabaseName(migratedPath);
+            opened = QFile::copy(importPath, migratedPath) && dbImport.open() && _createDB(dbImport, false);
+            migrated = true;
+            importPath = migratedPath;
+        }
+        dbImport.close();
+    }
+    QSqlDatabase::removeDatabase(kExportSession);
+    if(!opened || !_attachDB(importPath)) {
+        task->setError("Error opening import database");
+        if(migrated) {
+            QFile::remove(migratedPath);
+        }
+        task->setImportCompleted();
+        return;
+    }
+    QSqlQuery query(*_db);
+    //-- Prepare progress report
+    quint64 tileCount = 0;
+    quint64 currentCount = 0;
+    quint64 totalSaved = 0;
+    int lastProgress = -1;
+    QString s;
+    s = QString("SELECT COUNT(tileID) FROM %1.SetTiles").arg(kTransferSchema);
+    if(query.exec(s)) {
+        if(query.next()) {
+            //-- Total number of tiles in imported database
+            tileCount  = query.value(0).toULongLong();
+        }
+    }
+    //-- Exports made before the SetTiles index existed get one, failure only makes the copy slower
+    s = QString("CREATE INDEX IF NOT EXISTS %1.SetTilesIndex ON SetTiles (setID, tileID)").arg(kTransferSchema);
+    query.exec(s);
+    const auto reportProgress = [&](quint64 rows) {
+        currentCount += rows;
+        const int progress = (int)((double)currentCount / (double)qMax(tileCount, (quint64)1) * 100.0);
+        //-- Avoid calling this if (int) progress hasn't changed.
+        if(lastProgress != progress) {
+            lastProgress = progress;
+            task->setProgress(progress);
+        }
+    };
+    if(tileCount) {
+        _db->transaction();
+        bool ok = true;
+        //-- Iterate Tile Sets
+        s = QString("SELECT * FROM %1.TileSets ORDER BY defaultSet DESC, name ASC").arg(kTransferSchema);
+        if(query.exec(s)) {
+            while(query.next()) {
+                QString name            = query.value("name").toString();
+                quint64 setID           = query.value("setID").toULongLong();
+                QString mapType         = query.value("typeStr").toString();
+                double  topleftLat      = query.value("topleftLat").toDouble();
+                double  topleftLon      = query.value("topleftLon").toDouble();
+                double  bottomRightLat  = query.value("bottomRightLat").toDouble();
+                double  bottomRightLon  = query.value("bottomRightLon").toDouble();
+                int     minZoom         = query.value("minZoom").toInt();
+                int     maxZoom         = query.value("maxZoom").toInt();
+                int     type            = query.value("type").toInt();
+                quint32 numTiles        = query.value("numTiles").toUInt();
+                int     defaultSet      = query.value("defaultSet").toInt();
+                quint64 insertSetID     = _getDefaultTileSet();
+                //-- If not default set, create new one
+                if(!defaultSet) {
+                    //-- Check if we have this tile set already
+                    if(_findTileSetID(name, insertSetID)) {
+                        int testCount = 0;
+                        //-- Set with this name already exists. Make name unique.
+                        while (true) {
+                            auto testName = QString::asprintf("%s %02d", name.toLatin1().data(), ++testCount);
+                            if(!_findTileSetID(testName, insertSetID) || testCount > 99) {
+                                name = testName;
                                 break;
-                            } else {
-                                //-- Get just created (auto-incremented) setID
-                                insertSetID = cQuery.lastInsertId().toULongLong();
                             }
                         }
-                        //-- Find set tiles
-                        QSqlQuery cQuery(*_db);
-                        QSqlQuery subQuery(*dbImport);
-                        QString sb = QString("SELECT * FROM Tiles WHERE tileID IN (SELECT A.tileID FROM SetTiles A JOIN SetTiles B ON A.tileID = B.tileID WHERE B.setID = %1 GROUP BY A.tileID HAVING COUNT(A.tileID) = 1)").arg(setID);
-                        if(subQuery.exec(sb)) {
-                            quint64 tilesFound = 0;
-                            quint64 tilesSaved = 0;
-                            _db->transaction();
-                            while(subQuery.next()) {
-                                tilesFound++;
-                                QString hash    = subQuery.value("hash").toString();
-                                QString format  = subQuery.value("format").toString();
-                                QByteArray img  = subQuery.value("tile").toByteArray();
-                                int type        = subQuery.value("type").toInt();
-                                //-- Save tile
-                                cQuery.prepare("INSERT INTO Tiles(hash, format, tile, size, type, date) VALUES(?, ?, ?, ?, ?, ?)");
-                                cQuery.addBindValue(hash);
-                                cQuery.addBindValue(format);
-                                cQuery.addBindValue(img);
-                                cQuery.addBindValue(img.size());
-                                cQuery.addBindValue(type);
-                                cQuery.addBindValue(QDateTime::currentDateTime().toSecsSinceEpoch());
-                                if(cQuery.exec()) {
-                                    tilesSaved++;
-                                    quint64 importTileID = cQuery.lastInsertId().toULongLong();
-                                    QString s = QString("INSERT INTO SetTiles(tileID, setID) VALUES(%1, %2)").arg(importTileID).arg(insertSetID);
-                                    cQuery.prepare(s);
-                                    cQuery.exec();
-                                    currentCount++;
-                                    if(tileCount) {
-                                        int progress = (int)((double)currentCount / (double)tileCount * 100.0);
-                                        //-- Avoid calling this if (int) progress hasn't changed.
-                                        if(lastProgress != progress) {
-                                            lastProgress = progress;
-                                            task->setProgress(progress);
-                                        }
-                                    }
-                                }
-                            }
-                            _db->commit();
-                            if(tilesSaved) {
-                                //-- Update tile count (if any added)
-                                s = QString("SELECT COUNT(size) FROM Tiles A INNER JOIN SetTiles B on A.tileID = B.tileID WHERE B.setID = %1").arg(insertSetID);
-                                if(cQuery.exec(s)) {
-                                    if(cQuery.next()) {
-                                        quint64 count  = cQuery.value(0).toULongLong();
-                                        s = QString("UPDATE TileSets SET numTiles = %1 WHERE setID = %2").arg(count).arg(insertSetID);
-                                        cQuery.exec(s);
-                                    }
-                                }
-                            }
-                            qint64 uniqueTiles = tilesFound - tilesSaved;
-                            if((quint64)uniqueTiles < tileCount) {
-                                tileCount -= uniqueTiles;
-                            } else {
-                                tileCount = 0;
-                            }
-                            //-- If there was nothing new in this set, remove it.
-                            if(!tilesSaved && !defaultSet) {
-                                qCDebug(QGCTileCacheWorkerLog) << "No unique tiles in" << name << "Removing it.";
-                                _deleteTileSet(insertSetID);
-                            }
+                    }
+                    //-- Create new set
+                    QSqlQuery cQuery(*_db);
+                    cQuery.prepare("INSERT INTO TileSets("
+                        "name, typeStr, topleftLat, topleftLon, bottomRightLat, bottomRightLon, minZoom, maxZoom, type, numTiles, defaultSet, date"
+                        ") VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+                    cQuery.addBindValue(name);
+                    cQuery.addBindValue(mapType);
+                    cQuery.addBindValue(topleftLat);
+                    cQuery.addBindValue(topleftLon);
+                    cQuery.addBindValue(bottomRightLat);
+                    cQuery.addBindValue(bottomRightLon);
+                    cQuery.addBindValue(minZoom);
+                    cQuery.addBindValue(maxZoom);
+                    cQuery.addBindValue(type);
+                    cQuery.addBindValue(numTiles);
+                    cQuery.addBindValue(defaultSet);
+                    cQuery.addBindValue(QDateTime::currentDateTime().toSecsSinceEpoch());
+                    if(!cQuery.exec()) {
+                        task->setError("Error adding imported tile set to database");
+                        ok = false;
+                        break;
+                    } else {
+                        //-- Get just created (auto-incremented) setID
+                        insertSetID = cQuery.lastInsertId().toULongLong();
+                    }
+                }
+                //-- Copy set tiles
+                quint64 tilesSaved = 0;
+                if(!_copySetTiles(kTransferSchema, setID, "main", insertSetID, tilesSaved, reportProgress)) {
+                    task->setError("Error importing tiles");
+                    ok = false;
+                    break;
+                }
+                totalSaved += tilesSaved;
+                if(tilesSaved) {
+                    //-- Update tile count (if any added)
+                    QSqlQuery cQuery(*_db);
+                    s = QString("SELECT COUNT(size) FROM Tiles A INNER JOIN SetTiles B on A.tileID = B.tileID WHERE B.setID = %1").arg(insertSetID);
+                    if(cQuery.exec(s)) {
+                        if(cQuery.next()) {
+                            quint64 count  = cQuery.value(0).toULongLong();
+                            s = QString("UPDATE TileSets SET numTiles = %1 WHERE setID = %2").arg(count).arg(insertSetID);
+                            cQuery.exec(s);
                         }
                     }
-                } else {
-                    task->setError("No tile set in database");
+                } else if(!defaultSet) {
+                    //-- If there was nothing new in this set, remove it.
+                    qCDebug(QGCTileCacheWorkerLog) << "No unique tiles in" << name << "Removing it.";
+                    _deleteTileSet(insertSetID);
                 }
             }
-            delete dbImport;
-            QSqlDatabase::removeDatabase(kExportSession);
-            if(!tileCount) {
-                task->setError("No unique tiles in imported database");
-            }
         } else {
-            task->setError("Error opening import database");
+            task->setError("No tile set in database");
+            ok = false;
+        }
+        if(ok) {
+            _db->commit();
+        } else {
+            _db->rollback();
         }
     }
+    _detachDB();
+    if(migrated) {
+        QFile::remove(migratedPath);
+    }
+    if(!totalSaved) {
+        task->setError("No unique tiles in imported database");
+    }
     task->setImportCompleted();
 }
 
@@ -872,100 +1003,97 @@ QGCCacheWorker::_exportSets(QGCMapTask* mtask)
     QFile file(task->path());
     file.remove();
     //-- Create exported database
-    QScopedPointer<QSqlDatabase> dbExport(new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE", kExportSession)));
-    dbExport->setDatabaseName(task->path());
-    dbExport->setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-    if (dbExport->open()) {
-        if(_createDB(*dbExport, false)) {
-            //-- Prepare progress report
-            quint64 tileCount = 0;
-            quint64 currentCount = 0;
-            for(int i = 0; i < task->sets().count(); i++) {
-                QGCCachedTileSet* set = task->sets()[i];
-                //-- Default set has no unique tiles
-                if(set->defaultSet()) {
-                    tileCount += set->totalTileCount();
-                } else {
-                    tileCount += set->uniqueTileCount();
-                }
-            }
-            if(!tileCount) {
-                tileCount = 1;
-            }
-            //-- Iterate sets to save
-            for(int i = 0; i < task->sets().count(); i++) {
-                QGCCachedTileSet* set = task->sets()[i];
-                //-- Create Tile Exported Set
-                QSqlQuery exportQuery(*dbExport);
-                exportQuery.prepare("INSERT INTO TileSets("
-                    "name, typeStr, topleftLat, topleftLon, bottomRightLat, bottomRightLon, minZoom, maxZoom, type, numTiles, defaultSet, date"
-                    ") VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-                exportQuery.addBindValue(set->name());
-                exportQuery.addBindValue(set->mapTypeStr());
-                exportQuery.addBindValue(set->topleftLat());
-                exportQuery.addBindValue(set->topleftLon());
-                exportQuery.addBindValue(set->bottomRightLat());
-                exportQuery.addBindValue(set->bottomRightLon());
-                exportQuery.addBindValue(set->minZoom());
-                exportQuery.addBindValue(set->maxZoom());
-                exportQuery.addBindValue(UrlFactory::getQtMapIdFromProviderType(set->type()));
-                exportQuery.addBindValue(set->totalTileCount());
-                exportQuery.addBindValue(set->defaultSet());
-                exportQuery.addBindValue(QDateTime::currentDateTime().toSecsSinceEpoch());
-                if(!exportQuery.exec()) {
-                    task->setError("Error adding tile set to exported database");
-                    break;
-                } else {
-                    //-- Get just created (auto-incremented) setID
-                    quint64 exportSetID = exportQuery.lastInsertId().toULongLong();
-                    //-- Find set tiles
-                    QString s = QString("SELECT * FROM SetTiles WHERE setID = %1").arg(set->id());
-                    QSqlQuery query(*_db);
-                    if(query.exec(s)) {
-                        dbExport->transaction();
-                        while(query.next()) {
-                            quint64 tileID = query.value("tileID").toULongLong();
-                            //-- Get tile
-                            QString s = QString("SELECT * FROM Tiles WHERE tileID = \"%1\"").arg(tileID);
-                            QSqlQuery subQuery(*_db);
-                            if(subQuery.exec(s)) {
-                                if(subQuery.next()) {
-                                    QString hash    = subQuery.value("hash").toString();
-                                    QString format  = subQuery.value("format").toString();
-                                    QByteArray img  = subQuery.value("tile").toByteArray();
-                                    int type        = subQuery.value("type").toInt();
-                                    //-- Save tile
-                                    exportQuery.prepare("INSERT INTO Tiles(hash, format, tile, size, type, date) VALUES(?, ?, ?, ?, ?, ?)");
-                                    exportQuery.addBindValue(hash);
-                                    exportQuery.addBindValue(format);
-                                    exportQuery.addBindValue(img);
-                                    exportQuery.addBindValue(img.size());
-                                    exportQuery.addBindValue(type);
-                                    exportQuery.addBindValue(QDateTime::currentDateTime().toSecsSinceEpoch());
-                                    if(exportQuery.exec()) {
-                                        quint64 exportTileID = exportQuery.lastInsertId().toULongLong();
-                                        QString s = QString("INSERT INTO SetTiles(tileID, setID) VALUES(%1, %2)").arg(exportTileID).arg(exportSetID);
-                                        exportQuery.prepare(s);
-                                        exportQuery.exec();
-                                        currentCount++;
-                                        task->setProgress((int)((double)currentCount / (double)tileCount * 100.0));
-                                    }
-                                }
-                            }
-                        }
-                    }
-                    dbExport->commit();
-                }
-            }
+    bool opened = false;
+    bool created = false;
+    {
+        QSqlDatabase dbExport = QSqlDatabase::addDatabase("QSQLITE", kExportSession);
+        dbExport.setDatabaseName(task->path());
+        opened = dbExport.open();
+        if(opened) {
+            created = _createDB(dbExport, false);
         } else {
-            task->setError("Error creating export database");
+            qCritical() << "Map Cache SQL error (create export database):" << dbExport.lastError();
         }
-    } else {
-        qCritical() << "Map Cache SQL error (create export database):" << dbExport->lastError();
-        task->setError("Error opening export database");
+        dbExport.close();
     }
-    dbExport.reset();
     QSqlDatabase::removeDatabase(kExportSession);
+    if(!opened || !_attachDB(task->path())) {
+        task->setError("Error opening export database");
+        task->setExportCompleted();
+        return;
+    }
+    if(!created) {
+        task->setError("Error creating export database");
+        _detachDB();
+        task->setExportCompleted();
+        return;
+    }
+    QSqlQuery exportQuery(*_db);
+    //-- The export is a new file which is deleted on failure, so it does not need to survive a crash mid-write
+    exportQuery.exec(QString("PRAGMA %1.synchronous = OFF").arg(kTransferSchema));
+    //-- Prepare progress report
+    quint64 tileCount = 0;
+    quint64 currentCount = 0;
+    int lastProgress = -1;
+    for(int i = 0; i < task->sets().count(); i++) {
+        QString s = QString("SELECT COUNT(tileID) FROM SetTiles WHERE setID = %1").arg(task->sets()[i]->id());
+        if(exportQuery.exec(s) && exportQuery.next()) {
+            tileCount += exportQuery.value(0).toULongLong();
+        }
+    }
+    if(!tileCount) {
+        tileCount = 1;
+    }
+    const auto reportProgress = [&](quint64 rows) {
+        currentCount += rows;
+        const int progress = (int)((double)currentCount / (double)tileCount * 100.0);
+        if(lastProgress != progress) {
+            lastProgress = progress;
+            task->setProgress(progress);
+        }
+    };
+    _db->transaction();
+    bool ok = true;
+    //-- Iterate sets to save
+    for(int i = 0; i < task->sets().count(); i++) {
+        QGCCachedTileSet* set = task->sets()[i];
+        //-- Create Tile Exported Set
+        exportQuery.prepare(QString("INSERT INTO %1.TileSets("
+            "name, typeStr, topleftLat, topleftLon, bottomRightLat, bottomRightLon, minZoom, maxZoom, type, numTiles, defaultSet, date"
+            ") VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)").arg(kTransferSchema));
+        exportQuery.addBindValue(set->name());
+        exportQuery.addBindValue(set->mapTypeStr());
+        exportQuery.addBindValue(set->topleftLat());
+        exportQuery.addBindValue(set->topleftLon());
+        exportQuery.addBindValue(set->bottomRightLat());
+        exportQuery.addBindValue(set->bottomRightLon());
+        exportQuery.addBindValue(set->minZoom());
+        exportQuery.addBindValue(set->maxZoom());
+        exportQuery.addBindValue(UrlFactory::getQtMapIdFromProviderType(set->type()));
+        exportQuery.addBindValue(set->totalTileCount());
+        exportQuery.addBindValue(set->defaultSet());
+        exportQuery.addBindValue(QDateTime::currentDateTime().toSecsSinceEpoch());
+        if(!exportQuery.exec()) {
+            task->setError("Error adding tile set to exported database");
+            ok = false;
+            break;
+        }
+        //-- Get just created (auto-incremented) setID
+        quint64 exportSetID = exportQuery.lastInsertId().toULongLong();
+        //-- Copy set tiles
+        quint64 tilesSaved = 0;
+        if(!_copySetTiles("main", set->id(), kTransferSchema, exportSetID, tilesSaved, reportProgress)) {
+            task->setError("Error adding tiles to exported database");
+            ok = false;
+            break;
+        }
+    }
+    if(ok) {
+        _db->commit();
+    } else {
+        _db->rollback();
+    }
+    _detachDB();
     task->setExportCompleted();
 }
 
@@ -1010,21 +1138,105 @@ QGCCacheWorker::_connectDB()
 {
     _db.reset(new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE", kSession)));
     _db->setDatabaseName(_databasePath);
-    _db->setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
     _valid = _db->open();
+    if(_valid) {
+        //-- Readers see the last committed state while this connection writes, the mode is persistent in the file
+        QSqlQuery query(*_db);
+        if(!query.exec("PRAGMA journal_mode = WAL")) {
+            qWarning() << "Map Cache SQL error (enable WAL):" << query.lastError().text();
+        }
+    }
     return _valid;
 }
 
+//-----------------------------------------------------------------------------
+QString
+QGCCacheWorker::_readSessionPrefix() const
+{
+    return QString("%1_%2").arg(kReadSession).arg(reinterpret_cast<quintptr>(this));
+}
+
+//-----------------------------------------------------------------------------
+QGCCacheWorker::ReadConnection::~ReadConnection()
+{
+    QSqlDatabase::removeDatabase(name);
+}
+
+//-----------------------------------------------------------------------------
+QSqlDatabase
+QGCCacheWorker::_readDB()
+{
+    //-- QSqlDatabase connections may only be used and removed by the thread which created them
+    static std::atomic_int nextReadConnection = 0;
+    if(!_readConnections.hasLocalData()) {
+        ReadConnection* const readConnection = new ReadConnection;
+        readConnection->name = QString("%1_%2").arg(_readSessionPrefix()).arg(nextReadConnection++);
+        _readConnections.setLocalData(readConnection);
+    }
+    const QString connectionName = _readConnections.localData()->name;
+    if(QSqlDatabase::contains(connectionName)) {
+        QSqlDatabase db = QSqlDatabase::database(connectionName, false);
+        if(db.isOpen() || db.open()) {
+            return db;
+        }
+        qWarning() << "Map Cache SQL error (open read db):" << db.lastError();
+        return db;
+    }
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    db.setDatabaseName(_databasePath);
+    if(db.open()) {
+        QSqlQuery query(db);
+        (void) query.exec("PRAGMA query_only = 1");
+    } else {
+        qWarning() << "Map Cache SQL error (open read db):" << db.lastError();
+    }
+    return db;
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCCacheWorker::_closeReadDBs()
+{
+    //-- Each pool thread closes its own connection. Every job waits until all of them have closed, so with one job per
+    //-- thread they can only run on different threads. Read tasks wait at most kReadLockTimeoutMsecs, see _runReadTask.
+    if(_readConnections.hasLocalData()) {
+        _readConnections.setLocalData(nullptr);
+    }
+    const int threadCount = _readPool.maxThreadCount();
+    const std::shared_ptr<QSemaphore> closed = std::make_shared<QSemaphore>();
+    const std::shared_ptr<QSemaphore> done = std::make_shared<QSemaphore>();
+    for(int i = 0; i < threadCount; i++) {
+        _readPool.start([this, closed, done]() {
+            if(_readConnections.hasLocalData()) {
+                _readConnections.setLocalData(nullptr);
+            }
+            closed->release();
+            done->acquire();
+        }, QGCMapTask::PriorityHigh + 1);
+    }
+    closed->acquire(threadCount);
+    done->release(threadCount);
+}
+
 //-----------------------------------------------------------------------------
 bool
 QGCCacheWorker::_createDB(QSqlDatabase& db, bool createDefault)
 {
     bool res = false;
     QSqlQuery query(db);
+    //-- Tables from before packed tile keys are set aside, recreated below and then repopulated
+    const bool legacy = _isLegacyDB(db);
+    if(legacy) {
+        qCDebug(QGCTileCacheWorkerLog) << "Migrating map cache database to packed tile keys";
+        db.transaction();
+        query.exec("ALTER TABLE Tiles RENAME TO LegacyTiles");
+        query.exec("ALTER TABLE SetTiles RENAME TO LegacySetTiles");
+        query.exec("ALTER TABLE TilesDownload RENAME TO LegacyTilesDownload");
+    }
+    //-- tileID is the packed tile key (see UrlFactory::getTileKey), so tile lookups use the rowid b-tree directly
     if(!query.exec(
         "CREATE TABLE IF NOT EXISTS Tiles ("
         "tileID INTEGER PRIMARY KEY NOT NULL, "
-        "hash TEXT NOT NULL UNIQUE, "
         "format TEXT NOT NULL, "
         "tile BLOB NULL, "
         "size INTEGER, "
@@ -1033,8 +1245,6 @@ QGCCacheWorker::_createDB(QSqlDatabase& db, bool createDefault)
     {
         qWarning() << "Map Cache SQL error (create Tiles db):" << query.lastError().text();
     } else {
-        query.exec("CREATE INDEX IF NOT EXISTS hash ON Tiles ( hash, size, type ) ");
-             
         if(!query.exec(
             "CREATE TABLE IF NOT EXISTS TileSets ("
             "setID INTEGER PRIMARY KEY NOT NULL, "
@@ -1060,10 +1270,12 @@ QGCCacheWorker::_createDB(QSqlDatabase& db, bool createDefault)
             {
                 qWarning() << "Map Cache SQL error (create SetTiles db):" << query.lastError().text();
             } else {
+                query.exec("CREATE INDEX IF NOT EXISTS SetTilesIndex ON SetTiles ( setID, tileID )");
+
                 if(!query.exec(
                     "CREATE TABLE IF NOT EXISTS TilesDownload ("
                     "setID INTEGER, "
-                    "hash TEXT NOT NULL UNIQUE, "
+                    "tileKey INTEGER NOT NULL UNIQUE, "
                     "type INTEGER, "
                     "x INTEGER, "
                     "y INTEGER, "
@@ -1078,6 +1290,16 @@ QGCCacheWorker::_createDB(QSqlDatabase& db, bool createDefault)
             }
         }
     }
+    if(legacy) {
+        if(res) {
+            res = _migrateLegacyTables(db);
+        }
+        if(res) {
+            db.commit();
+        } else {
+            db.rollback();
+        }
+    }
     //-- Create default tile set
     if(res && createDefault) {
         QString s = QString("SELECT name FROM TileSets WHERE name = \"%1\"").arg("Default Tile Set");
@@ -1097,12 +1319,72 @@ QGCCacheWorker::_createDB(QSqlDatabase& db, bool createDefault)
         }
     }
     if(!res) {
-        QFile file(_databasePath);
+        QFile file(db.databaseName());
         file.remove();
     }
     return res;
 }
 
+//-----------------------------------------------------------------------------
+bool
+QGCCacheWorker::_isLegacyDB(const QSqlDatabase& db)
+{
+    return db.record("Tiles").contains("hash");
+}
+
+//-----------------------------------------------------------------------------
+bool
+QGCCacheWorker::_migrateLegacyTables(QSqlDatabase& db)
+{
+    QSqlQuery query(db);
+    //-- Legacy hashes start with the provider name hash, downloads reference the provider by map id
+    if(!query.exec("CREATE TEMP TABLE LegacyProviders (hash INTEGER, mapID INTEGER, providerID INTEGER)")) {
+        qWarning() << "Map Cache SQL error (create LegacyProviders):" << query.lastError().text();
+        return false;
+    }
+    for(const SharedMapProvider& provider : UrlFactory::getProviders()) {
+        query.prepare("INSERT INTO LegacyProviders(hash, mapID, providerID) VALUES(?, ?, ?)");
+        query.addBindValue(UrlFactory::hashFromProviderType(provider->getMapName()));
+        query.addBindValue(provider->getMapId());
+        query.addBindValue(provider->getProviderId());
+        query.exec();
+    }
+    //-- Same packing as UrlFactory::packTileKey
+    static const QString keyExpression = QStringLiteral(
+        "(p.providerID << %1) + CASE WHEN t.x < (1 << t.z) AND t.y < (1 << t.z) "
+        "THEN (((1 << (2 * t.z)) - 1) / 3) + (t.y << t.z) + t.x "
+        "ELSE %2 + (t.z << %3) + (t.y << %4) + t.x END")
+        .arg(UrlFactory::kTileKeyProviderShift).arg(UrlFactory::kTileKeyGridBase).arg(2 * UrlFactory::kTileKeyGridBits).arg(UrlFactory::kTileKeyGridBits);
+    const QStringList statements = {
+        QStringLiteral(
+            "CREATE TEMP TABLE LegacyTileKeys AS SELECT t.tileID AS oldID, %1 AS newID FROM ("
+            "SELECT tileID, CAST(substr(hash, 1, 10) AS INTEGER) AS providerHash, CAST(substr(hash, 11, 8) AS INTEGER) AS x, "
+            "CAST(substr(hash, 19, 8) AS INTEGER) AS y, CAST(substr(hash, 27, 3) AS INTEGER) AS z FROM LegacyTiles WHERE length(hash) = 29) t "
+            "JOIN LegacyProviders p ON t.providerHash = p.hash").arg(keyExpression),
+        QStringLiteral(
+            "INSERT OR IGNORE INTO Tiles(tileID, format, tile, size, type, date) "
+            "SELECT k.newID, t.format, t.tile, t.size, t.type, t.date FROM LegacyTiles t JOIN LegacyTileKeys k ON t.tileID = k.oldID"),
+        QStringLiteral(
+            "INSERT INTO SetTiles(setID, tileID) "
+            "SELECT DISTINCT s.setID, k.newID FROM LegacySetTiles s JOIN LegacyTileKeys k ON s.tileID = k.oldID"),
+        QStringLiteral(
+            "INSERT OR IGNORE INTO TilesDownload(setID, tileKey, type, x, y, z, state) "
+            "SELECT t.setID, %1, t.type, t.x, t.y, t.z, t.state FROM LegacyTilesDownload t JOIN LegacyProviders p ON t.type = p.mapID").arg(keyExpression),
+        QStringLiteral("DROP TABLE LegacyTiles"),
+        QStringLiteral("DROP TABLE LegacySetTiles"),
+        QStringLiteral("DROP TABLE LegacyTilesDownload"),
+        QStringLiteral("DROP TABLE LegacyTileKeys"),
+        QStringLiteral("DROP TABLE LegacyProviders"),
+    };
+    for(const QString& statement : statements) {
+        if(!query.exec(statement)) {
+            qWarning() << "Map Cache SQL error (migrate legacy tables):" << query.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
 //-----------------------------------------------------------------------------
 void
 QGCCacheWorker::_disconnectDB()
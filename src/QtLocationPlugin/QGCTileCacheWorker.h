@@ -18,19 +18,29 @@
 
 #pragma once
 
+#include "QGCMapTasks.h"
+
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QMutex>
 #include <QtCore/QQueue>
+#include <QtCore/QReadWriteLock>
 #include <QtCore/QString>
 #include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtCore/QThreadStorage>
 #include <QtCore/QWaitCondition>
 
+#include <array>
+#include <functional>
+
 Q_DECLARE_LOGGING_CATEGORY(QGCTileCacheWorkerLog)
 
-class QGCMapTask;
 class QGCCachedTileSet;
 class QSqlDatabase;
 
+/// Runs map cache tasks against the tile database. Writes are serialized through this thread's single
+/// connection, ordered by task priority. Tile lookups run on a small pool of read-only connections, the
+/// database is in WAL mode so they are not blocked by a long running write such as an import.
 class QGCCacheWorker : public QThread
 {
     Q_OBJECT
@@ -41,6 +51,9 @@ public:
 
     void setDatabaseFile(const QString &path) { _databasePath = path; }
 
+    /// Error of a tile lookup which found the database locked by a reset or import, unlike a cache miss it may be retried
+    static constexpr const char *kCacheBusyError = "Cache database busy";
+
 public slots:
     bool enqueueTask(QGCMapTask *task);
     void stop();
@@ -53,6 +66,9 @@ protected:
 
 private:
     void _runTask(QGCMapTask *task);
+    void _runReadTask(QGCMapTask *task);
+    QGCMapTask *_dequeueTask();
+    qsizetype _queuedTaskCount() const;
 
     void _saveTile(QGCMapTask *task);
     void _getTile(QGCMapTask *task);
@@ -70,19 +86,37 @@ private:
 
     bool _connectDB();
     void _disconnectDB();
+    QSqlDatabase _readDB();
+    void _closeReadDBs();
+    QString _readSessionPrefix() const;
     bool _createDB(QSqlDatabase &db, bool createDefault = true);
+    static bool _isLegacyDB(const QSqlDatabase &db);
+    static bool _migrateLegacyTables(QSqlDatabase &db);
+    bool _attachDB(const QString &path);
+    void _detachDB();
+    bool _copySetTiles(const QString &source, quint64 sourceSetID, const QString &target, quint64 targetSetID, quint64 &tilesAdded, const std::function<void(quint64)> &progress);
     bool _findTileSetID(const QString &name, quint64 &setID);
     bool _init();
-    quint64 _findTile(const QString &hash);
+    bool _findTile(quint64 tileKey);
     quint64 _getDefaultTileSet();
     void _deleteBingNoTileTiles();
     void _deleteTileSet(quint64 id);
     void _updateSetTotals(QGCCachedTileSet *set);
     void _updateTotals();
 
+    /// Read connection of one pool thread, it may only be used and removed by that thread
+    struct ReadConnection {
+        ~ReadConnection();
+
+        QString name;
+    };
+
     std::shared_ptr<QSqlDatabase> _db = nullptr;
     QMutex _taskQueueMutex;
-    QQueue<QGCMapTask*> _taskQueue;
+    std::array<QQueue<QGCMapTask*>, QGCMapTask::PriorityHigh + 1> _taskQueues; ///< Indexed by QGCMapTask::TaskPriority
+    QThreadStorage<ReadConnection*> _readConnections; ///< Declared before _readPool so it outlives the pool threads
+    QThreadPool _readPool;
+    QReadWriteLock _readLock; ///< Held for writing while the database file is replaced or its tables recreated
     QWaitCondition _waitc;
     QString _databasePath;
     quint32 _defaultCount = 0;
@@ -98,6 +132,13 @@ private:
     static QByteArray _bingNoTileImage;
     static constexpr const char *kSession = "QGeoTileWorkerSession";
     static constexpr const char *kExportSession = "QGeoTileExportSession";
+    static constexpr const char *kReadSession = "QGeoTileReadSession";
+    static constexpr int kMaxReadThreads = 4;
+    static constexpr int kReadLockTimeoutMsecs = 200; ///< Longest a lookup waits for a reset or replacing import to finish
+    static constexpr const char *kTransferSchema = "TransferDB"; ///< Schema name of an attached import/export database
+    static constexpr int kBulkCopyRows = 5000;
     static constexpr int kShortTimeout = 2;
     static constexpr int kLongTimeout = 5;
+
+    friend class QGCTileCacheWorkerTest;
 };
@@ -0,0 +1,400 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "QGCTilePrefetcher.h"
+#include "MapProvider.h"
+#include "QGCCacheTile.h"
+#include "QGCMapEngine.h"
+#include "QGCMapTasks.h"
+#include "QGCMapUrlEngine.h"
+#include "QGeoFileTileCacheQGC.h"
+#include "QGeoTileFetcherQGC.h"
+#include "QGeoTiledMappingManagerEngineQGC.h"
+
+#include <DeviceInfo.h>
+#include <QGCFileDownload.h>
+#include <QGCLoggingCategory.h>
+
+#include <QtCore/QFile>
+#include <QtCore/QtMath>
+#include <QtLocation/private/qabstractgeotilecache_p.h>
+#include <QtLocation/private/qgeotilespec_p.h>
+#include <QtNetwork/QNetworkAccessManager>
+
+QGC_LOGGING_CATEGORY(QGCTilePrefetcherLog, "qgc.qtlocationplugin.qgctileprefetcher")
+
+namespace {
+    constexpr double kEarthCircumferenceMeters = 40075016.686;
+
+    const QByteArray &bingNoTileImage()
+    {
+        static const QByteArray image = []() {
+            QFile file("://res/BingNoTileBytes.dat");
+            return (file.open(QFile::ReadOnly) ? file.readAll() : QByteArray());
+        }();
+        return image;
+    }
+}
+
+QGCTilePrefetcher::QGCTilePrefetcher(QObject *parent)
+    : QObject(parent)
+    , _networkManager(new QNetworkAccessManager(this))
+{
+    // qCDebug(QGCTilePrefetcherLog) << Q_FUNC_INFO << this;
+
+    _networkManager->setTransferTimeout(10000);
+
+    _bandwidthTimer.setInterval(kBandwidthIntervalMsecs);
+    (void) connect(&_bandwidthTimer, &QTimer::timeout, this, &QGCTilePrefetcher::_refillBandwidth);
+}
+
+QGCTilePrefetcher::~QGCTilePrefetcher()
+{
+    // qCDebug(QGCTilePrefetcherLog) << Q_FUNC_INFO << this;
+}
+
+void QGCTilePrefetcher::addMappingEngine(QGeoTiledMappingManagerEngineQGC *engine)
+{
+    (void) _engines.removeAll(nullptr);
+    if (!_engines.contains(engine)) {
+        _engines.append(engine);
+    }
+}
+
+void QGCTilePrefetcher::setEnabled(bool enabled)
+{
+    if (enabled == _enabled) {
+        return;
+    }
+
+    _enabled = enabled;
+    if (_enabled) {
+        _bandwidthBudget = 0;
+        _bandwidthTimer.start();
+    } else {
+        _bandwidthTimer.stop();
+        clear();
+    }
+}
+
+void QGCTilePrefetcher::setMaxBandwidth(quint32 bytesPerSecond)
+{
+    _maxBandwidth = bytesPerSecond;
+    _bandwidthBudget = qMin(_bandwidthBudget, static_cast<qint64>(_maxBandwidth));
+}
+
+void QGCTilePrefetcher::clear()
+{
+    _clearQueues();
+
+    const QList<QNetworkReply*> replies = _replies.keys();
+    for (QNetworkReply *reply : replies) {
+        reply->abort();
+    }
+}
+
+void QGCTilePrefetcher::_clearQueues()
+{
+    for (const PrefetchTile &tile : std::as_const(_downloadQueue)) {
+        (void) _pendingKeys.remove(tile.key);
+    }
+
+    _lookupQueue.clear();
+    _downloadQueue.clear();
+    _queuedKeys.clear();
+}
+
+void QGCTilePrefetcher::updatePrediction(const QString &mapType, int zoom, const QGeoCoordinate &position, double heading, double groundSpeed, const QList<QGeoCoordinate> &missionPath)
+{
+    if (!_enabled) {
+        return;
+    }
+
+    const SharedMapProvider provider = UrlFactory::getMapProviderFromProviderType(mapType);
+    if (!provider || provider->isElevationProvider() || provider->isLocalProvider()) {
+        return;
+    }
+
+    QList<QGeoCoordinate> vehiclePath;
+    if (position.isValid()) {
+        vehiclePath.append(position);
+        if ((groundSpeed > 1.) && !qIsNaN(heading)) {
+            const double lookahead = qMax(groundSpeed * kLookaheadSecs, kMinLookaheadMeters);
+            vehiclePath.append(position.atDistanceAndAzimuth(lookahead, heading));
+        }
+    }
+
+    // Work which has not started yet is replaced by the new prediction, in flight work is left to finish
+    _clearQueues();
+
+    // The vehicle track at the displayed zoom comes into view first, so it is queued first and with a corridor
+    _appendTiles(tilesAlongPath(mapType, zoom, vehiclePath, 1));
+    _appendTiles(tilesAlongPath(mapType, zoom + 1, vehiclePath, 0));
+    _appendTiles(tilesAlongPath(mapType, zoom - 1, vehiclePath, 0));
+    _appendTiles(tilesAlongPath(mapType, zoom, missionPath, 0));
+    _appendTiles(tilesAlongPath(mapType, zoom + 1, missionPath, 0));
+    _appendTiles(tilesAlongPath(mapType, zoom - 1, missionPath, 0));
+
+    qCDebug(QGCTilePrefetcherLog) << "Prefetch queue:" << _lookupQueue.count() << "zoom:" << zoom;
+
+    _processQueue();
+}
+
+QList<QGCTilePrefetcher::PrefetchTile> QGCTilePrefetcher::tilesAlongPath(const QString &mapType, int zoom, const QList<QGeoCoordinate> &path, int radius)
+{
+    QList<PrefetchTile> tiles;
+
+    if (path.isEmpty() || (zoom < 1) || (zoom > MAX_MAP_ZOOM)) {
+        return tiles;
+    }
+
+    const SharedMapProvider provider = UrlFactory::getMapProviderFromProviderType(mapType);
+    if (!provider) {
+        return tiles;
+    }
+
+    const int maxTile = (1 << zoom) - 1;
+    QSet<quint64> added;
+
+    const auto addTilesAround = [&](const QGeoCoordinate &coord) {
+        const int centerX = provider->long2tileX(coord.longitude(), zoom);
+        const int centerY = provider->lat2tileY(coord.latitude(), zoom);
+        for (int x = centerX - radius; x <= centerX + radius; x++) {
+            for (int y = centerY - radius; y <= centerY + radius; y++) {
+                if ((x < 0) || (y < 0) || (x > maxTile) || (y > maxTile) || (tiles.count() >= kMaxQueuedTiles)) {
+                    continue;
+                }
+
+                const quint64 key = UrlFactory::packTileKey(provider->getProviderId(), x, y, zoom);
+                if (added.contains(key)) {
+                    continue;
+                }
+                (void) added.insert(key);
+
+                PrefetchTile tile;
+                tile.mapId = provider->getMapId();
+                tile.x = x;
+                tile.y = y;
+                tile.z = zoom;
+                tile.type = mapType;
+                tile.key = key;
+                tiles.append(tile);
+            }
+        }
+    };
+
+    QGeoCoordinate previous;
+    for (const QGeoCoordinate &coord : path) {
+        if (!coord.isValid()) {
+            continue;
+        }
+
+        if (previous.isValid()) {
+            // Sample at half a tile width so every tile the segment passes through is visited
+            const double tileWidth = kEarthCircumferenceMeters * qCos(qDegreesToRadians(previous.latitude())) / (1 << zoom);
+            const double step = qMax(tileWidth / 2., 1.);
+            const double distance = previous.distanceTo(coord);
+            const double azimuth = previous.azimuthTo(coord);
+            for (double d = step; d < distance; d += step) {
+                addTilesAround(previous.atDistanceAndAzimuth(d, azimuth));
+                if (tiles.count() >= kMaxQueuedTiles) {
+                    return tiles;
+                }
+            }
+        }
+
+        addTilesAround(coord);
+        if (tiles.count() >= kMaxQueuedTiles) {
+            break;
+        }
+        previous = coord;
+    }
+
+    return tiles;
+}
+
+void QGCTilePrefetcher::_appendTiles(const QList<PrefetchTile> &tiles)
+{
+    for (const PrefetchTile &tile : tiles) {
+        if (_lookupQueue.count() >= kMaxQueuedTiles) {
+            break;
+        }
+
+        if (_queuedKeys.contains(tile.key) || _pendingKeys.contains(tile.key) || _completedKeys.contains(tile.key)) {
+            continue;
+        }
+
+        (void) _queuedKeys.insert(tile.key);
+        _lookupQueue.enqueue(tile);
+    }
+}
+
+void QGCTilePrefetcher::_markCompleted(quint64 key)
+{
+    // Bounded so a long flight does not grow this without limit. Clearing only means a tile may be looked up again.
+    if (_completedKeys.count() >= kMaxCompletedKeys) {
+        _completedKeys.clear();
+    }
+    (void) _completedKeys.insert(key);
+}
+
+void QGCTilePrefetcher::_processQueue()
+{
+    while (!_lookupQueue.isEmpty() && (_pendingLookups < kMaxPendingLookups)) {
+        _lookupTile(_lookupQueue.dequeue());
+    }
+
+    while (!_downloadQueue.isEmpty() && (_replies.count() < kMaxConcurrentDownloads) && (_bandwidthBudget > 0)) {
+        _downloadTile(_downloadQueue.dequeue());
+    }
+}
+
+void QGCTilePrefetcher::_refillBandwidth()
+{
+    const qint64 refill = static_cast<qint64>(_maxBandwidth) * kBandwidthIntervalMsecs / 1000;
+    _bandwidthBudget = qMin(_bandwidthBudget + refill, static_cast<qint64>(_maxBandwidth));
+
+    _processQueue();
+}
+
+void QGCTilePrefetcher::_lookupTile(const PrefetchTile &tile)
+{
+    (void) _queuedKeys.remove(tile.key);
+    (void) _pendingKeys.insert(tile.key);
+    _pendingLookups++;
+
+    // Queued so a failure reported synchronously from addTask does not re-enter _processQueue
+    QGCFetchTileTask* const task = QGeoFileTileCacheQGC::createFetchTileTask(tile.type, tile.x, tile.y, tile.z);
+    task->setPriority(QGCMapTask::PriorityLow);
+    (void) connect(task, &QGCFetchTileTask::tileFetched, this, [this, tile](QGCCacheTile *cacheTile) {
+        _tileLookupFinished(tile, cacheTile);
+    }, Qt::QueuedConnection);
+    (void) connect(task, &QGCMapTask::error, this, [this, tile](QGCMapTask::TaskType type, const QString &errorString) {
+        Q_UNUSED(type); Q_UNUSED(errorString);
+        _tileLookupFailed(tile);
+    }, Qt::QueuedConnection);
+    (void) getQGCMapEngine()->addTask(task);
+}
+
+void QGCTilePrefetcher::_tileLookupFinished(const PrefetchTile &tile, QGCCacheTile *cacheTile)
+{
+    _pendingLookups--;
+    (void) _pendingKeys.remove(tile.key);
+    _markCompleted(tile.key);
+
+    if (cacheTile) {
+        _warmMemoryCache(tile, cacheTile->img(), cacheTile->format());
+        delete cacheTile;
+    }
+
+    _processQueue();
+}
+
+void QGCTilePrefetcher::_tileLookupFailed(const PrefetchTile &tile)
+{
+    _pendingLookups--;
+    (void) _pendingKeys.remove(tile.key);
+
+    if (_enabled && (_maxBandwidth > 0)) {
+        (void) _pendingKeys.insert(tile.key);
+        _downloadQueue.enqueue(tile);
+    }
+
+    _processQueue();
+}
+
+void QGCTilePrefetcher::_downloadTile(const PrefetchTile &tile)
+{
+    if (!QGCDeviceInfo::isInternetAvailable()) {
+        (void) _pendingKeys.remove(tile.key);
+        return;
+    }
+
+    QNetworkRequest request = QGeoTileFetcherQGC::getNetworkRequest(tile.mapId, tile.x, tile.y, tile.z);
+    if (request.url().isEmpty()) {
+        (void) _pendingKeys.remove(tile.key);
+        _markCompleted(tile.key);
+        return;
+    }
+    request.setOriginatingObject(this);
+    request.setPriority(QNetworkRequest::LowPriority);
+
+    QNetworkReply* const reply = _networkManager->get(request);
+    reply->setParent(this);
+    QGCFileDownload::setIgnoreSSLErrorsIfNeeded(*reply);
+    (void) connect(reply, &QNetworkReply::finished, this, &QGCTilePrefetcher::_networkReplyFinished);
+    (void) _replies.insert(reply, tile);
+}
+
+void QGCTilePrefetcher::_networkReplyFinished()
+{
+    QNetworkReply* const reply = qobject_cast<QNetworkReply*>(sender());
+    if (!reply) {
+        return;
+    }
+    reply->deleteLater();
+
+    const PrefetchTile tile = _replies.take(reply);
+    (void) _pendingKeys.remove(tile.key);
+
+    if (reply->error() == QNetworkReply::OperationCanceledError) {
+        return;
+    }
+
+    // Failed tiles are not retried, the interactive path will request them again when they come into view
+    _markCompleted(tile.key);
+
+    const QByteArray image = reply->readAll();
+    _bandwidthBudget -= image.size();
+
+    if (reply->error() != QNetworkReply::NoError) {
+        qCDebug(QGCTilePrefetcherLog) << "Prefetch failed:" << tile.key << reply->errorString();
+        _processQueue();
+        return;
+    }
+
+    const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if ((statusCode < 200) || (statusCode >= 300) || image.isEmpty()) {
+        _processQueue();
+        return;
+    }
+
+    const SharedMapProvider mapProvider = UrlFactory::getMapProviderFromQtMapId(tile.mapId);
+    if (!mapProvider || (mapProvider->isBingProvider() && (image == bingNoTileImage()))) {
+        _processQueue();
+        return;
+    }
+
+    const QString format = mapProvider->getImageFormat(image);
+    if (!format.isEmpty()) {
+        QGeoFileTileCacheQGC::cacheTile(tile.type, tile.key, image, format);
+        _warmMemoryCache(tile, image, format);
+        qCDebug(QGCTilePrefetcherLog) << "Prefetched:" << tile.key << image.size();
+    }
+
+    _processQueue();
+}
+
+void QGCTilePrefetcher::_warmMemoryCache(const PrefetchTile &tile, const QByteArray &image, const QString &format)
+{
+    if (image.isEmpty()) {
+        return;
+    }
+
+    // Each map view has its own engine, it is not known which of them will show the tile
+    for (const QPointer<QGeoTiledMappingManagerEngineQGC> &engine : std::as_const(_engines)) {
+        QAbstractGeoTileCache* const tileCache = engine ? engine->tileCache() : nullptr;
+        if (!tileCache) {
+            continue;
+        }
+
+        const QGeoTileSpec spec(engine->managerName(), tile.mapId, tile.z, tile.x, tile.y, engine->tileVersion());
+        tileCache->insert(spec, image, format, QAbstractGeoTileCache::MemoryCache);
+    }
+}
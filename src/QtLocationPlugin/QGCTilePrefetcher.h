@@ -0,0 +1,112 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QHash>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+#include <QtCore/QQueue>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+#include <QtCore/QTimer>
+#include <QtNetwork/QNetworkReply>
+#include <QtPositioning/QGeoCoordinate>
+
+Q_DECLARE_LOGGING_CATEGORY(QGCTilePrefetcherLog)
+
+class QGCCacheTile;
+class QGeoTiledMappingManagerEngineQGC;
+class QNetworkAccessManager;
+
+/// Warms the tile caches ahead of the vehicle. Tiles along the predicted vehicle track and the
+/// remaining mission path are looked up in the cache database (and loaded into the in-memory
+/// tile caches of the mapping engines) or downloaded at low priority within a bandwidth budget.
+/// There is a single prefetcher, owned by QGCMapEngine.
+class QGCTilePrefetcher : public QObject
+{
+    Q_OBJECT
+
+    friend class QGCTilePrefetcherTest;
+public:
+    QGCTilePrefetcher(QObject *parent = nullptr);
+    ~QGCTilePrefetcher();
+
+    struct PrefetchTile {
+        int mapId = -1;
+        int x = 0;
+        int y = 0;
+        int z = 0;
+        QString type;
+        quint64 key = 0;
+    };
+
+    /// Prefetched tiles are also put into the in-memory tile cache of engine, until it is destroyed
+    void addMappingEngine(QGeoTiledMappingManagerEngineQGC *engine);
+
+    bool enabled() const { return _enabled; }
+    void setEnabled(bool enabled);
+
+    /// @param bytesPerSecond Network budget for prefetch downloads, 0 disables downloads (cache lookups still run)
+    void setMaxBandwidth(quint32 bytesPerSecond);
+
+    /// Replaces the pending prefetch work with tiles along the predicted path
+    ///     @param mapType Provider type name of the displayed map
+    ///     @param zoom Current map zoom level, tiles are prefetched at zoom - 1 through zoom + 1
+    ///     @param position Current vehicle position
+    ///     @param heading Vehicle heading in degrees
+    ///     @param groundSpeed Vehicle ground speed in m/s
+    ///     @param missionPath Planned flight path
+    void updatePrediction(const QString &mapType, int zoom, const QGeoCoordinate &position, double heading, double groundSpeed, const QList<QGeoCoordinate> &missionPath);
+
+    /// Drops all queued work and aborts in flight downloads
+    void clear();
+
+    /// Returns the tiles covering the polyline at the given zoom level, ordered along the path
+    ///     @param radius Number of neighbouring tiles to include on each side of the path
+    static QList<PrefetchTile> tilesAlongPath(const QString &mapType, int zoom, const QList<QGeoCoordinate> &path, int radius);
+
+private slots:
+    void _processQueue();
+    void _refillBandwidth();
+    void _networkReplyFinished();
+
+private:
+    void _lookupTile(const PrefetchTile &tile);
+    void _tileLookupFinished(const PrefetchTile &tile, QGCCacheTile *cacheTile);
+    void _tileLookupFailed(const PrefetchTile &tile);
+    void _downloadTile(const PrefetchTile &tile);
+    void _warmMemoryCache(const PrefetchTile &tile, const QByteArray &image, const QString &format);
+    void _appendTiles(const QList<PrefetchTile> &tiles);
+    void _clearQueues();
+    void _markCompleted(quint64 key);
+
+    QList<QPointer<QGeoTiledMappingManagerEngineQGC>> _engines;
+    QNetworkAccessManager *_networkManager = nullptr;
+    QTimer _bandwidthTimer;
+    QQueue<PrefetchTile> _lookupQueue;
+    QQueue<PrefetchTile> _downloadQueue;
+    QSet<quint64> _queuedKeys;
+    QSet<quint64> _pendingKeys;
+    QSet<quint64> _completedKeys;
+    QHash<QNetworkReply*, PrefetchTile> _replies;
+    int _pendingLookups = 0;
+    qint64 _bandwidthBudget = 0;
+    quint32 _maxBandwidth = 0;
+    bool _enabled = false;
+
+    static constexpr int kMaxPendingLookups = 2;        ///< Keeps interactive fetch tasks from queueing behind prefetch lookups
+    static constexpr int kMaxConcurrentDownloads = 2;   ///< Interactive requests use QGeoTileFetcherQGC::concurrentDownloads
+    static constexpr int kMaxQueuedTiles = 512;
+    static constexpr int kMaxCompletedKeys = 8192;
+    static constexpr int kBandwidthIntervalMsecs = 250;
+    static constexpr double kLookaheadSecs = 60.;
+    static constexpr double kMinLookaheadMeters = 500.;
+};
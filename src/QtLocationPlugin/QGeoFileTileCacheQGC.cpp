@@ -99,15 +99,15 @@ quint32 QGeoFileTileCacheQGC::getMaxDiskCacheSetting()
 
 void QGeoFileTileCacheQGC::cacheTile(const QString &type, int x, int y, int z, const QByteArray &image, const QString &format, qulonglong set)
 {
-    const QString hash = UrlFactory::getTileHash(type, x, y, z);
-    cacheTile(type, hash, image, format, set);
+    const quint64 tileKey = UrlFactory::getTileKey(type, x, y, z);
+    cacheTile(type, tileKey, image, format, set);
 }
 
-void QGeoFileTileCacheQGC::cacheTile(const QString &type, const QString &hash, const QByteArray &image, const QString &format, qulonglong set)
+void QGeoFileTileCacheQGC::cacheTile(const QString &type, quint64 tileKey, const QByteArray &image, const QString &format, qulonglong set)
 {
     AppSettings* const appSettings = SettingsManager::instance()->appSettings();
     if (!appSettings->disableAllPersistence()->rawValue().toBool()) {
-        QGCCacheTile* const tile = new QGCCacheTile(hash, image, format, type, set);
+        QGCCacheTile* const tile = new QGCCacheTile(tileKey, image, format, type, set);
         QGCSaveTileTask* const task = new QGCSaveTileTask(tile);
         (void) getQGCMapEngine()->addTask(task);
     }
@@ -115,8 +115,8 @@ void QGeoFileTileCacheQGC::cacheTile(const QString &type, const QString &hash, c
 
 QGCFetchTileTask* QGeoFileTileCacheQGC::createFetchTileTask(const QString &type, int x, int y, int z)
 {
-    const QString hash = UrlFactory::getTileHash(type, x, y, z);
-    QGCFetchTileTask* const task = new QGCFetchTileTask(hash);
+    const quint64 tileKey = UrlFactory::getTileKey(type, x, y, z);
+    QGCFetchTileTask* const task = new QGCFetchTileTask(tileKey);
     return task;
 }
 
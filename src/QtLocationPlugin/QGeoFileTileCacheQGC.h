@@ -26,7 +26,7 @@ public:
 
     static quint32 getMaxDiskCacheSetting();
     static void cacheTile(const QString &type, int x, int y, int z, const QByteArray &image, const QString &format, qulonglong set = UINT64_MAX);
-    static void cacheTile(const QString &type, const QString &hash, const QByteArray &image, const QString &format, qulonglong set = UINT64_MAX);
+    static void cacheTile(const QString &type, quint64 tileKey, const QByteArray &image, const QString &format, qulonglong set = UINT64_MAX);
     static QGCFetchTileTask *createFetchTileTask(const QString &type, int x, int y, int z);
     static QString getDatabaseFilePath() { return _databaseFilePath; }
     static QString getCachePath() { return _cachePath; }
@@ -204,3 +204,24 @@ void QGeoTiledMapReplyQGC::abort()
 {
     QGeoTiledMapReply::abort();
 }
+
+QGeoTiledMapReplyLocalQGC::QGeoTiledMapReplyLocalQGC(const QByteArray &image, const QGeoTileSpec &spec, QObject *parent)
+    : QGeoTiledMapReply(spec, parent)
+{
+    if (image.isEmpty()) {
+        setError(QGeoTiledMapReply::ParseError, tr("Tile Not In Local Packages"));
+        return;
+    }
+
+    const SharedMapProvider mapProvider = UrlFactory::getMapProviderFromQtMapId(spec.mapId());
+    const QString format = mapProvider ? mapProvider->getImageFormat(image) : QString();
+    if (format.isEmpty()) {
+        setError(QGeoTiledMapReply::ParseError, tr("Unknown Format"));
+        return;
+    }
+
+    setMapImageData(image);
+    setMapImageFormat(format);
+    setCached(true);
+    setFinished(true);
+}
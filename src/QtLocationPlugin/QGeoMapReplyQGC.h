@@ -52,3 +52,12 @@ private:
         REDIRECTION_MULTIPLE_CHOICES = 300
     };
 };
+
+/// Reply for tiles read synchronously from local tile packages, finished on construction
+class QGeoTiledMapReplyLocalQGC : public QGeoTiledMapReply
+{
+    Q_OBJECT
+
+public:
+    QGeoTiledMapReplyLocalQGC(const QByteArray &image, const QGeoTileSpec &spec, QObject *parent = nullptr);
+};
@@ -50,6 +50,10 @@ QGeoTiledMapReply* QGeoTileFetcherQGC::getTileImage(const QGeoTileSpec &spec)
         return nullptr;
     }*/
 
+    if (provider->isLocalProvider()) {
+        return new QGeoTiledMapReplyLocalQGC(provider->readLocalTile(spec.x(), spec.y(), spec.zoom()), spec);
+    }
+
     const QNetworkRequest request = getNetworkRequest(spec.mapId(), spec.x(), spec.y(), spec.zoom());
     if (request.url().isEmpty()) {
         return nullptr;
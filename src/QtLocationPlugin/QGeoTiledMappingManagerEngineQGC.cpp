@@ -10,11 +10,13 @@
 #include "QGeoTiledMappingManagerEngineQGC.h"
 #include "QGCApplication.h"
 #include "QGCMapEngine.h"
+#include "QGCTilePrefetcher.h"
 #include "QGeoTileFetcherQGC.h"
 #include "QGeoFileTileCacheQGC.h"
 #include "QGeoTiledMapQGC.h"
 #include "QGCMapUrlEngine.h"
 #include "MapProvider.h"
+#include "LocalTileMapProvider.h"
 #include "QGCMapEngineManager.h"
 #include <QGCLoggingCategory.h>
 
@@ -82,6 +84,9 @@ QGeoTiledMappingManagerEngineQGC::QGeoTiledMappingManagerEngineQGC(const QVarian
         getQGCMapEngine()->init(fileTileCache->getDatabaseFilePath());
     });
 
+    // Tiles are read on the fetcher's thread, the settings are only followed from here
+    LocalTileMapProvider::followSettings();
+
     m_prefetchStyle = QGeoTiledMap::PrefetchTwoNeighbourLayers;
 
     if (!m_networkManager) {
@@ -100,6 +105,8 @@ QGeoTiledMappingManagerEngineQGC::QGeoTiledMappingManagerEngineQGC(const QVarian
         m_networkManager->setCache(diskCache);
     }
 
+    getQGCMapEngine()->prefetcher()->addMappingEngine(this);
+
     QGeoTileFetcherQGC* const tileFetcher = new QGeoTileFetcherQGC(m_networkManager, parameters, this);
 
     *error = QGeoServiceProvider::NoError;
@@ -15,18 +15,21 @@
 #include "QGCCachedTileSet.h"
 #include "QGCMapUrlEngine.h"
 #include "QGCMapEngine.h"
+#include "QGCTilePrefetcher.h"
 #include "QGeoFileTileCacheQGC.h"
 #include "ElevationMapProvider.h"
 #include "QmlObjectListModel.h"
 #include "QGCApplication.h"
 #include "SettingsManager.h"
 #include "FlightMapSettings.h"
+#include "MapsSettings.h"
 #include "QGCLoggingCategory.h"
 
 #include <QtCore/qapplicationstatic.h>
 #include <QtCore/QRegularExpression>
 #include <QtCore/QSettings>
 #include <QtCore/QStorageInfo>
+#include <QtCore/QtMath>
 #include <QtQml/QQmlEngine>
 
 QGC_LOGGING_CATEGORY(QGCMapEngineManagerLog, "qgc.qtlocation.qmlcontrol.qgcmapenginemanagerlog")
@@ -85,6 +88,30 @@ void QGCMapEngineManager::updateForCurrentView(double lon0, double lat0, double
     qCDebug(QGCMapEngineManagerLog) << Q_FUNC_INFO << lat0 << lon0 << lat1 << lon1 << minZoom << maxZoom;
 }
 
+void QGCMapEngineManager::updatePrefetch(const QString &mapType, double zoom, const QGeoCoordinate &position, double heading, double groundSpeed, const QVariantList &missionPath)
+{
+    QGCTilePrefetcher* const prefetcher = getQGCMapEngine()->prefetcher();
+    if (!prefetcher) {
+        return;
+    }
+
+    MapsSettings* const mapsSettings = SettingsManager::instance()->mapsSettings();
+    prefetcher->setEnabled(mapsSettings->tilePrefetch()->rawValue().toBool());
+    if (!prefetcher->enabled()) {
+        return;
+    }
+    // Value saved in KB/s
+    prefetcher->setMaxBandwidth(mapsSettings->tilePrefetchMaxBandwidth()->rawValue().toUInt() * 1024);
+
+    QList<QGeoCoordinate> path;
+    path.reserve(missionPath.count());
+    for (const QVariant &coord : missionPath) {
+        path.append(coord.value<QGeoCoordinate>());
+    }
+
+    prefetcher->updatePrediction(mapType, qFloor(zoom), position, heading, groundSpeed, path);
+}
+
 QString QGCMapEngineManager::tileCountStr() const
 {
     return qgcApp()->numberToString(_imageSet.tileCount + _elevationSet.tileCount);
@@ -143,7 +170,8 @@ void QGCMapEngineManager::startDownload(const QString &name, const QString &mapT
     }
 
     const int mapid = UrlFactory::getQtMapIdFromProviderType(mapType);
-    if (_fetchElevation && !UrlFactory::isElevation(mapid)) {
+    // Local elevation providers have no tiles to download
+    if (_fetchElevation && !UrlFactory::isElevation(mapid) && (_elevationSet.tileCount > 0)) {
         QGCCachedTileSet* const set = new QGCCachedTileSet(name + QStringLiteral(" Elevation"));
         const QString elevationProviderName = SettingsManager::instance()->flightMapSettings()->elevationMapProvider()->rawValue().toString();
         set->setMapTypeStr(elevationProviderName);
@@ -192,6 +220,10 @@ QString QGCMapEngineManager::loadSetting(const QString &key, const QString &defa
 QStringList QGCMapEngineManager::mapTypeList(const QString &provider)
 {
     QStringList mapStringList = mapList();
+    const QStringList elevationStringList = elevationProviderList();
+    for (const QString &elevationProviderName : elevationStringList) {
+        (void) mapStringList.removeAll(elevationProviderName);
+    }
     mapStringList = mapStringList.filter(QRegularExpression(provider));
 
     static const QRegularExpression providerType = QRegularExpression(QStringLiteral("^([^\\ ]*) (.*)$"));
@@ -18,6 +18,7 @@
 
 // #include <QtQmlIntegration/QtQmlIntegration>
 #include <QtCore/QLoggingCategory>
+#include <QtPositioning/QGeoCoordinate>
 
 Q_DECLARE_LOGGING_CATEGORY(QGCMapEngineManagerLog)
 
@@ -71,6 +72,8 @@ public:
     Q_INVOKABLE void selectNone();
     Q_INVOKABLE void startDownload(const QString &name, const QString &mapType);
     Q_INVOKABLE void updateForCurrentView(double lon0, double lat0, double lon1, double lat1, int minZoom, int maxZoom, const QString &mapName);
+    /// Prefetches tiles along the predicted vehicle track and the planned mission path
+    Q_INVOKABLE void updatePrefetch(const QString &mapType, double zoom, const QGeoCoordinate &position, double heading, double groundSpeed, const QVariantList &missionPath);
 
     Q_INVOKABLE static QString loadSetting(const QString &key, const QString &defaultValue);
     Q_INVOKABLE static QStringList mapTypeList(const QString &provider);
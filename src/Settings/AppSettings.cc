@@ -257,6 +257,8 @@ void AppSettings::_checkSavePathDirectories(void)
         savePathDir.mkdir(photoDirectory);
         savePathDir.mkdir(crashDirectory);
         savePathDir.mkdir(customActionsDirectory);
+        savePathDir.mkdir(localTilesDirectory);
+        savePathDir.mkdir(elevationDirectory);
     }
 }
 
@@ -350,6 +352,26 @@ QString AppSettings::customActionsSavePath(void)
     return QString();
 }
 
+QString AppSettings::localTilesSavePath(void)
+{
+    QString path = savePath()->rawValue().toString();
+    if (!path.isEmpty() && QDir(path).exists()) {
+        QDir dir(path);
+        return dir.filePath(localTilesDirectory);
+    }
+    return QString();
+}
+
+QString AppSettings::elevationSavePath(void)
+{
+    QString path = savePath()->rawValue().toString();
+    if (!path.isEmpty() && QDir(path).exists()) {
+        QDir dir(path);
+        return dir.filePath(elevationDirectory);
+    }
+    return QString();
+}
+
 QList<int> AppSettings::firstRunPromptsIdsVariantToList(const QVariant& firstRunPromptIds)
 {
     QList<int> rgIds;
@@ -73,6 +73,8 @@ public:
     Q_PROPERTY(QString photoSavePath            READ photoSavePath              NOTIFY savePathsChanged)
     Q_PROPERTY(QString crashSavePath            READ crashSavePath              NOTIFY savePathsChanged)
     Q_PROPERTY(QString customActionsSavePath    READ customActionsSavePath      NOTIFY savePathsChanged)
+    Q_PROPERTY(QString localTilesSavePath       READ localTilesSavePath         NOTIFY savePathsChanged)
+    Q_PROPERTY(QString elevationSavePath        READ elevationSavePath          NOTIFY savePathsChanged)
 
     Q_PROPERTY(QString planFileExtension        MEMBER planFileExtension        CONSTANT)
     Q_PROPERTY(QString missionFileExtension     MEMBER missionFileExtension     CONSTANT)
@@ -92,6 +94,8 @@ public:
     QString photoSavePath         ();
     QString crashSavePath         ();
     QString customActionsSavePath ();
+    QString localTilesSavePath    ();
+    QString elevationSavePath     ();
 
     // Helper methods for working with firstRunPromptIds QVariant settings string list
     static QList<int> firstRunPromptsIdsVariantToList   (const QVariant& firstRunPromptIds);
@@ -120,6 +124,8 @@ public:
     static constexpr const char* photoDirectory =           QT_TRANSLATE_NOOP("AppSettings", "Photo");
     static constexpr const char* crashDirectory =           QT_TRANSLATE_NOOP("AppSettings", "CrashLogs");
     static constexpr const char* customActionsDirectory =   QT_TRANSLATE_NOOP("AppSettings", "CustomActions");
+    static constexpr const char* localTilesDirectory =      QT_TRANSLATE_NOOP("AppSettings", "Tiles");
+    static constexpr const char* elevationDirectory =       QT_TRANSLATE_NOOP("AppSettings", "Elevation");
 
 signals:
     void savePathsChanged();
@@ -40,3 +40,6 @@ DECLARE_SETTINGGROUP(Maps, "Maps")
 
 DECLARE_SETTINGSFACT(MapsSettings, maxCacheDiskSize)
 DECLARE_SETTINGSFACT(MapsSettings, maxCacheMemorySize)
+DECLARE_SETTINGSFACT(MapsSettings, maxTerrainCacheMemorySize)
+DECLARE_SETTINGSFACT(MapsSettings, tilePrefetch)
+DECLARE_SETTINGSFACT(MapsSettings, tilePrefetchMaxBandwidth)
@@ -21,4 +21,7 @@ public:
 
     DEFINE_SETTINGFACT(maxCacheDiskSize)
     DEFINE_SETTINGFACT(maxCacheMemorySize)
+    DEFINE_SETTINGFACT(maxTerrainCacheMemorySize)
+    DEFINE_SETTINGFACT(tilePrefetch)
+    DEFINE_SETTINGFACT(tilePrefetchMaxBandwidth)
 };
@@ -22,3 +22,5 @@ DECLARE_SETTINGSFACT(PlanViewSettings, useConditionGate)
 DECLARE_SETTINGSFACT(PlanViewSettings, takeoffItemNotRequired)
 DECLARE_SETTINGSFACT(PlanViewSettings, showGimbalOnlyWhenSet)
 DECLARE_SETTINGSFACT(PlanViewSettings, vtolTransitionDistance)
+DECLARE_SETTINGSFACT(PlanViewSettings, simplifyImportedShapes)
+DECLARE_SETTINGSFACT(PlanViewSettings, missionTransferWindow)
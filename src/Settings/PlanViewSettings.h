@@ -26,4 +26,6 @@ public:
     DEFINE_SETTINGFACT(takeoffItemNotRequired)
     DEFINE_SETTINGFACT(showGimbalOnlyWhenSet)
     DEFINE_SETTINGFACT(vtolTransitionDistance)
+    DEFINE_SETTINGFACT(simplifyImportedShapes)
+    DEFINE_SETTINGFACT(missionTransferWindow)
 };
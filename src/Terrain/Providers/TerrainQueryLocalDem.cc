@@ -0,0 +1,710 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TerrainQueryLocalDem.h"
+#include "TerrainTileManager.h"
+#include "SettingsManager.h"
+#include "AppSettings.h"
+#include "FlightMapSettings.h"
+#include "QGCLoggingCategory.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QRegularExpression>
+#include <QtCore/QtEndian>
+#include <QtCore/QtMath>
+#include <QtPositioning/QGeoCoordinate>
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+QGC_LOGGING_CATEGORY(TerrainQueryLocalDemLog, "qgc.terrain.terrainquerylocaldem")
+
+Q_GLOBAL_STATIC(LocalDemSource, _localDemSource)
+
+namespace {
+
+constexpr qint16 kHgtVoid = -32768;
+
+// TIFF and GeoTIFF tags
+constexpr quint16 kTagImageWidth = 256;
+constexpr quint16 kTagImageLength = 257;
+constexpr quint16 kTagBitsPerSample = 258;
+constexpr quint16 kTagCompression = 259;
+constexpr quint16 kTagStripOffsets = 273;
+constexpr quint16 kTagSamplesPerPixel = 277;
+constexpr quint16 kTagRowsPerStrip = 278;
+constexpr quint16 kTagTileWidth = 322;
+constexpr quint16 kTagTileLength = 323;
+constexpr quint16 kTagTileOffsets = 324;
+constexpr quint16 kTagSampleFormat = 339;
+constexpr quint16 kTagModelPixelScale = 33550;
+constexpr quint16 kTagModelTiepoint = 33922;
+constexpr quint16 kTagGeoKeyDirectory = 34735;
+constexpr quint16 kTagGdalNoData = 42113;
+
+constexpr quint16 kGeoKeyModelType = 1024;
+constexpr quint16 kGeoKeyRasterType = 1025;
+constexpr quint16 kModelTypeGeographic = 2;
+constexpr quint16 kRasterPixelIsPoint = 2;
+
+quint16 _readU16(const uchar *p, bool bigEndian)
+{
+    return bigEndian ? qFromBigEndian<quint16>(p) : qFromLittleEndian<quint16>(p);
+}
+
+quint32 _readU32(const uchar *p, bool bigEndian)
+{
+    return bigEndian ? qFromBigEndian<quint32>(p) : qFromLittleEndian<quint32>(p);
+}
+
+double _readF64(const uchar *p, bool bigEndian)
+{
+    const quint64 bits = bigEndian ? qFromBigEndian<quint64>(p) : qFromLittleEndian<quint64>(p);
+    double value;
+    (void) memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+float _readF32(const uchar *p, bool bigEndian)
+{
+    const quint32 bits = _readU32(p, bigEndian);
+    float value;
+    (void) memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/// Reads a TIFF directory entry. Values of up to four bytes are stored in the entry itself.
+class TiffEntry
+{
+public:
+    TiffEntry() = default;
+    TiffEntry(const uchar *data, qint64 size, const uchar *entry, bool bigEndian)
+        : _bigEndian(bigEndian)
+    {
+        _type = _readU16(entry + 2, bigEndian);
+        _count = _readU32(entry + 4, bigEndian);
+
+        const qint64 bytes = static_cast<qint64>(_typeSize()) * _count;
+        if ((_typeSize() == 0) || (bytes <= 0)) {
+            return;
+        }
+        if (bytes <= 4) {
+            _values = entry + 8;
+            return;
+        }
+        const quint32 offset = _readU32(entry + 8, bigEndian);
+        if ((offset + bytes) <= size) {
+            _values = data + offset;
+        }
+    }
+
+    bool isValid() const { return _values != nullptr; }
+    quint32 count() const { return _count; }
+
+    double value(quint32 index) const
+    {
+        const uchar* const p = _values + (static_cast<qint64>(index) * _typeSize());
+        switch (_type) {
+        case 1:
+            return *p;
+        case 3:
+            return _readU16(p, _bigEndian);
+        case 4:
+            return _readU32(p, _bigEndian);
+        case 11:
+            return _readF32(p, _bigEndian);
+        case 12:
+            return _readF64(p, _bigEndian);
+        default:
+            return qQNaN();
+        }
+    }
+
+    QList<double> values() const
+    {
+        QList<double> result;
+        if (isValid()) {
+            result.reserve(_count);
+            for (quint32 i = 0; i < _count; i++) {
+                result.append(value(i));
+            }
+        }
+        return result;
+    }
+
+    QByteArray string() const
+    {
+        return (isValid() && (_type == 2)) ? QByteArray(reinterpret_cast<const char*>(_values), _count) : QByteArray();
+    }
+
+private:
+    int _typeSize() const
+    {
+        switch (_type) {
+        case 1: case 2:
+            return 1;
+        case 3:
+            return 2;
+        case 4: case 11:
+            return 4;
+        case 12:
+            return 8;
+        default:
+            return 0;
+        }
+    }
+
+    bool _bigEndian = false;
+    quint16 _type = 0;
+    quint32 _count = 0;
+    const uchar *_values = nullptr;
+};
+
+}
+
+LocalDemSource *LocalDemSource::instance()
+{
+    return _localDemSource();
+}
+
+LocalDemSource::~LocalDemSource()
+{
+    _closeFiles();
+}
+
+void LocalDemSource::setDirectory(const QString &directory)
+{
+    {
+        QReadLocker locker(&_lock);
+        if (directory == _directory) {
+            return;
+        }
+    }
+
+    QWriteLocker locker(&_lock);
+    _directory = directory;
+    _scanDirectory();
+}
+
+void LocalDemSource::rescan()
+{
+    QWriteLocker locker(&_lock);
+    _scanDirectory();
+}
+
+void LocalDemSource::_scanDirectory()
+{
+    _closeFiles();
+
+    if (_directory.isEmpty()) {
+        return;
+    }
+
+    const QDir dir(_directory);
+    const QFileInfoList fileInfos = dir.entryInfoList({QStringLiteral("*.hgt"), QStringLiteral("*.tif"), QStringLiteral("*.tiff")}, QDir::Files | QDir::Readable, QDir::Name);
+    for (const QFileInfo &fileInfo : fileInfos) {
+        DemFile demFile;
+        if (_openFile(fileInfo.absoluteFilePath(), demFile)) {
+            qCDebug(TerrainQueryLocalDemLog) << "Local DEM:" << demFile.path << demFile.rows << "x" << demFile.columns << "north west" << demFile.northLat << demFile.westLon;
+            _files.append(demFile);
+            _indexFile(_files.count() - 1);
+        }
+    }
+}
+
+QStringList LocalDemSource::files() const
+{
+    QReadLocker locker(&_lock);
+
+    QStringList paths;
+    for (const DemFile &demFile : _files) {
+        paths.append(demFile.path);
+    }
+    return paths;
+}
+
+double LocalDemSource::elevation(double latitude, double longitude) const
+{
+    QReadLocker locker(&_lock);
+
+    const DemFile* const demFile = _findFile(latitude, longitude);
+    return demFile ? _interpolate(*demFile, latitude, longitude) : qQNaN();
+}
+
+bool LocalDemSource::elevations(const QList<QGeoCoordinate> &coordinates, QList<double> &elevations) const
+{
+    const qsizetype count = coordinates.count();
+    QList<double> latitudes(count);
+    QList<double> longitudes(count);
+    for (qsizetype i = 0; i < count; i++) {
+        latitudes[i] = coordinates[i].latitude();
+        longitudes[i] = coordinates[i].longitude();
+    }
+
+    elevations.resize(count);
+    return this->elevations(latitudes.constData(), longitudes.constData(), elevations.data(), count);
+}
+
+bool LocalDemSource::elevations(const double *latitudes, const double *longitudes, double *elevations, qsizetype count) const
+{
+    QReadLocker locker(&_lock);
+
+    bool complete = true;
+    const DemFile *demFile = nullptr;
+    int cellKey = -1;
+    for (qsizetype i = 0; i < count; i++) {
+        const double latitude = latitudes[i];
+        const double longitude = longitudes[i];
+
+        // Neighbouring coordinates nearly always fall into the same cell and file as the previous one
+        const int coordinateCellKey = (qIsNaN(latitude) || qIsNaN(longitude)) ? -1 : _cellKey(qFloor(latitude), qFloor(longitude));
+        if (!demFile || (coordinateCellKey != cellKey) || !_contains(*demFile, latitude, longitude)) {
+            demFile = _findFile(latitude, longitude);
+            cellKey = coordinateCellKey;
+        }
+
+        elevations[i] = demFile ? _interpolate(*demFile, latitude, longitude) : qQNaN();
+        complete &= !qIsNaN(elevations[i]);
+    }
+
+    return complete;
+}
+
+double LocalDemSource::resolution(double latitude, double longitude) const
+{
+    QReadLocker locker(&_lock);
+
+    const DemFile* const demFile = _findFile(latitude, longitude);
+    return demFile ? demFile->stepLat : 0.;
+}
+
+bool LocalDemSource::_openFile(const QString &path, DemFile &demFile) const
+{
+    demFile.path = path;
+    demFile.file = std::make_shared<QFile>(path);
+    if (!demFile.file->open(QIODevice::ReadOnly)) {
+        qCWarning(TerrainQueryLocalDemLog) << "Failed to open local DEM:" << path << demFile.file->errorString();
+        return false;
+    }
+
+    // Samples are read straight out of the page cache, nothing is loaded up front
+    demFile.size = demFile.file->size();
+    demFile.data = demFile.file->map(0, demFile.size);
+    if (!demFile.data) {
+        qCWarning(TerrainQueryLocalDemLog) << "Failed to map local DEM:" << path << demFile.file->errorString();
+        return false;
+    }
+
+    const bool valid = path.endsWith(QStringLiteral(".hgt"), Qt::CaseInsensitive) ? _openHgt(demFile) : _openGeoTiff(demFile);
+    if (!valid) {
+        return false;
+    }
+
+    if ((demFile.rows < 2) || (demFile.columns < 2) || (demFile.stepLat <= 0) || (demFile.stepLon <= 0)) {
+        qCWarning(TerrainQueryLocalDemLog) << "Unsupported local DEM grid:" << path;
+        return false;
+    }
+
+    // Every sample must be inside the file
+    const int sampleSize = _sampleSize(demFile.sampleType);
+    const int blocksAcross = (demFile.columns + demFile.blockWidth - 1) / demFile.blockWidth;
+    const int blocksDown = (demFile.rows + demFile.blockHeight - 1) / demFile.blockHeight;
+    if (demFile.blockOffsets.count() < (blocksAcross * blocksDown)) {
+        qCWarning(TerrainQueryLocalDemLog) << "Local DEM is missing data blocks:" << path;
+        return false;
+    }
+    const qint64 blockBytes = static_cast<qint64>(demFile.blockWidth) * demFile.blockHeight * sampleSize;
+    for (int i = 0; i < (blocksAcross * blocksDown); i++) {
+        // The last strip may be shorter than the others
+        const int blockRows = (blocksAcross == 1) ? qMin(demFile.blockHeight, demFile.rows - (i * demFile.blockHeight)) : demFile.blockHeight;
+        const qint64 bytes = (blocksAcross == 1) ? (static_cast<qint64>(demFile.blockWidth) * blockRows * sampleSize) : blockBytes;
+        if ((static_cast<qint64>(demFile.blockOffsets[i]) + bytes) > demFile.size) {
+            qCWarning(TerrainQueryLocalDemLog) << "Local DEM is truncated:" << path;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool LocalDemSource::_openHgt(DemFile &demFile) const
+{
+    // SRTM tiles are named after the south west corner, e.g. N37W122.hgt
+    static const QRegularExpression nameRegExp(QStringLiteral("^([NS])(\\d{2})([EW])(\\d{3})\\.hgt$"), QRegularExpression::CaseInsensitiveOption);
+    const QRegularExpressionMatch match = nameRegExp.match(QFileInfo(demFile.path).fileName());
+    if (!match.hasMatch()) {
+        qCWarning(TerrainQueryLocalDemLog) << "Unexpected .hgt file name:" << demFile.path;
+        return false;
+    }
+
+    const int samples = static_cast<int>(qSqrt(static_cast<double>(demFile.size / 2)));
+    if ((static_cast<qint64>(samples) * samples * 2) != demFile.size) {
+        qCWarning(TerrainQueryLocalDemLog) << "Unexpected .hgt file size:" << demFile.path << demFile.size;
+        return false;
+    }
+
+    int southLat = match.captured(2).toInt();
+    if (match.captured(1).compare(QStringLiteral("S"), Qt::CaseInsensitive) == 0) {
+        southLat = -southLat;
+    }
+    int westLon = match.captured(4).toInt();
+    if (match.captured(3).compare(QStringLiteral("W"), Qt::CaseInsensitive) == 0) {
+        westLon = -westLon;
+    }
+
+    // Samples sit on the grid lines, the outer rows and columns overlap the neighbouring tiles
+    demFile.northLat = southLat + 1;
+    demFile.westLon = westLon;
+    demFile.rows = samples;
+    demFile.columns = samples;
+    demFile.stepLat = 1.0 / (samples - 1);
+    demFile.stepLon = 1.0 / (samples - 1);
+    demFile.sampleType = SampleType::Int16;
+    demFile.bigEndian = true;
+    demFile.hasNoData = true;
+    demFile.noData = kHgtVoid;
+    demFile.blockWidth = samples;
+    demFile.blockHeight = samples;
+    demFile.blockOffsets = { 0 };
+
+    return true;
+}
+
+bool LocalDemSource::_openGeoTiff(DemFile &demFile) const
+{
+    const uchar* const data = demFile.data;
+    const qint64 size = demFile.size;
+    if ((size < 8) || (data[0] != data[1]) || ((data[0] != 'I') && (data[0] != 'M'))) {
+        qCWarning(TerrainQueryLocalDemLog) << "Not a TIFF file:" << demFile.path;
+        return false;
+    }
+
+    const bool bigEndian = (data[0] == 'M');
+    if (_readU16(data + 2, bigEndian) != 42) {
+        qCWarning(TerrainQueryLocalDemLog) << "BigTIFF is not supported:" << demFile.path;
+        return false;
+    }
+
+    const quint32 ifdOffset = _readU32(data + 4, bigEndian);
+    if ((static_cast<qint64>(ifdOffset) + 2) > size) {
+        return false;
+    }
+    const quint16 entryCount = _readU16(data + ifdOffset, bigEndian);
+    if ((static_cast<qint64>(ifdOffset) + 2 + (entryCount * 12)) > size) {
+        return false;
+    }
+
+    QHash<quint16, TiffEntry> entries;
+    for (quint16 i = 0; i < entryCount; i++) {
+        const uchar* const entry = data + ifdOffset + 2 + (i * 12);
+        (void) entries.insert(_readU16(entry, bigEndian), TiffEntry(data, size, entry, bigEndian));
+    }
+
+    const auto number = [&entries](quint16 tag, double defaultValue) {
+        const auto it = entries.constFind(tag);
+        return ((it != entries.cend()) && it->isValid() && (it->count() > 0)) ? it->value(0) : defaultValue;
+    };
+
+    if ((number(kTagCompression, 1) != 1) || (number(kTagSamplesPerPixel, 1) != 1)) {
+        qCWarning(TerrainQueryLocalDemLog) << "Only uncompressed single band GeoTIFFs are supported:" << demFile.path;
+        return false;
+    }
+
+    const int bitsPerSample = static_cast<int>(number(kTagBitsPerSample, 0));
+    const int sampleFormat = static_cast<int>(number(kTagSampleFormat, 1));
+    if ((bitsPerSample == 16) && (sampleFormat == 2)) {
+        demFile.sampleType = SampleType::Int16;
+    } else if ((bitsPerSample == 16) && (sampleFormat == 1)) {
+        demFile.sampleType = SampleType::UInt16;
+    } else if ((bitsPerSample == 32) && (sampleFormat == 3)) {
+        demFile.sampleType = SampleType::Float32;
+    } else {
+        qCWarning(TerrainQueryLocalDemLog) << "Unsupported GeoTIFF sample format:" << demFile.path << bitsPerSample << sampleFormat;
+        return false;
+    }
+    demFile.bigEndian = bigEndian;
+    demFile.columns = static_cast<int>(number(kTagImageWidth, 0));
+    demFile.rows = static_cast<int>(number(kTagImageLength, 0));
+
+    if (entries.contains(kTagTileOffsets)) {
+        demFile.blockWidth = static_cast<int>(number(kTagTileWidth, 0));
+        demFile.blockHeight = static_cast<int>(number(kTagTileLength, 0));
+        for (const double offset : entries.value(kTagTileOffsets).values()) {
+            demFile.blockOffsets.append(static_cast<quint64>(offset));
+        }
+    } else {
+        demFile.blockWidth = demFile.columns;
+        demFile.blockHeight = static_cast<int>(number(kTagRowsPerStrip, demFile.rows));
+        for (const double offset : entries.value(kTagStripOffsets).values()) {
+            demFile.blockOffsets.append(static_cast<quint64>(offset));
+        }
+    }
+    if ((demFile.blockWidth <= 0) || (demFile.blockHeight <= 0)) {
+        qCWarning(TerrainQueryLocalDemLog) << "Invalid GeoTIFF layout:" << demFile.path;
+        return false;
+    }
+
+    // Georeferencing: one tiepoint and the pixel scale, rotated or sheared rasters are not supported
+    const QList<double> tiepoint = entries.value(kTagModelTiepoint).values();
+    const QList<double> pixelScale = entries.value(kTagModelPixelScale).values();
+    if ((tiepoint.count() < 6) || (pixelScale.count() < 2)) {
+        qCWarning(TerrainQueryLocalDemLog) << "GeoTIFF is not georeferenced:" << demFile.path;
+        return false;
+    }
+
+    quint16 modelType = kModelTypeGeographic;
+    quint16 rasterType = 1;
+    const QList<double> geoKeys = entries.value(kTagGeoKeyDirectory).values();
+    for (qsizetype i = 4; (i + 3) < geoKeys.count(); i += 4) {
+        if (geoKeys[i] == kGeoKeyModelType) {
+            modelType = static_cast<quint16>(geoKeys[i + 3]);
+        } else if (geoKeys[i] == kGeoKeyRasterType) {
+            rasterType = static_cast<quint16>(geoKeys[i + 3]);
+        }
+    }
+    if (modelType != kModelTypeGeographic) {
+        qCWarning(TerrainQueryLocalDemLog) << "Only GeoTIFFs in geographic coordinates are supported:" << demFile.path;
+        return false;
+    }
+
+    demFile.stepLon = pixelScale[0];
+    demFile.stepLat = pixelScale[1];
+    demFile.westLon = tiepoint[3] - (tiepoint[0] * demFile.stepLon);
+    demFile.northLat = tiepoint[4] + (tiepoint[1] * demFile.stepLat);
+    if (rasterType != kRasterPixelIsPoint) {
+        // Tiepoints of area rasters refer to the pixel corner, samples are taken at the pixel centers
+        demFile.westLon += demFile.stepLon / 2;
+        demFile.northLat -= demFile.stepLat / 2;
+    }
+
+    bool ok = false;
+    const double noData = entries.value(kTagGdalNoData).string().trimmed().toDouble(&ok);
+    demFile.hasNoData = ok;
+    demFile.noData = noData;
+
+    return true;
+}
+
+void LocalDemSource::_indexFile(int fileIndex)
+{
+    const DemFile &demFile = _files[fileIndex];
+    const int southCell = qFloor(demFile.northLat - ((demFile.rows - 1) * demFile.stepLat));
+    const int northCell = qMin(qFloor(demFile.northLat), 89);
+    const int westCell = qFloor(demFile.westLon);
+    const int eastCell = qMin(qFloor(demFile.westLon + ((demFile.columns - 1) * demFile.stepLon)), 179);
+
+    for (int lat = qMax(southCell, -90); lat <= northCell; lat++) {
+        for (int lon = qMax(westCell, -180); lon <= eastCell; lon++) {
+            QList<int> &cellFiles = _cellIndex[_cellKey(lat, lon)];
+            // Finer models take precedence where files overlap
+            const auto it = std::upper_bound(cellFiles.begin(), cellFiles.end(), demFile.stepLat, [this](double stepLat, int index) {
+                return stepLat < _files[index].stepLat;
+            });
+            (void) cellFiles.insert(it, fileIndex);
+        }
+    }
+}
+
+void LocalDemSource::_closeFiles()
+{
+    // Unmapped when the last reference to each QFile goes away
+    _cellIndex.clear();
+    _files.clear();
+}
+
+const LocalDemSource::DemFile *LocalDemSource::_findFile(double latitude, double longitude) const
+{
+    if (qIsNaN(latitude) || qIsNaN(longitude)) {
+        return nullptr;
+    }
+
+    const auto it = _cellIndex.constFind(_cellKey(qFloor(latitude), qFloor(longitude)));
+    if (it == _cellIndex.cend()) {
+        return nullptr;
+    }
+
+    for (const int index : *it) {
+        if (_contains(_files[index], latitude, longitude)) {
+            return &_files[index];
+        }
+    }
+
+    return nullptr;
+}
+
+bool LocalDemSource::_contains(const DemFile &demFile, double latitude, double longitude)
+{
+    static constexpr double epsilon = 1e-9;
+    const double southLat = demFile.northLat - ((demFile.rows - 1) * demFile.stepLat);
+    const double eastLon = demFile.westLon + ((demFile.columns - 1) * demFile.stepLon);
+    return (latitude >= (southLat - epsilon)) && (latitude <= (demFile.northLat + epsilon)) &&
+        (longitude >= (demFile.westLon - epsilon)) && (longitude <= (eastLon + epsilon));
+}
+
+double LocalDemSource::_sample(const DemFile &demFile, int row, int column) const
+{
+    const int sampleSize = _sampleSize(demFile.sampleType);
+    const int blocksAcross = (demFile.columns + demFile.blockWidth - 1) / demFile.blockWidth;
+    const int block = ((row / demFile.blockHeight) * blocksAcross) + (column / demFile.blockWidth);
+    const qint64 offset = static_cast<qint64>(demFile.blockOffsets[block]) +
+        ((static_cast<qint64>(row % demFile.blockHeight) * demFile.blockWidth) + (column % demFile.blockWidth)) * sampleSize;
+    const uchar* const p = demFile.data + offset;
+
+    double value;
+    switch (demFile.sampleType) {
+    case SampleType::Int16:
+        value = static_cast<qint16>(_readU16(p, demFile.bigEndian));
+        break;
+    case SampleType::UInt16:
+        value = _readU16(p, demFile.bigEndian);
+        break;
+    case SampleType::Float32:
+    default:
+        value = _readF32(p, demFile.bigEndian);
+        break;
+    }
+
+    if (demFile.hasNoData && (value == demFile.noData)) {
+        return qQNaN();
+    }
+    return value;
+}
+
+double LocalDemSource::_interpolate(const DemFile &demFile, double latitude, double longitude) const
+{
+    const double rowPosition = (demFile.northLat - latitude) / demFile.stepLat;
+    const double columnPosition = (longitude - demFile.westLon) / demFile.stepLon;
+    const int row = qBound(0, qFloor(rowPosition), demFile.rows - 2);
+    const int column = qBound(0, qFloor(columnPosition), demFile.columns - 2);
+    const double rowFraction = qBound(0., rowPosition - row, 1.);
+    const double columnFraction = qBound(0., columnPosition - column, 1.);
+
+    const double northWest = _sample(demFile, row, column);
+    const double northEast = _sample(demFile, row, column + 1);
+    const double southWest = _sample(demFile, row + 1, column);
+    const double southEast = _sample(demFile, row + 1, column + 1);
+
+    if (qIsNaN(northWest) || qIsNaN(northEast) || qIsNaN(southWest) || qIsNaN(southEast)) {
+        // Next to voids only the nearest sample is used
+        const int nearestRow = qBound(0, qRound(rowPosition), demFile.rows - 1);
+        const int nearestColumn = qBound(0, qRound(columnPosition), demFile.columns - 1);
+        return _sample(demFile, nearestRow, nearestColumn);
+    }
+
+    const double north = northWest + ((northEast - northWest) * columnFraction);
+    const double south = southWest + ((southEast - southWest) * columnFraction);
+    return north + ((south - north) * rowFraction);
+}
+
+/*===========================================================================*/
+
+TerrainQueryLocalDem::TerrainQueryLocalDem(QObject *parent)
+    : TerrainQueryInterface(parent)
+{
+    // qCDebug(TerrainQueryLocalDemLog) << Q_FUNC_INFO << this;
+}
+
+TerrainQueryLocalDem::~TerrainQueryLocalDem()
+{
+    // qCDebug(TerrainQueryLocalDemLog) << Q_FUNC_INFO << this;
+}
+
+LocalDemSource *TerrainQueryLocalDem::source()
+{
+    LocalDemSource* const source = LocalDemSource::instance();
+
+    static std::once_flag directoryFollowsSettings;
+    std::call_once(directoryFollowsSettings, [source]() {
+        AppSettings* const appSettings = SettingsManager::instance()->appSettings();
+        Fact* const elevationMapProvider = SettingsManager::instance()->flightMapSettings()->elevationMapProvider();
+
+        source->setDirectory(appSettings->elevationSavePath());
+        (void) QObject::connect(appSettings, &AppSettings::savePathsChanged, appSettings, [source, appSettings]() {
+            source->setDirectory(appSettings->elevationSavePath());
+        });
+        // Selecting the provider again is how files copied in while running are picked up
+        (void) QObject::connect(elevationMapProvider, &Fact::rawValueChanged, appSettings, [source]() {
+            if (TerrainTileManager::localDemSelected()) {
+                source->rescan();
+            }
+        });
+    });
+
+    return source;
+}
+
+void TerrainQueryLocalDem::requestCoordinateHeights(const QList<QGeoCoordinate> &coordinates)
+{
+    if (coordinates.isEmpty()) {
+        return;
+    }
+
+    _queryMode = TerrainQuery::QueryModeCoordinates;
+
+    QList<double> heights;
+    if (!source()->elevations(coordinates, heights)) {
+        qCWarning(TerrainQueryLocalDemLog) << Q_FUNC_INFO << "no local elevation data for some coordinates";
+        _requestFailed();
+        return;
+    }
+
+    emit coordinateHeightsReceived(true, heights);
+}
+
+void TerrainQueryLocalDem::requestPathHeights(const QGeoCoordinate &fromCoord, const QGeoCoordinate &toCoord)
+{
+    _queryMode = TerrainQuery::QueryModePath;
+
+    double distanceBetween;
+    double finalDistanceBetween;
+    const QList<QGeoCoordinate> coordinates = TerrainTileManager::pathQueryToCoords(fromCoord, toCoord, distanceBetween, finalDistanceBetween);
+
+    QList<double> heights;
+    if (!source()->elevations(coordinates, heights)) {
+        qCWarning(TerrainQueryLocalDemLog) << Q_FUNC_INFO << "no local elevation data along path";
+        _requestFailed();
+        return;
+    }
+
+    emit pathHeightsReceived(true, distanceBetween, finalDistanceBetween, heights);
+}
+
+void TerrainQueryLocalDem::requestCarpetHeights(const QGeoCoordinate &swCoord, const QGeoCoordinate &neCoord, bool statsOnly)
+{
+    _queryMode = TerrainQuery::QueryModeCarpet;
+
+    double minHeight;
+    double maxHeight;
+    QList<QList<double>> carpet;
+    if (!carpetHeights(swCoord, neCoord, statsOnly, minHeight, maxHeight, carpet)) {
+        qCWarning(TerrainQueryLocalDemLog) << Q_FUNC_INFO << "no local elevation data for area";
+        _requestFailed();
+        return;
+    }
+
+    emit carpetHeightsReceived(true, minHeight, maxHeight, carpet);
+}
+
+bool TerrainQueryLocalDem::carpetHeights(const QGeoCoordinate &swCoord, const QGeoCoordinate &neCoord, bool statsOnly, double &minHeight, double &maxHeight, QList<QList<double>> &carpet)
+{
+    LocalDemSource* const demSource = source();
+
+    // Sampled at the resolution of the model in the middle of the area
+    const double resolution = demSource->resolution((swCoord.latitude() + neCoord.latitude()) / 2, (swCoord.longitude() + neCoord.longitude()) / 2);
+    if (resolution <= 0) {
+        return false;
+    }
+
+    return TerrainTileManager::sampleCarpet(swCoord, neCoord, resolution, statsOnly, [demSource](const double *latitudes, const double *longitudes, double *elevations, qsizetype count) {
+        return demSource->elevations(latitudes, longitudes, elevations, count);
+    }, minHeight, maxHeight, carpet);
+}
@@ -0,0 +1,127 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "TerrainQueryInterface.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QReadWriteLock>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+#include <memory>
+
+class QFile;
+class QGeoCoordinate;
+
+Q_DECLARE_LOGGING_CATEGORY(TerrainQueryLocalDemLog)
+
+/// Read-only access to digital elevation models in the local elevation directory. Supported are SRTM
+/// .hgt files and uncompressed single band GeoTIFFs in geographic coordinates (WGS84). Files are memory
+/// mapped and sampled in place, and indexed by the 1°x1° cells they cover.
+class LocalDemSource
+{
+public:
+    LocalDemSource() = default;
+    ~LocalDemSource();
+
+    static LocalDemSource *instance();
+
+    /// Scans directory for *.hgt, *.tif and *.tiff files, replacing any previously opened files. Does
+    /// nothing if the directory is unchanged, the file system is not touched in that case.
+    void setDirectory(const QString &directory);
+    /// Scans the current directory again to pick up files added or removed since the last scan
+    void rescan();
+    QStringList files() const;
+
+    /// Elevation in meters interpolated between the surrounding samples, NaN if no file covers the
+    /// coordinate or the data there is void
+    double elevation(double latitude, double longitude) const;
+
+    /// @return false if any coordinate has no elevation, those are NaN in elevations
+    bool elevations(const QList<QGeoCoordinate> &coordinates, QList<double> &elevations) const;
+    bool elevations(const double *latitudes, const double *longitudes, double *elevations, qsizetype count) const;
+
+    /// Sample spacing in degrees of the file covering the coordinate, or 0 if none does
+    double resolution(double latitude, double longitude) const;
+
+private:
+    enum class SampleType {
+        Int16,
+        UInt16,
+        Float32
+    };
+
+    struct DemFile {
+        QString path;
+        std::shared_ptr<QFile> file;
+        const uchar *data = nullptr;
+        qint64 size = 0;
+
+        double northLat = 0;            ///< Latitude of the first sample row
+        double westLon = 0;             ///< Longitude of the first sample column
+        double stepLat = 0;             ///< Degrees between sample rows, rows run north to south
+        double stepLon = 0;
+        int rows = 0;
+        int columns = 0;
+
+        SampleType sampleType = SampleType::Int16;
+        bool bigEndian = false;
+        bool hasNoData = false;
+        double noData = 0;
+
+        int blockWidth = 0;             ///< Width of the data blocks (full width for strips)
+        int blockHeight = 0;            ///< Rows per strip or tile height
+        QList<quint64> blockOffsets;    ///< Strip or tile offsets into the file
+    };
+
+    bool _openFile(const QString &path, DemFile &demFile) const;
+    bool _openHgt(DemFile &demFile) const;
+    bool _openGeoTiff(DemFile &demFile) const;
+    void _scanDirectory();
+    void _indexFile(int fileIndex);
+    void _closeFiles();
+
+    const DemFile *_findFile(double latitude, double longitude) const;
+    static bool _contains(const DemFile &demFile, double latitude, double longitude);
+    static int _sampleSize(SampleType sampleType) { return (sampleType == SampleType::Float32) ? 4 : 2; }
+    double _sample(const DemFile &demFile, int row, int column) const;
+    double _interpolate(const DemFile &demFile, double latitude, double longitude) const;
+    static int _cellKey(int latitude, int longitude) { return ((latitude + 90) * 360) + (longitude + 180); }
+
+    mutable QReadWriteLock _lock;
+    QString _directory;
+    QList<DemFile> _files;
+    QHash<int, QList<int>> _cellIndex;  ///< 1° cell to indices into _files, finest resolution first
+};
+
+/// Terrain queries answered synchronously from LocalDemSource, no network access is needed
+class TerrainQueryLocalDem : public TerrainQueryInterface
+{
+    Q_OBJECT
+
+public:
+    explicit TerrainQueryLocalDem(QObject *parent = nullptr);
+    ~TerrainQueryLocalDem();
+
+    void requestCoordinateHeights(const QList<QGeoCoordinate> &coordinates) final;
+    void requestPathHeights(const QGeoCoordinate &fromCoord, const QGeoCoordinate &toCoord) final;
+    void requestCarpetHeights(const QGeoCoordinate &swCoord, const QGeoCoordinate &neCoord, bool statsOnly) final;
+
+    /// Shared source for the elevation directory from the settings. It is scanned on first use and again
+    /// when the save path changes or the local elevation provider is selected.
+    static LocalDemSource *source();
+
+    /// Synchronous carpet at the resolution of the local model, rows run from south to north
+    ///     @return false if part of the area is not covered
+    static bool carpetHeights(const QGeoCoordinate &swCoord, const QGeoCoordinate &neCoord, bool statsOnly, double &minHeight, double &maxHeight, QList<QList<double>> &carpet);
+};
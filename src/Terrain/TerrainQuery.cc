@@ -9,7 +9,11 @@
 
 #include "TerrainQuery.h"
 #include "TerrainQueryInterface.h"
+#include "TerrainQueryLocalDem.h"
 #include "TerrainTileManager.h"
+#include "SettingsManager.h"
+#include "FlightMapSettings.h"
+#include "Fact.h"
 #include "QGCLoggingCategory.h"
 
 #include <QtCore/QTimer>
@@ -18,11 +22,19 @@ QGC_LOGGING_CATEGORY(TerrainQueryLog, "qgc.terrain.terrainquery")
 QGC_LOGGING_CATEGORY(TerrainQueryVerboseLog, "qgc.terrain.terrainquery.verbose")
 
 Q_GLOBAL_STATIC(TerrainAtCoordinateBatchManager, _terrainAtCoordinateBatchManager)
+Q_GLOBAL_STATIC(TerrainPathBatchManager, _terrainPathBatchManager)
+
+/// Local elevation models are read straight from the files, all other providers go through the tile manager
+static TerrainQueryInterface *_selectTerrainQuery(TerrainQueryInterface *tileQuery, TerrainQueryInterface *localDemQuery)
+{
+    return TerrainTileManager::localDemSelected() ? localDemQuery : tileQuery;
+}
 
 TerrainAtCoordinateBatchManager::TerrainAtCoordinateBatchManager(QObject *parent)
     : QObject(parent)
     , _batchTimer(new QTimer(this))
     , _terrainQuery(new TerrainOfflineQuery(this))
+    , _localDemQuery(new TerrainQueryLocalDem(this))
 {
     // qCDebug(TerrainQueryLog) << Q_FUNC_INFO << this;
 
@@ -31,6 +43,7 @@ TerrainAtCoordinateBatchManager::TerrainAtCoordinateBatchManager(QObject *parent
 
     (void) connect(_batchTimer, &QTimer::timeout, this, &TerrainAtCoordinateBatchManager::_sendNextBatch);
     (void) connect(_terrainQuery, &TerrainQueryInterface::coordinateHeightsReceived, this, &TerrainAtCoordinateBatchManager::_coordinateHeights);
+    (void) connect(_localDemQuery, &TerrainQueryInterface::coordinateHeightsReceived, this, &TerrainAtCoordinateBatchManager::_coordinateHeights);
 }
 
 TerrainAtCoordinateBatchManager::~TerrainAtCoordinateBatchManager()
@@ -100,7 +113,7 @@ void TerrainAtCoordinateBatchManager::_sendNextBatch()
     qCDebug(TerrainQueryLog) << Q_FUNC_INFO << "requesting next batch _state:_requestQueue.count:_sentRequests.count" << _stateToString(_state) << _requestQueue.count() << _sentRequests.count();
 
     _state = TerrainQuery::State::Downloading;
-    _terrainQuery->requestCoordinateHeights(coords);
+    _selectTerrainQuery(_terrainQuery, _localDemQuery)->requestCoordinateHeights(coords);
 }
 
 void TerrainAtCoordinateBatchManager::_batchFailed()
@@ -212,6 +225,11 @@ bool TerrainAtCoordinateQuery::getAltitudesForCoordinates(const QList<QGeoCoordi
     return TerrainTileManager::instance()->getAltitudesForCoordinates(coordinates, altitudes, error);
 }
 
+void TerrainAtCoordinateQuery::prefetchArea(const QGeoCoordinate &swCoord, const QGeoCoordinate &neCoord)
+{
+    TerrainTileManager::instance()->prefetchArea(swCoord, neCoord);
+}
+
 void TerrainAtCoordinateQuery::signalTerrainData(bool success, const QList<double> &heights)
 {
     emit terrainDataReceived(success, heights);
@@ -225,11 +243,8 @@ void TerrainAtCoordinateQuery::signalTerrainData(bool success, const QList<doubl
 TerrainPathQuery::TerrainPathQuery(bool autoDelete, QObject *parent)
    : QObject(parent)
    , _autoDelete(autoDelete)
-   , _terrainQuery(new TerrainOfflineQuery(this))
 {
     // qCDebug(TerrainQueryLog) << Q_FUNC_INFO << this;
-
-    (void) connect(_terrainQuery, &TerrainQueryInterface::pathHeightsReceived, this, &TerrainPathQuery::_pathHeights);
 }
 
 TerrainPathQuery::~TerrainPathQuery()
@@ -239,15 +254,11 @@ TerrainPathQuery::~TerrainPathQuery()
 
 void TerrainPathQuery::requestData(const QGeoCoordinate &fromCoord, const QGeoCoordinate &toCoord)
 {
-    _terrainQuery->requestPathHeights(fromCoord, toCoord);
+    TerrainPathBatchManager::instance()->addQuery(this, fromCoord, toCoord);
 }
 
-void TerrainPathQuery::_pathHeights(bool success, double distanceBetween, double finalDistanceBetween, const QList<double> &heights)
+void TerrainPathQuery::signalTerrainData(bool success, const PathHeightInfo_t &pathHeightInfo)
 {
-    PathHeightInfo_t pathHeightInfo;
-    pathHeightInfo.distanceBetween = distanceBetween;
-    pathHeightInfo.finalDistanceBetween = finalDistanceBetween;
-    pathHeightInfo.heights = heights;
     emit terrainDataReceived(success, pathHeightInfo);
     if (_autoDelete) {
         deleteLater();
@@ -259,11 +270,8 @@ void TerrainPathQuery::_pathHeights(bool success, double distanceBetween, double
 TerrainPolyPathQuery::TerrainPolyPathQuery(bool autoDelete, QObject *parent)
     : QObject(parent)
     , _autoDelete(autoDelete)
-    , _pathQuery(new TerrainPathQuery(false, this))
 {
     // qCDebug(TerrainQueryLog) << Q_FUNC_INFO << this;
-
-    (void) connect(_pathQuery, &TerrainPathQuery::terrainDataReceived, this, &TerrainPolyPathQuery::_terrainDataReceived);
 }
 
 TerrainPolyPathQuery::~TerrainPolyPathQuery()
@@ -286,30 +294,287 @@ void TerrainPolyPathQuery::requestData(const QList<QGeoCoordinate> &polyPath)
 {
     qCDebug(TerrainQueryLog) << Q_FUNC_INFO << "count" << polyPath.count();
 
-    _rgCoords = polyPath;
-    _curIndex = 0;
-    _pathQuery->requestData(_rgCoords[0], _rgCoords[1]);
+    TerrainPathBatchManager::instance()->addQuery(this, polyPath);
 }
 
-void TerrainPolyPathQuery::_terrainDataReceived(bool success, const TerrainPathQuery::PathHeightInfo_t &pathHeightInfo)
+void TerrainPolyPathQuery::signalTerrainData(bool success, const QList<TerrainPathQuery::PathHeightInfo_t> &rgPathHeightInfo)
 {
-    qCDebug(TerrainQueryLog) << Q_FUNC_INFO << "success:_curIndex" << success << _curIndex;
+    qCDebug(TerrainQueryLog) << Q_FUNC_INFO << "success:count" << success << rgPathHeightInfo.count();
 
-    if (!success) {
-        _rgPathHeightInfo.clear();
-        emit terrainDataReceived(false, _rgPathHeightInfo);
+    emit terrainDataReceived(success, rgPathHeightInfo);
+    if (_autoDelete) {
+        deleteLater();
+    }
+}
+
+/*===========================================================================*/
+
+TerrainPathBatchManager::TerrainPathBatchManager(QObject *parent)
+    : QObject(parent)
+    , _batchTimer(new QTimer(this))
+{
+    // qCDebug(TerrainQueryLog) << Q_FUNC_INFO << this;
+
+    _pathCache.setMaxCost(kMaxCachedHeights);
+
+    _batchTimer->setSingleShot(true);
+    _batchTimer->setInterval(kBatchTimeoutMsecs);
+
+    (void) connect(_batchTimer, &QTimer::timeout, this, &TerrainPathBatchManager::_sendNextBatch);
+    (void) connect(SettingsManager::instance()->flightMapSettings()->elevationMapProvider(), &Fact::rawValueChanged, this, &TerrainPathBatchManager::clearCache);
+
+    _setTerrainQuery(new TerrainOfflineQuery(this));
+    _localDemQuery = new TerrainQueryLocalDem(this);
+    (void) connect(_localDemQuery, &TerrainQueryInterface::coordinateHeightsReceived, this, &TerrainPathBatchManager::_coordinateHeights);
+}
+
+TerrainPathBatchManager::~TerrainPathBatchManager()
+{
+    // qCDebug(TerrainQueryLog) << Q_FUNC_INFO << this;
+}
+
+TerrainPathBatchManager *TerrainPathBatchManager::instance()
+{
+    return _terrainPathBatchManager();
+}
+
+void TerrainPathBatchManager::_setTerrainQuery(TerrainQueryInterface *terrainQuery)
+{
+    if (_terrainQuery) {
+        _terrainQuery->deleteLater();
+    }
+
+    _terrainQuery = terrainQuery;
+    (void) connect(_terrainQuery, &TerrainQueryInterface::coordinateHeightsReceived, this, &TerrainPathBatchManager::_coordinateHeights);
+}
+
+void TerrainPathBatchManager::addQuery(TerrainPathQuery *terrainPathQuery, const QGeoCoordinate &fromCoord, const QGeoCoordinate &toCoord)
+{
+    _addQuery(terrainPathQuery, false, { fromCoord, toCoord });
+}
+
+void TerrainPathBatchManager::addQuery(TerrainPolyPathQuery *terrainPolyPathQuery, const QList<QGeoCoordinate> &polyPath)
+{
+    if (polyPath.count() < 2) {
+        qCWarning(TerrainQueryLog) << Q_FUNC_INFO << "poly path needs at least two coordinates";
+        return;
+    }
+
+    _addQuery(terrainPolyPathQuery, true, polyPath);
+}
+
+void TerrainPathBatchManager::clearCache()
+{
+    _pathCache.clear();
+}
+
+void TerrainPathBatchManager::_addQuery(QObject *terrainQuery, bool polyPath, const QList<QGeoCoordinate> &coordinates)
+{
+    // Requests for paths which are all cached do not need to wait for the next batch
+    QList<TerrainPathQuery::PathHeightInfo_t> rgPathHeightInfo;
+    for (qsizetype i = 0; i < (coordinates.count() - 1); i++) {
+        const TerrainPathQuery::PathHeightInfo_t* const pathHeightInfo = _pathCache.object(_pathKey(coordinates[i], coordinates[i + 1]));
+        if (!pathHeightInfo) {
+            break;
+        }
+        rgPathHeightInfo.append(*pathHeightInfo);
+    }
+
+    if (rgPathHeightInfo.count() == (coordinates.count() - 1)) {
+        qCDebug(TerrainQueryVerboseLog) << Q_FUNC_INFO << "answered from cache" << terrainQuery;
+        // Results are always signalled asynchronously, callers connect after requesting
+        QTimer::singleShot(0, terrainQuery, [terrainQuery, polyPath, rgPathHeightInfo]() {
+            _signalQuery(terrainQuery, polyPath, true, rgPathHeightInfo);
+        });
+        return;
+    }
+
+    (void) connect(terrainQuery, &QObject::destroyed, this, &TerrainPathBatchManager::_queryObjectDestroyed);
+    const QueuedRequestInfo_t queuedRequestInfo = {
+        terrainQuery,
+        polyPath,
+        coordinates
+    };
+    _requestQueue.enqueue(queuedRequestInfo);
+
+    if (!_batchTimer->isActive()) {
+        _batchTimer->start();
+    }
+}
+
+void TerrainPathBatchManager::_sendNextBatch()
+{
+    qCDebug(TerrainQueryLog) << Q_FUNC_INFO << "_requestQueue.count:_sentRequests.count" << _requestQueue.count() << _sentRequests.count();
+
+    if (_state != TerrainQuery::State::Idle) {
+        // Waiting for the last batch to complete, wait some more
+        _batchTimer->start();
         return;
     }
 
-    (void) _rgPathHeightInfo.append(pathHeightInfo);
+    if (_requestQueue.isEmpty()) {
+        return;
+    }
+
+    _sentRequests.clear();
+    _sentPaths.clear();
+
+    // Every path is sampled once and every sample point is looked up once, no matter how many requests share them
+    QHash<PathKey_t, qsizetype> pathIndices;
+    QHash<QPair<double, double>, qsizetype> sampleIndices;
+    QList<QGeoCoordinate> samples;
+    while (!_requestQueue.isEmpty()) {
+        const QueuedRequestInfo_t requestInfo = _requestQueue.dequeue();
+        SentRequestInfo_t sentRequestInfo = {
+            requestInfo.terrainQuery,
+            requestInfo.polyPath,
+            false,
+            {}
+        };
 
-    if (++_curIndex >= (_rgCoords.count() - 1)) {
-        qCDebug(TerrainQueryLog) << Q_FUNC_INFO << "complete";
-        emit terrainDataReceived(true, _rgPathHeightInfo);
-        if (_autoDelete) {
-            deleteLater();
+        for (qsizetype i = 0; i < (requestInfo.coordinates.count() - 1); i++) {
+            const QGeoCoordinate &fromCoord = requestInfo.coordinates[i];
+            const QGeoCoordinate &toCoord = requestInfo.coordinates[i + 1];
+            const PathKey_t key = _pathKey(fromCoord, toCoord);
+
+            auto pathIt = pathIndices.constFind(key);
+            if (pathIt == pathIndices.cend()) {
+                SentPathInfo_t sentPathInfo;
+                sentPathInfo.key = key;
+
+                const TerrainPathQuery::PathHeightInfo_t* const cachedPathHeightInfo = _pathCache.object(key);
+                sentPathInfo.cached = (cachedPathHeightInfo != nullptr);
+                if (sentPathInfo.cached) {
+                    sentPathInfo.pathHeightInfo = *cachedPathHeightInfo;
+                } else {
+                    const QList<QGeoCoordinate> pathCoords = TerrainTileManager::pathQueryToCoords(fromCoord, toCoord, sentPathInfo.pathHeightInfo.distanceBetween, sentPathInfo.pathHeightInfo.finalDistanceBetween);
+                    sentPathInfo.sampleIndices.reserve(pathCoords.count());
+                    for (const QGeoCoordinate &pathCoord : pathCoords) {
+                        const QPair<double, double> point(pathCoord.latitude(), pathCoord.longitude());
+                        auto sampleIt = sampleIndices.constFind(point);
+                        if (sampleIt == sampleIndices.cend()) {
+                            sampleIt = sampleIndices.insert(point, samples.count());
+                            samples.append(pathCoord);
+                        }
+                        sentPathInfo.sampleIndices.append(*sampleIt);
+                    }
+                }
+
+                pathIt = pathIndices.insert(key, _sentPaths.count());
+                _sentPaths.append(sentPathInfo);
+            }
+            sentRequestInfo.pathIndices.append(*pathIt);
         }
+
+        _sentRequests.append(sentRequestInfo);
+    }
+    _sentSampleCount = samples.count();
+
+    qCDebug(TerrainQueryLog) << Q_FUNC_INFO << "requests:paths:samples" << _sentRequests.count() << _sentPaths.count() << _sentSampleCount;
+
+    if (samples.isEmpty()) {
+        // Everything was cached in the meantime
+        _coordinateHeights(true, QList<double>());
+        return;
+    }
+
+    _state = TerrainQuery::State::Downloading;
+    _selectTerrainQuery(_terrainQuery, _localDemQuery)->requestCoordinateHeights(samples);
+}
+
+void TerrainPathBatchManager::_batchFailed()
+{
+    const QList<TerrainPathQuery::PathHeightInfo_t> noPathHeightInfo;
+
+    for (qsizetype i = 0; i < _sentRequests.count(); i++) {
+        const SentRequestInfo_t sentRequestInfo = _sentRequests[i];
+        if (!sentRequestInfo.queryObjectDestroyed) {
+            (void) disconnect(sentRequestInfo.terrainQuery, &QObject::destroyed, this, &TerrainPathBatchManager::_queryObjectDestroyed);
+            _signalQuery(sentRequestInfo.terrainQuery, sentRequestInfo.polyPath, false, noPathHeightInfo);
+        }
+    }
+
+    _sentRequests.clear();
+    _sentPaths.clear();
+}
+
+void TerrainPathBatchManager::_queryObjectDestroyed(QObject *terrainQuery)
+{
+    qCDebug(TerrainQueryLog) << Q_FUNC_INFO << "terrainQuery" << terrainQuery;
+
+    qsizetype i = 0;
+    while (i < _requestQueue.count()) {
+        if (_requestQueue[i].terrainQuery == terrainQuery) {
+            (void) _requestQueue.removeAt(i);
+        } else {
+            i++;
+        }
+    }
+
+    for (SentRequestInfo_t &sentRequestInfo : _sentRequests) {
+        if (sentRequestInfo.terrainQuery == terrainQuery) {
+            sentRequestInfo.queryObjectDestroyed = true;
+        }
+    }
+}
+
+void TerrainPathBatchManager::_coordinateHeights(bool success, const QList<double> &heights)
+{
+    _state = TerrainQuery::State::Idle;
+
+    qCDebug(TerrainQueryLog) << Q_FUNC_INFO << "signalled success:count" << success << heights.count();
+
+    if (!success || (heights.count() != _sentSampleCount)) {
+        _batchFailed();
+    } else {
+        for (SentPathInfo_t &sentPathInfo : _sentPaths) {
+            if (sentPathInfo.cached) {
+                continue;
+            }
+
+            QList<double> &pathHeights = sentPathInfo.pathHeightInfo.heights;
+            pathHeights.reserve(sentPathInfo.sampleIndices.count());
+            for (const qsizetype sampleIndex : sentPathInfo.sampleIndices) {
+                pathHeights.append(heights[sampleIndex]);
+            }
+            (void) _pathCache.insert(sentPathInfo.key, new TerrainPathQuery::PathHeightInfo_t(sentPathInfo.pathHeightInfo), pathHeights.count());
+        }
+
+        // Receivers may queue new requests or delete other queries while being signalled
+        for (qsizetype i = 0; i < _sentRequests.count(); i++) {
+            const SentRequestInfo_t sentRequestInfo = _sentRequests[i];
+            if (sentRequestInfo.queryObjectDestroyed) {
+                continue;
+            }
+
+            QList<TerrainPathQuery::PathHeightInfo_t> rgPathHeightInfo;
+            rgPathHeightInfo.reserve(sentRequestInfo.pathIndices.count());
+            for (const qsizetype pathIndex : sentRequestInfo.pathIndices) {
+                rgPathHeightInfo.append(_sentPaths[pathIndex].pathHeightInfo);
+            }
+
+            (void) disconnect(sentRequestInfo.terrainQuery, &QObject::destroyed, this, &TerrainPathBatchManager::_queryObjectDestroyed);
+            _signalQuery(sentRequestInfo.terrainQuery, sentRequestInfo.polyPath, true, rgPathHeightInfo);
+        }
+        _sentRequests.clear();
+        _sentPaths.clear();
+    }
+
+    if (!_requestQueue.isEmpty()) {
+        _batchTimer->start();
+    }
+}
+
+TerrainPathBatchManager::PathKey_t TerrainPathBatchManager::_pathKey(const QGeoCoordinate &fromCoord, const QGeoCoordinate &toCoord)
+{
+    return { fromCoord.latitude(), fromCoord.longitude(), toCoord.latitude(), toCoord.longitude() };
+}
+
+void TerrainPathBatchManager::_signalQuery(QObject *terrainQuery, bool polyPath, bool success, const QList<TerrainPathQuery::PathHeightInfo_t> &rgPathHeightInfo)
+{
+    if (polyPath) {
+        static_cast<TerrainPolyPathQuery*>(terrainQuery)->signalTerrainData(success, rgPathHeightInfo);
     } else {
-        _pathQuery->requestData(_rgCoords[_curIndex], _rgCoords[_curIndex + 1]);
+        static_cast<TerrainPathQuery*>(terrainQuery)->signalTerrainData(success, rgPathHeightInfo.isEmpty() ? TerrainPathQuery::PathHeightInfo_t() : rgPathHeightInfo.first());
     }
 }
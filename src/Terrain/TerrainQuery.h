@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include <QtCore/QCache>
+#include <QtCore/QHash>
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QObject>
 #include <QtCore/QQueue>
@@ -72,6 +74,7 @@ private:
     TerrainQuery::State _state = TerrainQuery::State::Idle;
     QTimer *_batchTimer = nullptr;
     TerrainQueryInterface *_terrainQuery = nullptr;
+    TerrainQueryInterface *_localDemQuery = nullptr;
     static constexpr int _batchTimeout = 500;
 };
 
@@ -97,6 +100,9 @@ public:
     /// @return true: altitude returned (check error as well), false: database query queued (altitudes not returned)
     static bool getAltitudesForCoordinates(const QList<QGeoCoordinate> &coordinates, QList<double> &altitudes, bool &error);
 
+    /// Queues downloads for the uncached terrain tiles of the area, nothing is signalled
+    static void prefetchArea(const QGeoCoordinate &swCoord, const QGeoCoordinate &neCoord);
+
     void signalTerrainData(bool success, const QList<double> &heights);
 
 signals:
@@ -123,21 +129,19 @@ public:
     void requestData(const QGeoCoordinate &fromCoord, const QGeoCoordinate &toCoord);
 
     struct PathHeightInfo_t {
-        double distanceBetween;        ///< Distance between each height value
-        double finalDistanceBetween;   ///< Distance between final two height values
-        QList<double> heights;                ///< Terrain heights along path
+        double distanceBetween = 0;         ///< Distance between each height value
+        double finalDistanceBetween = 0;    ///< Distance between final two height values
+        QList<double> heights;              ///< Terrain heights along path
     };
 
+    void signalTerrainData(bool success, const PathHeightInfo_t &pathHeightInfo);
+
 signals:
     /// Signalled when terrain data comes back from server
     void terrainDataReceived(bool success, const TerrainPathQuery::PathHeightInfo_t &pathHeightInfo);
 
-private slots:
-    void _pathHeights(bool success, double distanceBetween, double finalDistanceBetween, const QList<double> &heights);
-
 private:
     bool _autoDelete = false;
-    TerrainQueryInterface *_terrainQuery = nullptr;
 };
 Q_DECLARE_METATYPE(TerrainPathQuery::PathHeightInfo_t)
 
@@ -158,17 +162,96 @@ public:
     void requestData(const QVariantList &polyPath);
     void requestData(const QList<QGeoCoordinate> &polyPath);
 
+    void signalTerrainData(bool success, const QList<TerrainPathQuery::PathHeightInfo_t> &rgPathHeightInfo);
+
 signals:
     /// Signalled when terrain data comes back from server
     void terrainDataReceived(bool success, const QList<TerrainPathQuery::PathHeightInfo_t> &rgPathHeightInfo);
 
+private:
+    bool _autoDelete = false;
+};
+
+/*===========================================================================*/
+
+/// Path and poly path queries issued within a short window are answered by a single coordinate lookup.
+/// Sample points shared between paths are looked up once and completed path profiles are cached, so an
+/// edit to one item of a large mission does not query the paths which did not change again.
+class TerrainPathBatchManager : public QObject
+{
+    Q_OBJECT
+
+    friend class TerrainQueryTest;
+public:
+    explicit TerrainPathBatchManager(QObject *parent = nullptr);
+    ~TerrainPathBatchManager();
+
+    static TerrainPathBatchManager *instance();
+
+    void addQuery(TerrainPathQuery *terrainPathQuery, const QGeoCoordinate &fromCoord, const QGeoCoordinate &toCoord);
+    void addQuery(TerrainPolyPathQuery *terrainPolyPathQuery, const QList<QGeoCoordinate> &polyPath);
+
+    /// Cached profiles are dropped when the elevation provider changes
+    void clearCache();
+
 private slots:
-    void _terrainDataReceived(bool success, const TerrainPathQuery::PathHeightInfo_t &pathHeightInfo);
+    void _sendNextBatch();
+    void _queryObjectDestroyed(QObject *terrainQuery);
+    void _coordinateHeights(bool success, const QList<double> &heights);
 
 private:
-    bool _autoDelete = false;
-    int _curIndex = 0;
-    QList<QGeoCoordinate> _rgCoords;
-    QList<TerrainPathQuery::PathHeightInfo_t> _rgPathHeightInfo;
-    TerrainPathQuery *_pathQuery = nullptr;
+    struct PathKey_t {
+        double fromLat;
+        double fromLon;
+        double toLat;
+        double toLon;
+
+        bool operator==(const PathKey_t &other) const
+        {
+            return (fromLat == other.fromLat) && (fromLon == other.fromLon) && (toLat == other.toLat) && (toLon == other.toLon);
+        }
+        friend size_t qHash(const PathKey_t &key, size_t seed = 0)
+        {
+            return qHashMulti(seed, key.fromLat, key.fromLon, key.toLat, key.toLon);
+        }
+    };
+
+    struct QueuedRequestInfo_t {
+        QObject *terrainQuery;
+        bool polyPath;                      ///< true: TerrainPolyPathQuery, false: TerrainPathQuery
+        QList<QGeoCoordinate> coordinates;  ///< Path vertices
+    };
+
+    struct SentRequestInfo_t {
+        QObject *terrainQuery;
+        bool polyPath;
+        bool queryObjectDestroyed;
+        QList<qsizetype> pathIndices;       ///< Index into _sentPaths for each segment
+    };
+
+    struct SentPathInfo_t {
+        PathKey_t key;
+        bool cached;
+        TerrainPathQuery::PathHeightInfo_t pathHeightInfo;
+        QList<qsizetype> sampleIndices;     ///< Index into the coordinates sent for each height
+    };
+
+    void _addQuery(QObject *terrainQuery, bool polyPath, const QList<QGeoCoordinate> &coordinates);
+    void _setTerrainQuery(TerrainQueryInterface *terrainQuery);
+    void _batchFailed();
+    static PathKey_t _pathKey(const QGeoCoordinate &fromCoord, const QGeoCoordinate &toCoord);
+    static void _signalQuery(QObject *terrainQuery, bool polyPath, bool success, const QList<TerrainPathQuery::PathHeightInfo_t> &rgPathHeightInfo);
+
+    QQueue<QueuedRequestInfo_t> _requestQueue;
+    QList<SentRequestInfo_t> _sentRequests;
+    QList<SentPathInfo_t> _sentPaths;
+    qsizetype _sentSampleCount = 0;
+    TerrainQuery::State _state = TerrainQuery::State::Idle;
+    QTimer *_batchTimer = nullptr;
+    TerrainQueryInterface *_terrainQuery = nullptr;
+    TerrainQueryInterface *_localDemQuery = nullptr;
+    QCache<PathKey_t, TerrainPathQuery::PathHeightInfo_t> _pathCache;   ///< Cost is the number of heights
+
+    static constexpr int kBatchTimeoutMsecs = 50;
+    static constexpr int kMaxCachedHeights = 1000000;
 };
@@ -111,6 +111,12 @@ void TerrainOfflineQuery::requestPathHeights(const QGeoCoordinate &fromCoord, co
     TerrainTileManager::instance()->addPathQuery(this, fromCoord, toCoord);
 }
 
+void TerrainOfflineQuery::requestCarpetHeights(const QGeoCoordinate &swCoord, const QGeoCoordinate &neCoord, bool statsOnly)
+{
+    _queryMode = TerrainQuery::QueryModeCarpet;
+    TerrainTileManager::instance()->addCarpetQuery(this, swCoord, neCoord, statsOnly);
+}
+
 /*===========================================================================*/
 
 TerrainOnlineQuery::TerrainOnlineQuery(QObject *parent)
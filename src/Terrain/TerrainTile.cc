@@ -13,21 +13,31 @@
 #include <QtCore/QtNumeric>
 #include <QtPositioning/QGeoCoordinate>
 
+#include <algorithm>
+#include <cstring>
+
 QGC_LOGGING_CATEGORY(TerrainTileLog, "qgc.terrain.terraintile");
 
 TerrainTile::TerrainTile(const QByteArray &byteArray)
-    : _tileInfo(*reinterpret_cast<const TileInfo_t*>(byteArray.constData()))
+    : _data(byteArray)
 {
     // qCDebug(TerrainTileLog) << Q_FUNC_INFO << this;
 
     constexpr int cTileHeaderBytes = static_cast<int>(sizeof(TileInfo_t));
-    const int cTileBytesAvailable = byteArray.size();
+    const qsizetype cTileBytesAvailable = _data.size();
 
     if (cTileBytesAvailable < cTileHeaderBytes) {
         qCWarning(TerrainTileLog) << "Terrain tile binary data too small for TileInfo_s header";
         return;
     }
 
+    (void) memcpy(&_tileInfo, _data.constData(), cTileHeaderBytes);
+
+    if ((_tileInfo.gridSizeLat <= 0) || (_tileInfo.gridSizeLon <= 0)) {
+        qCWarning(TerrainTileLog) << this << "Tile grid is empty";
+        return;
+    }
+
     const int cTileDataBytes = static_cast<int>(sizeof(int16_t)) * _tileInfo.gridSizeLat * _tileInfo.gridSizeLon;
     if (cTileBytesAvailable < cTileHeaderBytes + cTileDataBytes) {
         qCWarning(TerrainTileLog) << "Terrain tile binary data too small for tile data";
@@ -45,22 +55,11 @@ TerrainTile::TerrainTile(const QByteArray &byteArray)
 
     qCDebug(TerrainTileLog) << this << "TileInfo: south west:" << _tileInfo.swLat << _tileInfo.swLon;
     qCDebug(TerrainTileLog) << this << "TileInfo: north east:" << _tileInfo.neLat << _tileInfo.neLon;
-    qCDebug(TerrainTileLog) << this << "TileInfo: dimensions:" << _tileInfo.gridSizeLat << "by" << _tileInfo.gridSizeLat;
+    qCDebug(TerrainTileLog) << this << "TileInfo: dimensions:" << _tileInfo.gridSizeLat << "by" << _tileInfo.gridSizeLon;
     qCDebug(TerrainTileLog) << this << "TileInfo: min, max, avg:" << _tileInfo.minElevation << _tileInfo.maxElevation << _tileInfo.avgElevation;
     qCDebug(TerrainTileLog) << this << "TileInfo: cell size:" << _cellSizeLat << _cellSizeLon;
 
-    _elevationData.resize(_tileInfo.gridSizeLat);
-    for (int k = 0; k < _tileInfo.gridSizeLat; k++) {
-        _elevationData[k].resize(_tileInfo.gridSizeLon);
-    }
-
-    int valueIndex = 0;
-    const int16_t* const pTileData = reinterpret_cast<const int16_t*>(&reinterpret_cast<const uint8_t*>(byteArray.constData())[cTileHeaderBytes]);
-    for (int i = 0; i < _tileInfo.gridSizeLat; i++) {
-        for (int j = 0; j < _tileInfo.gridSizeLon; j++) {
-            _elevationData[i][j] = pTileData[valueIndex++];
-        }
-    }
+    _elevationData = reinterpret_cast<const int16_t*>(_data.constData() + cTileHeaderBytes);
 
     _isValid = true;
 }
@@ -77,35 +76,109 @@ double TerrainTile::elevation(const QGeoCoordinate &coordinate) const
         return qQNaN();
     }
 
-    const double latDeltaSw = coordinate.latitude() - _tileInfo.swLat;
-    const double lonDeltaSw = coordinate.longitude() - _tileInfo.swLon;
+    const double latitude = coordinate.latitude();
+    const double longitude = coordinate.longitude();
+    double elevation;
+    _nearestElevations(&latitude, &longitude, &elevation, 1);
 
-    const int16_t latIndex = qFloor(latDeltaSw / _cellSizeLat);
-    const int16_t lonIndex = qFloor(lonDeltaSw / _cellSizeLon);
+    if (qIsNaN(elevation)) {
+        qCWarning(TerrainTileLog) << this << "Internal error: coordinate" << coordinate << "outside tile bounds";
+    }
 
-    const bool latIndexInvalid = (latIndex < 0) || (latIndex > (_tileInfo.gridSizeLat - 1));
-    const bool lonIndexInvalid = (lonIndex < 0) || (lonIndex > (_tileInfo.gridSizeLon - 1));
+    return elevation;
+}
 
-    if (latIndexInvalid || lonIndexInvalid) {
-        qCWarning(TerrainTileLog) << this << "Internal error: coordinate" << coordinate << "outside tile bounds";
-        return qQNaN();
+bool TerrainTile::elevations(const double *latitudes, const double *longitudes, double *elevations, qsizetype count, Interpolation interpolation) const
+{
+    if (!_isValid) {
+        qCWarning(TerrainTileLog) << this << "Request for elevations, but tile is invalid.";
+        std::fill_n(elevations, count, qQNaN());
+        return false;
     }
 
-    if ((latIndex >= _elevationData.size()) || (lonIndex >= _elevationData[latIndex].size())) {
-        qCWarning(TerrainTileLog).noquote() << this << "Internal error: _elevationData size inconsistent _tileInfo << coordinate" << coordinate
-            << "\n\t_tillIndo.gridSizeLat:" << _tileInfo.gridSizeLat << "_tileInfo.gridSizeLon:" << _tileInfo.gridSizeLon
-            << "\n\t_data.size():" << _elevationData.size() << "_elevationData[latIndex].size():" << _elevationData[latIndex].size();
-        return qQNaN();
+    if (interpolation == Interpolation::Bilinear) {
+        _bilinearElevations(latitudes, longitudes, elevations, count);
+    } else {
+        _nearestElevations(latitudes, longitudes, elevations, count);
     }
 
-    const int16_t elevation = _elevationData[latIndex][lonIndex];
-    if (elevation < _tileInfo.minElevation) {
-        qCWarning(TerrainTileLog) << this << "Warning: elevation read is below min elevation in tile:" << elevation << "<" << _tileInfo.minElevation;
-    } else if (elevation > _tileInfo.maxElevation) {
-        qCWarning(TerrainTileLog) << this << "Warning: elevation read is above max elevation in tile:" << elevation << ">" << _tileInfo.maxElevation;
+    return std::none_of(elevations, elevations + count, [](double elevation) { return qIsNaN(elevation); });
+}
+
+void TerrainTile::_nearestElevations(const double *latitudes, const double *longitudes, double *elevations, qsizetype count) const
+{
+    const double gridSizeLat = _tileInfo.gridSizeLat;
+    const double gridSizeLon = _tileInfo.gridSizeLon;
+    const int rowStride = _tileInfo.gridSizeLon;
+
+    int indices[kBatchBlockSize];
+    for (qsizetype blockStart = 0; blockStart < count; blockStart += kBatchBlockSize) {
+        const qsizetype blockCount = qMin(kBatchBlockSize, count - blockStart);
+        const double* const blockLats = latitudes + blockStart;
+        const double* const blockLons = longitudes + blockStart;
+
+        // Branch free so the compiler can vectorize the cell index computation, -1 marks coordinates outside the tile
+        for (qsizetype k = 0; k < blockCount; k++) {
+            const double latCell = (blockLats[k] - _tileInfo.swLat) / _cellSizeLat;
+            const double lonCell = (blockLons[k] - _tileInfo.swLon) / _cellSizeLon;
+            const bool inside = (latCell >= 0.0) & (latCell < gridSizeLat) & (lonCell >= 0.0) & (lonCell < gridSizeLon);
+            indices[k] = inside ? ((static_cast<int>(latCell) * rowStride) + static_cast<int>(lonCell)) : -1;
+        }
+
+        double* const blockElevations = elevations + blockStart;
+        for (qsizetype k = 0; k < blockCount; k++) {
+            blockElevations[k] = (indices[k] < 0) ? qQNaN() : static_cast<double>(_elevationData[indices[k]]);
+        }
     }
+}
 
-    qCDebug(TerrainTileLog) << this << "latIndex, lonIndex:" << latIndex << lonIndex << "elevation:" << elevation;
+void TerrainTile::_bilinearElevations(const double *latitudes, const double *longitudes, double *elevations, qsizetype count) const
+{
+    const double gridSizeLat = _tileInfo.gridSizeLat;
+    const double gridSizeLon = _tileInfo.gridSizeLon;
+    const double maxLatIndex = _tileInfo.gridSizeLat - 1;
+    const double maxLonIndex = _tileInfo.gridSizeLon - 1;
+    const int rowStride = _tileInfo.gridSizeLon;
+
+    int lowRows[kBatchBlockSize];
+    int highRows[kBatchBlockSize];
+    int lowCols[kBatchBlockSize];
+    int highCols[kBatchBlockSize];
+    double latWeights[kBatchBlockSize];
+    double lonWeights[kBatchBlockSize];
+    bool insides[kBatchBlockSize];
+    for (qsizetype blockStart = 0; blockStart < count; blockStart += kBatchBlockSize) {
+        const qsizetype blockCount = qMin(kBatchBlockSize, count - blockStart);
+        const double* const blockLats = latitudes + blockStart;
+        const double* const blockLons = longitudes + blockStart;
+
+        // Grid values lie at cell centers, coordinates in the outer half of an edge cell take the edge value
+        for (qsizetype k = 0; k < blockCount; k++) {
+            const double latCell = (blockLats[k] - _tileInfo.swLat) / _cellSizeLat;
+            const double lonCell = (blockLons[k] - _tileInfo.swLon) / _cellSizeLon;
+            const bool inside = (latCell >= 0.0) & (latCell < gridSizeLat) & (lonCell >= 0.0) & (lonCell < gridSizeLon);
+            const double latCenter = inside ? qBound(0.0, latCell - 0.5, maxLatIndex) : 0.0;
+            const double lonCenter = inside ? qBound(0.0, lonCell - 0.5, maxLonIndex) : 0.0;
+            const int lowRow = static_cast<int>(latCenter);
+            const int lowCol = static_cast<int>(lonCenter);
+            lowRows[k] = lowRow * rowStride;
+            highRows[k] = qMin(lowRow + 1, _tileInfo.gridSizeLat - 1) * rowStride;
+            lowCols[k] = lowCol;
+            highCols[k] = qMin(lowCol + 1, _tileInfo.gridSizeLon - 1);
+            latWeights[k] = latCenter - lowRow;
+            lonWeights[k] = lonCenter - lowCol;
+            insides[k] = inside;
+        }
 
-    return static_cast<double>(elevation);
+        double* const blockElevations = elevations + blockStart;
+        for (qsizetype k = 0; k < blockCount; k++) {
+            const double southWest = _elevationData[lowRows[k] + lowCols[k]];
+            const double southEast = _elevationData[lowRows[k] + highCols[k]];
+            const double northWest = _elevationData[highRows[k] + lowCols[k]];
+            const double northEast = _elevationData[highRows[k] + highCols[k]];
+            const double south = southWest + ((southEast - southWest) * lonWeights[k]);
+            const double north = northWest + ((northEast - northWest) * lonWeights[k]);
+            blockElevations[k] = insides[k] ? (south + ((north - south) * latWeights[k])) : qQNaN();
+        }
+    }
 }
@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include <QtCore/QByteArray>
 #include <QtCore/QList>
 #include <QtCore/QLoggingCategory>
 
@@ -22,8 +23,14 @@ class TerrainTile
     friend class TerrainTileTest;
 
 public:
-    /// Constructor from serialized elevation data (either from file or web)
-    ///    @param document
+    enum class Interpolation {
+        Nearest,    ///< Value of the grid cell containing the coordinate
+        Bilinear    ///< Blend of the four nearest grid cell centers
+    };
+
+    /// Constructor from serialized elevation data (either from file or web). The elevation grid is not
+    /// copied, the tile keeps a shared reference to byteArray.
+    ///    @param byteArray
     explicit TerrainTile(const QByteArray &byteArray);
     virtual ~TerrainTile();
 
@@ -31,11 +38,23 @@ public:
     ///    @return true if data is valid
     bool isValid() const { return _isValid; }
 
+    /// Approximate heap memory held by the tile
+    qsizetype memoryUsage() const { return static_cast<qsizetype>(sizeof(TerrainTile)) + _data.capacity(); }
+
     /// Evaluates the elevation at the given coordinate
     ///    @param coordinate
     ///    @return elevation
     double elevation(const QGeoCoordinate &coordinate) const;
 
+    /// Evaluates the elevations at count coordinates given as separate latitude and longitude arrays
+    ///    @param latitudes
+    ///    @param longitudes
+    ///    @param[out] elevations NaN for coordinates outside the tile
+    ///    @param count
+    ///    @param interpolation
+    ///    @return false if the tile is invalid or any coordinate is outside the tile
+    bool elevations(const double *latitudes, const double *longitudes, double *elevations, qsizetype count, Interpolation interpolation = Interpolation::Nearest) const;
+
     /// Accessor for the minimum elevation of the tile
     ///    @return minimum elevation
     double minElevation() const { return (_isValid ? static_cast<double>(_tileInfo.minElevation) : qQNaN()); }
@@ -57,9 +76,15 @@ protected:
     } Q_PACKED;
 
 private:
+    void _nearestElevations(const double *latitudes, const double *longitudes, double *elevations, qsizetype count) const;
+    void _bilinearElevations(const double *latitudes, const double *longitudes, double *elevations, qsizetype count) const;
+
     TileInfo_t _tileInfo{};
-    QList<QList<int16_t>> _elevationData;   ///< 2D elevation data array
-    double _cellSizeLat = 0.0;              ///< data grid size in latitude direction
-    double _cellSizeLon = 0.0;              ///< data grid size in longitude direction
-    bool _isValid = false;                  ///< data loaded is valid
+    QByteArray _data;                               ///< Serialized tile, shared with the caller
+    const int16_t *_elevationData = nullptr;        ///< Row major elevation grid inside _data, south row first
+    double _cellSizeLat = 0.0;                      ///< data grid size in latitude direction
+    double _cellSizeLon = 0.0;                      ///< data grid size in longitude direction
+    bool _isValid = false;                          ///< data loaded is valid
+
+    static constexpr qsizetype kBatchBlockSize = 256;   ///< Lookups whose cell indices are computed together
 };
@@ -0,0 +1,131 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TerrainTileCache.h"
+#include "TerrainTile.h"
+#include "QGCLoggingCategory.h"
+
+#include <QtCore/QList>
+
+#include <algorithm>
+
+QGC_LOGGING_CATEGORY(TerrainTileCacheLog, "qgc.terrain.terraintilecache")
+
+TerrainTileCache::TerrainTileCache(qint64 maxBytes)
+    : _maxBytes(maxBytes)
+{
+    // qCDebug(TerrainTileCacheLog) << Q_FUNC_INFO << this;
+}
+
+TerrainTileCache::~TerrainTileCache()
+{
+    // qCDebug(TerrainTileCacheLog) << Q_FUNC_INFO << this;
+}
+
+std::shared_ptr<const TerrainTile> TerrainTileCache::tile(quint64 tileKey) const
+{
+    QReadLocker locker(&_lock);
+
+    const auto it = _entries.constFind(tileKey);
+    if (it == _entries.cend()) {
+        return nullptr;
+    }
+
+    it->lastUsed.storeRelaxed(_nextUse());
+    return it->tile;
+}
+
+bool TerrainTileCache::contains(quint64 tileKey) const
+{
+    QReadLocker locker(&_lock);
+
+    return _entries.contains(tileKey);
+}
+
+void TerrainTileCache::insert(quint64 tileKey, const std::shared_ptr<const TerrainTile> &tile)
+{
+    if (!tile) {
+        return;
+    }
+
+    QWriteLocker locker(&_lock);
+
+    if (_entries.contains(tileKey)) {
+        return;
+    }
+
+    Entry_t entry;
+    entry.tile = tile;
+    entry.cost = tile->memoryUsage();
+    entry.lastUsed.storeRelaxed(_nextUse());
+    (void) _entries.insert(tileKey, entry);
+    _bytes += entry.cost;
+
+    if (_bytes > _maxBytes) {
+        _evict((_maxBytes * kEvictionTargetPercent) / 100);
+    }
+}
+
+void TerrainTileCache::clear()
+{
+    QWriteLocker locker(&_lock);
+
+    _entries.clear();
+    _bytes = 0;
+}
+
+void TerrainTileCache::setMaxBytes(qint64 maxBytes)
+{
+    QWriteLocker locker(&_lock);
+
+    _maxBytes = maxBytes;
+    if (_bytes > _maxBytes) {
+        _evict(_maxBytes);
+    }
+}
+
+qint64 TerrainTileCache::maxBytes() const
+{
+    QReadLocker locker(&_lock);
+
+    return _maxBytes;
+}
+
+qint64 TerrainTileCache::bytes() const
+{
+    QReadLocker locker(&_lock);
+
+    return _bytes;
+}
+
+qsizetype TerrainTileCache::count() const
+{
+    QReadLocker locker(&_lock);
+
+    return _entries.count();
+}
+
+void TerrainTileCache::_evict(qint64 targetBytes)
+{
+    QList<std::pair<quint64, quint64>> usage;
+    usage.reserve(_entries.count());
+    for (auto it = _entries.cbegin(); it != _entries.cend(); ++it) {
+        usage.append({ it->lastUsed.loadRelaxed(), it.key() });
+    }
+    std::sort(usage.begin(), usage.end());
+
+    const qsizetype countBefore = _entries.count();
+    for (qsizetype i = 0; (i < usage.count() - 1) && (_bytes > targetBytes); i++) {
+        const auto it = _entries.constFind(usage[i].second);
+        _bytes -= it->cost;
+        (void) _entries.erase(it);
+    }
+
+    qCDebug(TerrainTileCacheLog) << "Evicted" << (countBefore - _entries.count()) << "tiles, cache size" << _bytes << "bytes";
+}
@@ -0,0 +1,66 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QAtomicInteger>
+#include <QtCore/QHash>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QReadWriteLock>
+
+#include <memory>
+
+class TerrainTile;
+
+Q_DECLARE_LOGGING_CATEGORY(TerrainTileCacheLog)
+
+/// Memory budgeted cache of decoded terrain tiles keyed by packed tile key. Lookups only take a shared
+/// lock, so concurrent readers do not block each other. When an insert exceeds the budget the least
+/// recently used tiles are evicted. Tiles are handed out as shared pointers and stay usable by the
+/// caller after they have been evicted.
+class TerrainTileCache
+{
+public:
+    explicit TerrainTileCache(qint64 maxBytes);
+    ~TerrainTileCache();
+
+    /// @return nullptr if the tile is not cached
+    std::shared_ptr<const TerrainTile> tile(quint64 tileKey) const;
+    bool contains(quint64 tileKey) const;
+
+    /// Adds a tile, a tile which is already cached for tileKey is kept
+    void insert(quint64 tileKey, const std::shared_ptr<const TerrainTile> &tile);
+    void clear();
+
+    /// Evicts immediately if the new budget is exceeded
+    void setMaxBytes(qint64 maxBytes);
+    qint64 maxBytes() const;
+    qint64 bytes() const;
+    qsizetype count() const;
+
+private:
+    struct Entry_t {
+        std::shared_ptr<const TerrainTile> tile;
+        qint64 cost = 0;
+        mutable QAtomicInteger<quint64> lastUsed;    ///< Updated by readers holding only the shared lock
+    };
+
+    /// Evicts least recently used tiles until no more than targetBytes remain, the most recently used
+    /// tile is always kept. The write lock must be held.
+    void _evict(qint64 targetBytes);
+    quint64 _nextUse() const { return _useCounter.fetchAndAddRelaxed(1); }
+
+    mutable QReadWriteLock _lock;
+    QHash<quint64, Entry_t> _entries;
+    qint64 _bytes = 0;
+    qint64 _maxBytes = 0;
+    mutable QAtomicInteger<quint64> _useCounter;
+
+    static constexpr int kEvictionTargetPercent = 90;   ///< Evict below the budget so that inserts at the limit do not each rescan the cache
+};
@@ -10,19 +10,26 @@
 #include "TerrainTileManager.h"
 #include "TerrainTile.h"
 #include "TerrainTileCopernicus.h"
+#include "TerrainQueryLocalDem.h"
 #include "QGeoTileFetcherQGC.h"
 #include "QGeoMapReplyQGC.h"
 #include "QGCMapUrlEngine.h"
 #include "ElevationMapProvider.h"
 #include "SettingsManager.h"
 #include "FlightMapSettings.h"
+#include "MapsSettings.h"
 #include "QGCLoggingCategory.h"
 
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtCore/QElapsedTimer>
 #include <QtLocation/private/qgeotilespec_p.h>
 #include <QtNetwork/QNetworkAccessManager>
 #include <QtNetwork/QNetworkProxy>
 #include <QtNetwork/QNetworkRequest>
 
+#include <algorithm>
+#include <numeric>
+
 QGC_LOGGING_CATEGORY(TerrainTileManagerLog, "qgc.terrain.terraintilemanager")
 
 Q_GLOBAL_STATIC(TerrainTileManager, _terrainTileManager)
@@ -32,12 +39,29 @@ TerrainTileManager *TerrainTileManager::instance()
     return _terrainTileManager();
 }
 
+static SharedMapProvider _elevationProvider()
+{
+    const QString elevationProviderName = SettingsManager::instance()->flightMapSettings()->elevationMapProvider()->rawValue().toString();
+    return UrlFactory::getMapProviderFromProviderType(elevationProviderName);
+}
+
+bool TerrainTileManager::localDemSelected()
+{
+    const SharedMapProvider provider = _elevationProvider();
+    return (provider && provider->isLocalProvider());
+}
+
 TerrainTileManager::TerrainTileManager(QObject *parent)
     : QObject(parent)
+    , _tileCache(_maxTileCacheBytes())
     , _networkManager(new QNetworkAccessManager(this))
 {
     // qCDebug(TerrainTileManagerLog) << Q_FUNC_INFO << this;
 
+    (void) connect(SettingsManager::instance()->mapsSettings()->maxTerrainCacheMemorySize(), &Fact::rawValueChanged, this, [this]() {
+        _tileCache.setMaxBytes(_maxTileCacheBytes());
+    });
+
 #if defined(Q_OS_ANDROID) || defined(Q_OS_IOS)
     QNetworkProxy proxy = _networkManager->proxy();
     proxy.setType(QNetworkProxy::DefaultProxy);
@@ -47,8 +71,6 @@ TerrainTileManager::TerrainTileManager(QObject *parent)
 
 TerrainTileManager::~TerrainTileManager()
 {
-    qDeleteAll(_tiles);
-
     // qCDebug(TerrainTileManagerLog) << Q_FUNC_INFO << this;
 }
 
@@ -56,47 +78,124 @@ bool TerrainTileManager::getAltitudesForCoordinates(const QList<QGeoCoordinate>
 {
     error = false;
 
-    const QString elevationProviderName = SettingsManager::instance()->flightMapSettings()->elevationMapProvider()->rawValue().toString();
-    const SharedMapProvider provider = UrlFactory::getMapProviderFromProviderType(elevationProviderName);
+    if (localDemSelected()) {
+        error = !TerrainQueryLocalDem::source()->elevations(coordinates, altitudes);
+        return true;
+    }
+
+    if (!_requestMissingTiles(coordinates).isEmpty()) {
+        return false;
+    }
+
+    return _getCachedAltitudes(coordinates, altitudes, error);
+}
+
+QSet<quint64> TerrainTileManager::_requestMissingTiles(const QList<QGeoCoordinate> &coordinates, PinnedTiles *cachedTiles)
+{
+    const SharedMapProvider provider = _elevationProvider();
+
+    QSet<quint64> checkedTiles;
+    QSet<quint64> missingTiles;
     for (const QGeoCoordinate &coordinate: coordinates) {
-        const QString tileHash = UrlFactory::getTileHash(
-            provider->getMapName(),
-            provider->long2tileX(coordinate.longitude(), 1),
-            provider->lat2tileY(coordinate.latitude(), 1),
-            1
-        );
-        qCDebug(TerrainTileManagerLog) << Q_FUNC_INFO << "hash:coordinate" << tileHash << coordinate;
-
-        TerrainTile* const tile = _getCachedTile(tileHash);
+        const int x = provider->long2tileX(coordinate.longitude(), 1);
+        const int y = provider->lat2tileY(coordinate.latitude(), 1);
+        const quint64 tileKey = UrlFactory::packTileKey(provider->getProviderId(), x, y, 1);
+        if (checkedTiles.contains(tileKey)) {
+            continue;
+        }
+        (void) checkedTiles.insert(tileKey);
+
+        const std::shared_ptr<const TerrainTile> tile = _getCachedTile(tileKey);
         if (tile) {
-            const double elevation = tile->elevation(coordinate);
-            if (qIsNaN(elevation)) {
-                error = true;
-                qCWarning(TerrainTileManagerLog) << Q_FUNC_INFO << "Internal Error: missing elevation in tile cache";
-            } else {
-                qCDebug(TerrainTileManagerLog) << Q_FUNC_INFO << "returning elevation from tile cache" << elevation;
+            if (cachedTiles) {
+                (void) cachedTiles->insert(tileKey, tile);
             }
-            altitudes.push_back(elevation);
-        } else if (_state != TerrainQuery::State::Downloading) {
-            QGeoTileSpec spec;
-            spec.setX(provider->long2tileX(coordinate.longitude(), 1));
-            spec.setY(provider->lat2tileY(coordinate.latitude(), 1));
-            spec.setZoom(1);
-            spec.setMapId(provider->getMapId());
-            const QNetworkRequest request = QGeoTileFetcherQGC::getNetworkRequest(spec.mapId(), spec.x(), spec.y(), spec.zoom());
-            QGeoTiledMapReplyQGC* const reply = new QGeoTiledMapReplyQGC(_networkManager, request, spec, this);
-            (void) connect(reply, &QGeoTiledMapReplyQGC::finished, this, &TerrainTileManager::_terrainDone);
-            _state = TerrainQuery::State::Downloading;
-            // TODO: Batch Downloading?
-            return false;
-        } else {
+            continue;
+        }
+        (void) missingTiles.insert(tileKey);
+
+        if (!_downloadingTiles.contains(tileKey)) {
+            (void) _downloadingTiles.insert(tileKey);
+            _downloadQueue.enqueue({ tileKey, provider->getMapId(), x, y });
+        }
+    }
+
+    if (!missingTiles.isEmpty()) {
+        qCDebug(TerrainTileManagerLog) << Q_FUNC_INFO << "missing tiles" << missingTiles.count() << "downloads queued" << _downloadQueue.count() << "active" << _activeDownloads;
+        _startTileDownloads();
+    }
+
+    return missingTiles;
+}
+
+bool TerrainTileManager::_getCachedAltitudes(const QList<QGeoCoordinate> &coordinates, QList<double> &altitudes, bool &error, const PinnedTiles *pinnedTiles)
+{
+    const qsizetype count = coordinates.count();
+    QList<double> latitudes(count);
+    QList<double> longitudes(count);
+    for (qsizetype i = 0; i < count; i++) {
+        latitudes[i] = coordinates[i].latitude();
+        longitudes[i] = coordinates[i].longitude();
+    }
+
+    altitudes.resize(count);
+    if (!_getCachedElevations(_elevationProvider(), latitudes.constData(), longitudes.constData(), altitudes.data(), count, error, pinnedTiles)) {
+        altitudes.clear();
+        return false;
+    }
+
+    qCDebug(TerrainTileManagerLog) << Q_FUNC_INFO << "returning" << count << "elevations from tile cache";
+
+    return true;
+}
+
+bool TerrainTileManager::_getCachedElevations(const SharedMapProvider &provider, const double *latitudes, const double *longitudes, double *elevations, qsizetype count, bool &error, const PinnedTiles *pinnedTiles) const
+{
+    error = false;
+
+    QList<quint64> tileKeys(count);
+    for (qsizetype i = 0; i < count; i++) {
+        tileKeys[i] = _tileKey(provider, latitudes[i], longitudes[i]);
+    }
+
+    // Path and area queries visit tiles in long runs of neighbouring coordinates, each run is a single batch lookup
+    qsizetype runStart = 0;
+    while (runStart < count) {
+        const quint64 tileKey = tileKeys[runStart];
+        std::shared_ptr<const TerrainTile> tile = pinnedTiles ? pinnedTiles->value(tileKey) : nullptr;
+        if (!tile) {
+            tile = _getCachedTile(tileKey);
+        }
+        if (!tile) {
             return false;
         }
+
+        qsizetype runEnd = runStart + 1;
+        while ((runEnd < count) && (tileKeys[runEnd] == tileKey)) {
+            runEnd++;
+        }
+
+        if (!tile->elevations(latitudes + runStart, longitudes + runStart, elevations + runStart, runEnd - runStart)) {
+            error = true;
+            qCWarning(TerrainTileManagerLog) << Q_FUNC_INFO << "Internal Error: missing elevation in tile cache";
+        }
+
+        runStart = runEnd;
     }
 
     return true;
 }
 
+quint64 TerrainTileManager::_tileKey(const SharedMapProvider &provider, double latitude, double longitude)
+{
+    return UrlFactory::packTileKey(provider->getProviderId(), provider->long2tileX(longitude, 1), provider->lat2tileY(latitude, 1), 1);
+}
+
+quint64 TerrainTileManager::_tileKey(const QGeoCoordinate &coordinate)
+{
+    return _tileKey(_elevationProvider(), coordinate.latitude(), coordinate.longitude());
+}
+
 void TerrainTileManager::addCoordinateQuery(TerrainQueryInterface *terrainQueryInterface, const QList<QGeoCoordinate> &coordinates)
 {
     qCDebug(TerrainTileManagerLog) << Q_FUNC_INFO << "count" << coordinates.count();
@@ -105,21 +204,27 @@ void TerrainTileManager::addCoordinateQuery(TerrainQueryInterface *terrainQueryI
         return;
     }
 
-    bool error;
-    QList<double> altitudes;
-    if (!getAltitudesForCoordinates(coordinates, altitudes, error)) {
+    PinnedTiles cachedTiles;
+    const QSet<quint64> missingTiles = _requestMissingTiles(coordinates, &cachedTiles);
+    if (!missingTiles.isEmpty()) {
         qCDebug(TerrainTileManagerLog) << Q_FUNC_INFO << "queue count" << _requestQueue.count();
         const QueuedRequestInfo_t queuedRequestInfo = {
             terrainQueryInterface,
             TerrainQuery::QueryMode::QueryModeCoordinates,
             0,
             0,
-            coordinates
+            coordinates,
+            missingTiles,
+            cachedTiles
         };
         _requestQueue.enqueue(queuedRequestInfo);
         return;
     }
 
+    bool error;
+    QList<double> altitudes;
+    (void) _getCachedAltitudes(coordinates, altitudes, error);
+
     if (error) {
         QList<double> noAltitudes;
         qCWarning(TerrainTileManagerLog) << Q_FUNC_INFO << "signalling failure due to internal error";
@@ -135,23 +240,29 @@ void TerrainTileManager::addPathQuery(TerrainQueryInterface *terrainQueryInterfa
 {
     double distanceBetween;
     double finalDistanceBetween;
-    const QList<QGeoCoordinate> coordinates = _pathQueryToCoords(startPoint, endPoint, distanceBetween, finalDistanceBetween);
+    const QList<QGeoCoordinate> coordinates = pathQueryToCoords(startPoint, endPoint, distanceBetween, finalDistanceBetween);
 
-    bool error;
-    QList<double> altitudes;
-    if (!getAltitudesForCoordinates(coordinates, altitudes, error)) {
+    PinnedTiles cachedTiles;
+    const QSet<quint64> missingTiles = _requestMissingTiles(coordinates, &cachedTiles);
+    if (!missingTiles.isEmpty()) {
         qCDebug(TerrainTileManagerLog) << Q_FUNC_INFO << "queue count" << _requestQueue.count();
         const QueuedRequestInfo_t queuedRequestInfo = {
             terrainQueryInterface,
             TerrainQuery::QueryMode::QueryModePath,
             distanceBetween,
             finalDistanceBetween,
-            coordinates
+            coordinates,
+            missingTiles,
+            cachedTiles
         };
         _requestQueue.enqueue(queuedRequestInfo);
         return;
     }
 
+    bool error;
+    QList<double> altitudes;
+    (void) _getCachedAltitudes(coordinates, altitudes, error);
+
     if (error) {
         QList<double> noAltitudes;
         qCWarning(TerrainTileManagerLog) << Q_FUNC_INFO << "signalling failure due to internal error";
@@ -163,7 +274,159 @@ void TerrainTileManager::addPathQuery(TerrainQueryInterface *terrainQueryInterfa
     terrainQueryInterface->signalPathHeights((coordinates.count() == altitudes.count()), distanceBetween, finalDistanceBetween, altitudes);
 }
 
-QList<QGeoCoordinate> TerrainTileManager::_pathQueryToCoords(const QGeoCoordinate &fromCoord, const QGeoCoordinate &toCoord, double &distanceBetween, double &finalDistanceBetween)
+void TerrainTileManager::addCarpetQuery(TerrainQueryInterface *terrainQueryInterface, const QGeoCoordinate &swCoord, const QGeoCoordinate &neCoord, bool statsOnly)
+{
+    qCDebug(TerrainTileManagerLog) << Q_FUNC_INFO << swCoord << neCoord << statsOnly;
+
+    if ((swCoord.latitude() > neCoord.latitude()) || (swCoord.longitude() > neCoord.longitude())) {
+        qCWarning(TerrainTileManagerLog) << Q_FUNC_INFO << "south west corner is not south west of north east corner";
+        terrainQueryInterface->signalCarpetHeights(false, qQNaN(), qQNaN(), QList<QList<double>>());
+        return;
+    }
+
+    PinnedTiles cachedTiles;
+    const QSet<quint64> missingTiles = _requestMissingTiles(_carpetTileCoords(swCoord, neCoord), &cachedTiles);
+    if (!missingTiles.isEmpty()) {
+        qCDebug(TerrainTileManagerLog) << Q_FUNC_INFO << "queue count" << _requestQueue.count();
+        const QueuedRequestInfo_t queuedRequestInfo = {
+            terrainQueryInterface,
+            TerrainQuery::QueryMode::QueryModeCarpet,
+            0,
+            0,
+            QList<QGeoCoordinate>(),
+            missingTiles,
+            cachedTiles,
+            swCoord,
+            neCoord,
+            statsOnly
+        };
+        _requestQueue.enqueue(queuedRequestInfo);
+        return;
+    }
+
+    _signalCarpet(terrainQueryInterface, swCoord, neCoord, statsOnly);
+}
+
+void TerrainTileManager::prefetchArea(const QGeoCoordinate &swCoord, const QGeoCoordinate &neCoord)
+{
+    if (localDemSelected() || (swCoord.latitude() > neCoord.latitude()) || (swCoord.longitude() > neCoord.longitude())) {
+        return;
+    }
+
+    const QSet<quint64> missingTiles = _requestMissingTiles(_carpetTileCoords(swCoord, neCoord));
+    qCDebug(TerrainTileManagerLog) << Q_FUNC_INFO << swCoord << neCoord << "missing tiles" << missingTiles.count();
+}
+
+QList<QGeoCoordinate> TerrainTileManager::_carpetTileCoords(const QGeoCoordinate &swCoord, const QGeoCoordinate &neCoord)
+{
+    // Stepping by the tile size visits every row and column of tiles, the north east corner closes the last ones
+    static constexpr double tileSize = TerrainTileCopernicus::kTileSizeDegrees;
+    const int latSteps = qCeil((neCoord.latitude() - swCoord.latitude()) / tileSize);
+    const int lonSteps = qCeil((neCoord.longitude() - swCoord.longitude()) / tileSize);
+
+    QList<QGeoCoordinate> coordinates;
+    coordinates.reserve((latSteps + 1) * (lonSteps + 1));
+    for (int latStep = 0; latStep <= latSteps; latStep++) {
+        const double latitude = qMin(swCoord.latitude() + (latStep * tileSize), neCoord.latitude());
+        for (int lonStep = 0; lonStep <= lonSteps; lonStep++) {
+            const double longitude = qMin(swCoord.longitude() + (lonStep * tileSize), neCoord.longitude());
+            (void) coordinates.append(QGeoCoordinate(latitude, longitude));
+        }
+    }
+
+    return coordinates;
+}
+
+void TerrainTileManager::_signalCarpet(TerrainQueryInterface *terrainQueryInterface, const QGeoCoordinate &swCoord, const QGeoCoordinate &neCoord, bool statsOnly, const PinnedTiles *pinnedTiles)
+{
+    const SharedMapProvider provider = _elevationProvider();
+    const auto sampler = [this, &provider, pinnedTiles](const double *latitudes, const double *longitudes, double *elevations, qsizetype count) {
+        bool error;
+        return (_getCachedElevations(provider, latitudes, longitudes, elevations, count, error, pinnedTiles) && !error);
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+
+    double minHeight;
+    double maxHeight;
+    QList<QList<double>> carpet;
+    if (!sampleCarpet(swCoord, neCoord, TerrainTileCopernicus::kTleValueSpacingDegrees, statsOnly, sampler, minHeight, maxHeight, carpet)) {
+        // Every tile was pinned or cached when the query was answered
+        qCWarning(TerrainTileManagerLog) << Q_FUNC_INFO << "signalling failure, tiles for the area are not cached";
+        terrainQueryInterface->signalCarpetHeights(false, qQNaN(), qQNaN(), QList<QList<double>>());
+        return;
+    }
+
+    qCDebug(TerrainTileManagerLog) << Q_FUNC_INFO << "carpet rows" << carpet.count() << "sampled in" << timer.elapsed() << "msecs";
+    terrainQueryInterface->signalCarpetHeights(true, minHeight, maxHeight, carpet);
+}
+
+bool TerrainTileManager::sampleCarpet(const QGeoCoordinate &swCoord, const QGeoCoordinate &neCoord, double spacingDegrees, bool statsOnly, const CarpetRowSampler &sampler, double &minHeight, double &maxHeight, QList<QList<double>> &carpet)
+{
+    minHeight = qQNaN();
+    maxHeight = qQNaN();
+    carpet.clear();
+
+    const double latSpan = neCoord.latitude() - swCoord.latitude();
+    const double lonSpan = neCoord.longitude() - swCoord.longitude();
+    if ((latSpan < 0) || (lonSpan < 0) || (spacingDegrees <= 0)) {
+        return false;
+    }
+
+    const int rows = qBound(1, qCeil(latSpan / spacingDegrees) + 1, kMaxCarpetSamples);
+    const int columns = qBound(1, qCeil(lonSpan / spacingDegrees) + 1, kMaxCarpetSamples);
+    const double latStep = (rows > 1) ? (latSpan / (rows - 1)) : 0;
+    const double lonStep = (columns > 1) ? (lonSpan / (columns - 1)) : 0;
+
+    QList<double> longitudes(columns);
+    for (int column = 0; column < columns; column++) {
+        longitudes[column] = swCoord.longitude() + (column * lonStep);
+    }
+
+    QList<int> rowIndices(rows);
+    std::iota(rowIndices.begin(), rowIndices.end(), 0);
+    QList<double> rowMinHeights(rows, qQNaN());
+    QList<double> rowMaxHeights(rows, qQNaN());
+    QList<bool> rowComplete(rows, false);
+    if (!statsOnly) {
+        carpet.resize(rows);
+    }
+
+    // Every row is written by exactly one worker, no locking is needed
+    const double* const longitudeData = longitudes.constData();
+    double* const rowMinData = rowMinHeights.data();
+    double* const rowMaxData = rowMaxHeights.data();
+    bool* const rowCompleteData = rowComplete.data();
+    QList<double>* const carpetData = statsOnly ? nullptr : carpet.data();
+
+    QtConcurrent::blockingMap(rowIndices, [&](int row) {
+        const QList<double> latitudes(columns, swCoord.latitude() + (row * latStep));
+        QList<double> heights(columns);
+        rowCompleteData[row] = sampler(latitudes.constData(), longitudeData, heights.data(), columns);
+        if (!rowCompleteData[row]) {
+            return;
+        }
+
+        const auto [rowMin, rowMax] = std::minmax_element(heights.cbegin(), heights.cend());
+        rowMinData[row] = *rowMin;
+        rowMaxData[row] = *rowMax;
+        if (carpetData) {
+            carpetData[row] = std::move(heights);
+        }
+    });
+
+    if (rowComplete.contains(false)) {
+        carpet.clear();
+        return false;
+    }
+
+    minHeight = *std::min_element(rowMinHeights.cbegin(), rowMinHeights.cend());
+    maxHeight = *std::max_element(rowMaxHeights.cbegin(), rowMaxHeights.cend());
+    return true;
+}
+
+QList<QGeoCoordinate> TerrainTileManager::pathQueryToCoords(const QGeoCoordinate &fromCoord, const QGeoCoordinate &toCoord, double &distanceBetween, double &finalDistanceBetween)
 {
     const double lat = fromCoord.latitude();
     const double lon = fromCoord.longitude();
@@ -194,128 +457,154 @@ QList<QGeoCoordinate> TerrainTileManager::_pathQueryToCoords(const QGeoCoordinat
     return coordinates;
 }
 
-void TerrainTileManager::_tileFailed()
+void TerrainTileManager::_startTileDownloads()
 {
-    QList<double> noAltitudes;
-
-    for (const QueuedRequestInfo_t &requestInfo: _requestQueue) {
-        switch (requestInfo.queryMode) {
-        case TerrainQuery::QueryMode::QueryModeCoordinates:
-            requestInfo.terrainQueryInterface->signalCoordinateHeights(false, noAltitudes);
-            break;
-        case TerrainQuery::QueryMode::QueryModePath:
-            requestInfo.terrainQueryInterface->signalPathHeights(false, requestInfo.distanceBetween, requestInfo.finalDistanceBetween, noAltitudes);
-            break;
-        default:
-            continue;
+    while ((_activeDownloads < kMaxConcurrentDownloads) && !_downloadQueue.isEmpty()) {
+        const TileDownload_t download = _downloadQueue.dequeue();
+
+        QGeoTileSpec spec;
+        spec.setX(download.x);
+        spec.setY(download.y);
+        spec.setZoom(1);
+        spec.setMapId(download.mapId);
+        const QNetworkRequest request = QGeoTileFetcherQGC::getNetworkRequest(spec.mapId(), spec.x(), spec.y(), spec.zoom());
+        QGeoTiledMapReplyQGC* const reply = new QGeoTiledMapReplyQGC(_networkManager, request, spec, this);
+        _activeDownloads++;
+
+        if (reply->isFinished()) {
+            // Failures such as no network are reported from within the constructor
+            (void) QMetaObject::invokeMethod(this, [this, reply]() {
+                _tileDownloadFinished(reply);
+            }, Qt::QueuedConnection);
+        } else {
+            (void) connect(reply, &QGeoTiledMapReplyQGC::finished, this, [this, reply]() {
+                _tileDownloadFinished(reply);
+            });
         }
     }
-
-    _requestQueue.clear();
 }
 
-void TerrainTileManager::_terrainDone()
+void TerrainTileManager::_tileDownloadFinished(QGeoTiledMapReplyQGC *reply)
 {
-    _state = TerrainQuery::State::Idle;
-
-    QGeoTiledMapReplyQGC* const reply = qobject_cast<QGeoTiledMapReplyQGC*>(QObject::sender());
-    if (!reply) {
-        qCWarning(TerrainTileManagerLog) << "Elevation tile fetched but invalid reply data type.";
-        return;
-    }
+    _activeDownloads--;
     reply->deleteLater();
 
-    const QByteArray responseBytes = reply->mapImageData();
     const QGeoTileSpec spec = reply->tileSpec();
+    const quint64 tileKey = UrlFactory::getTileKey(UrlFactory::getProviderTypeFromQtMapId(spec.mapId()), spec.x(), spec.y(), spec.zoom());
+    (void) _downloadingTiles.remove(tileKey);
 
+    std::shared_ptr<const TerrainTile> tile;
     if (reply->error() != QGeoTiledMapReplyQGC::NoError) {
         qCWarning(TerrainTileManagerLog) << "Elevation tile fetching returned error:" << reply->errorString();
-        _tileFailed();
-        return;
-    }
-
-    if (responseBytes.isEmpty()) {
+    } else if (reply->mapImageData().isEmpty()) {
         qCWarning(TerrainTileManagerLog) << "Error in fetching elevation tile. Empty response.";
-        _tileFailed();
-        return;
+    } else {
+        qCDebug(TerrainTileManagerLog) << "Received some bytes of terrain data:" << reply->mapImageData().size();
+        tile = _cacheTile(reply->mapImageData(), tileKey);
     }
 
-    qCDebug(TerrainTileManagerLog) << "Received some bytes of terrain data:" << responseBytes.size();
-
-    const QString hash = UrlFactory::getTileHash(UrlFactory::getProviderTypeFromQtMapId(spec.mapId()), spec.x(), spec.y(), spec.zoom());
-    _cacheTile(responseBytes, hash);
+    _resolveRequests(tileKey, tile);
+    _startTileDownloads();
+}
 
-    for (qsizetype i = _requestQueue.count() - 1; i >= 0; i--) {
-        bool error;
+void TerrainTileManager::_resolveRequests(quint64 tileKey, const std::shared_ptr<const TerrainTile> &tile)
+{
+    struct CompletedRequest_t {
+        QueuedRequestInfo_t requestInfo;
+        bool success;
         QList<double> altitudes;
+    };
+
+    // Requests are signalled only after the queue is updated, receivers may queue new requests
+    QList<CompletedRequest_t> completedRequests;
+    for (qsizetype i = 0; i < _requestQueue.count(); ) {
         QueuedRequestInfo_t &requestInfo = _requestQueue[i];
+        if (!requestInfo.missingTiles.remove(tileKey)) {
+            i++;
+            continue;
+        }
 
-        if (!getAltitudesForCoordinates(requestInfo.coordinates, altitudes, error)) {
+        if (!tile) {
+            qCWarning(TerrainTileManagerLog) << "signalling failure due to missing tile";
+            completedRequests.append({ _requestQueue.takeAt(i), false, QList<double>() });
             continue;
         }
+        // The cache may evict the tile before the last tile of the request arrives
+        (void) requestInfo.tiles.insert(tileKey, tile);
 
-        switch (requestInfo.queryMode) {
-        case TerrainQuery::QueryMode::QueryModeCoordinates:
-            if (error) {
-                qCWarning(TerrainTileManagerLog) << "signalling failure due to internal error";
-                QList<double> noAltitudes;
-                requestInfo.terrainQueryInterface->signalCoordinateHeights(false, noAltitudes);
-            } else {
-                qCDebug(TerrainTileManagerLog) << "All altitudes taken from cached data";
-                requestInfo.terrainQueryInterface->signalCoordinateHeights(requestInfo.coordinates.count() == altitudes.count(), altitudes);
-            }
-            break;
-        case TerrainQuery::QueryMode::QueryModePath:
-            if (error) {
-                qCWarning(TerrainTileManagerLog) << "signalling failure due to internal error";
-                QList<double> noAltitudes;
-                requestInfo.terrainQueryInterface->signalPathHeights(false, requestInfo.distanceBetween, requestInfo.finalDistanceBetween, noAltitudes);
-            } else {
-                qCDebug(TerrainTileManagerLog) << "All altitudes taken from cached data";
-                requestInfo.terrainQueryInterface->signalPathHeights(requestInfo.coordinates.count() == altitudes.count(), requestInfo.distanceBetween, requestInfo.finalDistanceBetween, altitudes);
-            }
-            break;
-        default:
-            break;
+        if (!requestInfo.missingTiles.isEmpty()) {
+            i++;
+            continue;
         }
 
-        _requestQueue.removeAt(i);
+        if (requestInfo.queryMode == TerrainQuery::QueryMode::QueryModeCarpet) {
+            // Sampled when signalled
+            completedRequests.append({ _requestQueue.takeAt(i), true, QList<double>() });
+            continue;
+        }
+
+        bool error;
+        QList<double> altitudes;
+        if (!_getCachedAltitudes(requestInfo.coordinates, altitudes, error, &requestInfo.tiles)) {
+            // Covering tiles are pinned as they are found cached or arrive, re-queueing would never resolve this
+            qCWarning(TerrainTileManagerLog) << "signalling failure, tile is neither pinned nor cached";
+            completedRequests.append({ _requestQueue.takeAt(i), false, QList<double>() });
+        } else if (error) {
+            qCWarning(TerrainTileManagerLog) << "signalling failure due to internal error";
+            completedRequests.append({ _requestQueue.takeAt(i), false, QList<double>() });
+        } else {
+            qCDebug(TerrainTileManagerLog) << "All altitudes taken from cached data";
+            const bool success = (requestInfo.coordinates.count() == altitudes.count());
+            completedRequests.append({ _requestQueue.takeAt(i), success, altitudes });
+        }
     }
-}
 
-void TerrainTileManager::_cacheTile(const QByteArray &data, const QString &hash)
-{
-    TerrainTile* const terrainTile = new TerrainTile(data);
-    if (terrainTile->isValid()) {
-        _tilesMutex.lock();
-        if (!_tiles.contains(hash)) {
-            (void) _tiles.insert(hash, terrainTile);
+    for (const CompletedRequest_t &completedRequest : completedRequests) {
+        const QueuedRequestInfo_t &requestInfo = completedRequest.requestInfo;
+        if ((requestInfo.queryMode == TerrainQuery::QueryMode::QueryModeCarpet) && completedRequest.success) {
+            _signalCarpet(requestInfo.terrainQueryInterface, requestInfo.swCoord, requestInfo.neCoord, requestInfo.statsOnly, &requestInfo.tiles);
         } else {
-            delete terrainTile;
+            _signalRequest(requestInfo, completedRequest.success, completedRequest.altitudes);
         }
-        _tilesMutex.unlock();
-    } else {
-        delete terrainTile;
-        qCWarning(TerrainTileManagerLog) << "Received invalid tile";
     }
 }
 
-TerrainTile *TerrainTileManager::_getCachedTile(const QString &hash)
+void TerrainTileManager::_signalRequest(const QueuedRequestInfo_t &requestInfo, bool success, const QList<double> &altitudes)
 {
-    _tilesMutex.lock();
-    if (!_tiles.contains(hash)) {
-        _tilesMutex.unlock();
-        return nullptr;
+    switch (requestInfo.queryMode) {
+    case TerrainQuery::QueryMode::QueryModeCoordinates:
+        requestInfo.terrainQueryInterface->signalCoordinateHeights(success, altitudes);
+        break;
+    case TerrainQuery::QueryMode::QueryModePath:
+        requestInfo.terrainQueryInterface->signalPathHeights(success, requestInfo.distanceBetween, requestInfo.finalDistanceBetween, altitudes);
+        break;
+    case TerrainQuery::QueryMode::QueryModeCarpet:
+        requestInfo.terrainQueryInterface->signalCarpetHeights(false, qQNaN(), qQNaN(), QList<QList<double>>());
+        break;
+    default:
+        break;
     }
+}
 
-    TerrainTile* const tile = _tiles[hash];
-
-    if (!tile->isValid()) {
-        _tilesMutex.unlock();
+std::shared_ptr<const TerrainTile> TerrainTileManager::_cacheTile(const QByteArray &data, quint64 tileKey)
+{
+    const std::shared_ptr<const TerrainTile> terrainTile = std::make_shared<const TerrainTile>(data);
+    if (!terrainTile->isValid()) {
+        qCWarning(TerrainTileManagerLog) << "Received invalid tile";
         return nullptr;
     }
 
-    _tilesMutex.unlock();
+    _tileCache.insert(tileKey, terrainTile);
+    return terrainTile;
+}
 
-    return tile;
+std::shared_ptr<const TerrainTile> TerrainTileManager::_getCachedTile(quint64 tileKey) const
+{
+    // Only valid tiles are cached
+    return _tileCache.tile(tileKey);
+}
+
+qint64 TerrainTileManager::_maxTileCacheBytes()
+{
+    return static_cast<qint64>(SettingsManager::instance()->mapsSettings()->maxTerrainCacheMemorySize()->rawValue().toUInt()) * 1024 * 1024;
 }
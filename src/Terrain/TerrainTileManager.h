@@ -10,16 +10,24 @@
 #pragma once
 
 #include "TerrainQueryInterface.h"
+#include "TerrainTileCache.h"
 
+#include <QtCore/QHash>
 #include <QtCore/QLoggingCategory>
-#include <QtCore/QMutex>
 #include <QtCore/QObject>
 #include <QtCore/QQueue>
+#include <QtCore/QSet>
 #include <QtPositioning/QGeoCoordinate>
 
+#include <functional>
+#include <memory>
+
+class MapProvider;
 class TerrainTile;
+class QGeoTiledMapReplyQGC;
 class QNetworkAccessManager;
 class UnitTestTerrainQuery;
+class TerrainTileManagerTest;
 
 Q_DECLARE_LOGGING_CATEGORY(TerrainTileManagerLog)
 
@@ -28,29 +36,43 @@ class TerrainTileManager : public QObject
     Q_OBJECT
 
     friend class UnitTestTerrainQuery;
+    friend class TerrainTileManagerTest;
 public:
     explicit TerrainTileManager(QObject *parent = nullptr);
     ~TerrainTileManager();
 
     static TerrainTileManager *instance();
 
-    /// Either returns altitudes from cache or queues database request
+    /// Local DEM elevation is read by TerrainQueryLocalDem straight from the files, no tiles are involved
+    static bool localDemSelected();
+
+    /// Either returns altitudes from cache or queues downloads for every missing tile
     ///     @param[out] error true: altitude not returned due to error, false: altitudes returned
-    ///     @return true: altitude returned (check error as well), false: database query queued (altitudes not returned)
+    ///     @return true: altitude returned (check error as well), false: tile downloads queued (altitudes not returned)
     bool getAltitudesForCoordinates(const QList<QGeoCoordinate> &coordinates, QList<double> &altitudes, bool &error);
 
     void addCoordinateQuery(TerrainQueryInterface *terrainQueryInterface, const QList<QGeoCoordinate> &coordinates);
     void addPathQuery(TerrainQueryInterface *terrainQueryInterface, const QGeoCoordinate &startPoint, const QGeoCoordinate &endPoint);
+    void addCarpetQuery(TerrainQueryInterface *terrainQueryInterface, const QGeoCoordinate &swCoord, const QGeoCoordinate &neCoord, bool statsOnly);
+    /// Queues downloads for the uncached tiles of the area so later queries there are answered from the cache
+    void prefetchArea(const QGeoCoordinate &swCoord, const QGeoCoordinate &neCoord);
+
+    /// Returns a list of individual coordinates along the requested path spaced according to the terrain tile value spacing
+    static QList<QGeoCoordinate> pathQueryToCoords(const QGeoCoordinate &fromCoord, const QGeoCoordinate &toCoord, double &distanceBetween, double &finalDistanceBetween);
+
+    /// Fills elevations for count coordinates, called from several threads at once
+    ///     @return false if any elevation is missing
+    using CarpetRowSampler = std::function<bool(const double *latitudes, const double *longitudes, double *elevations, qsizetype count)>;
+
+    /// Samples the grid spanning swCoord to neCoord at spacingDegrees, rows are sampled in parallel and run from
+    /// south to north. With statsOnly no rows are kept, only the extremes.
+    ///     @return false if any sample is missing
+    static bool sampleCarpet(const QGeoCoordinate &swCoord, const QGeoCoordinate &neCoord, double spacingDegrees, bool statsOnly, const CarpetRowSampler &sampler, double &minHeight, double &maxHeight, QList<QList<double>> &carpet);
 
-private slots:
-    void _terrainDone();
+    static constexpr int kMaxCarpetSamples = 4096;      ///< Per side, larger areas are sampled more coarsely
 
 private:
-    /// Returns a list of individual coordinates along the requested path spaced according to the terrain tile value spacing
-    static QList<QGeoCoordinate> _pathQueryToCoords(const QGeoCoordinate &fromCoord, const QGeoCoordinate &toCoord, double &distanceBetween, double &finalDistanceBetween);
-    void _tileFailed();
-    void _cacheTile(const QByteArray &data, const QString &hash);
-    TerrainTile *_getCachedTile(const QString &hash);
+    using PinnedTiles = QHash<quint64, std::shared_ptr<const TerrainTile>>;
 
     struct QueuedRequestInfo_t {
         TerrainQueryInterface *terrainQueryInterface;
@@ -58,13 +80,53 @@ private:
         double distanceBetween;                         ///< Distance between each returned height
         double finalDistanceBetween;                    ///< Distance between for final height
         QList<QGeoCoordinate> coordinates;
+        QSet<quint64> missingTiles;                     ///< Tiles which must arrive before the request can be answered
+        PinnedTiles tiles;                              ///< Tiles which have arrived, held so the cache can't evict them first
+        QGeoCoordinate swCoord;                         ///< Carpet bounds
+        QGeoCoordinate neCoord;
+        bool statsOnly = false;
+    };
+
+    struct TileDownload_t {
+        quint64 tileKey;
+        int mapId;
+        int x;
+        int y;
     };
 
+    /// Returns the keys of uncached tiles covering coordinates, downloads are queued for each of them
+    ///     @param[out] cachedTiles Optional, receives the covering tiles which are cached
+    QSet<quint64> _requestMissingTiles(const QList<QGeoCoordinate> &coordinates, PinnedTiles *cachedTiles = nullptr);
+    /// @return false: a tile covering coordinates is neither pinned nor cached
+    bool _getCachedAltitudes(const QList<QGeoCoordinate> &coordinates, QList<double> &altitudes, bool &error, const PinnedTiles *pinnedTiles = nullptr);
+    /// Thread safe, the provider is looked up once by the caller. Pinned tiles are looked up before the cache.
+    ///     @return false: a tile covering the coordinates is neither pinned nor cached
+    bool _getCachedElevations(const std::shared_ptr<const MapProvider> &provider, const double *latitudes, const double *longitudes, double *elevations, qsizetype count, bool &error, const PinnedTiles *pinnedTiles = nullptr) const;
+    /// Coordinates touching every tile of the area between swCoord and neCoord
+    static QList<QGeoCoordinate> _carpetTileCoords(const QGeoCoordinate &swCoord, const QGeoCoordinate &neCoord);
+    void _signalCarpet(TerrainQueryInterface *terrainQueryInterface, const QGeoCoordinate &swCoord, const QGeoCoordinate &neCoord, bool statsOnly, const PinnedTiles *pinnedTiles = nullptr);
+    static quint64 _tileKey(const std::shared_ptr<const MapProvider> &provider, double latitude, double longitude);
+    /// Key of the tile of the selected elevation provider containing coordinate
+    static quint64 _tileKey(const QGeoCoordinate &coordinate);
+    void _startTileDownloads();
+    void _tileDownloadFinished(QGeoTiledMapReplyQGC *reply);
+    /// @param tile nullptr: the tile could not be downloaded
+    void _resolveRequests(quint64 tileKey, const std::shared_ptr<const TerrainTile> &tile);
+    static void _signalRequest(const QueuedRequestInfo_t &requestInfo, bool success, const QList<double> &altitudes);
+    /// @return The decoded tile, nullptr if data is not a valid tile
+    std::shared_ptr<const TerrainTile> _cacheTile(const QByteArray &data, quint64 tileKey);
+    std::shared_ptr<const TerrainTile> _getCachedTile(quint64 tileKey) const;
+    static qint64 _maxTileCacheBytes();
+
     QQueue<QueuedRequestInfo_t> _requestQueue;
-    TerrainQuery::State _state = TerrainQuery::State::Idle;
 
-    QMutex _tilesMutex;
-    QHash<QString, TerrainTile*> _tiles;
+    QQueue<TileDownload_t> _downloadQueue;
+    QSet<quint64> _downloadingTiles;                    ///< Queued or in flight
+    int _activeDownloads = 0;
+
+    TerrainTileCache _tileCache;
 
     QNetworkAccessManager *_networkManager = nullptr;
+
+    static constexpr int kMaxConcurrentDownloads = 6;   ///< Matches the per host connection limit of QNetworkAccessManager
 };
@@ -224,6 +224,21 @@ Item {
             LabelledFactTextField {
                 fact: _mapsSettings.maxCacheMemorySize
             }    
+
+            LabelledFactTextField {
+                fact: _mapsSettings.maxTerrainCacheMemorySize
+            }
+
+            FactCheckBoxSlider {
+                Layout.fillWidth:   true
+                text:               qsTr("Prefetch Tiles Ahead Of Vehicle")
+                fact:               _mapsSettings.tilePrefetch
+            }
+
+            LabelledFactTextField {
+                fact:       _mapsSettings.tilePrefetchMaxBandwidth
+                enabled:    _mapsSettings.tilePrefetch.rawValue
+            }
         }
 
         QGCFileDialog {
@@ -51,5 +51,19 @@ SettingsPage {
             fact:               _planViewSettings.takeoffItemNotRequired
             visible:            fact.visible
         }
+
+        FactCheckBoxSlider {
+            Layout.fillWidth:   true
+            text:               qsTr("Simplify Imported KML/SHP Shapes")
+            fact:               _planViewSettings.simplifyImportedShapes
+            visible:            fact.visible
+        }
+
+        LabelledFactTextField {
+            Layout.fillWidth:   true
+            label:              qsTr("Mission Items In Flight During Transfers")
+            fact:               _planViewSettings.missionTransferWindow
+            visible:            fact.visible
+        }
     }
 }
@@ -8,50 +8,64 @@
  ****************************************************************************/
 
 #include "KMLHelper.h"
+#include "PolylineSimplifier.h"
 
 #include <QtCore/QFile>
+#include <QtCore/QLocale>
+#include <QtCore/QXmlStreamReader>
 
-QDomDocument KMLHelper::_loadFile(const QString& kmlFile, QString& errorString)
-{
-    QFile file(kmlFile);
+#include <algorithm>
 
+bool KMLHelper::_openFile(const QString& kmlFile, QFile& file, QString& errorString)
+{
     errorString.clear();
 
+    file.setFileName(kmlFile);
+
     if (!file.exists()) {
         errorString = QString(_errorPrefix).arg(tr("File not found: %1").arg(kmlFile));
-        return QDomDocument();
+        return false;
     }
 
     if (!file.open(QIODevice::ReadOnly)) {
         errorString = QString(_errorPrefix).arg(tr("Unable to open file: %1 error: $%2").arg(kmlFile).arg(file.errorString()));
-        return QDomDocument();
+        return false;
     }
 
-    QDomDocument doc;
-    QString errorMessage;
-    int errorLine;
-    if (!doc.setContent(&file, &errorMessage, &errorLine)) {
-        errorString = QString(_errorPrefix).arg(tr("Unable to parse KML file: %1 error: %2 line: %3").arg(kmlFile).arg(errorMessage).arg(errorLine));
-        return QDomDocument();
-    }
+    return true;
+}
 
-    return doc;
+QString KMLHelper::_xmlErrorString(const QString& kmlFile, const QXmlStreamReader& xml)
+{
+    return QString(_errorPrefix).arg(tr("Unable to parse KML file: %1 error: %2 line: %3").arg(kmlFile).arg(xml.errorString()).arg(xml.lineNumber()));
 }
 
 ShapeFileHelper::ShapeType KMLHelper::determineShapeType(const QString& kmlFile, QString& errorString)
 {
-    QDomDocument domDocument = KMLHelper::_loadFile(kmlFile, errorString);
-    if (!errorString.isEmpty()) {
+    QFile file;
+    if (!_openFile(kmlFile, file, errorString)) {
         return ShapeFileHelper::Error;
     }
 
-    QDomNodeList rgNodes = domDocument.elementsByTagName("Polygon");
-    if (rgNodes.count()) {
-        return ShapeFileHelper::Polygon;
+    // Polygons win over line strings, so only a polygon ends the scan early
+    bool foundLineString = false;
+    QXmlStreamReader xml(&file);
+    while (!xml.atEnd()) {
+        if (xml.readNext() == QXmlStreamReader::StartElement) {
+            if (xml.name() == QStringLiteral("Polygon")) {
+                return ShapeFileHelper::Polygon;
+            } else if (xml.name() == QStringLiteral("LineString")) {
+                foundLineString = true;
+            }
+        }
+    }
+
+    if (xml.hasError()) {
+        errorString = _xmlErrorString(kmlFile, xml);
+        return ShapeFileHelper::Error;
     }
 
-    rgNodes = domDocument.elementsByTagName("LineString");
-    if (rgNodes.count()) {
+    if (foundLineString) {
         return ShapeFileHelper::Polyline;
     }
 
@@ -59,106 +73,226 @@ ShapeFileHelper::ShapeType KMLHelper::determineShapeType(const QString& kmlFile,
     return ShapeFileHelper::Error;
 }
 
-bool KMLHelper::loadPolygonFromFile(const QString& kmlFile, QList<QGeoCoordinate>& vertices, QString& errorString)
+/// Parses one "longitude,latitude[,altitude]" tuple into the buffer
+/// @return false: Tuple is malformed
+bool KMLHelper::_parseCoordinateTuple(QStringView tuple, CoordinateBuffer_t& buffer)
 {
-    errorString.clear();
-    vertices.clear();
-
-    QDomDocument domDocument = KMLHelper::_loadFile(kmlFile, errorString);
-    if (!errorString.isEmpty()) {
+    const qsizetype firstComma = tuple.indexOf(QLatin1Char(','));
+    if (firstComma < 0) {
         return false;
     }
-
-    QDomNodeList rgNodes = domDocument.elementsByTagName("Polygon");
-    if (rgNodes.count() == 0) {
-        errorString = QString(_errorPrefix).arg(tr("Unable to find Polygon node in KML"));
-        return false;
+    qsizetype secondComma = tuple.indexOf(QLatin1Char(','), firstComma + 1);
+    if (secondComma < 0) {
+        secondComma = tuple.length();
     }
 
-    QDomNode coordinatesNode = rgNodes.item(0).namedItem("outerBoundaryIs").namedItem("LinearRing").namedItem("coordinates");
-    if (coordinatesNode.isNull()) {
-        errorString = QString(_errorPrefix).arg(tr("Internal error: Unable to find coordinates node in KML"));
+    bool longitudeOk, latitudeOk;
+    const QLocale cLocale = QLocale::c();
+    const double longitude = cLocale.toDouble(tuple.first(firstComma), &longitudeOk);
+    const double latitude = cLocale.toDouble(tuple.sliced(firstComma + 1, secondComma - firstComma - 1), &latitudeOk);
+    if (!longitudeOk || !latitudeOk) {
         return false;
     }
 
-    QString coordinatesString = coordinatesNode.toElement().text().simplified();
-    QStringList rgCoordinateStrings = coordinatesString.split(" ");
+    buffer.latitudes.append(latitude);
+    buffer.longitudes.append(longitude);
+    buffer.parsedCount++;
 
-    QList<QGeoCoordinate> rgCoords;
-    for (int i=0; i<rgCoordinateStrings.count()-1; i++) {
-        QString coordinateString = rgCoordinateStrings[i];
+    return true;
+}
 
-        QStringList rgValueStrings = coordinateString.split(",");
+/// Parses the text of a coordinates element, which may arrive in several chunks
+///     @param final true: No more text follows, a pending tuple is complete
+void KMLHelper::_parseCoordinateText(QStringView text, bool final, CoordinateBuffer_t& buffer)
+{
+    const qsizetype length = text.length();
+    qsizetype i = 0;
+
+    while (i < length && !buffer.error) {
+        if (text[i].isSpace()) {
+            if (!buffer.pendingTuple.isEmpty()) {
+                buffer.error = !_parseCoordinateTuple(buffer.pendingTuple, buffer);
+                buffer.pendingTuple.clear();
+            }
+            i++;
+            continue;
+        }
 
-        QGeoCoordinate coord;
-        coord.setLongitude(rgValueStrings[0].toDouble());
-        coord.setLatitude(rgValueStrings[1].toDouble());
+        qsizetype end = i;
+        while (end < length && !text[end].isSpace()) {
+            end++;
+        }
 
-        rgCoords.append(coord);
+        const QStringView tuple = text.sliced(i, end - i);
+        if (end == length && !final) {
+            buffer.pendingTuple.append(tuple);
+        } else if (!buffer.pendingTuple.isEmpty()) {
+            buffer.pendingTuple.append(tuple);
+            buffer.error = !_parseCoordinateTuple(buffer.pendingTuple, buffer);
+            buffer.pendingTuple.clear();
+        } else {
+            buffer.error = !_parseCoordinateTuple(tuple, buffer);
+        }
+        i = end;
     }
 
-    // Determine winding, reverse if needed. QGC wants clockwise winding
-    double sum = 0;
-    for (int i=0; i<rgCoords.count(); i++) {
-        QGeoCoordinate coord1 = rgCoords[i];
-        QGeoCoordinate coord2 = (i == rgCoords.count() - 1) ? rgCoords[0] : rgCoords[i+1];
+    if (final && !buffer.error && !buffer.pendingTuple.isEmpty()) {
+        buffer.error = !_parseCoordinateTuple(buffer.pendingTuple, buffer);
+        buffer.pendingTuple.clear();
+    }
+}
 
-        sum += (coord2.longitude() - coord1.longitude()) * (coord2.latitude() + coord1.latitude());
+/// Streams the file into buffer until the coordinates element at elementPath has been read. The first element of the
+/// path may be anywhere in the document, the following ones must be direct children of the previous one.
+bool KMLHelper::_readCoordinates(const QString& kmlFile, const QStringList& elementPath, CoordinateBuffer_t& buffer, QString& errorString, const std::function<bool(double)>& progress)
+{
+    QFile file;
+    if (!_openFile(kmlFile, file, errorString)) {
+        return false;
     }
-    bool reverse = sum < 0.0;
-    if (reverse) {
-        QList<QGeoCoordinate> rgReversed;
 
-        for (int i=0; i<rgCoords.count(); i++) {
-            rgReversed.prepend(rgCoords[i]);
+    const double fileSize = qMax(file.size(), static_cast<qint64>(1));
+    double reportedFraction = 0;
+
+    QList<int> matchedDepths;   // Element depth of each matched path element
+    int depth = 0;
+
+    QXmlStreamReader xml(&file);
+    while (!xml.atEnd()) {
+        const QXmlStreamReader::TokenType token = xml.readNext();
+
+        if (token == QXmlStreamReader::StartElement) {
+            depth++;
+            const int matchedCount = matchedDepths.count();
+            if (matchedCount == 0) {
+                if (xml.name() == elementPath[0]) {
+                    matchedDepths.append(depth);
+                }
+            } else if (matchedCount < elementPath.count() && depth == matchedDepths.last() + 1 && xml.name() == elementPath[matchedCount]) {
+                matchedDepths.append(depth);
+            }
+        } else if (token == QXmlStreamReader::EndElement) {
+            if (!matchedDepths.isEmpty() && depth == matchedDepths.last()) {
+                if (matchedDepths.count() == elementPath.count()) {
+                    _parseCoordinateText(QStringView(), true /* final */, buffer);
+                    break;
+                } else if (matchedDepths.count() == 1) {
+                    errorString = QString(_errorPrefix).arg(tr("Internal error: Unable to find coordinates node in KML"));
+                    return false;
+                }
+                matchedDepths.removeLast();
+            }
+            depth--;
+        } else if (token == QXmlStreamReader::Characters && matchedDepths.count() == elementPath.count()) {
+            _parseCoordinateText(xml.text(), false /* final */, buffer);
+            PolylineSimplifier::reduceStreamingBuffer(buffer.latitudes, buffer.longitudes, buffer.vertexBudget);
+        }
+
+        if (buffer.error) {
+            errorString = QString(_errorPrefix).arg(tr("Invalid coordinates in KML file: %1 line: %2").arg(kmlFile).arg(xml.lineNumber()));
+            return false;
         }
-        rgCoords = rgReversed;
+
+        if (progress) {
+            const double fraction = file.pos() / fileSize;
+            if (fraction - reportedFraction >= 0.01) {
+                reportedFraction = fraction;
+                if (!progress(fraction)) {
+                    errorString = QString(_errorPrefix).arg(tr("Load cancelled."));
+                    return false;
+                }
+            }
+        }
+    }
+
+    if (xml.hasError()) {
+        errorString = _xmlErrorString(kmlFile, xml);
+        return false;
     }
 
-    vertices = rgCoords;
+    if (matchedDepths.isEmpty()) {
+        errorString = QString(_errorPrefix).arg(tr("Unable to find %1 node in KML").arg(elementPath[0]));
+        return false;
+    }
+
+    if (progress && !progress(1.0)) {
+        errorString = QString(_errorPrefix).arg(tr("Load cancelled."));
+        return false;
+    }
 
     return true;
 }
 
-bool KMLHelper::loadPolylineFromFile(const QString& kmlFile, QList<QGeoCoordinate>& coords, QString& errorString)
+void KMLHelper::_coordinatesFromBuffer(const CoordinateBuffer_t& buffer, QList<QGeoCoordinate>& coords)
 {
-    errorString.clear();
     coords.clear();
+    coords.reserve(buffer.latitudes.count());
+    for (qsizetype i=0; i<buffer.latitudes.count(); i++) {
+        coords.append(QGeoCoordinate(buffer.latitudes[i], buffer.longitudes[i]));
+    }
+}
+
+bool KMLHelper::loadPolygonFromFile(const QString& kmlFile, QList<QGeoCoordinate>& vertices, QString& errorString, int vertexBudget, qsizetype* sourceVertexCount, const std::function<bool(double)>& progress)
+{
+    errorString.clear();
+    vertices.clear();
 
-    QDomDocument domDocument = KMLHelper::_loadFile(kmlFile, errorString);
-    if (!errorString.isEmpty()) {
+    CoordinateBuffer_t buffer = { {}, {}, QString(), 0, vertexBudget, false };
+    static const QStringList elementPath = { QStringLiteral("Polygon"), QStringLiteral("outerBoundaryIs"), QStringLiteral("LinearRing"), QStringLiteral("coordinates") };
+    if (!_readCoordinates(kmlFile, elementPath, buffer, errorString, progress)) {
         return false;
     }
 
-    QDomNodeList rgNodes = domDocument.elementsByTagName("LineString");
-    if (rgNodes.count() == 0) {
-        errorString = QString(_errorPrefix).arg(tr("Unable to find LineString node in KML"));
-        return false;
+    // The ring repeats the first vertex at the end
+    if (!buffer.latitudes.isEmpty()) {
+        buffer.latitudes.removeLast();
+        buffer.longitudes.removeLast();
+        buffer.parsedCount--;
     }
 
-    QDomNode coordinatesNode = rgNodes.item(0).namedItem("coordinates");
-    if (coordinatesNode.isNull()) {
-        errorString = QString(_errorPrefix).arg(tr("Internal error: Unable to find coordinates node in KML"));
-        return false;
+    // Determine winding, reverse if needed. QGC wants clockwise winding
+    double sum = 0;
+    const qsizetype count = buffer.latitudes.count();
+    for (qsizetype i=0; i<count; i++) {
+        const qsizetype j = (i == count - 1) ? 0 : i + 1;
+        sum += (buffer.longitudes[j] - buffer.longitudes[i]) * (buffer.latitudes[j] + buffer.latitudes[i]);
+    }
+    if (sum < 0.0) {
+        std::reverse(buffer.latitudes.begin(), buffer.latitudes.end());
+        std::reverse(buffer.longitudes.begin(), buffer.longitudes.end());
+    }
+
+    if (vertexBudget > 0) {
+        PolylineSimplifier::simplifyToVertexBudget(buffer.latitudes, buffer.longitudes, vertexBudget, true /* closed */);
     }
 
-    QString coordinatesString = coordinatesNode.toElement().text().simplified();
-    QStringList rgCoordinateStrings = coordinatesString.split(" ");
+    _coordinatesFromBuffer(buffer, vertices);
+    if (sourceVertexCount) {
+        *sourceVertexCount = buffer.parsedCount;
+    }
 
-    QList<QGeoCoordinate> rgCoords;
-    for (int i=0; i<rgCoordinateStrings.count()-1; i++) {
-        QString coordinateString = rgCoordinateStrings[i];
+    return true;
+}
 
-        QStringList rgValueStrings = coordinateString.split(",");
+bool KMLHelper::loadPolylineFromFile(const QString& kmlFile, QList<QGeoCoordinate>& coords, QString& errorString, int vertexBudget, qsizetype* sourceVertexCount, const std::function<bool(double)>& progress)
+{
+    errorString.clear();
+    coords.clear();
 
-        QGeoCoordinate coord;
-        coord.setLongitude(rgValueStrings[0].toDouble());
-        coord.setLatitude(rgValueStrings[1].toDouble());
+    CoordinateBuffer_t buffer = { {}, {}, QString(), 0, vertexBudget, false };
+    static const QStringList elementPath = { QStringLiteral("LineString"), QStringLiteral("coordinates") };
+    if (!_readCoordinates(kmlFile, elementPath, buffer, errorString, progress)) {
+        return false;
+    }
 
-        rgCoords.append(coord);
+    if (vertexBudget > 0) {
+        PolylineSimplifier::simplifyToVertexBudget(buffer.latitudes, buffer.longitudes, vertexBudget, false /* closed */);
     }
 
-    coords = rgCoords;
+    _coordinatesFromBuffer(buffer, coords);
+    if (sourceVertexCount) {
+        *sourceVertexCount = buffer.parsedCount;
+    }
 
     return true;
 }
@@ -10,23 +10,50 @@
 #pragma once
 
 #include <QtCore/QObject>
-#include <QtXml/QDomDocument>
 #include <QtCore/QList>
+#include <QtCore/QStringList>
+#include <QtCore/QStringView>
 #include <QtPositioning/QGeoCoordinate>
 
+#include <functional>
+
 #include "ShapeFileHelper.h"
 
+class QFile;
+class QXmlStreamReader;
+
+/// KML files are read with QXmlStreamReader and coordinates are parsed as they stream in, so large files are never
+/// held in memory as a whole. Only the first Polygon or LineString of the file is loaded.
 class KMLHelper : public QObject
 {
     Q_OBJECT
 
 public:
     static ShapeFileHelper::ShapeType determineShapeType(const QString& kmlFile, QString& errorString);
-    static bool loadPolygonFromFile(const QString& kmlFile, QList<QGeoCoordinate>& vertices, QString& errorString);
-    static bool loadPolylineFromFile(const QString& kmlFile, QList<QGeoCoordinate>& coords, QString& errorString);
+
+    /// @param vertexBudget Simplify to at most this many vertices, 0 to keep all
+    /// @param sourceVertexCount[out] Number of vertices in the file before simplification, may be nullptr
+    /// @param progress Called with the fraction of the file read so far, returning false cancels the load
+    static bool loadPolygonFromFile(const QString& kmlFile, QList<QGeoCoordinate>& vertices, QString& errorString, int vertexBudget = 0, qsizetype* sourceVertexCount = nullptr, const std::function<bool(double)>& progress = nullptr);
+    static bool loadPolylineFromFile(const QString& kmlFile, QList<QGeoCoordinate>& coords, QString& errorString, int vertexBudget = 0, qsizetype* sourceVertexCount = nullptr, const std::function<bool(double)>& progress = nullptr);
 
 private:
-    static QDomDocument _loadFile(const QString& kmlFile, QString& errorString);
+    /// Streaming parser state for the text of a coordinates element
+    typedef struct {
+        QList<double>   latitudes;
+        QList<double>   longitudes;
+        QString         pendingTuple;   ///< Tuple split across two chunks of text
+        qsizetype       parsedCount;    ///< Tuples parsed, including those already simplified away
+        int             vertexBudget;
+        bool            error;
+    } CoordinateBuffer_t;
+
+    static bool _openFile                       (const QString& kmlFile, QFile& file, QString& errorString);
+    static bool _readCoordinates                (const QString& kmlFile, const QStringList& elementPath, CoordinateBuffer_t& buffer, QString& errorString, const std::function<bool(double)>& progress);
+    static void _parseCoordinateText            (QStringView text, bool final, CoordinateBuffer_t& buffer);
+    static bool _parseCoordinateTuple           (QStringView tuple, CoordinateBuffer_t& buffer);
+    static void _coordinatesFromBuffer          (const CoordinateBuffer_t& buffer, QList<QGeoCoordinate>& coords);
+    static QString _xmlErrorString              (const QString& kmlFile, const QXmlStreamReader& xml);
 
     static constexpr const char* _errorPrefix = QT_TR_NOOP("KML file load failed. %1");
 };
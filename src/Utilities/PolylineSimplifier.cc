@@ -0,0 +1,125 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "PolylineSimplifier.h"
+
+#include <QtCore/QtMath>
+
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+void PolylineSimplifier::simplifyToVertexBudget(QList<double>& latitudes, QList<double>& longitudes, qsizetype vertexBudget, bool closed)
+{
+    Q_ASSERT(latitudes.count() == longitudes.count());
+
+    const qsizetype count = latitudes.count();
+    vertexBudget = qMax(vertexBudget, static_cast<qsizetype>(closed ? 3 : 2));
+    if (count <= vertexBudget) {
+        return;
+    }
+
+    // Areas are only compared with each other, so a local equirectangular frame is good enough
+    const double longitudeScale = qCos(qDegreesToRadians(latitudes[0]));
+    const double infiniteArea = std::numeric_limits<double>::infinity();
+
+    QList<qsizetype> previous(count);
+    QList<qsizetype> next(count);
+    for (qsizetype i=0; i<count; i++) {
+        previous[i] = i - 1;
+        next[i] = i + 1;
+    }
+    if (closed) {
+        previous[0] = count - 1;
+        next[count - 1] = 0;
+    }
+
+    const auto triangleArea = [&](qsizetype i) {
+        const qsizetype a = previous[i];
+        const qsizetype b = next[i];
+        if (a < 0 || b >= count) {
+            return infiniteArea;
+        }
+        const double ax = (longitudes[a] - longitudes[i]) * longitudeScale;
+        const double ay = latitudes[a] - latitudes[i];
+        const double bx = (longitudes[b] - longitudes[i]) * longitudeScale;
+        const double by = latitudes[b] - latitudes[i];
+        return qAbs((ax * by) - (ay * bx)) / 2.0;
+    };
+
+    // Min heap of (area, vertex). Entries are not updated in place, stale ones are skipped when popped.
+    typedef std::pair<double, qsizetype> HeapEntry_t;
+    std::priority_queue<HeapEntry_t, std::vector<HeapEntry_t>, std::greater<HeapEntry_t>> heap;
+
+    QList<double> areas(count);
+    QList<bool> removed(count, false);
+    for (qsizetype i=0; i<count; i++) {
+        areas[i] = triangleArea(i);
+        heap.push({ areas[i], i });
+    }
+
+    qsizetype remaining = count;
+    while (remaining > vertexBudget && !heap.empty()) {
+        const HeapEntry_t entry = heap.top();
+        heap.pop();
+
+        const qsizetype i = entry.second;
+        if (removed[i] || entry.first != areas[i]) {
+            continue;
+        }
+        if (qIsInf(entry.first)) {
+            break;
+        }
+
+        removed[i] = true;
+        remaining--;
+
+        const qsizetype a = previous[i];
+        const qsizetype b = next[i];
+        if (a >= 0) {
+            next[a] = b;
+        }
+        if (b < count) {
+            previous[b] = a;
+        }
+
+        // A neighbour never gets a smaller area than the vertex removed before it, which keeps the removal order stable
+        for (const qsizetype neighbour : { a, b }) {
+            if (neighbour >= 0 && neighbour < count) {
+                areas[neighbour] = qMax(triangleArea(neighbour), entry.first);
+                heap.push({ areas[neighbour], neighbour });
+            }
+        }
+    }
+
+    qsizetype kept = 0;
+    for (qsizetype i=0; i<count; i++) {
+        if (!removed[i]) {
+            latitudes[kept] = latitudes[i];
+            longitudes[kept] = longitudes[i];
+            kept++;
+        }
+    }
+    latitudes.resize(kept);
+    longitudes.resize(kept);
+}
+
+void PolylineSimplifier::reduceStreamingBuffer(QList<double>& latitudes, QList<double>& longitudes, qsizetype vertexBudget)
+{
+    if (vertexBudget <= 0) {
+        return;
+    }
+
+    // Reducing to twice the budget leaves room for the final pass to pick the best vertices across the whole file
+    if (latitudes.count() >= qMax(vertexBudget * 4, _minStreamingBufferCount)) {
+        simplifyToVertexBudget(latitudes, longitudes, vertexBudget * 2, false /* closed */);
+    }
+}
@@ -0,0 +1,31 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QList>
+
+/// Reduces the vertex count of polylines and polygon rings held as flat latitude/longitude buffers. Uses
+/// Visvalingam-Whyatt: the vertex which forms the smallest triangle with its neighbours is removed until the vertex
+/// budget is met, so the result keeps the vertices which contribute most to the shape.
+class PolylineSimplifier
+{
+public:
+    /// Simplifies in place to at most vertexBudget vertices
+    ///     @param closed true: Polygon ring, any vertex may go. false: Polyline, the end points are kept
+    static void simplifyToVertexBudget(QList<double>& latitudes, QList<double>& longitudes, qsizetype vertexBudget, bool closed);
+
+    /// Keeps a buffer which is filled while streaming a file within a few times the vertex budget, so that the whole
+    /// file never has to be held in memory. The buffer is treated as a polyline so the first and last vertex stay put.
+    /// Does nothing if vertexBudget is 0.
+    static void reduceStreamingBuffer(QList<double>& latitudes, QList<double>& longitudes, qsizetype vertexBudget);
+
+private:
+    static constexpr qsizetype _minStreamingBufferCount = 65536;
+};
@@ -8,11 +8,14 @@
  ****************************************************************************/
 
 #include "SHPFileHelper.h"
+#include "PolylineSimplifier.h"
 #include "QGCGeo.h"
 
 #include <QtCore/QFile>
 #include <QtCore/QDebug>
 #include <QtCore/QRegularExpression>
+#include <QtCore/QtEndian>
+#include <QtCore/QtMath>
 
 /// Validates the specified SHP file is truly a SHP file and is in the format we understand.
 ///     @param utmZone[out] Zone for UTM shape, 0 for lat/lon shape
@@ -108,71 +111,182 @@ ShapeFileHelper::ShapeType SHPFileHelper::determineShapeType(const QString& shpF
     return shapeType;
 }
 
-bool SHPFileHelper::loadPolygonFromFile(const QString& shpFile, QList<QGeoCoordinate>& vertices, QString& errorString)
+/// Reads the first record of the shape file in blocks, so that only the coordinates are held in memory rather than
+/// the whole record plus a copy of it as read by SHPReadObject.
+///     @param utmZone Zone for UTM shape, 0 for lat/lon shape
+///     @param recordPointCount[out] Number of points in the record
+bool SHPFileHelper::_readPolygonRecord(const QString& shpFile, int utmZone, bool utmSouthernHemisphere, int vertexBudget, QList<double>& latitudes, QList<double>& longitudes, qsizetype& recordPointCount, QString& errorString, const std::function<bool(double)>& progress)
+{
+    static constexpr int recordHeaderSize =     8;
+    static constexpr int shapeTypeSize =        4;
+    static constexpr int polygonHeaderSize =    44;     // Shape type, bounding box, part count, point count
+    static constexpr int pointSize =            16;
+
+    QFile file(shpFile);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(_firstRecordOffset)) {
+        errorString = QString(_errorPrefix).arg(tr("SHP file open failed: %1").arg(file.errorString()));
+        return false;
+    }
+
+    // The file header only states the shape type of the file, each record carries its own which may be a null shape
+    QByteArray recordHeader = file.read(recordHeaderSize + shapeTypeSize);
+    if (recordHeader.size() != recordHeaderSize + shapeTypeSize) {
+        errorString = QString(_errorPrefix).arg(tr("File is truncated."));
+        return false;
+    }
+    if (qFromLittleEndian<qint32>(recordHeader.constData() + recordHeaderSize) != SHPT_POLYGON) {
+        errorString = QString(_errorPrefix).arg(tr("File does not contain a polygon."));
+        return false;
+    }
+
+    recordHeader.append(file.read(polygonHeaderSize - shapeTypeSize));
+    if (recordHeader.size() != recordHeaderSize + polygonHeaderSize) {
+        errorString = QString(_errorPrefix).arg(tr("File is truncated."));
+        return false;
+    }
+
+    // Record header is big endian with the length in 16 bit words, record content is little endian
+    const uchar* header = reinterpret_cast<const uchar*>(recordHeader.constData());
+    const qint64 contentSize = static_cast<qint64>(qFromBigEndian<qint32>(header + 4)) * 2;
+    const qint32 partCount = qFromLittleEndian<qint32>(header + recordHeaderSize + 36);
+    const qint32 pointCount = qFromLittleEndian<qint32>(header + recordHeaderSize + 40);
+
+    if (partCount != 1) {
+        errorString = QString(_errorPrefix).arg(tr("Only single part polygons are supported."));
+        return false;
+    }
+    if (pointCount <= 0 || contentSize < polygonHeaderSize + (partCount * 4) + (static_cast<qint64>(pointCount) * pointSize)) {
+        errorString = QString(_errorPrefix).arg(tr("Invalid polygon record."));
+        return false;
+    }
+    recordPointCount = pointCount;
+    if (!file.skip(partCount * 4)) {
+        errorString = QString(_errorPrefix).arg(tr("File is truncated."));
+        return false;
+    }
+
+    QList<double> eastings(_readBlockVertexCount);
+    QList<double> northings(_readBlockVertexCount);
+    QList<double> blockLatitudes(_readBlockVertexCount);
+    QList<double> blockLongitudes(_readBlockVertexCount);
+
+    latitudes.reserve(vertexBudget > 0 ? qMin(pointCount, vertexBudget * 4) : pointCount);
+    longitudes.reserve(latitudes.capacity());
+
+    for (qint32 blockStart=0; blockStart<pointCount; blockStart+=_readBlockVertexCount) {
+        const int blockCount = qMin(_readBlockVertexCount, pointCount - blockStart);
+        const QByteArray block = file.read(static_cast<qint64>(blockCount) * pointSize);
+        if (block.size() != blockCount * pointSize) {
+            errorString = QString(_errorPrefix).arg(tr("File is truncated."));
+            return false;
+        }
+
+        const uchar* points = reinterpret_cast<const uchar*>(block.constData());
+        for (int i=0; i<blockCount; i++) {
+            eastings[i] = qFromLittleEndian<double>(points + (i * pointSize));
+            northings[i] = qFromLittleEndian<double>(points + (i * pointSize) + 8);
+        }
+
+        if (!utmZone || !QGCGeo::convertUTMToGeo(eastings.constData(), northings.constData(), utmZone, utmSouthernHemisphere, blockLatitudes.data(), blockLongitudes.data(), blockCount)) {
+            for (int i=0; i<blockCount; i++) {
+                QGeoCoordinate coord;
+                if (!utmZone || !QGCGeo::convertUTMToGeo(eastings[i], northings[i], utmZone, utmSouthernHemisphere, coord)) {
+                    coord.setLatitude(northings[i]);
+                    coord.setLongitude(eastings[i]);
+                }
+                blockLatitudes[i] = coord.latitude();
+                blockLongitudes[i] = coord.longitude();
+            }
+        }
+
+        latitudes.append(blockLatitudes.first(blockCount));
+        longitudes.append(blockLongitudes.first(blockCount));
+        PolylineSimplifier::reduceStreamingBuffer(latitudes, longitudes, vertexBudget);
+
+        if (progress && !progress(static_cast<double>(blockStart + blockCount) / pointCount)) {
+            errorString = QString(_errorPrefix).arg(tr("Load cancelled."));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Great circle distance in meters, same as QGeoCoordinate::distanceTo without creating coordinates
+double SHPFileHelper::_distance(double latitude1, double longitude1, double latitude2, double longitude2)
+{
+    static constexpr double earthMeanRadius = 6371007.2;
+
+    const double dLatitude = qDegreesToRadians(latitude2 - latitude1);
+    const double dLongitude = qDegreesToRadians(longitude2 - longitude1);
+    const double haversineDLatitude = qSin(dLatitude / 2.0) * qSin(dLatitude / 2.0);
+    const double haversineDLongitude = qSin(dLongitude / 2.0) * qSin(dLongitude / 2.0);
+    const double y = haversineDLatitude + (qCos(qDegreesToRadians(latitude1)) * qCos(qDegreesToRadians(latitude2)) * haversineDLongitude);
+    const double x = 2 * qAsin(qSqrt(y));
+
+    return x * earthMeanRadius;
+}
+
+bool SHPFileHelper::loadPolygonFromFile(const QString& shpFile, QList<QGeoCoordinate>& vertices, QString& errorString, int vertexBudget, qsizetype* sourceVertexCount, const std::function<bool(double)>& progress)
 {
     int         utmZone = 0;
     bool        utmSouthernHemisphere;
     double      vertexFilterMeters = 5;
-    SHPHandle   shpHandle = Q_NULLPTR;
-    SHPObject*  shpObject = Q_NULLPTR;
 
     errorString.clear();
     vertices.clear();
 
-    shpHandle = SHPFileHelper::_loadShape(shpFile, &utmZone, &utmSouthernHemisphere, errorString);
+    SHPHandle shpHandle = SHPFileHelper::_loadShape(shpFile, &utmZone, &utmSouthernHemisphere, errorString);
     if (!errorString.isEmpty()) {
-        goto Error;
+        return false;
     }
 
     int cEntities, shapeType;
     SHPGetInfo(shpHandle, &cEntities, &shapeType, Q_NULLPTR /* padfMinBound */, Q_NULLPTR /* padfMaxBound */);
+    SHPClose(shpHandle);
     if (shapeType != SHPT_POLYGON) {
         errorString = QString(_errorPrefix).arg(tr("File does not contain a polygon."));
-        goto Error;
-    }
-
-    shpObject = SHPReadObject(shpHandle, 0);
-    if (shpObject->nParts != 1) {
-        errorString = QString(_errorPrefix).arg(tr("Only single part polygons are supported."));
-        goto Error;
+        return false;
     }
 
-    for (int i=0; i<shpObject->nVertices; i++) {
-        QGeoCoordinate coord;
-        if (!utmZone || !QGCGeo::convertUTMToGeo(shpObject->padfX[i], shpObject->padfY[i], utmZone, utmSouthernHemisphere, coord)) {
-            coord.setLatitude(shpObject->padfY[i]);
-            coord.setLongitude(shpObject->padfX[i]);
-        }
-        vertices.append(coord);
+    QList<double> latitudes;
+    QList<double> longitudes;
+    qsizetype recordPointCount;
+    if (!_readPolygonRecord(shpFile, utmZone, utmSouthernHemisphere, vertexBudget, latitudes, longitudes, recordPointCount, errorString, progress)) {
+        return false;
     }
 
     // Filter last vertex such that it differs from first
-    {
-        QGeoCoordinate firstVertex = vertices[0];
+    qsizetype count = latitudes.count();
+    while (count > 3 && _distance(latitudes[count - 1], longitudes[count - 1], latitudes[0], longitudes[0]) < vertexFilterMeters) {
+        count--;
+    }
 
-        while (vertices.count() > 3 && vertices.last().distanceTo(firstVertex) < vertexFilterMeters) {
-            vertices.removeLast();
+    // Filter vertex distances to be larger than vertexFilterMeters apart, the last vertex is always kept
+    qsizetype kept = 1;
+    for (qsizetype i=1; i<count; i++) {
+        if (i == count - 1 || _distance(latitudes[kept - 1], longitudes[kept - 1], latitudes[i], longitudes[i]) >= vertexFilterMeters) {
+            latitudes[kept] = latitudes[i];
+            longitudes[kept] = longitudes[i];
+            kept++;
         }
     }
+    latitudes.resize(kept);
+    longitudes.resize(kept);
 
-    // Filter vertex distances to be larger than 1 meter apart
-    {
-        int i = 0;
-        while (i < vertices.count() - 2) {
-            if (vertices[i].distanceTo(vertices[i+1]) < vertexFilterMeters) {
-                vertices.removeAt(i+1);
-            } else {
-                i++;
-            }
-        }
+    if (vertexBudget > 0) {
+        PolylineSimplifier::simplifyToVertexBudget(latitudes, longitudes, vertexBudget, true /* closed */);
     }
 
-Error:
-    if (shpObject) {
-        SHPDestroyObject(shpObject);
+    vertices.reserve(latitudes.count());
+    for (qsizetype i=0; i<latitudes.count(); i++) {
+        vertices.append(QGeoCoordinate(latitudes[i], longitudes[i]));
     }
-    if (shpHandle) {
-        SHPClose(shpHandle);
+
+    // The ring repeats the first vertex at the end
+    if (sourceVertexCount) {
+        *sourceVertexCount = recordPointCount - 1;
     }
-    return errorString.isEmpty();
+
+    return true;
 }
@@ -17,6 +17,8 @@
 #include <QtCore/QList>
 #include <QtPositioning/QGeoCoordinate>
 
+#include <functional>
+
 /// The QGCMapPolygon class provides a polygon which can be displayed on a map using a map visuals control.
 /// It maintains a representation of the polygon on QVariantList and QmlObjectListModel format.
 class SHPFileHelper : public QObject
@@ -25,11 +27,20 @@ class SHPFileHelper : public QObject
 
 public:
     static ShapeFileHelper::ShapeType determineShapeType(const QString& shpFile, QString& errorString);
-    static bool loadPolygonFromFile(const QString& shpFile, QList<QGeoCoordinate>& vertices, QString& errorString);
+
+    /// @param vertexBudget Simplify to at most this many vertices, 0 to keep all
+    /// @param sourceVertexCount[out] Number of vertices in the file before simplification, may be nullptr
+    /// @param progress Called with the fraction of the polygon read so far, returning false cancels the load
+    static bool loadPolygonFromFile(const QString& shpFile, QList<QGeoCoordinate>& vertices, QString& errorString, int vertexBudget = 0, qsizetype* sourceVertexCount = nullptr, const std::function<bool(double)>& progress = nullptr);
 
 private:
     static bool         _validateSHPFiles(const QString& shpFile, int* utmZone, bool* utmSouthernHemisphere, QString& errorString);
     static SHPHandle    _loadShape(const QString& shpFile, int* utmZone, bool* utmSouthernHemisphere, QString& errorString);
+    static bool         _readPolygonRecord(const QString& shpFile, int utmZone, bool utmSouthernHemisphere, int vertexBudget, QList<double>& latitudes, QList<double>& longitudes, qsizetype& recordPointCount, QString& errorString, const std::function<bool(double)>& progress);
+    static double       _distance(double latitude1, double longitude1, double latitude2, double longitude2);
+
+    static constexpr qint64 _firstRecordOffset =    100;    ///< Records follow the fixed size file header
+    static constexpr int    _readBlockVertexCount = 4096;
 
     static constexpr const char* _errorPrefix = QT_TR_NOOP("SHP file load failed. %1");
 };
@@ -57,7 +57,7 @@ ShapeFileHelper::ShapeType ShapeFileHelper::determineShapeType(const QString& fi
     return shapeType;
 }
 
-bool ShapeFileHelper::loadPolygonFromFile(const QString& file, QList<QGeoCoordinate>& vertices, QString& errorString)
+bool ShapeFileHelper::loadPolygonFromFile(const QString& file, QList<QGeoCoordinate>& vertices, QString& errorString, int vertexBudget, qsizetype* sourceVertexCount, const std::function<bool(double)>& progress)
 {
     bool success = false;
 
@@ -67,16 +67,16 @@ bool ShapeFileHelper::loadPolygonFromFile(const QString& file, QList<QGeoCoordin
     bool fileIsKML = _fileIsKML(file, errorString);
     if (errorString.isEmpty()) {
         if (fileIsKML) {
-            success = KMLHelper::loadPolygonFromFile(file, vertices, errorString);
+            success = KMLHelper::loadPolygonFromFile(file, vertices, errorString, vertexBudget, sourceVertexCount, progress);
         } else {
-            success = SHPFileHelper::loadPolygonFromFile(file, vertices, errorString);
+            success = SHPFileHelper::loadPolygonFromFile(file, vertices, errorString, vertexBudget, sourceVertexCount, progress);
         }
     }
 
     return success;
 }
 
-bool ShapeFileHelper::loadPolylineFromFile(const QString& file, QList<QGeoCoordinate>& coords, QString& errorString)
+bool ShapeFileHelper::loadPolylineFromFile(const QString& file, QList<QGeoCoordinate>& coords, QString& errorString, int vertexBudget, qsizetype* sourceVertexCount, const std::function<bool(double)>& progress)
 {
     errorString.clear();
     coords.clear();
@@ -84,7 +84,7 @@ bool ShapeFileHelper::loadPolylineFromFile(const QString& file, QList<QGeoCoordi
     bool fileIsKML = _fileIsKML(file, errorString);
     if (errorString.isEmpty()) {
         if (fileIsKML) {
-            KMLHelper::loadPolylineFromFile(file, coords, errorString);
+            KMLHelper::loadPolylineFromFile(file, coords, errorString, vertexBudget, sourceVertexCount, progress);
         } else {
             errorString = QString(_errorPrefix).arg(tr("Polyline not support from SHP files."));
         }
@@ -14,6 +14,8 @@
 #include <QtCore/QVariant>
 #include <QtPositioning/QGeoCoordinate>
 
+#include <functional>
+
 /// Routines for loading polygons or polylines from KML or SHP files.
 class ShapeFileHelper : public QObject
 {
@@ -38,8 +40,15 @@ public:
     QStringList fileDialogKMLOrSHPFilters   (void) const;
 
     static ShapeType determineShapeType(const QString& file, QString& errorString);
-    static bool loadPolygonFromFile(const QString& file, QList<QGeoCoordinate>& vertices, QString& errorString);
-    static bool loadPolylineFromFile(const QString& file, QList<QGeoCoordinate>& coords, QString& errorString);
+
+    /// Files are streamed, so large files can be loaded without holding them in memory as a whole.
+    ///     @param vertexBudget Simplify to at most this many vertices while loading, 0 to keep all
+    ///     @param sourceVertexCount[out] Number of vertices in the file before simplification, may be nullptr
+    ///     @param progress Called from the loading thread with the fraction loaded so far, returning false cancels the load
+    static bool loadPolygonFromFile(const QString& file, QList<QGeoCoordinate>& vertices, QString& errorString, int vertexBudget = 0, qsizetype* sourceVertexCount = nullptr, const std::function<bool(double)>& progress = nullptr);
+    static bool loadPolylineFromFile(const QString& file, QList<QGeoCoordinate>& coords, QString& errorString, int vertexBudget = 0, qsizetype* sourceVertexCount = nullptr, const std::function<bool(double)>& progress = nullptr);
+
+    static constexpr int simplifiedVertexBudget = 5000;   ///< Vertex budget used when simplifying imported shapes is enabled
 
 private:
     static bool _fileIsKML(const QString& file, QString& errorString);
@@ -10,10 +10,16 @@
 #include "TerrainProtocolHandler.h"
 #include "TerrainQuery.h"
 #include "Vehicle.h"
+#include "MissionManager.h"
+#include "MissionItem.h"
 #include "MAVLinkProtocol.h"
+#include "SettingsManager.h"
+#include "FlightMapSettings.h"
+#include "Fact.h"
 #include "QGCLoggingCategory.h"
 
 #include <QtCore/QTimer>
+#include <QtCore/QtMath>
 
 QGC_LOGGING_CATEGORY(TerrainProtocolHandlerLog, "qgc.vehicle.terrainprotocolhandler")
 
@@ -22,12 +28,20 @@ TerrainProtocolHandler::TerrainProtocolHandler(Vehicle *vehicle, TerrainFactGrou
     , _vehicle(vehicle)
     , _terrainFactGroup(terrainFactGroup)
     , _terrainDataSendTimer(new QTimer(this))
+    , _blockCache(kMaxCachedBlocks)
 {
     // qCDebug(TerrainProtocolHandlerLog) << Q_FUNC_INFO << this;
 
     _terrainDataSendTimer->setSingleShot(false);
-    _terrainDataSendTimer->setInterval(1000.0/12.0);
+    _terrainDataSendTimer->setInterval(kSendIntervalMsecs);
     (void) connect(_terrainDataSendTimer, &QTimer::timeout, this, &TerrainProtocolHandler::_sendNextTerrainData);
+
+    (void) connect(_vehicle, &Vehicle::coordinateChanged, this, &TerrainProtocolHandler::_prefetchAroundVehicle);
+    (void) connect(_vehicle, &Vehicle::homePositionChanged, this, &TerrainProtocolHandler::_prefetchAroundVehicle);
+    (void) connect(SettingsManager::instance()->flightMapSettings()->elevationMapProvider(), &Fact::rawValueChanged, this, [this]() {
+        _blockCache.clear();
+        _erroredBlocks.clear();
+    });
 }
 
 TerrainProtocolHandler::~TerrainProtocolHandler()
@@ -44,6 +58,9 @@ bool TerrainProtocolHandler::mavlinkMessageReceived(const mavlink_message_t &mes
     case MAVLINK_MSG_ID_TERRAIN_REPORT:
         _handleTerrainReport(message);
         return false;
+    case MAVLINK_MSG_ID_RADIO_STATUS:
+        _handleRadioStatus(message);
+        return true;
     default:
         return true;
     }
@@ -51,6 +68,8 @@ bool TerrainProtocolHandler::mavlinkMessageReceived(const mavlink_message_t &mes
 
 void TerrainProtocolHandler::_handleTerrainRequest(const mavlink_message_t &message)
 {
+    _setUsesTerrainProtocol();
+
     _terrainRequestActive = true;
     mavlink_msg_terrain_request_decode(&message, &_currentTerrainRequest);
     _sendNextTerrainData();
@@ -58,6 +77,8 @@ void TerrainProtocolHandler::_handleTerrainRequest(const mavlink_message_t &mess
 
 void TerrainProtocolHandler::_handleTerrainReport(const mavlink_message_t &message)
 {
+    _setUsesTerrainProtocol();
+
     mavlink_terrain_report_t terrainReport;
     mavlink_msg_terrain_report_decode(&message, &terrainReport);
 
@@ -84,50 +105,192 @@ void TerrainProtocolHandler::_handleTerrainReport(const mavlink_message_t &messa
     }
 }
 
+void TerrainProtocolHandler::_handleRadioStatus(const mavlink_message_t &message)
+{
+    mavlink_radio_status_t radioStatus;
+    mavlink_msg_radio_status_decode(&message, &radioStatus);
+
+    _radioStatusReceived = true;
+    _radioTxBuffer = radioStatus.txbuf;
+}
+
+void TerrainProtocolHandler::_setUsesTerrainProtocol()
+{
+    if (_usesTerrainProtocol) {
+        return;
+    }
+
+    qCDebug(TerrainProtocolHandlerLog) << "Vehicle uses the terrain protocol, prefetching terrain";
+    _usesTerrainProtocol = true;
+    _prefetchAroundVehicle();
+    prefetchMission();
+}
+
+void TerrainProtocolHandler::_prefetchAroundVehicle()
+{
+    if (!_usesTerrainProtocol || _vehicle->armed()) {
+        return;
+    }
+
+    QGeoCoordinate coord = _vehicle->coordinate();
+    if (!coord.isValid()) {
+        coord = _vehicle->homePosition();
+    }
+    if (!coord.isValid()) {
+        return;
+    }
+
+    // Only prefetch again once the vehicle has moved a good part of the way towards the edge of the prefetched area
+    if (_lastPrefetchCoord.isValid() && (_lastPrefetchCoord.distanceTo(coord) < (kPrefetchRadiusMeters / 2))) {
+        return;
+    }
+
+    _lastPrefetchCoord = coord;
+    _prefetchRadius(coord, kPrefetchRadiusMeters);
+}
+
+void TerrainProtocolHandler::prefetchMission()
+{
+    if (!_usesTerrainProtocol || !_vehicle->missionManager()) {
+        return;
+    }
+
+    QList<QGeoCoordinate> waypoints;
+    for (const MissionItem *missionItem : _vehicle->missionManager()->missionItems()) {
+        switch (missionItem->frame()) {
+        case MAV_FRAME_GLOBAL:
+        case MAV_FRAME_GLOBAL_RELATIVE_ALT:
+        case MAV_FRAME_GLOBAL_INT:
+        case MAV_FRAME_GLOBAL_RELATIVE_ALT_INT:
+        case MAV_FRAME_GLOBAL_TERRAIN_ALT:
+        case MAV_FRAME_GLOBAL_TERRAIN_ALT_INT:
+            break;
+        default:
+            continue;
+        }
+
+        const QGeoCoordinate coord = missionItem->coordinate();
+        if (coord.isValid() && ((coord.latitude() != 0) || (coord.longitude() != 0))) {
+            (void) waypoints.append(coord);
+        }
+    }
+
+    if (waypoints.isEmpty()) {
+        return;
+    }
+    qCDebug(TerrainProtocolHandlerLog) << "Prefetching terrain along" << waypoints.count() << "mission waypoints";
+
+    // Overlapping squares along each leg cover a corridor of twice the half width
+    _prefetchRadius(waypoints.first(), kCorridorHalfWidthMeters);
+    for (qsizetype i = 1; i < waypoints.count(); i++) {
+        const QGeoCoordinate &fromCoord = waypoints[i - 1];
+        const QGeoCoordinate &toCoord = waypoints[i];
+        const double distance = fromCoord.distanceTo(toCoord);
+        const double azimuth = fromCoord.azimuthTo(toCoord);
+        for (double legDistance = kCorridorHalfWidthMeters; legDistance < distance; legDistance += kCorridorHalfWidthMeters) {
+            _prefetchRadius(fromCoord.atDistanceAndAzimuth(legDistance, azimuth), kCorridorHalfWidthMeters);
+        }
+        _prefetchRadius(toCoord, kCorridorHalfWidthMeters);
+    }
+}
+
+void TerrainProtocolHandler::_prefetchRadius(const QGeoCoordinate &center, double radiusMeters)
+{
+    const QGeoCoordinate swCoord(center.atDistanceAndAzimuth(radiusMeters, 180).latitude(), center.atDistanceAndAzimuth(radiusMeters, 270).longitude());
+    const QGeoCoordinate neCoord(center.atDistanceAndAzimuth(radiusMeters, 0).latitude(), center.atDistanceAndAzimuth(radiusMeters, 90).longitude());
+    TerrainAtCoordinateQuery::prefetchArea(swCoord, neCoord);
+}
+
+int TerrainProtocolHandler::_blocksPerInterval() const
+{
+    // Without a radio reporting its buffer the link is assumed to be fast (USB, network)
+    if (!_radioStatusReceived) {
+        return kMaxBlocksPerInterval;
+    }
+
+    if (_radioTxBuffer < kRadioTxBufferLowPercent) {
+        return 1;
+    }
+
+    const int freePercent = qMin(static_cast<int>(_radioTxBuffer), 100) - kRadioTxBufferLowPercent;
+    return 1 + (((kMaxBlocksPerInterval - 1) * freePercent) / (100 - kRadioTxBufferLowPercent));
+}
+
 void TerrainProtocolHandler::_sendNextTerrainData()
 {
     if (!_terrainRequestActive) {
         return;
     }
 
-    QGeoCoordinate terrainRequestCoordSWCorner(static_cast<double>(_currentTerrainRequest.lat) / 1e7, static_cast<double>(_currentTerrainRequest.lon) / 1e7);
+    const QGeoCoordinate terrainRequestCoordSWCorner(static_cast<double>(_currentTerrainRequest.lat) / 1e7, static_cast<double>(_currentTerrainRequest.lon) / 1e7);
     const int spacingBetweenGrids = _currentTerrainRequest.grid_spacing * 4;
+    const int maxBlocks = _blocksPerInterval();
 
     // Each TERRAIN_DATA sent to vehicle contains a 4x4 grid of heights
     // TERRAIN_REQUEST.mask has a bit for each entry in an 8x7 grid
     // gridBit = 0 refers to the the sw corner of the 8x7 grid
+    //
+    // All requested blocks are computed up front, which fills the block cache and queues downloads for
+    // missing terrain. Blocks which are not available yet are skipped rather than holding up the others.
 
-    bool bitFound = false;
+    int sentBlocks = 0;
     for (int rowIndex=0; rowIndex<7; rowIndex++) {
         for (int colIndex=0; colIndex<8; colIndex++) {
             const uint8_t gridBit = (rowIndex * 8) + colIndex;
             const uint64_t checkBit = 1ull << gridBit;
-            if (_currentTerrainRequest.mask & checkBit) {
-                // Move east and then north to generate the coordinate for sw corner of the specific gridBit
-                QGeoCoordinate swCorner = terrainRequestCoordSWCorner.atDistanceAndAzimuth(spacingBetweenGrids * colIndex, 90);
-                swCorner = swCorner.atDistanceAndAzimuth(spacingBetweenGrids * rowIndex, 0);
-                _sendTerrainData(swCorner, gridBit);
-                bitFound = true;
-                break;
+            if (!(_currentTerrainRequest.mask & checkBit)) {
+                continue;
             }
-        }
 
-        if (bitFound) {
-            break;
+            // Move east and then north to generate the coordinate for sw corner of the specific gridBit
+            QGeoCoordinate swCorner = terrainRequestCoordSWCorner.atDistanceAndAzimuth(spacingBetweenGrids * colIndex, 90);
+            swCorner = swCorner.atDistanceAndAzimuth(spacingBetweenGrids * rowIndex, 0);
+
+            TerrainBlock_t block;
+            if (!_terrainBlock(swCorner, block) || (sentBlocks >= maxBlocks)) {
+                continue;
+            }
+
+            // Only clear the bit once the data is sent. Otherwise it is tried again on the next timer tick
+            _sendTerrainData(block, gridBit);
+            _currentTerrainRequest.mask &= ~checkBit;
+            sentBlocks++;
         }
     }
 
-    if (bitFound) {
-        // Kick timer to send next possible TERRAIN_DATA to vehicle
-        _terrainDataSendTimer->start();
+    if (_currentTerrainRequest.mask) {
+        if (!_terrainDataSendTimer->isActive()) {
+            _terrainDataSendTimer->start();
+        }
     } else {
         _terrainRequestActive = false;
+        _terrainDataSendTimer->stop();
     }
 }
 
-void TerrainProtocolHandler::_sendTerrainData(const QGeoCoordinate &swCorner, uint8_t gridBit)
+bool TerrainProtocolHandler::_terrainBlock(const QGeoCoordinate &swCorner, TerrainBlock_t &block)
 {
+    const BlockKey_t blockKey = {
+        static_cast<qint32>(qRound64(swCorner.latitude() * 1e7)),
+        static_cast<qint32>(qRound64(swCorner.longitude() * 1e7)),
+        _currentTerrainRequest.grid_spacing
+    };
+
+    const TerrainBlock_t *const cachedBlock = _blockCache.object(blockKey);
+    if (cachedBlock) {
+        block = *cachedBlock;
+        return true;
+    }
+
+    // A failed block is not queried again on every send interval
+    const auto erroredBlock = _erroredBlocks.constFind(blockKey);
+    const bool erroredBefore = (erroredBlock != _erroredBlocks.constEnd());
+    if (erroredBefore && !erroredBlock.value().hasExpired()) {
+        return false;
+    }
+
     QList<QGeoCoordinate> coordinates;
+    coordinates.reserve(block.size());
     for (int rowIndex=0; rowIndex<4; rowIndex++) {
         for (int colIndex=0; colIndex<4; colIndex++) {
             // Move east and then north to generate the coordinate for grid point
@@ -141,23 +304,33 @@ void TerrainProtocolHandler::_sendTerrainData(const QGeoCoordinate &swCorner, ui
     bool error = false;
     QList<double> altitudes;
     if (!TerrainAtCoordinateQuery::getAltitudesForCoordinates(coordinates, altitudes, error)) {
-        return;
+        return false;
     }
 
-    if (error) {
-        qCWarning(TerrainProtocolHandlerLog) << Q_FUNC_INFO << "TerrainAtCoordinateQuery::getAltitudesForCoordinates failed";
-        return;
+    if (error || (altitudes.count() != static_cast<qsizetype>(block.size()))) {
+        if (erroredBefore) {
+            qCDebug(TerrainProtocolHandlerLog) << Q_FUNC_INFO << "TerrainAtCoordinateQuery::getAltitudesForCoordinates failed again" << swCorner;
+        } else {
+            qCWarning(TerrainProtocolHandlerLog) << Q_FUNC_INFO << "TerrainAtCoordinateQuery::getAltitudesForCoordinates failed" << swCorner;
+        }
+        if (_erroredBlocks.count() >= kMaxCachedBlocks) {
+            _erroredBlocks.clear();
+        }
+        _erroredBlocks[blockKey] = QDeadlineTimer(kErroredBlockRetryMsecs);
+        return false;
     }
+    (void) _erroredBlocks.remove(blockKey);
 
-    // Only clear the bit if the query succeeds. Otherwise just let it try again on the next timer tick
-    const uint64_t removeBit = ~(1ull << gridBit);
-    _currentTerrainRequest.mask &= removeBit;
-    int altIndex = 0;
-    int16_t terrainData[16];
-    for (const double& altitude : altitudes) {
-        terrainData[altIndex++] = static_cast<int16_t>(altitude);
+    for (size_t i = 0; i < block.size(); i++) {
+        block[i] = static_cast<int16_t>(altitudes[i]);
     }
+    (void) _blockCache.insert(blockKey, new TerrainBlock_t(block));
+
+    return true;
+}
 
+void TerrainProtocolHandler::_sendTerrainData(const TerrainBlock_t &block, uint8_t gridBit)
+{
     SharedLinkInterfacePtr sharedLink = _vehicle->vehicleLinkManager()->primaryLink().lock();
     if (sharedLink) {
         mavlink_message_t msg;
@@ -170,7 +343,7 @@ void TerrainProtocolHandler::_sendTerrainData(const QGeoCoordinate &swCorner, ui
             _currentTerrainRequest.lon,
             _currentTerrainRequest.grid_spacing,
             gridBit,
-            terrainData
+            block.data()
         );
 
         _vehicle->sendMessageOnLinkThreadSafe(sharedLink.get(), msg);
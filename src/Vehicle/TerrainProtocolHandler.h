@@ -9,10 +9,15 @@
 
 #pragma once
 
+#include <QtCore/QCache>
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QHash>
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QObject>
 #include <QtPositioning/QGeoCoordinate>
 
+#include <array>
+
 #include "MAVLinkLib.h"
 
 class QTimer;
@@ -21,6 +26,10 @@ class Vehicle;
 
 Q_DECLARE_LOGGING_CATEGORY(TerrainProtocolHandlerLog)
 
+/// Answers TERRAIN_REQUEST from the vehicle with TERRAIN_DATA. Once the vehicle has shown it uses the
+/// terrain protocol, terrain tiles around the vehicle and along the mission are prefetched while it is
+/// disarmed. Computed 4x4 blocks are kept in a block cache so that overlapping requests are answered
+/// without querying terrain again, and requested blocks are streamed as fast as the link allows.
 class TerrainProtocolHandler : public QObject
 {
     Q_OBJECT
@@ -32,17 +41,62 @@ public:
     /// @return true: Allow vehicle to continue processing, false: Vehicle should not process message
     bool mavlinkMessageReceived(const mavlink_message_t &message);
 
+    /// Prefetches terrain along the current mission of the vehicle
+    void prefetchMission();
+
 private slots:
     void _sendNextTerrainData();
+    void _prefetchAroundVehicle();
 
 private:
+    /// Grid spacing and sw corner of a 4x4 block of TERRAIN_DATA
+    struct BlockKey_t {
+        qint32 lat = 0;     ///< degE7
+        qint32 lon = 0;     ///< degE7
+        quint16 spacing = 0;
+
+        bool operator==(const BlockKey_t &other) const
+        {
+            return (lat == other.lat) && (lon == other.lon) && (spacing == other.spacing);
+        }
+
+        friend size_t qHash(const BlockKey_t &key, size_t seed = 0)
+        {
+            return qHashMulti(seed, key.lat, key.lon, key.spacing);
+        }
+    };
+    using TerrainBlock_t = std::array<int16_t, 16>;
+
     void _handleTerrainRequest(const mavlink_message_t &message);
     void _handleTerrainReport(const mavlink_message_t &message);
-    void _sendTerrainData(const QGeoCoordinate &swCorner, uint8_t gridBit);
+    void _handleRadioStatus(const mavlink_message_t &message);
+    void _setUsesTerrainProtocol();
+    /// @return false: terrain for the block is not available yet, the missing tiles are queued for download,
+    ///                or the terrain query failed recently for this block
+    bool _terrainBlock(const QGeoCoordinate &swCorner, TerrainBlock_t &block);
+    void _sendTerrainData(const TerrainBlock_t &block, uint8_t gridBit);
+    /// Number of TERRAIN_DATA messages which fit into the link budget of one send interval
+    int _blocksPerInterval() const;
+    static void _prefetchRadius(const QGeoCoordinate &center, double radiusMeters);
 
     Vehicle *_vehicle = nullptr;
     TerrainFactGroup *_terrainFactGroup = nullptr;
     QTimer *_terrainDataSendTimer = nullptr;
     bool _terrainRequestActive = false;
     mavlink_terrain_request_t _currentTerrainRequest;
+
+    bool _usesTerrainProtocol = false;      ///< Vehicle has sent TERRAIN_REQUEST or TERRAIN_REPORT
+    QGeoCoordinate _lastPrefetchCoord;
+    bool _radioStatusReceived = false;
+    uint8_t _radioTxBuffer = 100;           ///< Percentage of free space in the radio transmit buffer
+    QCache<BlockKey_t, TerrainBlock_t> _blockCache;
+    QHash<BlockKey_t, QDeadlineTimer> _erroredBlocks;   ///< Blocks whose terrain query failed, not queried again before the deadline
+
+    static constexpr int kSendIntervalMsecs = 50;
+    static constexpr int kMaxBlocksPerInterval = 8;         ///< About 9 KB/s of TERRAIN_DATA on fast links
+    static constexpr int kRadioTxBufferLowPercent = 50;     ///< Below this the radio is congested, fall back to one block per interval
+    static constexpr int kMaxCachedBlocks = 8192;           ///< 256 KB of heights
+    static constexpr int kErroredBlockRetryMsecs = 5000;    ///< Provider errors are usually not resolved within a few send intervals
+    static constexpr double kPrefetchRadiusMeters = 5000;
+    static constexpr double kCorridorHalfWidthMeters = 1000;
 };
@@ -274,6 +274,11 @@ void Vehicle::_commonInit()
 
     connect(_missionManager, &MissionManager::sendComplete,             _trajectoryPoints, &TrajectoryPoints::clear);
     connect(_missionManager, &MissionManager::newMissionItemsAvailable, _trajectoryPoints, &TrajectoryPoints::clear);
+    // Offline editing vehicles have no terrain protocol handler
+    if (_terrainProtocolHandler) {
+        connect(_missionManager, &MissionManager::sendComplete,             _terrainProtocolHandler, &TerrainProtocolHandler::prefetchMission);
+        connect(_missionManager, &MissionManager::newMissionItemsAvailable, _terrainProtocolHandler, &TerrainProtocolHandler::prefetchMission);
+    }
 
     _standardModes                  = new StandardModes                 (this, this);
     _componentInformationManager    = new ComponentInformationManager   (this, this);
@@ -16,9 +16,11 @@
 #include "QGCApplication.h"
 #include "QGC.h"
 #include "AppMessages.h"
+#include "CmdLineOptParser.h"
 
 #ifndef __mobile__
     #include "RunGuard.h"
+    #include <optional>
 #endif
 
 #ifdef Q_OS_ANDROID
@@ -27,8 +29,6 @@
 
 #ifdef QT_DEBUG
 
-#include "CmdLineOptParser.h"
-
 #ifdef UNITTEST_BUILD
 #include "UnitTestList.h"
 #endif
@@ -63,7 +63,9 @@ void sigHandler(int s)
 {
     std::signal(s, SIG_DFL);
     if(qgcApp()) {
-        qgcApp()->mainRootWindow()->close();
+        if (qgcApp()->mainRootWindow()) {
+            qgcApp()->mainRootWindow()->close();
+        }
         QEvent event{QEvent::Quit};
         qgcApp()->event(&event);
     }
@@ -82,6 +84,17 @@ void sigHandler(int s)
 
 int main(int argc, char *argv[])
 {
+    // Plan batch runs have no user interface. They may run next to a normal instance, as root in a container
+    // and without a display, so the checks below which pop message boxes are skipped for them.
+    bool planBatch = false;
+    CmdLineOpt_t rgPlanBatchOptions[] = {
+        { "--plan-batch",           &planBatch,             nullptr },
+    };
+    ParseCmdLineOptions(argc, argv, rgPlanBatchOptions, sizeof(rgPlanBatchOptions)/sizeof(rgPlanBatchOptions[0]), false);
+    if (planBatch && !qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
 #ifndef __mobile__
     // We make the runguard key different for custom and non custom
     // builds, so they can be executed together in the same device.
@@ -89,8 +102,8 @@ int main(int argc, char *argv[])
     // not be able to run at the same time
     const QString runguardString = QString("%1 RunGuardKey").arg(QGC_APP_NAME);
 
-    RunGuard guard(runguardString);
-    if (!guard.tryToRun()) {
+    std::optional<RunGuard> guard;
+    if (!planBatch && !guard.emplace(runguardString).tryToRun()) {
         // QApplication is necessary to use QMessageBox
         QApplication errorApp(argc, argv);
         QMessageBox::critical(nullptr, QObject::tr("Error"),
@@ -102,7 +115,7 @@ int main(int argc, char *argv[])
 
 #ifdef Q_OS_LINUX
 #ifndef Q_OS_ANDROID
-    if (getuid() == 0) {
+    if (!planBatch && (getuid() == 0)) {
         QApplication errorApp(argc, argv);
         QMessageBox::critical(nullptr, QObject::tr("Error"),
             QObject::tr("You are running %1 as root. "
@@ -211,7 +224,10 @@ int main(int argc, char *argv[])
         exitCode = runTests(stressUnitTests, unitTestOptions);
     } else
 #endif
-    {
+    if (app.runningPlanBatch()) {
+        // Plans are generated without creating the QML engine or any windows
+        exitCode = app.runPlanBatch();
+    } else {
         #ifdef Q_OS_ANDROID
             AndroidInterface::checkStoragePermissions();
         #endif
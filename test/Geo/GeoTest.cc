@@ -16,6 +16,8 @@
 #include "GeoTest.h"
 #include "QGCGeo.h"
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRandomGenerator>
 #include <QtTest/QTest>
 
 static bool compareDoubles(double actual, double expected, double epsilon = 0.00001)
@@ -138,3 +140,194 @@ void GeoTest::_convertMGRSToGeo_test()
     QVERIFY(compareDoubles(coord.longitude(), m_origin.longitude()));
     QVERIFY(compareDoubles(coord.altitude(), m_origin.altitude()));
 }
+
+void GeoTest::_randomCoordinates(qsizetype count, QList<double> &latitudes, QList<double> &longitudes, QList<double> &altitudes) const
+{
+    QRandomGenerator random(1234);
+
+    latitudes.resize(count);
+    longitudes.resize(count);
+    altitudes.resize(count);
+    for (qsizetype i = 0; i < count; i++) {
+        latitudes[i] = m_origin.latitude() + (random.bounded(1.0) - 0.5);
+        longitudes[i] = m_origin.longitude() + (random.bounded(1.0) - 0.5);
+        altitudes[i] = (random.bounded(1100.0) - 100.0);
+    }
+}
+
+void GeoTest::_convertGeoToNedBatch_test()
+{
+    QList<double> latitudes;
+    QList<double> longitudes;
+    QList<double> altitudes;
+    _randomCoordinates(kBatchCount, latitudes, longitudes, altitudes);
+
+    // The origin itself must come out as 0 rather than NaN
+    latitudes[0] = m_origin.latitude();
+    longitudes[0] = m_origin.longitude();
+    altitudes[0] = m_origin.altitude();
+
+    QList<double> x(kBatchCount);
+    QList<double> y(kBatchCount);
+    QList<double> z(kBatchCount);
+    QGCGeo::convertGeoToNed(latitudes.constData(), longitudes.constData(), altitudes.constData(), m_origin, x.data(), y.data(), z.data(), kBatchCount);
+
+    for (qsizetype i = 0; i < kBatchCount; i++) {
+        double expectedX, expectedY, expectedZ;
+        QGCGeo::convertGeoToNed(QGeoCoordinate(latitudes[i], longitudes[i], altitudes[i]), m_origin, expectedX, expectedY, expectedZ);
+
+        QVERIFY(compareDoubles(x[i], expectedX, 1e-6));
+        QVERIFY(compareDoubles(y[i], expectedY, 1e-6));
+        QVERIFY(compareDoubles(z[i], expectedZ, 1e-6));
+    }
+
+    // Without altitudes only the horizontal components are computed
+    QList<double> x2D(kBatchCount);
+    QList<double> y2D(kBatchCount);
+    QGCGeo::convertGeoToNed(latitudes.constData(), longitudes.constData(), nullptr, m_origin, x2D.data(), y2D.data(), nullptr, kBatchCount);
+    QCOMPARE(x2D, x);
+    QCOMPARE(y2D, y);
+}
+
+void GeoTest::_convertNedToGeoBatch_test()
+{
+    QRandomGenerator random(4321);
+
+    QList<double> x(kBatchCount);
+    QList<double> y(kBatchCount);
+    QList<double> z(kBatchCount);
+    for (qsizetype i = 0; i < kBatchCount; i++) {
+        x[i] = (random.bounded(100000.0) - 50000.0);
+        y[i] = (random.bounded(100000.0) - 50000.0);
+        z[i] = (random.bounded(1100.0) - 1000.0);
+    }
+    x[0] = y[0] = 0;
+
+    QList<double> latitudes(kBatchCount);
+    QList<double> longitudes(kBatchCount);
+    QList<double> altitudes(kBatchCount);
+    QGCGeo::convertNedToGeo(x.constData(), y.constData(), z.constData(), m_origin, latitudes.data(), longitudes.data(), altitudes.data(), kBatchCount);
+
+    for (qsizetype i = 0; i < kBatchCount; i++) {
+        QGeoCoordinate expected;
+        QGCGeo::convertNedToGeo(x[i], y[i], z[i], m_origin, expected);
+
+        QVERIFY(compareDoubles(latitudes[i], expected.latitude(), 1e-9));
+        QVERIFY(compareDoubles(longitudes[i], expected.longitude(), 1e-9));
+        QVERIFY(compareDoubles(altitudes[i], expected.altitude(), 1e-6));
+    }
+}
+
+void GeoTest::_nedOrigin_test()
+{
+    const QGCGeo::NedOrigin nedOrigin(m_origin);
+    QCOMPARE(nedOrigin.origin(), m_origin);
+
+    const QGeoCoordinate coord(47.364869, 8.594398, 0.0);
+    double x = 0., y = 0., z = 0.;
+    nedOrigin.convertGeoToNed(coord, x, y, z);
+    QVERIFY(compareDoubles(x, -1282.58731618));
+    QVERIFY(compareDoubles(y, 3490.85591324));
+    QVERIFY(compareDoubles(z, 0.));
+
+    QGeoCoordinate result;
+    nedOrigin.convertNedToGeo(x, y, z, result);
+    QVERIFY(compareDoubles(result.latitude(), coord.latitude()));
+    QVERIFY(compareDoubles(result.longitude(), coord.longitude()));
+    QVERIFY(compareDoubles(result.altitude(), coord.altitude()));
+
+    QGeoCoordinate atOrigin(m_origin);
+    atOrigin.setAltitude(10.);
+    nedOrigin.convertGeoToNed(atOrigin, x, y, z);
+    QCOMPARE(x, 0.);
+    QCOMPARE(y, 0.);
+    QVERIFY(compareDoubles(z, -10.));
+}
+
+void GeoTest::_convertUTMBatch_test()
+{
+    QList<double> latitudes;
+    QList<double> longitudes;
+    QList<double> altitudes;
+    _randomCoordinates(kBatchCount, latitudes, longitudes, altitudes);
+
+    QList<double> eastings(kBatchCount);
+    QList<double> northings(kBatchCount);
+    const int zone = QGCGeo::convertGeoToUTM(latitudes.constData(), longitudes.constData(), eastings.data(), northings.data(), kBatchCount);
+    QCOMPARE(zone, 32);
+
+    for (qsizetype i = 0; i < kBatchCount; i++) {
+        double easting, northing;
+        QCOMPARE(QGCGeo::convertGeoToUTM(QGeoCoordinate(latitudes[i], longitudes[i]), easting, northing), zone);
+        QVERIFY(compareDoubles(eastings[i], easting, 1e-6));
+        QVERIFY(compareDoubles(northings[i], northing, 1e-6));
+    }
+
+    QList<double> resultLatitudes(kBatchCount);
+    QList<double> resultLongitudes(kBatchCount);
+    QVERIFY(QGCGeo::convertUTMToGeo(eastings.constData(), northings.constData(), zone, false, resultLatitudes.data(), resultLongitudes.data(), kBatchCount));
+    for (qsizetype i = 0; i < kBatchCount; i++) {
+        QVERIFY(compareDoubles(resultLatitudes[i], latitudes[i], 1e-9));
+        QVERIFY(compareDoubles(resultLongitudes[i], longitudes[i], 1e-9));
+    }
+}
+
+void GeoTest::_convertUTMBatchAcrossEquator_test()
+{
+    // Points across a zone boundary and the equator end up in the grid of the first point
+    const double latitudes[] = { 0.1, -0.1, 0.1 };
+    const double longitudes[] = { 5.9, 5.9, 6.1 };
+    double eastings[3];
+    double northings[3];
+    const int zone = QGCGeo::convertGeoToUTM(latitudes, longitudes, eastings, northings, 3);
+    QCOMPARE(zone, 31);
+    QVERIFY(northings[0] > 0);
+    QVERIFY(northings[1] < 0);
+    QVERIFY(eastings[2] > eastings[0]);
+
+    double resultLatitudes[3];
+    double resultLongitudes[3];
+    QVERIFY(QGCGeo::convertUTMToGeo(eastings, northings, zone, false, resultLatitudes, resultLongitudes, 3));
+    for (int i = 0; i < 3; i++) {
+        QVERIFY(compareDoubles(resultLatitudes[i], latitudes[i], 1e-9));
+        QVERIFY(compareDoubles(resultLongitudes[i], longitudes[i], 1e-9));
+    }
+}
+
+void GeoTest::_benchmarkNedBatch()
+{
+    QList<double> latitudes;
+    QList<double> longitudes;
+    QList<double> altitudes;
+    _randomCoordinates(kBenchmarkCount, latitudes, longitudes, altitudes);
+
+    QList<double> x(kBenchmarkCount);
+    QList<double> y(kBenchmarkCount);
+    QList<double> z(kBenchmarkCount);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (qsizetype i = 0; i < kBenchmarkCount; i++) {
+        QGCGeo::convertGeoToNed(QGeoCoordinate(latitudes[i], longitudes[i], altitudes[i]), m_origin, x[i], y[i], z[i]);
+    }
+    const qint64 scalarMsecs = timer.elapsed();
+
+    timer.restart();
+    QGCGeo::convertGeoToNed(latitudes.constData(), longitudes.constData(), altitudes.constData(), m_origin, x.data(), y.data(), z.data(), kBenchmarkCount);
+    const qint64 batchMsecs = timer.elapsed();
+
+    timer.restart();
+    for (qsizetype i = 0; i < kBenchmarkCount; i++) {
+        QGeoCoordinate coord;
+        QGCGeo::convertNedToGeo(x[i], y[i], z[i], m_origin, coord);
+        latitudes[i] = coord.latitude();
+    }
+    const qint64 scalarReverseMsecs = timer.elapsed();
+
+    timer.restart();
+    QGCGeo::convertNedToGeo(x.constData(), y.constData(), z.constData(), m_origin, latitudes.data(), longitudes.data(), altitudes.data(), kBenchmarkCount);
+    const qint64 batchReverseMsecs = timer.elapsed();
+
+    qDebug() << "Geo to NED" << kBenchmarkCount << "points: scalar" << scalarMsecs << "msecs, batch" << batchMsecs << "msecs";
+    qDebug() << "NED to Geo" << kBenchmarkCount << "points: scalar" << scalarReverseMsecs << "msecs, batch" << batchReverseMsecs << "msecs";
+}
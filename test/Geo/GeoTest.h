@@ -37,7 +37,20 @@ private slots:
     void _convertGeoToMGRS_test(void);
     void _convertMGRSToGeo_test(void);
 
+    void _convertGeoToNedBatch_test(void);
+    void _convertNedToGeoBatch_test(void);
+    void _nedOrigin_test(void);
+    void _convertUTMBatch_test(void);
+    void _convertUTMBatchAcrossEquator_test(void);
+    void _benchmarkNedBatch(void);
+
 private:
+    /// Random coordinates within about 50 km of m_origin as structure of arrays
+    void _randomCoordinates(qsizetype count, QList<double> &latitudes, QList<double> &longitudes, QList<double> &altitudes) const;
+
+    static constexpr qsizetype kBatchCount = 10000;
+    static constexpr qsizetype kBenchmarkCount = 1000000;
+
      /// Use ETH campus (47.3764° N, 8.5481° E)
     const QGeoCoordinate m_origin{47.3764, 8.5481, 0.0};
 };
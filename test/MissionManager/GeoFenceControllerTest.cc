@@ -0,0 +1,95 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "GeoFenceControllerTest.h"
+#include "GeoFenceController.h"
+#include "MissionController.h"
+#include "MissionSettingsItem.h"
+#include "PlanMasterController.h"
+#include "QGCFencePolygon.h"
+#include "RallyPointController.h"
+#include "Vehicle.h"
+
+#include <QtTest/QTest>
+
+void GeoFenceControllerTest::_testPlanBreaches(void)
+{
+    PlanMasterController masterController;
+    masterController.setFlyView(false);
+    masterController.start();
+
+    GeoFenceController*     geoFenceController =    masterController.geoFenceController();
+    MissionController*      missionController =     masterController.missionController();
+    RallyPointController*   rallyPointController =  masterController.rallyPointController();
+
+    // Viewport of 2km square, the inclusion polygon is inset to 1.5km
+    const QGeoCoordinate center(47.3977, 8.5456);
+    geoFenceController->addInclusionPolygon(center.atDistanceAndAzimuth(1414, -45), center.atDistanceAndAzimuth(1414, 135));
+    QCOMPARE(geoFenceController->polygons()->count(), 1);
+
+    const QGeoCoordinate outside = center.atDistanceAndAzimuth(2000, 90);
+    missionController->insertSimpleMissionItem(center, 1);
+    missionController->insertSimpleMissionItem(outside, 2);
+    missionController->visualItems()->value<MissionSettingsItem*>(0)->setInitialHomePositionFromUser(center);
+    rallyPointController->addPoint(outside);
+    rallyPointController->addPoint(center);
+
+    QCOMPARE(geoFenceController->missionItemsBreachingFence(), QList<int>({ 2 }));
+    QCOMPARE(geoFenceController->rallyPointsBreachingFence(), QList<int>({ 0 }));
+    QVERIFY(!geoFenceController->breachesFence(center));
+    QVERIFY(geoFenceController->breachesFence(outside));
+
+    // Dragging the center moves the vertices one by one and only signals pathChanged at the end. The index must follow
+    // each vertex so a query in between does not use the bounds of the polygon before the drag.
+    QGCFencePolygon* polygon = geoFenceController->polygons()->value<QGCFencePolygon*>(0);
+    polygon->setCenterDrag(true);
+    for (int i=0; i<polygon->count(); i++) {
+        polygon->adjustVertex(i, polygon->vertexCoordinate(i).atDistanceAndAzimuth(2000, 90));
+    }
+    QCOMPARE(geoFenceController->missionItemsBreachingFence(), QList<int>({ 0, 1 }));
+    QCOMPARE(geoFenceController->rallyPointsBreachingFence(), QList<int>({ 1 }));
+    polygon->setCenterDrag(false);
+
+    // Without a fence nothing breaches
+    geoFenceController->removeAll();
+    QVERIFY(geoFenceController->missionItemsBreachingFence().isEmpty());
+    QVERIFY(geoFenceController->rallyPointsBreachingFence().isEmpty());
+}
+
+void GeoFenceControllerTest::_testVehicleBreach(void)
+{
+    _connectMockLink(MAV_AUTOPILOT_PX4);
+    QTRY_VERIFY(_vehicle->coordinate().isValid());
+
+    PlanMasterController* masterController = new PlanMasterController(this);
+    masterController->setFlyView(true);
+    masterController->start();
+    QTRY_VERIFY(!masterController->syncInProgress());
+
+    GeoFenceController* geoFenceController = masterController->geoFenceController();
+    QVERIFY(!geoFenceController->vehicleBreachesFence());
+
+    // Fence around the vehicle
+    const QGeoCoordinate vehicleCoordinate = _vehicle->coordinate();
+    geoFenceController->addInclusionPolygon(vehicleCoordinate.atDistanceAndAzimuth(1414, -45), vehicleCoordinate.atDistanceAndAzimuth(1414, 135));
+    QTest::qWait(100);
+    QVERIFY(!geoFenceController->vehicleBreachesFence());
+
+    // Moving the fence away from the vehicle is a breach
+    QGCFencePolygon* polygon = geoFenceController->polygons()->value<QGCFencePolygon*>(0);
+    polygon->setCenter(vehicleCoordinate.atDistanceAndAzimuth(5000, 90));
+    QTRY_VERIFY(geoFenceController->vehicleBreachesFence());
+
+    // No fence, no breach
+    geoFenceController->removeAll();
+    QTRY_VERIFY(!geoFenceController->vehicleBreachesFence());
+
+    delete masterController;
+    _disconnectMockLink();
+}
@@ -0,0 +1,139 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "GeoFenceIndexTest.h"
+#include "GeoFenceIndex.h"
+#include "QGCFenceCircle.h"
+#include "QGCFencePolygon.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRandomGenerator>
+#include <QtTest/QTest>
+
+void GeoFenceIndexTest::_testClassify(void)
+{
+    const QGeoCoordinate center(47.3977, 8.5456);
+
+    // 2km inclusion square with an exclusion circle in it, plus an exclusion triangle in the north east corner
+    QGCFencePolygon inclusion(true /* inclusion */, this);
+    inclusion.appendVertices(QList<QGeoCoordinate>({ center.atDistanceAndAzimuth(1414, -45), center.atDistanceAndAzimuth(1414, 45),
+                                                     center.atDistanceAndAzimuth(1414, 135), center.atDistanceAndAzimuth(1414, -135) }));
+    QGCFencePolygon exclusion(false /* inclusion */, this);
+    exclusion.appendVertices(QList<QGeoCoordinate>({ center.atDistanceAndAzimuth(1414, 45), center.atDistanceAndAzimuth(1000, 0),
+                                                     center.atDistanceAndAzimuth(1000, 90) }));
+    QGCFenceCircle circle(center, 200, false /* inclusion */, this);
+
+    GeoFenceIndex index;
+    QCOMPARE(index.classify(center), GeoFenceIndex::FenceStatusInside);
+
+    index.build({ &inclusion, &exclusion }, { &circle });
+    QVERIFY(!index.isEmpty());
+
+    const QList<QGeoCoordinate> coordinates = {
+        center.atDistanceAndAzimuth(500, -90),      // Inside the square
+        center.atDistanceAndAzimuth(100, 30),       // Inside the circle
+        center.atDistanceAndAzimuth(1300, 45),      // Inside the triangle
+        center.atDistanceAndAzimuth(2000, -90),     // Outside the square
+        center.atDistanceAndAzimuth(50000, 180),    // Outside the grid
+    };
+    const QList<GeoFenceIndex::FenceStatus_t> expected = {
+        GeoFenceIndex::FenceStatusInside,
+        GeoFenceIndex::FenceStatusInsideExclusion,
+        GeoFenceIndex::FenceStatusInsideExclusion,
+        GeoFenceIndex::FenceStatusOutsideInclusion,
+        GeoFenceIndex::FenceStatusOutsideInclusion,
+    };
+    QVERIFY(index.classify(coordinates) == expected);
+    for (int i=0; i<coordinates.count(); i++) {
+        QCOMPARE(index.classify(coordinates[i]), expected[i]);
+    }
+
+    // Without inclusion fences only the exclusions count
+    index.build({ &exclusion }, { &circle });
+    QCOMPARE(index.classify(coordinates[3]), GeoFenceIndex::FenceStatusInside);
+    QCOMPARE(index.classify(coordinates[1]), GeoFenceIndex::FenceStatusInsideExclusion);
+}
+
+void GeoFenceIndexTest::_testManyFences(void)
+{
+    // Airspace like fence: hundreds of small polygons and circles spread over a few degrees
+    static constexpr int polygonCount = 400;
+    static constexpr int circleCount = 100;
+    static constexpr int coordinateCount = 20000;
+
+    QRandomGenerator random(4242);
+    const auto randomCoordinate = [&random]() {
+        return QGeoCoordinate(46 + (random.generateDouble() * 3), 7 + (random.generateDouble() * 4));
+    };
+
+    QList<QGCFencePolygon*> polygons;
+    for (int i=0; i<polygonCount; i++) {
+        const QGeoCoordinate polygonCenter = randomCoordinate();
+        const double radius = 1000 + (random.generateDouble() * 5000);
+        QList<QGeoCoordinate> vertices;
+        for (int j=0; j<5; j++) {
+            vertices.append(polygonCenter.atDistanceAndAzimuth(radius * (0.5 + (random.generateDouble() * 0.5)), j * 72.0));
+        }
+        QGCFencePolygon* polygon = new QGCFencePolygon(i % 2 == 0 /* inclusion */, this);
+        polygon->appendVertices(vertices);
+        polygons.append(polygon);
+    }
+    QList<QGCFenceCircle*> circles;
+    for (int i=0; i<circleCount; i++) {
+        circles.append(new QGCFenceCircle(randomCoordinate(), 500 + (random.generateDouble() * 5000), i % 2 == 0 /* inclusion */, this));
+    }
+
+    QList<QGeoCoordinate> coordinates;
+    for (int i=0; i<coordinateCount; i++) {
+        coordinates.append(randomCoordinate());
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<GeoFenceIndex::FenceStatus_t> expected;
+    for (const QGeoCoordinate& coordinate: coordinates) {
+        bool insideInclusion = false;
+        bool insideExclusion = false;
+        for (const QGCFencePolygon* polygon: polygons) {
+            if (polygon->containsCoordinate(coordinate)) {
+                (polygon->inclusion() ? insideInclusion : insideExclusion) = true;
+            }
+        }
+        for (QGCFenceCircle* circle: circles) {
+            if (circle->center().distanceTo(coordinate) <= circle->radius()->rawValue().toDouble()) {
+                (circle->inclusion() ? insideInclusion : insideExclusion) = true;
+            }
+        }
+        expected.append(insideExclusion ? GeoFenceIndex::FenceStatusInsideExclusion :
+                            (insideInclusion ? GeoFenceIndex::FenceStatusInside : GeoFenceIndex::FenceStatusOutsideInclusion));
+    }
+    const qint64 linearMsecs = timer.restart();
+
+    QList<const QGCFencePolygon*> constPolygons;
+    for (const QGCFencePolygon* polygon: polygons) {
+        constPolygons.append(polygon);
+    }
+    GeoFenceIndex index;
+    index.build(constPolygons, circles);
+    const qint64 buildMsecs = timer.restart();
+
+    const QList<GeoFenceIndex::FenceStatus_t> statuses = index.classify(coordinates);
+    const qint64 classifyMsecs = timer.elapsed();
+
+    qDebug() << "GeoFenceIndex coordinates:fences" << coordinateCount << polygonCount + circleCount
+             << "msecs linear:build:classify" << linearMsecs << buildMsecs << classifyMsecs;
+
+    QVERIFY(statuses == expected);
+    QVERIFY(statuses.count(GeoFenceIndex::FenceStatusInside) > 0);
+    QVERIFY(statuses.count(GeoFenceIndex::FenceStatusInsideExclusion) > 0);
+
+    qDeleteAll(polygons);
+    qDeleteAll(circles);
+}
@@ -127,7 +127,7 @@ void MissionCommandTreeTest::_checkOverrideValues(const MissionCommandUIInfo* ui
 void MissionCommandTreeTest::testJsonLoad()
 {
     // Test loading from the bad command list
-    MissionCommandList *const commandList = _commandTree->_staticCommandTree[MAV_AUTOPILOT_GENERIC][MAV_TYPE_GENERIC];
+    MissionCommandList *const commandList = _commandTree->_commandList(QGCMAVLink::FirmwareClassGeneric, QGCMAVLink::VehicleClassGeneric);
     QVERIFY(commandList != nullptr);
 
     // Command 1 should have all values defaulted, no params
@@ -208,3 +208,27 @@ void MissionCommandTreeTest::testAllTrees()
 
 }
 
+void MissionCommandTreeTest::testLazyLoad()
+{
+    // Nothing is loaded until it is needed
+    QVERIFY(_commandTree->_staticCommandTree.isEmpty());
+
+    QCOMPARE(_commandTree->rawName(static_cast<MAV_CMD>(1)), _rawName(1));
+    QCOMPARE(_commandTree->_staticCommandTree.count(), 1);
+    QCOMPARE(_commandTree->_staticCommandTree[QGCMAVLink::FirmwareClassGeneric].count(), 1);
+    const MissionCommandList *const baseList = _commandTree->_commandList(QGCMAVLink::FirmwareClassGeneric, QGCMAVLink::VehicleClassGeneric);
+
+    // Building the fixed wing tree loads only the fixed wing overrides
+    Vehicle *const vehicle = new Vehicle(MAV_AUTOPILOT_GENERIC, MAV_TYPE_FIXED_WING, this);
+    const MissionCommandUIInfo *const overrideInfo = _commandTree->getUIInfo(vehicle, QGCMAVLink::VehicleClassGeneric, static_cast<MAV_CMD>(4));
+    QCOMPARE(_commandTree->_staticCommandTree[QGCMAVLink::FirmwareClassGeneric].count(), 2);
+    QVERIFY(_commandTree->_staticCommandTree[QGCMAVLink::FirmwareClassGeneric].contains(QGCMAVLink::VehicleClassFixedWing));
+    QVERIFY(!_commandTree->_staticCommandTree[QGCMAVLink::FirmwareClassGeneric].contains(QGCMAVLink::VehicleClassMultiRotor));
+
+    // Overridden commands are copies, the others are shared with the base list
+    _checkOverrideValues(overrideInfo, 4);
+    QVERIFY(overrideInfo != baseList->getUIInfo(static_cast<MAV_CMD>(4)));
+    _checkBaseValues(baseList->getUIInfo(static_cast<MAV_CMD>(4)), 4);
+    QVERIFY(_commandTree->getUIInfo(vehicle, QGCMAVLink::VehicleClassGeneric, static_cast<MAV_CMD>(1)) == baseList->getUIInfo(static_cast<MAV_CMD>(1)));
+    delete vehicle;
+}
@@ -25,6 +25,7 @@ private slots:
     void testJsonLoad();
     void testOverride();
     void testAllTrees();
+    void testLazyLoad();
 
 private:
     QString _rawName(int id) const;
@@ -17,7 +17,11 @@
 #include "AppSettings.h"
 #include "PlanViewSettings.h"
 #include "MultiSignalSpy.h"
+#include "TakeoffMissionItem.h"
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonObject>
 #include <QtTest/QTest>
 
 MissionControllerTest::MissionControllerTest(void)
@@ -232,6 +236,163 @@ void MissionControllerTest::_testVehicleYawRecalc(void)
     }
 }
 
+void MissionControllerTest::_testIncrementalFlightStatus(void)
+{
+    _initForFirmwareType(MAV_AUTOPILOT_PX4);
+
+    int cMissionItems = 500;
+    QGeoCoordinate currentCoord(47.397, 8.545);
+    for (int i=1; i<=cMissionItems; i++) {
+        currentCoord = currentCoord.atDistanceAndAzimuth(50, (i % 20) * 18);
+        _missionController->insertSimpleMissionItem(currentCoord, i);
+    }
+
+    QTest::qWait(100); // Recalcs in MissionController are queued to remove dups. Allow return to main message loop.
+
+    QmlObjectListModel* visualItems = _missionController->visualItems();
+    QCOMPARE(visualItems->count(), cMissionItems + 1);
+
+    // Snapshot of the values the incremental recalc must reproduce
+    auto snapshot = [this, visualItems]() {
+        QList<double> values;
+        for (int i=0; i<visualItems->count(); i++) {
+            VisualMissionItem* item = visualItems->value<VisualMissionItem*>(i);
+            values << item->distanceFromStart() << item->distance() << item->azimuth() << item->missionVehicleYaw() << item->altPercent();
+        }
+        values << _missionController->missionDistance() << _missionController->missionTime() << _missionController->missionMaxTelemetry();
+        return values;
+    };
+    auto compareSnapshots = [](const QList<double>& incremental, const QList<double>& full) {
+        QCOMPARE(incremental.count(), full.count());
+        for (qsizetype i=0; i<incremental.count(); i++) {
+            if (qIsNaN(full[i])) {
+                QVERIFY(qIsNaN(incremental[i]));
+            } else {
+                QVERIFY2(qAbs(incremental[i] - full[i]) < 1e-6, qPrintable(QStringLiteral("index %1 %2 != %3").arg(i).arg(incremental[i]).arg(full[i])));
+            }
+        }
+    };
+
+    // Move a waypoint in the middle of the mission. The flight path segments are reused so the model rows must stay put.
+    QObject* firstSegment = _missionController->simpleFlightPathSegments()->get(0);
+    int segmentCount = _missionController->simpleFlightPathSegments()->count();
+    VisualMissionItem* movedItem = visualItems->value<VisualMissionItem*>(cMissionItems / 2);
+    double distanceBefore = _missionController->missionDistance();
+
+    QElapsedTimer timer;
+    timer.start();
+    movedItem->setCoordinate(movedItem->coordinate().atDistanceAndAzimuth(200, 90));
+    _missionController->_recalcMissionFlightStatus();
+    qint64 incrementalNs = timer.nsecsElapsed();
+    QVERIFY(_missionController->missionDistance() != distanceBefore);
+
+    QTest::qWait(100);
+    QCOMPARE(_missionController->simpleFlightPathSegments()->get(0), firstSegment);
+    QCOMPARE(_missionController->simpleFlightPathSegments()->count(), segmentCount);
+
+    QList<double> incremental = snapshot();
+    timer.restart();
+    _missionController->_setAllFlightStatusDirty();
+    _missionController->_recalcMissionFlightStatus();
+    qint64 fullNs = timer.nsecsElapsed();
+    compareSnapshots(incremental, snapshot());
+
+    qDebug() << "Flight status recalc for" << cMissionItems << "items, incremental:" << incrementalNs / 1000 << "us full:" << fullNs / 1000 << "us";
+
+    // A change which alters state carried to following items, gimbal yaw in this case, must still reach the end of the mission
+    SettingsManager::instance()->planViewSettings()->showGimbalOnlyWhenSet()->setRawValue(false);
+    SimpleMissionItem* gimbalItem = visualItems->value<SimpleMissionItem*>(cMissionItems / 4);
+    gimbalItem->cameraSection()->setSpecifyGimbal(true);
+    gimbalItem->cameraSection()->gimbalYaw()->setRawValue(45);
+    QTest::qWait(100);
+    QCOMPARE(visualItems->value<VisualMissionItem*>(cMissionItems)->missionGimbalYaw(), 45.0);
+
+    incremental = snapshot();
+    _missionController->_setAllFlightStatusDirty();
+    _missionController->_recalcMissionFlightStatus();
+    compareSnapshots(incremental, snapshot());
+}
+
+void MissionControllerTest::_testLoadLargePlan(void)
+{
+    _initForFirmwareType(MAV_AUTOPILOT_PX4);
+
+    const int cWaypoints = 10000;
+    const QGeoCoordinate homeCoord(47.397, 8.545, 488);
+
+    auto simpleItemJson = [](int command, const QGeoCoordinate& coord, double param1, int doJumpId) {
+        QJsonObject item;
+        item[QStringLiteral("type")] =          QStringLiteral("SimpleItem");
+        item[QStringLiteral("command")] =       command;
+        item[QStringLiteral("frame")] =         MAV_FRAME_GLOBAL_RELATIVE_ALT;
+        item[QStringLiteral("autoContinue")] =  true;
+        item[QStringLiteral("doJumpId")] =      doJumpId;
+        item[QStringLiteral("params")] =        QJsonArray({ param1, 0, 0, QJsonValue(), coord.latitude(), coord.longitude(), 50 });
+        return item;
+    };
+
+    QJsonArray rgItems;
+    int doJumpId = 1;
+    rgItems.append(simpleItemJson(MAV_CMD_NAV_TAKEOFF, homeCoord, 0, doJumpId++));
+    for (int i=0; i<cWaypoints; i++) {
+        rgItems.append(simpleItemJson(MAV_CMD_NAV_WAYPOINT, homeCoord.atDistanceAndAzimuth(10 * (i / 100), (i % 100) * 3.6), 0, doJumpId++));
+    }
+    // Jump back to the first waypoint
+    rgItems.append(simpleItemJson(MAV_CMD_DO_JUMP, QGeoCoordinate(0, 0), 2 /* doJumpId */, doJumpId++));
+
+    QJsonObject json;
+    json[QStringLiteral("firmwareType")] =          MAV_AUTOPILOT_PX4;
+    json[QStringLiteral("vehicleType")] =           MAV_TYPE_QUADROTOR;
+    json[QStringLiteral("plannedHomePosition")] =   QJsonArray({ homeCoord.latitude(), homeCoord.longitude(), homeCoord.altitude() });
+    json[QStringLiteral("items")] =                 rgItems;
+
+    QElapsedTimer timer;
+    timer.start();
+    QString errorString;
+    QVERIFY2(_missionController->load(json, errorString), qPrintable(errorString));
+    qint64 loadMsecs = timer.elapsed();
+    QTest::qWait(100); // Recalcs in MissionController are queued to remove dups. Allow return to main message loop.
+    qint64 totalMsecs = timer.elapsed();
+
+    qDebug() << "Plan load" << cWaypoints << "waypoints: load" << loadMsecs << "msecs, load and recalc" << totalMsecs << "msecs";
+
+    QmlObjectListModel* visualItems = _missionController->visualItems();
+    QCOMPARE(visualItems->count(), cWaypoints + 3);
+    QVERIFY(visualItems->value<TakeoffMissionItem*>(1));
+    SimpleMissionItem* doJumpItem = visualItems->value<SimpleMissionItem*>(visualItems->count() - 1);
+    QVERIFY(doJumpItem);
+    QCOMPARE(doJumpItem->command(), static_cast<int>(MAV_CMD_DO_JUMP));
+    QCOMPARE(static_cast<int>(doJumpItem->missionItem().param1()), visualItems->value<SimpleMissionItem*>(2)->sequenceNumber());
+    QVERIFY(_missionController->missionDistance() > 0);
+    for (int i=1; i<visualItems->count(); i++) {
+        QCOMPARE(visualItems->value<VisualMissionItem*>(i)->sequenceNumber(), i);
+    }
+    QCOMPARE(visualItems->value<SimpleMissionItem*>(2)->coordinate().latitude(), homeCoord.latitude());
+
+    // Items created by a failed load are freed again
+    auto visualItemCount = [this]() {
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+        return _masterController->findChildren<VisualMissionItem*>().count();
+    };
+    const qsizetype loadedItemCount = visualItemCount();
+
+    // A jump to a missing item fails the load and keeps the current mission
+    QJsonArray rgBadJumpItems = rgItems;
+    rgBadJumpItems.append(simpleItemJson(MAV_CMD_DO_JUMP, QGeoCoordinate(0, 0), 99999 /* doJumpId */, doJumpId++));
+    json[QStringLiteral("items")] = rgBadJumpItems;
+    QVERIFY(!_missionController->load(json, errorString));
+    QCOMPARE(_missionController->visualItems(), visualItems);
+    QCOMPARE(visualItemCount(), loadedItemCount);
+
+    // So is a complex item which fails to load, along with the items before it
+    QJsonArray rgBadComplexItems = rgItems;
+    rgBadComplexItems.append(QJsonObject({ { QStringLiteral("type"), QStringLiteral("ComplexItem") }, { QStringLiteral("complexItemType"), QStringLiteral("survey") } }));
+    json[QStringLiteral("items")] = rgBadComplexItems;
+    QVERIFY(!_missionController->load(json, errorString));
+    QCOMPARE(_missionController->visualItems(), visualItems);
+    QCOMPARE(visualItemCount(), loadedItemCount);
+}
+
 void MissionControllerTest::_testLoadJsonSectionAvailable(void)
 {
     _initForFirmwareType(MAV_AUTOPILOT_PX4);
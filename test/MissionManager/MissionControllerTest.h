@@ -34,6 +34,8 @@ private slots:
     void _testGlobalAltMode             (void);
     void _testGimbalRecalc              (void);
     void _testVehicleYawRecalc          (void);
+    void _testIncrementalFlightStatus   (void);
+    void _testLoadLargePlan             (void);
 
 private:
 #if 0
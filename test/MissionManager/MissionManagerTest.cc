@@ -11,7 +11,11 @@
 #include "MissionManagerTest.h"
 #include "MissionManager.h"
 #include "MultiSignalSpy.h"
+#include "SettingsManager.h"
+#include "PlanViewSettings.h"
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QScopeGuard>
 #include <QtTest/QTest>
 #include <QtTest/QSignalSpy>
 
@@ -355,3 +359,74 @@ void MissionManagerTest::_testErrorAckFailureStrings(void)
     }
 
 }
+
+void MissionManagerTest::_transferItems(int transferWindow, int itemCount, qint64& writeMsecs, qint64& readMsecs)
+{
+    SettingsManager::instance()->planViewSettings()->missionTransferWindow()->setRawValue(transferWindow);
+    QCOMPARE(_missionManager->transferWindow(), transferWindow);
+    _mockLink->setMissionTransferWindow(transferWindow);
+
+    // Home position is in the first item and is not sent to PX4
+    QList<MissionItem*> missionItems;
+    for (int i=0; i<=itemCount; i++) {
+        missionItems.append(new MissionItem(i, MAV_CMD_NAV_WAYPOINT, MAV_FRAME_GLOBAL_RELATIVE_ALT, 0, 0, 0, 0, 47.3769 + (i * 0.0001), 8.549444, 50 + i, true, false, this));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    _missionManager->writeMissionItems(missionItems);
+    QVERIFY(_multiSpyMissionManager->waitForSignalByIndex(sendCompleteSignalIndex, _missionManagerSignalWaitTime));
+    QCOMPARE(_multiSpyMissionManager->checkSignalByMask(errorSignalMask), false);
+    writeMsecs = timer.elapsed();
+    _multiSpyMissionManager->clearAllSignals();
+
+    timer.restart();
+    _missionManager->loadFromVehicle();
+    QVERIFY(_multiSpyMissionManager->waitForSignalByIndex(newMissionItemsAvailableSignalIndex, _missionManagerSignalWaitTime));
+    QCOMPARE(_multiSpyMissionManager->checkSignalByMask(errorSignalMask), false);
+    readMsecs = timer.elapsed();
+    _multiSpyMissionManager->clearAllSignals();
+
+    const QList<MissionItem*>& readItems = _missionManager->missionItems();
+    QCOMPARE(readItems.count(), itemCount);
+    for (int i=0; i<readItems.count(); i++) {
+        QCOMPARE(readItems[i]->sequenceNumber(), i);
+        QCOMPARE(readItems[i]->param7(), 50.0 + i + 1);
+    }
+
+    _mockLink->resetMissionItemHandler();
+}
+
+void MissionManagerTest::_testPipelinedTransfer(void)
+{
+    _initForFirmwareType(MAV_AUTOPILOT_PX4);
+    _mockLink->setMissionItemResponseLatency(20);
+
+    // _transferItems changes the global transfer window, restore it however the test ends
+    Fact* windowFact = SettingsManager::instance()->planViewSettings()->missionTransferWindow();
+    const QVariant savedWindow = windowFact->rawValue();
+    auto restoreWindow = qScopeGuard([&]() {
+        _mockLink->setMissionItemResponseLatency(0);
+        windowFact->setRawValue(savedWindow);
+    });
+
+    const int itemCount = 200;
+    qint64 sequentialWriteMsecs = 0;
+    qint64 sequentialReadMsecs = 0;
+    qint64 pipelinedWriteMsecs = 0;
+    qint64 pipelinedReadMsecs = 0;
+
+    _transferItems(1, itemCount, sequentialWriteMsecs, sequentialReadMsecs);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+    _transferItems(10, itemCount, pipelinedWriteMsecs, pipelinedReadMsecs);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+
+    qDebug() << "Sequential write/read" << sequentialWriteMsecs << sequentialReadMsecs << "msecs, pipelined write/read" << pipelinedWriteMsecs << pipelinedReadMsecs << "msecs";
+
+    QVERIFY(pipelinedWriteMsecs < sequentialWriteMsecs);
+    QVERIFY(pipelinedReadMsecs < sequentialReadMsecs);
+}
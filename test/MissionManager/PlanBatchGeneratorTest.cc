@@ -0,0 +1,191 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "PlanBatchGeneratorTest.h"
+#include "PlanBatchGenerator.h"
+#include "PlanMasterController.h"
+#include "MissionController.h"
+#include "SurveyComplexItem.h"
+#include "JsonHelper.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QTemporaryDir>
+#include <QtPositioning/QGeoPath>
+#include <QtPositioning/QGeoRectangle>
+#include <QtTest/QTest>
+
+PlanBatchGeneratorTest::PlanBatchGeneratorTest(void)
+{
+    // We use a 200m by 100m test polygon
+    _polyVertices.append(QGeoCoordinate(47.633550640000003, -122.08982199));
+    _polyVertices.append(_polyVertices[0].atDistanceAndAzimuth(200, 90));
+    _polyVertices.append(_polyVertices[1].atDistanceAndAzimuth(100, 180));
+    _polyVertices.append(_polyVertices[2].atDistanceAndAzimuth(200, -90.0));
+}
+
+/// Builds a survey the way the Plan view does and returns it as saved to a plan file
+QJsonObject PlanBatchGeneratorTest::_surveyItemObject(const QList<QGeoCoordinate>& polygon)
+{
+    PlanMasterController masterController(MAV_AUTOPILOT_PX4, MAV_TYPE_QUADROTOR);
+    masterController.start();
+
+    const QGeoCoordinate center = QGeoPath(polygon).boundingGeoRectangle().center();
+    SurveyComplexItem* surveyItem = qobject_cast<SurveyComplexItem*>(masterController.missionController()->insertComplexMissionItem(SurveyComplexItem::name, center, -1));
+    if (!surveyItem) {
+        return QJsonObject();
+    }
+    surveyItem->surveyAreaPolygon()->appendVertices(polygon);
+    surveyItem->gridAngle()->setRawValue(30);
+    surveyItem->cameraCalc()->adjustedFootprintSide()->setRawValue(25);
+    surveyItem->cameraCalc()->adjustedFootprintFrontal()->setRawValue(20);
+
+    QJsonArray items;
+    surveyItem->save(items);
+    return items.count() ? items[0].toObject() : QJsonObject();
+}
+
+QJsonObject PlanBatchGeneratorTest::_loadPlanSurveyItem(const QString& planFile)
+{
+    QFile file(planFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QJsonObject();
+    }
+
+    const QJsonObject missionObject = QJsonDocument::fromJson(file.readAll()).object()[PlanMasterController::kJsonMissionObjectKey].toObject();
+    for (const QJsonValue& itemValue : missionObject[QStringLiteral("items")].toArray()) {
+        const QJsonObject itemObject = itemValue.toObject();
+        if (itemObject[ComplexMissionItem::jsonComplexItemTypeKey].toString() == SurveyComplexItem::jsonComplexItemTypeValue) {
+            return itemObject;
+        }
+    }
+    return QJsonObject();
+}
+
+void PlanBatchGeneratorTest::_testSurveyMatchesPlanView(void)
+{
+    const QJsonObject expectedItem = _surveyItemObject(_polyVertices);
+    QVERIFY(!expectedItem.isEmpty());
+
+    QTemporaryDir outputDir;
+    QVERIFY(outputDir.isValid());
+
+    // The saved survey doubles as its own preset, the polygon in it is ignored
+    PlanBatchGenerator::Job_t job;
+    job.name = QStringLiteral("Survey");
+    job.preset = expectedItem;
+    job.coordinates = _polyVertices;
+
+    PlanBatchGenerator generator;
+    generator.setJobs({ job });
+    generator.setVehicleType(MAV_AUTOPILOT_PX4, MAV_TYPE_QUADROTOR);
+    generator.setOutputDirectory(outputDir.path());
+    QCOMPARE(generator.run(), 0);
+
+    QCOMPARE(generator.results().count(), 1);
+    const PlanBatchGenerator::Result_t& result = generator.results()[0];
+    QVERIFY2(!result.planFile.isEmpty(), qPrintable(result.errorString));
+
+    // Transects are built off the GUI thread by the generator, they must still match the Plan view ones
+    const QJsonObject generatedItem = _loadPlanSurveyItem(result.planFile);
+    QVERIFY(!generatedItem.isEmpty());
+    const QString transectStyleKey = QStringLiteral("TransectStyleComplexItem");
+    const QString itemsKey = QStringLiteral("Items");
+    QVERIFY(!expectedItem[transectStyleKey].toObject()[itemsKey].toArray().isEmpty());
+    QCOMPARE(generatedItem[transectStyleKey].toObject()[itemsKey].toArray(), expectedItem[transectStyleKey].toObject()[itemsKey].toArray());
+}
+
+void PlanBatchGeneratorTest::_testJobFile(void)
+{
+    const QJsonObject presetObject = _surveyItemObject(_polyVertices);
+    QVERIFY(!presetObject.isEmpty());
+
+    QTemporaryDir jobDir;
+    QVERIFY(jobDir.isValid());
+
+    QJsonArray polygonArray;
+    for (const QGeoCoordinate& vertex : _polyVertices) {
+        polygonArray.append(QJsonArray({ vertex.latitude(), vertex.longitude() }));
+    }
+    QJsonArray lineArray;
+    lineArray.append(polygonArray[0]);
+    lineArray.append(polygonArray[1]);
+
+    QJsonArray jobsArray;
+    for (int i=0; i<3; i++) {
+        QJsonObject jobObject;
+        jobObject[PlanBatchGenerator::jsonNameKey] = QStringLiteral("Survey%1").arg(i);
+        jobObject[PlanBatchGenerator::jsonPresetKey] = QStringLiteral("Mapping");
+        jobObject[PlanBatchGenerator::jsonCoordinatesKey] = polygonArray;
+        jobsArray.append(jobObject);
+    }
+    // A survey needs a polygon, so this job fails
+    QJsonObject lineJobObject;
+    lineJobObject[PlanBatchGenerator::jsonNameKey] = QStringLiteral("Line");
+    lineJobObject[PlanBatchGenerator::jsonPresetKey] = QStringLiteral("Mapping");
+    lineJobObject[PlanBatchGenerator::jsonCoordinatesKey] = lineArray;
+    jobsArray.append(lineJobObject);
+
+    QJsonObject jobFileObject;
+    JsonHelper::saveQGCJsonFileHeader(jobFileObject, PlanBatchGenerator::jsonFileTypeValue, 1);
+    jobFileObject[PlanBatchGenerator::jsonFirmwareTypeKey] = MAV_AUTOPILOT_PX4;
+    jobFileObject[PlanBatchGenerator::jsonVehicleTypeKey] = MAV_TYPE_QUADROTOR;
+    jobFileObject[PlanBatchGenerator::jsonPresetsKey] = QJsonObject({ { QStringLiteral("Mapping"), presetObject } });
+    jobFileObject[PlanBatchGenerator::jsonJobsKey] = jobsArray;
+
+    const QString jobFilename = jobDir.filePath(QStringLiteral("jobs.json"));
+    QFile jobFile(jobFilename);
+    QVERIFY(jobFile.open(QIODevice::WriteOnly));
+    jobFile.write(QJsonDocument(jobFileObject).toJson());
+    jobFile.close();
+
+    PlanBatchGenerator generator;
+    QString errorString;
+    QVERIFY2(generator.loadJobFile(jobFilename, errorString), qPrintable(errorString));
+    QCOMPARE(generator.jobs().count(), 4);
+
+    generator.setOutputDirectory(jobDir.path());
+    generator.setMaxPlansInFlight(2);
+    QCOMPARE(generator.run(), 1);
+
+    QCOMPARE(generator.results().count(), 4);
+    int planCount = 0;
+    for (const PlanBatchGenerator::Result_t& result : generator.results()) {
+        if (result.name == QStringLiteral("Line")) {
+            QVERIFY(result.planFile.isEmpty());
+            QVERIFY(!result.errorString.isEmpty());
+        } else {
+            QVERIFY2(QFile::exists(result.planFile), qPrintable(result.errorString));
+            planCount++;
+        }
+    }
+    QCOMPARE(planCount, 3);
+    QVERIFY(generator.plansPerSecond() > 0);
+
+    // Unknown presets are reported when loading
+    jobsArray[0] = QJsonObject({ { PlanBatchGenerator::jsonNameKey, QStringLiteral("Bad") }, { PlanBatchGenerator::jsonPresetKey, QStringLiteral("Unknown") }, { PlanBatchGenerator::jsonCoordinatesKey, polygonArray } });
+    jobFileObject[PlanBatchGenerator::jsonJobsKey] = jobsArray;
+    QVERIFY(jobFile.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    jobFile.write(QJsonDocument(jobFileObject).toJson());
+    jobFile.close();
+    QVERIFY(!generator.loadJobFile(jobFilename, errorString));
+    QVERIFY(generator.jobs().isEmpty());
+
+    // Names become plan file names, so they may neither leave the output directory nor collide
+    for (const QString& badName : { QStringLiteral("../Escape"), QStringLiteral("Sub/Dir"), QStringLiteral(".."), QStringLiteral("survey1") }) {
+        jobsArray[0] = QJsonObject({ { PlanBatchGenerator::jsonNameKey, badName }, { PlanBatchGenerator::jsonPresetKey, QStringLiteral("Mapping") }, { PlanBatchGenerator::jsonCoordinatesKey, polygonArray } });
+        jobFileObject[PlanBatchGenerator::jsonJobsKey] = jobsArray;
+        QVERIFY(jobFile.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        jobFile.write(QJsonDocument(jobFileObject).toJson());
+        jobFile.close();
+        QVERIFY2(!generator.loadJobFile(jobFilename, errorString), qPrintable(badName));
+        QVERIFY(!errorString.isEmpty());
+    }
+}
@@ -0,0 +1,33 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+#include <QtCore/QJsonObject>
+#include <QtPositioning/QGeoCoordinate>
+
+class PlanBatchGeneratorTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    PlanBatchGeneratorTest(void);
+
+private slots:
+    void _testSurveyMatchesPlanView(void);
+    void _testJobFile(void);
+
+private:
+    QJsonObject _surveyItemObject   (const QList<QGeoCoordinate>& polygon);
+    QJsonObject _loadPlanSurveyItem (const QString& planFile);
+
+    QList<QGeoCoordinate> _polyVertices;
+};
@@ -12,6 +12,17 @@
 #include "QGCQGeoCoordinate.h"
 #include "MultiSignalSpy.h"
 #include "QmlObjectListModel.h"
+#include "ShapeFileHelper.h"
+#include "QGCFencePolygon.h"
+#include "SettingsManager.h"
+#include "PlanViewSettings.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QScopeGuard>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QTextStream>
+#include <QtCore/QtMath>
 
 QGCMapPolygonTest::QGCMapPolygonTest(void)
 {
@@ -217,6 +228,127 @@ void QGCMapPolygonTest::_testKMLLoad(void)
     QVERIFY(!_mapPolygon->loadKMLOrSHPFile(QStringLiteral(":/unittest/PolygonBadCoordinatesNode.kml")));
 }
 
+void QGCMapPolygonTest::_testKMLLoadLarge(void)
+{
+    // Jagged counter-clockwise ring with a large vertex count like detailed cadastral exports
+    static constexpr int vertexCount = 200000;
+    const QGeoCoordinate center(47.633, -122.089);
+
+    QTemporaryDir directory;
+    const QString kmlFile = directory.filePath(QStringLiteral("Large.kml"));
+    {
+        QFile file(kmlFile);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+        QTextStream stream(&file);
+        stream.setRealNumberPrecision(12);
+        stream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<kml xmlns=\"http://www.opengis.net/kml/2.2\"><Document><Placemark><Polygon><outerBoundaryIs><LinearRing><coordinates>\n";
+        for (int i=0; i<=vertexCount; i++) {
+            const double angle = (2.0 * M_PI * (i % vertexCount)) / vertexCount;
+            const double radius = 1000.0 + ((i % 2) ? 2.0 : 0.0) + (200.0 * qSin(angle * 8));
+            const QGeoCoordinate vertex = center.atDistanceAndAzimuth(radius, qRadiansToDegrees(angle));
+            stream << vertex.longitude() << "," << vertex.latitude() << ",0 ";
+        }
+        stream << "\n</coordinates></LinearRing></outerBoundaryIs></Polygon></Placemark></Document></kml>\n";
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QList<QGeoCoordinate> vertices;
+    QString errorString;
+    QVERIFY(ShapeFileHelper::loadPolygonFromFile(kmlFile, vertices, errorString));
+    QVERIFY(errorString.isEmpty());
+    QCOMPARE(vertices.count(), vertexCount);
+    qDebug() << "Full load of" << vertexCount << "vertices msecs" << timer.elapsed();
+
+    // Simplified load stays within the budget and keeps the shape
+    static constexpr int vertexBudget = 1000;
+    qsizetype sourceVertexCount = 0;
+    timer.restart();
+    QVERIFY(ShapeFileHelper::loadPolygonFromFile(kmlFile, vertices, errorString, vertexBudget, &sourceVertexCount));
+    qDebug() << "Simplified load to" << vertices.count() << "vertices msecs" << timer.elapsed();
+    QVERIFY(vertices.count() <= vertexBudget);
+    QVERIFY(vertices.count() > vertexBudget / 2);
+    QCOMPARE(sourceVertexCount, vertexCount);
+    for (const QGeoCoordinate& vertex : vertices) {
+        const double distance = center.distanceTo(vertex);
+        QVERIFY(distance > 790 && distance < 1210);
+    }
+
+    QGCMapPolygon simplifiedPolygon;
+    simplifiedPolygon.appendVertices(vertices);
+    QGCMapPolygon fullPolygon;
+    QVERIFY(ShapeFileHelper::loadPolygonFromFile(kmlFile, vertices, errorString));
+    fullPolygon.appendVertices(vertices);
+    QVERIFY(qAbs(simplifiedPolygon.area() - fullPolygon.area()) < fullPolygon.area() * 0.01);
+
+    // Imports are only simplified when the setting is enabled, fences never are
+    Fact* simplifyFact = SettingsManager::instance()->planViewSettings()->simplifyImportedShapes();
+    const QVariant savedSimplify = simplifyFact->rawValue();
+    auto restoreSimplify = qScopeGuard([&]() { simplifyFact->setRawValue(savedSimplify); });
+
+    simplifyFact->setRawValue(false);
+    QGCMapPolygon importedPolygon;
+    QVERIFY(importedPolygon.loadKMLOrSHPFile(kmlFile));
+    QCOMPARE(importedPolygon.count(), vertexCount);
+
+    simplifyFact->setRawValue(true);
+    QVERIFY(importedPolygon.loadKMLOrSHPFile(kmlFile));
+    QVERIFY(importedPolygon.count() <= ShapeFileHelper::simplifiedVertexBudget);
+
+    QGCFencePolygon fencePolygon(true /* inclusion */);
+    QVERIFY(fencePolygon.loadKMLOrSHPFile(kmlFile));
+    QCOMPARE(fencePolygon.count(), vertexCount);
+
+    // Progress is reported up to completion, returning false from the callback cancels the load
+    double lastFraction = 0;
+    QVERIFY(ShapeFileHelper::loadPolygonFromFile(kmlFile, vertices, errorString, 0, nullptr, [&lastFraction](double fraction) {
+        const bool increasing = fraction >= lastFraction;
+        lastFraction = fraction;
+        return increasing;
+    }));
+    QCOMPARE(lastFraction, 1.0);
+    QVERIFY(!ShapeFileHelper::loadPolygonFromFile(kmlFile, vertices, errorString, 0, nullptr, [](double fraction) { return fraction < 0.5; }));
+    QVERIFY(!errorString.isEmpty());
+
+    // A polygon load cancelled from the UI leaves the polygon unchanged
+    const int importedCount = importedPolygon.count();
+    (void) connect(&importedPolygon, &QGCMapPolygon::importProgressChanged, &importedPolygon, &QGCMapPolygon::cancelImport);
+    QSignalSpy spyImporting(&importedPolygon, &QGCMapPolygon::importingChanged);
+    QVERIFY(!importedPolygon.loadKMLOrSHPFile(kmlFile));
+    QVERIFY(!importedPolygon.importing());
+    QCOMPARE(spyImporting.count(), 2);
+    QCOMPARE(importedPolygon.count(), importedCount);
+}
+
+void QGCMapPolygonTest::_testSHPLoad(void)
+{
+    QTemporaryDir directory;
+    const QString shpFile = directory.filePath(QStringLiteral("MP 19.shp"));
+    for (const QString& extension : { QStringLiteral(".shp"), QStringLiteral(".shx"), QStringLiteral(".prj") }) {
+        const QString file = directory.filePath(QStringLiteral("MP 19") + extension);
+        QVERIFY(QFile::copy(QStringLiteral(":/unittest/MP 19") + extension, file));
+        QVERIFY(QFile::setPermissions(file, QFileDevice::ReadOwner | QFileDevice::WriteOwner));
+    }
+
+    QList<QGeoCoordinate> vertices;
+    QString errorString;
+    qsizetype sourceVertexCount = 0;
+    QVERIFY(ShapeFileHelper::loadPolygonFromFile(shpFile, vertices, errorString, 0, &sourceVertexCount));
+    QVERIFY(vertices.count() >= 3);
+    QVERIFY(sourceVertexCount >= vertices.count());
+
+    // A null shape record in a polygon file is rejected rather than read as a polygon
+    {
+        QFile file(shpFile);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.seek(100 /* file header */ + 8 /* record header */));
+        QCOMPARE(file.write(QByteArray(4, '\0')), 4);
+    }
+    QVERIFY(!ShapeFileHelper::loadPolygonFromFile(shpFile, vertices, errorString));
+    QVERIFY(!errorString.isEmpty());
+    QVERIFY(vertices.isEmpty());
+}
+
 void QGCMapPolygonTest::_testSelectVertex(void)
 {
     // Create polygon
@@ -331,3 +463,31 @@ void QGCMapPolygonTest::_testSegmentSplit(void)
     QVERIFY(_mapPolygon->count() == 14);
     QVERIFY(_mapPolygon->selectedVertex() == _mapPolygon->count()-2);
 }
+
+void QGCMapPolygonTest::_testContainsCoordinate(void)
+{
+    foreach (auto vertex, _polyPoints) {
+        _mapPolygon->appendVertex(vertex);
+    }
+
+    const QGeoCoordinate inside(47.633, -122.089);
+    const QGeoCoordinate outside(47.633, -122.080);
+    QVERIFY(_mapPolygon->containsCoordinate(inside));
+    QVERIFY(!_mapPolygon->containsCoordinate(outside));
+    QVERIFY(_mapPolygon->containsCoordinates({ inside, outside, _polyPoints[0] }) == QList<bool>({ true, false, _mapPolygon->containsCoordinate(_polyPoints[0]) }));
+
+    // The cached projection must follow edits, including those made while center dragging which don't signal
+    _mapPolygon->adjustVertex(1, QGeoCoordinate(47.635638361473475, -122.07));
+    _mapPolygon->adjustVertex(2, QGeoCoordinate(47.63057923872075, -122.07));
+    QVERIFY(_mapPolygon->containsCoordinate(outside));
+    QVERIFY(_mapPolygon->containsCoordinates({ outside }) == QList<bool>({ true }));
+
+    _mapPolygon->setCenterDrag(true);
+    _mapPolygon->setCenter(QGeoCoordinate(_mapPolygon->center().latitude() + 1, _mapPolygon->center().longitude()));
+    QVERIFY(!_mapPolygon->containsCoordinate(outside));
+    _mapPolygon->setCenterDrag(false);
+
+    _mapPolygon->clear();
+    QVERIFY(!_mapPolygon->containsCoordinate(inside));
+    QVERIFY(_mapPolygon->containsCoordinates({ inside }) == QList<bool>({ false }));
+}
@@ -30,8 +30,11 @@ private slots:
     void _testDirty(void);
     void _testVertexManipulation(void);
     void _testKMLLoad(void);
+    void _testKMLLoadLarge(void);
+    void _testSHPLoad(void);
     void _testSelectVertex(void);
     void _testSegmentSplit(void);
+    void _testContainsCoordinate(void);
 
 private:
     enum {
@@ -11,6 +11,15 @@
 #include "SurveyComplexItem.h"
 #include "PlanViewSettings.h"
 #include "MultiSignalSpy.h"
+#include "QGCGeo.h"
+#include "SHPFileHelper.h"
+#include "TransectRouteOptimizer.h"
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QtMath>
 
 SurveyComplexItemTest::SurveyComplexItemTest(void)
 {
@@ -355,3 +364,284 @@ void SurveyComplexItemTest::_testHoverCaptureItemGeneration(void)
     _testItemGenerationWorker(false /* imagesInTurnaround */, true /* hasTurnaround */, true /* useConditionGate */, expectedCommands);
     _testItemGenerationWorker(false /* imagesInTurnaround */, true /* hasTurnaround */, false /* useConditionGate */, expectedCommands);
 }
+
+void SurveyComplexItemTest::_testRebuildTransectsJob(void)
+{
+    // Large polygon with tight spacing which is built on a worker thread
+    const QGeoCoordinate center(47.633550640000003, -122.08982199);
+    QList<QGeoCoordinate> vertices;
+    for (int i=0; i<_largePolygonVertexCount; i++) {
+        vertices.append(center.atDistanceAndAzimuth(_largePolygonRadius, (360.0 * i) / _largePolygonVertexCount));
+    }
+    _mapPolygon->clear();
+    _mapPolygon->appendVertices(vertices);
+    _surveyItem->cameraCalc()->adjustedFootprintSide()->setRawValue(1.0);
+    QTRY_VERIFY_WITH_TIMEOUT(!_surveyItem->rebuildingTransects(), 30000);
+
+    // Changing the grid angle only starts the job, the GUI thread is not blocked on the transects
+    QElapsedTimer timer;
+    timer.start();
+    _surveyItem->gridAngle()->setRawValue(10);
+    qDebug() << "Grid angle change returned after" << timer.elapsed() << "msecs";
+    QVERIFY(_surveyItem->rebuildingTransects());
+
+    // A second change while running supersedes the first job
+    _surveyItem->gridAngle()->setRawValue(20);
+    QVERIFY(_surveyItem->rebuildingTransects());
+    QTRY_VERIFY_WITH_TIMEOUT(!_surveyItem->rebuildingTransects(), 30000);
+    qDebug() << "Transects rebuilt after" << timer.elapsed() << "msecs";
+
+    // Result must match a synchronous build for the final settings
+    const QList<QList<SurveyComplexItem::CoordInfo_t>> expectedTransects = SurveyComplexItem::_buildTransects(_surveyItem->_transectParams(), std::function<bool(double)>());
+    QVERIFY(expectedTransects.count() > _expectedTransectCount);
+    QCOMPARE(_surveyItem->_transectCount(), static_cast<int>(expectedTransects.count()));
+    QCOMPARE(_surveyItem->_transects.first().first().coord, expectedTransects.first().first().coord);
+    QCOMPARE(_surveyItem->_transects.last().last().coord, expectedTransects.last().last().coord);
+
+    // Cancelled jobs stop early and deliver nothing
+    const QList<QList<SurveyComplexItem::CoordInfo_t>> cancelledTransects = SurveyComplexItem::_buildTransects(_surveyItem->_transectParams(), [](double) { return false; });
+    QVERIFY(cancelledTransects.isEmpty());
+}
+
+/// Survey areas from the shape file fixtures
+void SurveyComplexItemTest::_testShapeFilePolygons(QList<QList<QGeoCoordinate>>& polygons)
+{
+    polygons.clear();
+
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    for (const QString& baseName : { QStringLiteral("MP 19"), QStringLiteral("Sarah's Farm") }) {
+        for (const QString& extension : { QStringLiteral(".shp"), QStringLiteral(".shx"), QStringLiteral(".prj") }) {
+            QVERIFY(QFile::copy(QStringLiteral(":/unittest/") + baseName + extension, directory.filePath(baseName + extension)));
+        }
+
+        QList<QGeoCoordinate> vertices;
+        QString errorString;
+        QVERIFY2(SHPFileHelper::loadPolygonFromFile(directory.filePath(baseName + QStringLiteral(".shp")), vertices, errorString), qPrintable(baseName + QStringLiteral(": ") + errorString));
+        QVERIFY(vertices.count() >= 3);
+        polygons << vertices;
+    }
+}
+
+/// Survey areas in NED: the shape file fixtures plus a jagged polygon with a large vertex count like detailed KML/SHP imports
+void SurveyComplexItemTest::_testPolygons(QList<QPolygonF>& polygons)
+{
+    polygons.clear();
+
+    QList<QList<QGeoCoordinate>> shapeFilePolygons;
+    _testShapeFilePolygons(shapeFilePolygons);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+
+    for (const QList<QGeoCoordinate>& vertices : shapeFilePolygons) {
+        const QGCGeo::NedOrigin nedOrigin(vertices.first());
+        QPolygonF polygon;
+        for (const QGeoCoordinate& vertex : vertices) {
+            double north, east, down;
+            nedOrigin.convertGeoToNed(vertex, north, east, down);
+            polygon << QPointF(east, north);
+        }
+        polygons << polygon;
+    }
+
+    QRandomGenerator random(1);
+    QPolygonF jaggedPolygon;
+    for (int i=0; i<_jaggedPolygonVertexCount; i++) {
+        const double angle = (2.0 * M_PI * i) / _jaggedPolygonVertexCount;
+        const double radius = 500.0 + random.bounded(400.0);
+        jaggedPolygon << QPointF(radius * qCos(angle), radius * qSin(angle));
+    }
+    polygons << jaggedPolygon;
+}
+
+void SurveyComplexItemTest::_testPolygonDecomposeConvex(void)
+{
+    const auto signedArea = [](const QPolygonF& polygon) {
+        double area = 0;
+        for (qsizetype i=0; i<polygon.count(); i++) {
+            const QPointF& p1 = polygon[i];
+            const QPointF& p2 = polygon[(i + 1) % polygon.count()];
+            area += (p1.x() * p2.y()) - (p2.x() * p1.y());
+        }
+        return area / 2.0;
+    };
+
+    QList<QPolygonF> polygons;
+    _testPolygons(polygons);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+    QCOMPARE(polygons.count(), static_cast<qsizetype>(3));
+
+    for (const QPolygonF& polygon : polygons) {
+        QList<QPolygonF> pieces;
+        QElapsedTimer timer;
+        timer.start();
+        SurveyComplexItem::_PolygonDecomposeConvex(polygon, pieces);
+        qDebug() << "Decomposed" << polygon.count() << "vertices into" << pieces.count() << "convex pieces in" << timer.elapsed() << "msecs";
+
+        QVERIFY(!pieces.isEmpty());
+        QVERIFY(pieces.count() <= polygon.count() - 2);
+
+        double piecesArea = 0;
+        for (const QPolygonF& piece : pieces) {
+            QVERIFY(piece.count() >= 3);
+            piecesArea += signedArea(piece);
+
+            // Counter-clockwise and convex: no vertex turns right
+            for (qsizetype i=0; i<piece.count(); i++) {
+                const QPointF ab = piece[(i + 1) % piece.count()] - piece[i];
+                const QPointF ac = piece[(i + 2) % piece.count()] - piece[i];
+                QVERIFY(((ab.x() * ac.y()) - (ab.y() * ac.x())) >= -1e-6);
+            }
+        }
+        QVERIFY(qAbs(piecesArea - qAbs(signedArea(polygon))) < (qAbs(signedArea(polygon)) * 1e-9));
+    }
+}
+
+void SurveyComplexItemTest::_testIntersectLinesWithPolygon(void)
+{
+    // Every line against every edge, as the survey used to do it
+    const auto referenceIntersect = [](const QList<QLineF>& lineList, const QPolygonF& polygon) {
+        QList<QLineF> resultLines;
+        for (const QLineF& line : lineList) {
+            QList<QPointF> intersections;
+            for (qsizetype j=0; j<polygon.count()-1; j++) {
+                QPointF intersectPoint;
+                if ((line.intersects(QLineF(polygon[j], polygon[j+1]), &intersectPoint) == QLineF::BoundedIntersection) && !intersections.contains(intersectPoint)) {
+                    intersections.append(intersectPoint);
+                }
+            }
+            double maxDistance = 0;
+            QLineF transect;
+            for (const QPointF& p1 : intersections) {
+                for (const QPointF& p2 : intersections) {
+                    if (QLineF(p1, p2).length() > maxDistance) {
+                        maxDistance = QLineF(p1, p2).length();
+                        transect = QLineF(p1, p2);
+                    }
+                }
+            }
+            if (intersections.count() > 1) {
+                resultLines.append(transect);
+            }
+        }
+        return resultLines;
+    };
+
+    QList<QPolygonF> polygons;
+    _testPolygons(polygons);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+
+    for (QPolygonF polygon : polygons) {
+        polygon << polygon.first();
+
+        const QRectF boundingRect = polygon.boundingRect();
+        const QPointF center = boundingRect.center();
+        const double halfWidth = (qMax(boundingRect.width(), boundingRect.height()) + 2000.0) / 2.0;
+        const double spacing = halfWidth / 200.0;
+
+        for (double gridAngle : { 0.0, 30.0, -75.0 }) {
+            QList<QLineF> lineList;
+            for (double x=center.x()-halfWidth; x<center.x()+halfWidth; x+=spacing) {
+                lineList += QLineF(SurveyComplexItem::_rotatePoint(QPointF(x, center.y() - halfWidth), center, gridAngle),
+                                   SurveyComplexItem::_rotatePoint(QPointF(x, center.y() + halfWidth), center, gridAngle));
+            }
+
+            QElapsedTimer timer;
+            timer.start();
+            QList<QLineF> resultLines;
+            SurveyComplexItem::_intersectLinesWithPolygon(lineList, polygon, resultLines);
+            const qint64 sweepMsecs = timer.restart();
+            const QList<QLineF> expectedLines = referenceIntersect(lineList, polygon);
+            qDebug() << "Intersected" << lineList.count() << "lines with" << polygon.count() << "vertices in" << sweepMsecs << "msecs, brute force" << timer.elapsed() << "msecs";
+
+            QCOMPARE(resultLines.count(), expectedLines.count());
+            for (qsizetype i=0; i<resultLines.count(); i++) {
+                QVERIFY(QLineF(resultLines[i].p1(), expectedLines[i].p1()).length() < 1e-6);
+                QVERIFY(QLineF(resultLines[i].p2(), expectedLines[i].p2()).length() < 1e-6);
+            }
+        }
+    }
+}
+
+void SurveyComplexItemTest::_testOptimizeTransectOrder(void)
+{
+    const auto transitDistance = [](const QList<QList<SurveyComplexItem::CoordInfo_t>>& transects) {
+        double distance = 0;
+        for (qsizetype i=1; i<transects.count(); i++) {
+            distance += transects[i - 1].last().coord.distanceTo(transects[i].first().coord);
+        }
+        return distance;
+    };
+
+    QList<QList<QGeoCoordinate>> shapeFilePolygons;
+    _testShapeFilePolygons(shapeFilePolygons);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+
+    // The optimized order is never longer than the lawnmower pattern
+    for (const QList<QGeoCoordinate>& vertices : shapeFilePolygons) {
+        for (double gridAngle : { 0.0, 35.0 }) {
+            SurveyComplexItem::TransectParams_t params = _surveyItem->_transectParams();
+            params.polygon = vertices;
+            params.gridAngle = gridAngle;
+            params.gridSpacing = 20;
+            params.refly90Degrees = true;
+            params.flyAlternateTransects = false;
+
+            params.optimizeTransectOrder = false;
+            const QList<QList<SurveyComplexItem::CoordInfo_t>> lawnmowerTransects = SurveyComplexItem::_buildTransects(params, std::function<bool(double)>());
+            params.optimizeTransectOrder = true;
+            QElapsedTimer timer;
+            timer.start();
+            const QList<QList<SurveyComplexItem::CoordInfo_t>> optimizedTransects = SurveyComplexItem::_buildTransects(params, std::function<bool(double)>());
+            const qint64 optimizeMsecs = timer.elapsed();
+
+            const double lawnmowerDistance = transitDistance(lawnmowerTransects);
+            const double optimizedDistance = transitDistance(optimizedTransects);
+            qDebug() << "Shape file transects" << optimizedTransects.count() << "grid angle" << gridAngle << "transit distance lawnmower:optimized" << lawnmowerDistance << optimizedDistance
+                     << "saved" << (lawnmowerDistance - optimizedDistance) << "meters in" << optimizeMsecs << "msecs";
+
+            QCOMPARE(optimizedTransects.count(), lawnmowerTransects.count());
+            QVERIFY(optimizedDistance <= lawnmowerDistance + 0.01);
+        }
+    }
+
+    // Scattered transects, like the pieces of a split survey, gain a lot over the order they were generated in
+    QRandomGenerator random(1);
+    QList<QPointF> entries;
+    QList<QPointF> exits;
+    TransectRouteOptimizer::Route_t initialRoute;
+    for (int i=0; i<200; i++) {
+        const QPointF entry(random.bounded(2000.0), random.bounded(2000.0));
+        entries << entry;
+        exits << entry + QPointF(random.bounded(200.0), random.bounded(200.0));
+        initialRoute.append({ i, false });
+    }
+    const TransectRouteOptimizer optimizer(entries, exits, QPointF(0, 0));
+    const TransectRouteOptimizer::Route_t route = optimizer.optimize(initialRoute, 5000000, 60000);
+
+    QCOMPARE(route.count(), initialRoute.count());
+    QList<bool> visited(entries.count(), false);
+    for (const TransectRouteOptimizer::Visit_t& visit : route) {
+        QVERIFY(!visited[visit.transect]);
+        visited[visit.transect] = true;
+    }
+    qDebug() << "Scattered transects transit distance initial:optimized" << optimizer.transitDistance(initialRoute) << optimizer.transitDistance(route);
+    QVERIFY(optimizer.transitDistance(route) < optimizer.transitDistance(initialRoute) / 4);
+
+    // The route only depends on the evaluation budget, so a worker thread running the starts in parallel gets the same one
+    const TransectRouteOptimizer::Route_t workerRoute = QtConcurrent::run([&optimizer, &initialRoute]() {
+        return optimizer.optimize(initialRoute, 5000000, 60000);
+    }).result();
+    QCOMPARE(workerRoute.count(), route.count());
+    for (int i=0; i<route.count(); i++) {
+        QCOMPARE(workerRoute[i].transect, route[i].transect);
+        QCOMPARE(workerRoute[i].reversed, route[i].reversed);
+    }
+}
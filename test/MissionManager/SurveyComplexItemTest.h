@@ -11,6 +11,7 @@
 
 #include "TransectStyleComplexItemTestBase.h"
 
+#include <QtGui/QPolygonF>
 #include <QtPositioning/QGeoCoordinate>
 
 class SurveyComplexItem;
@@ -37,6 +38,10 @@ private slots:
     void _testItemGeneration(void);
     void _testItemCount(void);
     void _testHoverCaptureItemGeneration(void);
+    void _testRebuildTransectsJob(void);
+    void _testPolygonDecomposeConvex(void);
+    void _testIntersectLinesWithPolygon(void);
+    void _testOptimizeTransectOrder(void);
 #else
     // Handy mechanism to to a single test
 private slots:
@@ -47,12 +52,19 @@ private:
     void _testEntryLocation(void);
     void _testItemGeneration(void);
     void _testHoverCaptureItemGeneration(void);
+    void _testRebuildTransectsJob(void);
+    void _testPolygonDecomposeConvex(void);
+    void _testIntersectLinesWithPolygon(void);
+    void _testOptimizeTransectOrder(void);
 #endif
 
 private:
     double          _clampGridAngle180(double gridAngle);
     QList<MAV_CMD>  _createExpectedCommands(bool hasTurnaround, bool useConditionGate);
     void            _testItemGenerationWorker(bool imagesInTurnaround, bool hasTurnaround, bool useConditionGate, const QList<MAV_CMD>& expectedCommands);
+    /// Check QTest::currentTestFailed() after these, the fixtures are verified as they are loaded
+    void            _testShapeFilePolygons(QList<QList<QGeoCoordinate>>& polygons);
+    void            _testPolygons(QList<QPolygonF>& polygons);
 
     // SurveyComplexItem signals
 
@@ -84,4 +96,7 @@ private:
     QList<QGeoCoordinate>   _polyVertices;
 
     static const int _expectedTransectCount = 2;
+    static constexpr int    _largePolygonVertexCount =  200;
+    static constexpr double _largePolygonRadius =       3000;
+    static constexpr int    _jaggedPolygonVertexCount = 2500;
 };
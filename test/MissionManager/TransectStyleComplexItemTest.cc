@@ -12,7 +12,10 @@
 #include "PlanMasterController.h"
 #include "MultiSignalSpyV2.h"
 #include "TerrainQueryTest.h"
+#include "QGCGeo.h"
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QtMath>
 #include <QtTest/QTest>
 
 TransectStyleComplexItemTest::TransectStyleComplexItemTest(void)
@@ -210,6 +213,97 @@ void TransectStyleComplexItemTest::_testAltitudes(void)
     }
 }
 
+void TransectStyleComplexItemTest::_testCalcAboveTerrainFlightPath(void)
+{
+    // Synthetic mountainous carpet: 200 lawnmower transects of 2km with a terrain height every 10m
+    static constexpr int    transectCount       = 200;
+    static constexpr double transectLength      = 2000;
+    static constexpr double transectSpacing     = 20;
+    static constexpr double sampleSpacing       = 10;
+    static constexpr double distanceToSurface   = 50;
+    static constexpr double maxRate             = 3;
+    static constexpr double flightSpeed         = 10;
+    static constexpr double tolerance           = 10;
+
+    const QGeoCoordinate origin = UnitTestTerrainQuery::linearSlopeRegion.center();
+    const auto terrainHeight = [](double north, double east) {
+        return 1000 + (400 * qSin(north / 350) * qCos(east / 500)) + (40 * qSin(east / 45));
+    };
+    const auto toGeo = [&origin](double north, double east) {
+        QGeoCoordinate coord;
+        QGCGeo::convertNedToGeo(north, east, 0, origin, coord);
+        return QGeoCoordinate(coord.latitude(), coord.longitude());
+    };
+
+    QList<QList<TransectStyleComplexItem::CoordInfo_t>> transects;
+    QList<QPointF> vertices;
+    for (int i=0; i<transectCount; i++) {
+        const double north = i * transectSpacing;
+        const double entryEast = (i % 2) ? transectLength : 0;
+        const double exitEast = transectLength - entryEast;
+        transects.append({ { toGeo(north, entryEast), TransectStyleComplexItem::CoordTypeSurveyEntry },
+                           { toGeo(north, exitEast),  TransectStyleComplexItem::CoordTypeSurveyExit } });
+        vertices.append(QPointF(north, entryEast));
+        vertices.append(QPointF(north, exitEast));
+    }
+
+    int sampleCount = 0;
+    QList<TerrainPathQuery::PathHeightInfo_t> rgPathHeightInfo;
+    for (int i=0; i<vertices.count() - 1; i++) {
+        const QPointF from = vertices[i];
+        const QPointF delta = vertices[i + 1] - from;
+        const int cHeights = qCeil(qSqrt(QPointF::dotProduct(delta, delta)) / sampleSpacing) + 1;
+
+        TerrainPathQuery::PathHeightInfo_t pathHeightInfo;
+        for (int j=0; j<cHeights; j++) {
+            const QPointF sample = from + (delta * (static_cast<double>(j) / (cHeights - 1)));
+            pathHeightInfo.heights.append(terrainHeight(sample.x(), sample.y()));
+        }
+        sampleCount += cHeights;
+        rgPathHeightInfo.append(pathHeightInfo);
+    }
+
+    TransectStyleComplexItem::TerrainAdjustParams_t params;
+    params.distanceToSurface    = distanceToSurface;
+    params.maxClimbRate         = maxRate;
+    params.maxDescentRate       = maxRate;
+    params.flightSpeed          = flightSpeed;
+    params.tolerance            = tolerance;
+
+    QElapsedTimer timer;
+    timer.start();
+    const TransectStyleComplexItem::TerrainAdjustResult_t result = TransectStyleComplexItem::_calcAboveTerrainFlightPath(transects, rgPathHeightInfo, params);
+    qDebug() << "_calcAboveTerrainFlightPath samples:points:msecs" << sampleCount << result.flightPath.count() << timer.elapsed();
+
+    QVERIFY(result.flightPath.count() > 2 * transectCount);
+    QCOMPARE(result.flightPath.first().coord.latitude(), transects.first().first().coord.latitude());
+    QCOMPARE(result.flightPath.last().coord.longitude(), transects.last().last().coord.longitude());
+
+    const QGCGeo::NedOrigin nedOrigin(origin);
+    int transectPointCount = 0;
+    for (int i=0; i<result.flightPath.count(); i++) {
+        const TransectStyleComplexItem::CoordInfo_t& coordInfo = result.flightPath[i];
+        if (coordInfo.coordType != TransectStyleComplexItem::CoordTypeInteriorTerrainAdded) {
+            transectPointCount++;
+        }
+
+        // Altitudes are only ever raised above the terrain
+        double north, east, down;
+        nedOrigin.convertGeoToNed(QGeoCoordinate(coordInfo.coord.latitude(), coordInfo.coord.longitude(), 0), north, east, down);
+        QVERIFY(coordInfo.coord.altitude() >= terrainHeight(north, east) + distanceToSurface - 0.1);
+        QVERIFY(coordInfo.coord.altitude() >= result.minAMSLAltitude);
+        QVERIFY(coordInfo.coord.altitude() <= result.maxAMSLAltitude);
+
+        if (i > 0) {
+            const QGeoCoordinate& previousCoord = result.flightPath[i - 1].coord;
+            const double seconds = previousCoord.distanceTo(coordInfo.coord) / flightSpeed;
+            const double rate = (coordInfo.coord.altitude() - previousCoord.altitude()) / seconds;
+            QVERIFY(qAbs(rate) < maxRate + 0.15);
+        }
+    }
+    QCOMPARE(transectPointCount, 2 * transectCount);
+}
+
 // TODO: Move To Terrain Testing
 /*void TransectStyleComplexItemTest::_testFollowTerrain(void)
 {
@@ -34,6 +34,7 @@ private slots:
     void _testRebuildTransects  (void);
     void _testDistanceSignalling(void);
     void _testAltitudes         (void);
+    void _testCalcAboveTerrainFlightPath(void);
     // void _testFollowTerrain     (void);
 
 private:
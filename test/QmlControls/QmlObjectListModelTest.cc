@@ -0,0 +1,183 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "QmlObjectListModelTest.h"
+#include "QmlObjectListModel.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtTest/QSignalSpy>
+#include <QtTest/QTest>
+
+static QObjectList _createObjects(int count, QObject* parent)
+{
+    QObjectList objects;
+    for (int i=0; i<count; i++) {
+        objects.append(new DirtyTestObject(parent));
+    }
+    return objects;
+}
+
+void QmlObjectListModelTest::_testRanges(void)
+{
+    QmlObjectListModel model;
+    const QObjectList objects = _createObjects(10, this);
+
+    QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy removedSpy(&model, &QAbstractItemModel::rowsRemoved);
+    QSignalSpy movedSpy(&model, &QAbstractItemModel::rowsMoved);
+    QSignalSpy countSpy(&model, &QmlObjectListModel::countChanged);
+
+    model.append(objects.mid(0, 4));
+    model.insert(2, objects.mid(4, 6));
+    QCOMPARE(insertedSpy.count(), 2);
+    QCOMPARE(countSpy.count(), 2);
+    QVERIFY(*model.objectList() == (objects.mid(0, 2) + objects.mid(4, 6) + objects.mid(2, 2)));
+
+    // Move a range back and forth
+    model.moveRange(2, 6, 4);
+    QVERIFY(*model.objectList() == objects);
+    model.moveRange(4, 6, 2);
+    QVERIFY(*model.objectList() == (objects.mid(0, 2) + objects.mid(4, 6) + objects.mid(2, 2)));
+    model.move(0, 9);
+    QCOMPARE(model.get(9), objects[0]);
+    model.move(9, 0);
+    QCOMPARE(model.get(0), objects[0]);
+    QCOMPARE(movedSpy.count(), 4);
+
+    const QObjectList removed = model.removeRange(2, 6);
+    QVERIFY(removed == objects.mid(4, 6));
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(countSpy.count(), 3);
+    QCOMPARE(model.count(), 4);
+
+    // Removed objects no longer propagate dirty
+    model.setDirty(false);
+    qobject_cast<DirtyTestObject*>(removed[0])->setDirty(true);
+    QVERIFY(!model.dirty());
+    qobject_cast<DirtyTestObject*>(objects[0])->setDirty(true);
+    QVERIFY(model.dirty());
+
+    // Invalid ranges are ignored
+    QVERIFY(model.removeRange(3, 2).isEmpty());
+    model.moveRange(0, 2, 3);
+    QCOMPARE(model.count(), 4);
+    QCOMPARE(movedSpy.count(), 4);
+}
+
+void QmlObjectListModelTest::_testReplaceAll(void)
+{
+    QmlObjectListModel model;
+    const QObjectList objects = _createObjects(10, this);
+    model.append(objects.mid(0, 8));
+
+    QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy removedSpy(&model, &QAbstractItemModel::rowsRemoved);
+    QSignalSpy movedSpy(&model, &QAbstractItemModel::rowsMoved);
+    QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+
+    // Unchanged list signals nothing
+    QVERIFY(model.replaceAll(objects.mid(0, 8)).isEmpty());
+    QCOMPARE(insertedSpy.count() + removedSpy.count() + movedSpy.count(), 0);
+
+    // Remove a range in the middle, append to the end
+    QObjectList newList = objects.mid(0, 2) + objects.mid(5, 5);
+    QVERIFY(model.replaceAll(newList) == objects.mid(2, 3));
+    QVERIFY(*model.objectList() == newList);
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(insertedSpy.count(), 1);
+
+    // Swapping two ranges is a single move
+    newList = objects.mid(5, 5) + objects.mid(0, 2);
+    QVERIFY(model.replaceAll(newList).isEmpty());
+    QVERIFY(*model.objectList() == newList);
+    QCOMPARE(movedSpy.count(), 1);
+
+    // Mixed changes
+    newList = { objects[9], objects[2], objects[0], objects[6], objects[3], objects[7] };
+    const QObjectList removed = model.replaceAll(newList);
+    QVERIFY(*model.objectList() == newList);
+    QCOMPARE(removed.count(), 3);
+    for (QObject* object : { objects[1], objects[5], objects[8] }) {
+        QVERIFY(removed.contains(object));
+    }
+
+    QVERIFY(model.replaceAll(QObjectList()).count() == newList.count());
+    QCOMPARE(model.count(), 0);
+    QCOMPARE(resetSpy.count(), 0);
+}
+
+void QmlObjectListModelTest::_testDeferredSignals(void)
+{
+    QmlObjectListModel model;
+    const QObjectList objects = _createObjects(10, this);
+
+    QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+    QSignalSpy countSpy(&model, &QmlObjectListModel::countChanged);
+    QSignalSpy dirtySpy(&model, &QmlObjectListModel::dirtyChanged);
+
+    model.beginReset();
+    for (QObject* object : objects) {
+        model.append(object);
+    }
+    (void) model.removeAt(0);
+    qobject_cast<DirtyTestObject*>(objects[1])->setDirty(true);
+    QCOMPARE(countSpy.count(), 0);
+    QCOMPARE(dirtySpy.count(), 0);
+    model.endReset();
+
+    QCOMPARE(insertedSpy.count(), 0);
+    QCOMPARE(resetSpy.count(), 1);
+    QCOMPARE(countSpy.count(), 1);
+    QCOMPARE(countSpy.last().at(0).toInt(), 9);
+    QCOMPARE(dirtySpy.count(), 1);
+    QVERIFY(model.dirty());
+
+    // A reset which leaves the count alone does not signal it
+    model.beginReset();
+    (void) model.removeAt(0);
+    model.insert(0, objects[0]);
+    model.endReset();
+    QCOMPARE(countSpy.count(), 1);
+}
+
+void QmlObjectListModelTest::_testInsertBenchmark(void)
+{
+    static constexpr int objectCount = 10000;
+    const QObjectList objects = _createObjects(objectCount, this);
+
+    QElapsedTimer timer;
+
+    QmlObjectListModel singleModel;
+    QSignalSpy singleCountSpy(&singleModel, &QmlObjectListModel::countChanged);
+    timer.start();
+    for (QObject* object : objects) {
+        singleModel.append(object);
+    }
+    const qint64 singleMsecs = timer.elapsed();
+    QCOMPARE(singleModel.count(), objectCount);
+    QCOMPARE(singleCountSpy.count(), objectCount);
+
+    QmlObjectListModel bulkModel;
+    QSignalSpy bulkInsertedSpy(&bulkModel, &QAbstractItemModel::rowsInserted);
+    QSignalSpy bulkCountSpy(&bulkModel, &QmlObjectListModel::countChanged);
+    timer.restart();
+    bulkModel.append(objects);
+    const qint64 bulkMsecs = timer.elapsed();
+    QCOMPARE(bulkModel.count(), objectCount);
+    QCOMPARE(bulkInsertedSpy.count(), 1);
+    QCOMPARE(bulkCountSpy.count(), 1);
+
+    timer.restart();
+    (void) bulkModel.replaceAll(objects.mid(objectCount / 2) + objects.mid(0, objectCount / 2));
+    const qint64 replaceMsecs = timer.elapsed();
+    QCOMPARE(bulkModel.get(0), objects[objectCount / 2]);
+
+    qDebug() << "Insert" << objectCount << "objects msecs single:bulk:replaceAll" << singleMsecs << bulkMsecs << replaceMsecs;
+}
@@ -0,0 +1,43 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+/// List item with a dirty property, like the mission items the model usually holds
+class DirtyTestObject : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(bool dirty READ dirty WRITE setDirty NOTIFY dirtyChanged)
+
+public:
+    DirtyTestObject(QObject* parent = nullptr) : QObject(parent) { }
+
+    bool dirty(void) const { return _dirty; }
+    void setDirty(bool dirty) { if (dirty != _dirty) { _dirty = dirty; emit dirtyChanged(_dirty); } }
+
+signals:
+    void dirtyChanged(bool dirty);
+
+private:
+    bool _dirty = false;
+};
+
+class QmlObjectListModelTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testRanges            (void);
+    void _testReplaceAll        (void);
+    void _testDeferredSignals   (void);
+    void _testInsertBenchmark   (void);
+};
@@ -0,0 +1,172 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "LocalTileSourceTest.h"
+#include "LocalTileMapProvider.h"
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QSemaphore>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QThread>
+#include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
+#include <QtTest/QTest>
+
+#include <memory>
+
+bool LocalTileSourceTest::_createMBTiles(const QString &path, int x, int y, int zoom, const QByteArray &image)
+{
+    static constexpr const char *connectionName = "LocalTileSourceTest";
+
+    bool created = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+        db.setDatabaseName(path);
+        if (db.open()) {
+            QSqlQuery query(db);
+            created = query.exec(QStringLiteral("CREATE TABLE metadata (name TEXT, value TEXT)")) &&
+                query.exec(QStringLiteral("INSERT INTO metadata VALUES ('minzoom', '%1'), ('maxzoom', '%1')").arg(zoom)) &&
+                query.exec(QStringLiteral("CREATE TABLE tiles (zoom_level INTEGER, tile_column INTEGER, tile_row INTEGER, tile_data BLOB)"));
+            if (created) {
+                // MBTiles rows use TMS addressing with the origin in the bottom left
+                (void) query.prepare(QStringLiteral("INSERT INTO tiles VALUES (?, ?, ?, ?)"));
+                query.addBindValue(zoom);
+                query.addBindValue(x);
+                query.addBindValue((1 << zoom) - 1 - y);
+                query.addBindValue(image);
+                created = query.exec();
+            }
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    return created;
+}
+
+QStringList LocalTileSourceTest::_connectionNames()
+{
+    QStringList connectionNames;
+    for (const QString &connectionName : QSqlDatabase::connectionNames()) {
+        if (connectionName.startsWith(QLatin1String(LocalTileSource::kConnectionPrefix))) {
+            connectionNames.append(connectionName);
+        }
+    }
+    return connectionNames;
+}
+
+void LocalTileSourceTest::_testReadTile()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    const QByteArray image("tile image");
+    QVERIFY(_createMBTiles(directory.filePath(QStringLiteral("tiles.mbtiles")), kTileX, kTileY, kTileZoom, image));
+
+    LocalTileSource source;
+    source.setDirectory(directory.path());
+    QCOMPARE(source.files().count(), 1);
+
+    QCOMPARE(source.tile(kTileX, kTileY, kTileZoom), image);
+    // The row is flipped from TMS, the mirrored row holds nothing
+    QVERIFY(source.tile(kTileX, (1 << kTileZoom) - 1 - kTileY, kTileZoom).isEmpty());
+    // Outside of the zoom range of the package
+    QVERIFY(source.tile(kTileX * 2, kTileY * 2, kTileZoom + 1).isEmpty());
+}
+
+void LocalTileSourceTest::_testConcurrentReads()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    const QByteArray image("tile image");
+    QVERIFY(_createMBTiles(directory.filePath(QStringLiteral("tiles.mbtiles")), kTileX, kTileY, kTileZoom, image));
+
+    LocalTileSource source;
+    source.setDirectory(directory.path());
+    const qsizetype guiThreadConnections = _connectionNames().count();
+
+    QAtomicInt failedReads;
+    QList<QThread*> threads;
+    for (int i = 0; i < kReaderThreads; i++) {
+        threads.append(QThread::create([&source, &image, &failedReads]() {
+            for (int read = 0; read < kReadsPerThread; read++) {
+                if (source.tile(kTileX, kTileY, kTileZoom) != image) {
+                    (void) failedReads.fetchAndAddRelaxed(1);
+                }
+            }
+        }));
+        threads.last()->start();
+    }
+    for (QThread *thread : threads) {
+        QVERIFY(thread->wait(kTimeoutMsecs));
+    }
+    qDeleteAll(threads);
+
+    QCOMPARE(failedReads.loadRelaxed(), 0);
+    // Threads close their connections as they exit
+    QCOMPARE(_connectionNames().count(), guiThreadConnections);
+}
+
+QStringList LocalTileSourceTest::_threadConnectionNames(LocalTileSource &source)
+{
+    return source._threadConnections.hasLocalData() ? source._threadConnections.localData()->connectionNames : QStringList();
+}
+
+void LocalTileSourceTest::_testCrossThreadClose()
+{
+    QTemporaryDir oldDirectory;
+    QTemporaryDir newDirectory;
+    QVERIFY(oldDirectory.isValid() && newDirectory.isValid());
+    const QByteArray oldImage("old tile image");
+    const QByteArray newImage("new tile image");
+    QVERIFY(_createMBTiles(oldDirectory.filePath(QStringLiteral("tiles.mbtiles")), kTileX, kTileY, kTileZoom, oldImage));
+    QVERIFY(_createMBTiles(newDirectory.filePath(QStringLiteral("tiles.mbtiles")), kTileX, kTileY, kTileZoom, newImage));
+
+    LocalTileSource source;
+    source.setDirectory(oldDirectory.path());
+    const QStringList guiOldConnections = _threadConnectionNames(source);
+    QCOMPARE(guiOldConnections.count(), 1);
+
+    // The reader keeps its thread, and with it its connections, across the directory change
+    QSemaphore firstReadDone;
+    QSemaphore directoryChanged;
+    QByteArray firstRead;
+    QByteArray secondRead;
+    QStringList readerOldConnections;
+    QStringList readerNewConnections;
+    std::unique_ptr<QThread> reader(QThread::create([&]() {
+        firstRead = source.tile(kTileX, kTileY, kTileZoom);
+        readerOldConnections = _threadConnectionNames(source);
+        firstReadDone.release();
+        if (!directoryChanged.tryAcquire(1, kTimeoutMsecs)) {
+            return;
+        }
+        secondRead = source.tile(kTileX, kTileY, kTileZoom);
+        readerNewConnections = _threadConnectionNames(source);
+    }));
+    reader->start();
+
+    QVERIFY(firstReadDone.tryAcquire(1, kTimeoutMsecs));
+    QCOMPARE(firstRead, oldImage);
+    QCOMPARE(readerOldConnections.count(), 1);
+    QVERIFY(readerOldConnections.first() != guiOldConnections.first());
+
+    // The GUI thread closes its own connection to the old file, the reader's stays open until its next read
+    source.setDirectory(newDirectory.path());
+    QVERIFY(!QSqlDatabase::contains(guiOldConnections.first()));
+    QVERIFY(QSqlDatabase::contains(readerOldConnections.first()));
+    directoryChanged.release();
+
+    QVERIFY(reader->wait(kTimeoutMsecs));
+    QCOMPARE(secondRead, newImage);
+    QCOMPARE(readerNewConnections.count(), 1);
+    QVERIFY(readerNewConnections.first() != readerOldConnections.first());
+    QVERIFY(!QSqlDatabase::contains(readerOldConnections.first()));
+    // Closed as the reader thread exited
+    QVERIFY(!QSqlDatabase::contains(readerNewConnections.first()));
+}
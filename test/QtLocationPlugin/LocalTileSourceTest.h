@@ -0,0 +1,40 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+class LocalTileSource;
+
+/// Reads tiles from MBTiles packages created by the test, from the GUI thread and from worker threads
+class LocalTileSourceTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testReadTile();
+    void _testConcurrentReads();
+    void _testCrossThreadClose();
+
+private:
+    /// Creates an MBTiles package holding one tile in XYZ tile coordinates
+    static bool _createMBTiles(const QString &path, int x, int y, int zoom, const QByteArray &image);
+    /// Names of the local tile connections of all sources and threads
+    static QStringList _connectionNames();
+    /// Names of the connections source opened for the calling thread
+    static QStringList _threadConnectionNames(LocalTileSource &source);
+
+    static constexpr int kTileX = 5;
+    static constexpr int kTileY = 3;
+    static constexpr int kTileZoom = 4;
+    static constexpr int kReaderThreads = 4;
+    static constexpr int kReadsPerThread = 200;
+    static constexpr int kTimeoutMsecs = 10000;
+};
@@ -0,0 +1,82 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "QGCMapUrlEngineTest.h"
+#include "QGCMapUrlEngine.h"
+#include "ElevationMapProvider.h"
+#include "MapProvider.h"
+
+#include <QtCore/QSet>
+#include <QtTest/QTest>
+
+#include <limits>
+
+void QGCMapUrlEngineTest::_testProviderIdsUnique()
+{
+    // Provider ids are a hash of the map name, a new provider may collide with an existing one
+    QVERIFY(UrlFactory::providerIdsUnique());
+
+    for (const SharedMapProvider &provider : UrlFactory::getProviders()) {
+        QCOMPARE(UrlFactory::getProviderIdFromProviderType(provider->getMapName()), provider->getProviderId());
+        QCOMPARE(UrlFactory::tileKeyToType(UrlFactory::getTileKey(provider->getMapName(), 1, 1, 2)), provider->getMapName());
+    }
+}
+
+void QGCMapUrlEngineTest::_testPackTileKey()
+{
+    static constexpr quint16 providerId = 0x7fff;
+
+    // Every tile of the first zoom levels gets its own key, the provider id stays in the top bits
+    QSet<quint64> keys;
+    for (int z = 0; z <= 5; z++) {
+        for (int y = 0; y < (1 << z); y++) {
+            for (int x = 0; x < (1 << z); x++) {
+                const quint64 key = UrlFactory::packTileKey(providerId, x, y, z);
+                QCOMPARE(UrlFactory::tileKeyToProviderId(key), providerId);
+                keys.insert(key);
+            }
+        }
+    }
+    QCOMPARE(keys.count(), static_cast<qsizetype>(((1 << (2 * 6)) - 1) / 3));
+
+    // Keys fit SQLite's signed integer primary keys up to the maximum zoom
+    const int maxZoom = static_cast<int>(MAX_MAP_ZOOM);
+    const quint64 maxKey = UrlFactory::packTileKey(providerId, (1 << maxZoom) - 1, (1 << maxZoom) - 1, maxZoom);
+    QVERIFY(maxKey <= static_cast<quint64>(std::numeric_limits<qint64>::max()));
+    QCOMPARE(UrlFactory::tileKeyToProviderId(maxKey), providerId);
+
+    // Grid tiles beyond 2^z are packed past the quadtree range
+    const quint64 gridKey = UrlFactory::packTileKey(providerId, 20000, 9000, 1);
+    QCOMPARE(UrlFactory::tileKeyToProviderId(gridKey), providerId);
+    QVERIFY((gridKey & ((Q_UINT64_C(1) << UrlFactory::kTileKeyProviderShift) - 1)) >= UrlFactory::kTileKeyGridBase);
+    QVERIFY(gridKey != UrlFactory::packTileKey(providerId, 9000, 20000, 1));
+}
+
+void QGCMapUrlEngineTest::_testTileKeyFromLegacyHash()
+{
+    const auto legacyHash = [](const QString &type, int x, int y, int z) {
+        return QString::asprintf("%010d%08d%08d%03d", UrlFactory::hashFromProviderType(type), x, y, z);
+    };
+
+    for (const SharedMapProvider &provider : UrlFactory::getProviders()) {
+        const QString type = provider->getMapName();
+        QCOMPARE(UrlFactory::tileKeyFromLegacyHash(legacyHash(type, 3, 5, 4)), UrlFactory::getTileKey(type, 3, 5, 4));
+    }
+
+    // Elevation tiles use grid coordinates beyond 2^z
+    const QString elevationType = QString::fromLatin1(CopernicusElevationProvider::kProviderKey);
+    QCOMPARE(UrlFactory::tileKeyFromLegacyHash(legacyHash(elevationType, 20000, 9000, 1)), UrlFactory::getTileKey(elevationType, 20000, 9000, 1));
+
+    QCOMPARE(UrlFactory::tileKeyFromLegacyHash(QString()), UrlFactory::kInvalidTileKey);
+    QCOMPARE(UrlFactory::tileKeyFromLegacyHash(legacyHash(QStringLiteral("Bing Satellite"), 1, 1, 2).chopped(1)), UrlFactory::kInvalidTileKey);
+    QCOMPARE(UrlFactory::tileKeyFromLegacyHash(QStringLiteral("0000000001000000010000000100x")), UrlFactory::kInvalidTileKey);
+    QCOMPARE(UrlFactory::tileKeyFromLegacyHash(legacyHash(QStringLiteral("Bing Satellite"), 1, 1, 99)), UrlFactory::kInvalidTileKey);
+    // No provider has this name hash
+    QCOMPARE(UrlFactory::tileKeyFromLegacyHash(QStringLiteral("00000000010000000100000001002")), UrlFactory::kInvalidTileKey);
+}
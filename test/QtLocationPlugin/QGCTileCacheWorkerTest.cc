@@ -0,0 +1,421 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "QGCTileCacheWorkerTest.h"
+#include "QGCTileCacheWorker.h"
+#include "QGCCachedTileSet.h"
+#include "QGCCacheTile.h"
+#include "QGCMapTasks.h"
+#include "QGCMapUrlEngine.h"
+#include "ElevationMapProvider.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QSemaphore>
+#include <QtCore/QTemporaryDir>
+#include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
+#include <QtTest/QTest>
+#include <QtTest/QSignalSpy>
+
+bool QGCTileCacheWorkerTest::_initDatabase(QGCCacheWorker &worker, const QString &cachePath)
+{
+    worker.setDatabaseFile(cachePath);
+    if (!worker.enqueueTask(new QGCMapTask(QGCMapTask::taskInit))) {
+        return false;
+    }
+
+    // Tasks other than init are rejected until the worker thread has created the database
+    QObject context;
+    QList<QGCCachedTileSet*> tileSets;
+    const bool queued = QTest::qWaitFor([&worker, &context, &tileSets]() {
+        QGCFetchTileSetTask* const task = new QGCFetchTileSetTask();
+        (void) QObject::connect(task, &QGCFetchTileSetTask::tileSetFetched, &context, [&tileSets](QGCCachedTileSet *tileSet) {
+            tileSets.append(tileSet);
+        });
+        return worker.enqueueTask(task);
+    }, kTaskTimeoutMsecs);
+
+    const bool fetched = queued && QTest::qWaitFor([&tileSets]() { return !tileSets.isEmpty(); }, kTaskTimeoutMsecs);
+    qDeleteAll(tileSets);
+    return fetched;
+}
+
+void QGCTileCacheWorkerTest::_stopWorker(QGCCacheWorker &worker)
+{
+    worker.stop();
+    QVERIFY(worker.wait(kTaskTimeoutMsecs));
+}
+
+quint64 QGCTileCacheWorkerTest::_createSyntheticSet(const QString &cachePath, int tileCount)
+{
+    quint64 setID = 0;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), kTestConnection);
+        db.setDatabaseName(cachePath);
+        if (db.open()) {
+            QSqlQuery query(db);
+            (void) db.transaction();
+            query.prepare(QStringLiteral("INSERT INTO TileSets(name, typeStr, minZoom, maxZoom, type, numTiles, date) VALUES(?, ?, ?, ?, ?, ?, ?)"));
+            query.addBindValue(QString(kSyntheticSetName));
+            query.addBindValue(QString(kSyntheticMapType));
+            query.addBindValue(kSyntheticZoom);
+            query.addBindValue(kSyntheticZoom);
+            query.addBindValue(UrlFactory::getQtMapIdFromProviderType(QString(kSyntheticMapType)));
+            query.addBindValue(tileCount);
+            query.addBindValue(QDateTime::currentDateTime().toSecsSinceEpoch());
+            if (query.exec()) {
+                setID = query.lastInsertId().toULongLong();
+
+                const quint16 providerId = UrlFactory::getProviderIdFromProviderType(QString(kSyntheticMapType));
+                const int tilesPerRow = 1 << kSyntheticZoom;
+                const QByteArray image(kSyntheticTileSize, 'x');
+
+                QSqlQuery tileQuery(db);
+                (void) tileQuery.prepare(QStringLiteral("INSERT INTO Tiles(tileID, format, tile, size, type, date) VALUES(?, ?, ?, ?, ?, ?)"));
+                QSqlQuery setTileQuery(db);
+                (void) setTileQuery.prepare(QStringLiteral("INSERT INTO SetTiles(tileID, setID) VALUES(?, ?)"));
+                for (int i = 0; i < tileCount; i++) {
+                    const quint64 tileKey = UrlFactory::packTileKey(providerId, i % tilesPerRow, i / tilesPerRow, kSyntheticZoom);
+                    tileQuery.addBindValue(tileKey);
+                    tileQuery.addBindValue(QStringLiteral("png"));
+                    tileQuery.addBindValue(image);
+                    tileQuery.addBindValue(image.size());
+                    tileQuery.addBindValue(UrlFactory::getQtMapIdFromProviderType(QString(kSyntheticMapType)));
+                    tileQuery.addBindValue(QDateTime::currentDateTime().toSecsSinceEpoch());
+                    setTileQuery.addBindValue(tileKey);
+                    setTileQuery.addBindValue(setID);
+                    if (!tileQuery.exec() || !setTileQuery.exec()) {
+                        setID = 0;
+                        break;
+                    }
+                }
+            }
+            if (setID) {
+                (void) db.commit();
+            } else {
+                (void) db.rollback();
+            }
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(kTestConnection);
+
+    return setID;
+}
+
+quint64 QGCTileCacheWorkerTest::_createLegacyDatabase(const QString &cachePath)
+{
+    static const QStringList schema = {
+        QStringLiteral("CREATE TABLE Tiles (tileID INTEGER PRIMARY KEY NOT NULL, hash TEXT NOT NULL UNIQUE, format TEXT NOT NULL, tile BLOB NULL, size INTEGER, type INTEGER, date INTEGER DEFAULT 0)"),
+        QStringLiteral("CREATE TABLE TileSets (setID INTEGER PRIMARY KEY NOT NULL, name TEXT NOT NULL UNIQUE, typeStr TEXT, topleftLat REAL DEFAULT 0.0, topleftLon REAL DEFAULT 0.0, bottomRightLat REAL DEFAULT 0.0, bottomRightLon REAL DEFAULT 0.0, minZoom INTEGER DEFAULT 3, maxZoom INTEGER DEFAULT 3, type INTEGER DEFAULT -1, numTiles INTEGER DEFAULT 0, defaultSet INTEGER DEFAULT 0, date INTEGER DEFAULT 0)"),
+        QStringLiteral("CREATE TABLE SetTiles (setID INTEGER, tileID INTEGER)"),
+        QStringLiteral("CREATE TABLE TilesDownload (setID INTEGER, hash TEXT NOT NULL UNIQUE, type INTEGER, x INTEGER, y INTEGER, z INTEGER, state INTEGER DEFAULT 0)"),
+    };
+    const QString elevationType = QString::fromLatin1(CopernicusElevationProvider::kProviderKey);
+    const QList<std::pair<QString, QByteArray>> tiles = {
+        { _legacyHash(QString(kSyntheticMapType), 3, 5, 4), QByteArrayLiteral("satellite") },
+        { _legacyHash(elevationType, 20000, 9000, 1), QByteArrayLiteral("elevation") },
+        // Hashes that do not parse are dropped by the migration
+        { QStringLiteral("invalid"), QByteArrayLiteral("invalid") },
+    };
+
+    quint64 setID = 0;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), kTestConnection);
+        db.setDatabaseName(cachePath);
+        if (db.open()) {
+            QSqlQuery query(db);
+            bool res = true;
+            for (const QString &statement : schema) {
+                res = res && query.exec(statement);
+            }
+            if (res) {
+                query.prepare(QStringLiteral("INSERT INTO TileSets(name, typeStr, minZoom, maxZoom, type, numTiles, date) VALUES(?, ?, ?, ?, ?, ?, ?)"));
+                query.addBindValue(QString(kLegacySetName));
+                query.addBindValue(QString(kSyntheticMapType));
+                query.addBindValue(1);
+                query.addBindValue(4);
+                query.addBindValue(UrlFactory::getQtMapIdFromProviderType(QString(kSyntheticMapType)));
+                query.addBindValue(tiles.size());
+                query.addBindValue(QDateTime::currentDateTime().toSecsSinceEpoch());
+                res = query.exec();
+                setID = res ? query.lastInsertId().toULongLong() : 0;
+            }
+            for (const std::pair<QString, QByteArray> &tile : tiles) {
+                if (!res) {
+                    break;
+                }
+                query.prepare(QStringLiteral("INSERT INTO Tiles(hash, format, tile, size, type, date) VALUES(?, ?, ?, ?, ?, ?)"));
+                query.addBindValue(tile.first);
+                query.addBindValue(QStringLiteral("png"));
+                query.addBindValue(tile.second);
+                query.addBindValue(tile.second.size());
+                query.addBindValue(UrlFactory::getQtMapIdFromProviderType(QString(kSyntheticMapType)));
+                query.addBindValue(QDateTime::currentDateTime().toSecsSinceEpoch());
+                res = query.exec();
+                if (res) {
+                    const qulonglong tileID = query.lastInsertId().toULongLong();
+                    query.prepare(QStringLiteral("INSERT INTO SetTiles(setID, tileID) VALUES(?, ?)"));
+                    query.addBindValue(setID);
+                    query.addBindValue(tileID);
+                    res = query.exec();
+                }
+            }
+            if (res) {
+                query.prepare(QStringLiteral("INSERT INTO TilesDownload(setID, hash, type, x, y, z, state) VALUES(?, ?, ?, ?, ?, ?, ?)"));
+                query.addBindValue(setID);
+                query.addBindValue(_legacyHash(QString(kSyntheticMapType), 6, 7, 4));
+                query.addBindValue(UrlFactory::getQtMapIdFromProviderType(QString(kSyntheticMapType)));
+                query.addBindValue(6);
+                query.addBindValue(7);
+                query.addBindValue(4);
+                query.addBindValue(0);
+                res = query.exec();
+            }
+            if (!res) {
+                setID = 0;
+            }
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(kTestConnection);
+
+    return setID;
+}
+
+QString QGCTileCacheWorkerTest::_legacyHash(const QString &type, int x, int y, int z)
+{
+    return QString::asprintf("%010d%08d%08d%03d", UrlFactory::hashFromProviderType(type), x, y, z);
+}
+
+qint64 QGCTileCacheWorkerTest::_queryCount(const QString &databasePath, const QString &sql)
+{
+    qint64 count = -1;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), kTestConnection);
+        db.setDatabaseName(databasePath);
+        if (db.open()) {
+            QSqlQuery query(db);
+            if (query.exec(sql) && query.next()) {
+                count = query.value(0).toLongLong();
+            }
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(kTestConnection);
+
+    return count;
+}
+
+void QGCTileCacheWorkerTest::_setupSyntheticSet(QGCCachedTileSet &tileSet, quint64 setID)
+{
+    tileSet.setId(setID);
+    tileSet.setMapTypeStr(QString(kSyntheticMapType));
+    tileSet.setType(QString(kSyntheticMapType));
+    tileSet.setMinZoom(kSyntheticZoom);
+    tileSet.setMaxZoom(kSyntheticZoom);
+    tileSet.setTotalTileCount(kSyntheticTileCount);
+}
+
+bool QGCTileCacheWorkerTest::_exportSyntheticSet(const QString &cachePath, const QString &exportPath, qint64 &elapsedMsecs)
+{
+    QGCCacheWorker worker;
+    if (!_initDatabase(worker, cachePath)) {
+        _stopWorker(worker);
+        return false;
+    }
+
+    const quint64 setID = _createSyntheticSet(cachePath, kSyntheticTileCount);
+    if (!setID) {
+        _stopWorker(worker);
+        return false;
+    }
+
+    QGCCachedTileSet tileSet(QString(kSyntheticSetName));
+    _setupSyntheticSet(tileSet, setID);
+
+    QGCExportTileTask* const task = new QGCExportTileTask({ &tileSet }, exportPath);
+    QSignalSpy spyCompleted(task, &QGCExportTileTask::actionCompleted);
+    QSignalSpy spyError(task, &QGCMapTask::error);
+
+    QElapsedTimer timer;
+    timer.start();
+    const bool completed = worker.enqueueTask(task) && spyCompleted.wait(kTaskTimeoutMsecs);
+    elapsedMsecs = timer.elapsed();
+
+    _stopWorker(worker);
+
+    return completed && spyError.isEmpty();
+}
+
+void QGCTileCacheWorkerTest::_testExport()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString exportPath = tempDir.filePath(QStringLiteral("export.qgctiledb"));
+
+    qint64 elapsedMsecs = 0;
+    QVERIFY(_exportSyntheticSet(tempDir.filePath(QStringLiteral("cache.db")), exportPath, elapsedMsecs));
+    qDebug() << "Exported" << kSyntheticTileCount << "tiles in" << elapsedMsecs << "msecs";
+
+    QCOMPARE(_queryCount(exportPath, QStringLiteral("SELECT COUNT(*) FROM Tiles")), static_cast<qint64>(kSyntheticTileCount));
+    QCOMPARE(_queryCount(exportPath, QStringLiteral("SELECT COUNT(*) FROM SetTiles")), static_cast<qint64>(kSyntheticTileCount));
+    QCOMPARE(_queryCount(exportPath, QStringLiteral("SELECT COUNT(*) FROM TileSets WHERE name = '%1'").arg(kSyntheticSetName)), static_cast<qint64>(1));
+}
+
+void QGCTileCacheWorkerTest::_testImport()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString exportPath = tempDir.filePath(QStringLiteral("export.qgctiledb"));
+
+    qint64 elapsedMsecs = 0;
+    QVERIFY(_exportSyntheticSet(tempDir.filePath(QStringLiteral("cache.db")), exportPath, elapsedMsecs));
+
+    const QString importCachePath = tempDir.filePath(QStringLiteral("import.db"));
+    QGCCacheWorker worker;
+    QVERIFY(_initDatabase(worker, importCachePath));
+
+    QGCImportTileTask* const task = new QGCImportTileTask(exportPath, false);
+    QSignalSpy spyCompleted(task, &QGCImportTileTask::actionCompleted);
+    QSignalSpy spyError(task, &QGCMapTask::error);
+
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(worker.enqueueTask(task));
+    QVERIFY(spyCompleted.wait(kTaskTimeoutMsecs));
+    qDebug() << "Imported" << kSyntheticTileCount << "tiles in" << timer.elapsed() << "msecs";
+    QCOMPARE(spyError.count(), 0);
+
+    _stopWorker(worker);
+
+    QCOMPARE(_queryCount(importCachePath, QStringLiteral("SELECT COUNT(*) FROM Tiles")), static_cast<qint64>(kSyntheticTileCount));
+    QCOMPARE(_queryCount(importCachePath, QStringLiteral("SELECT numTiles FROM TileSets WHERE name = '%1'").arg(kSyntheticSetName)), static_cast<qint64>(kSyntheticTileCount));
+}
+
+void QGCTileCacheWorkerTest::_testFetchDuringExport()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString cachePath = tempDir.filePath(QStringLiteral("cache.db"));
+
+    QGCCacheWorker worker;
+    QVERIFY(_initDatabase(worker, cachePath));
+    const quint64 setID = _createSyntheticSet(cachePath, kSyntheticTileCount);
+    QVERIFY(setID);
+
+    QGCCachedTileSet tileSet(QString(kSyntheticSetName));
+    _setupSyntheticSet(tileSet, setID);
+
+    QGCExportTileTask* const exportTask = new QGCExportTileTask({ &tileSet }, tempDir.filePath(QStringLiteral("export.qgctiledb")));
+    QSignalSpy spyExported(exportTask, &QGCExportTileTask::actionCompleted);
+
+    // A lookup queued behind a bulk export must be answered from a read connection before the export finishes
+    const quint16 providerId = UrlFactory::getProviderIdFromProviderType(QString(kSyntheticMapType));
+    QGCFetchTileTask* const fetchTask = new QGCFetchTileTask(UrlFactory::packTileKey(providerId, 0, 0, kSyntheticZoom));
+    QSignalSpy spyFetched(fetchTask, &QGCFetchTileTask::tileFetched);
+
+    // The export holds its first progress report until the lookup has been answered, or gives up after a short timeout
+    QSemaphore fetched;
+    std::atomic_bool exportStarted = false;
+    std::atomic_bool fetchedDuringExport = false;
+    (void) connect(fetchTask, &QGCFetchTileTask::tileFetched, fetchTask, [&fetched]() { fetched.release(); }, Qt::DirectConnection);
+    (void) connect(exportTask, &QGCExportTileTask::actionProgress, exportTask, [&]() {
+        if (!exportStarted.exchange(true)) {
+            fetchedDuringExport = fetched.tryAcquire(1, kFetchTimeoutMsecs);
+        }
+    }, Qt::DirectConnection);
+
+    QVERIFY(worker.enqueueTask(exportTask));
+    QVERIFY(worker.enqueueTask(fetchTask));
+    QVERIFY(spyFetched.wait(kFetchTimeoutMsecs));
+
+    QGCCacheTile* const tile = spyFetched.at(0).at(0).value<QGCCacheTile*>();
+    QVERIFY(tile);
+    QCOMPARE(tile->img().size(), static_cast<qsizetype>(kSyntheticTileSize));
+    delete tile;
+
+    QVERIFY(spyExported.count() || spyExported.wait(kTaskTimeoutMsecs));
+    QVERIFY(exportStarted);
+    QVERIFY(fetchedDuringExport);
+    _stopWorker(worker);
+}
+
+void QGCTileCacheWorkerTest::_testMigrateLegacyDatabase()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString cachePath = tempDir.filePath(QStringLiteral("cache.db"));
+    const quint64 setID = _createLegacyDatabase(cachePath);
+    QVERIFY(setID);
+
+    QGCCacheWorker worker;
+    QVERIFY(_initDatabase(worker, cachePath));
+
+    // Migrated tiles are found by their packed keys
+    const QString elevationType = QString::fromLatin1(CopernicusElevationProvider::kProviderKey);
+    const QList<std::pair<quint64, QByteArray>> tiles = {
+        { UrlFactory::getTileKey(QString(kSyntheticMapType), 3, 5, 4), QByteArrayLiteral("satellite") },
+        { UrlFactory::getTileKey(elevationType, 20000, 9000, 1), QByteArrayLiteral("elevation") },
+    };
+    for (const std::pair<quint64, QByteArray> &expected : tiles) {
+        QGCFetchTileTask* const task = new QGCFetchTileTask(expected.first);
+        QSignalSpy spyFetched(task, &QGCFetchTileTask::tileFetched);
+        QVERIFY(worker.enqueueTask(task));
+        QVERIFY(spyFetched.wait(kFetchTimeoutMsecs));
+
+        QGCCacheTile* const tile = spyFetched.at(0).at(0).value<QGCCacheTile*>();
+        QVERIFY(tile);
+        const QByteArray image = tile->img();
+        delete tile;
+        QCOMPARE(image, expected.second);
+    }
+
+    _stopWorker(worker);
+
+    QCOMPARE(_queryCount(cachePath, QStringLiteral("SELECT COUNT(*) FROM pragma_table_info('Tiles') WHERE name = 'hash'")), static_cast<qint64>(0));
+    QCOMPARE(_queryCount(cachePath, QStringLiteral("SELECT COUNT(*) FROM sqlite_master WHERE name LIKE 'Legacy%'")), static_cast<qint64>(0));
+    QCOMPARE(_queryCount(cachePath, QStringLiteral("SELECT COUNT(*) FROM Tiles")), static_cast<qint64>(tiles.size()));
+    QCOMPARE(_queryCount(cachePath, QStringLiteral("SELECT COUNT(*) FROM SetTiles WHERE setID = %1 AND tileID IN (%2, %3)").arg(setID).arg(tiles[0].first).arg(tiles[1].first)), static_cast<qint64>(tiles.size()));
+    QCOMPARE(_queryCount(cachePath, QStringLiteral("SELECT COUNT(*) FROM TilesDownload WHERE setID = %1 AND tileKey = %2").arg(setID).arg(UrlFactory::getTileKey(QString(kSyntheticMapType), 6, 7, 4))), static_cast<qint64>(1));
+    QCOMPARE(_queryCount(cachePath, QStringLiteral("SELECT COUNT(*) FROM TileSets WHERE name = '%1'").arg(kLegacySetName)), static_cast<qint64>(1));
+    QCOMPARE(_queryCount(cachePath, QStringLiteral("SELECT COUNT(*) FROM TileSets WHERE defaultSet = 1")), static_cast<qint64>(1));
+}
+
+void QGCTileCacheWorkerTest::_testFetchWhileLocked()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString cachePath = tempDir.filePath(QStringLiteral("cache.db"));
+
+    QGCCacheWorker worker;
+    QVERIFY(_initDatabase(worker, cachePath));
+    QVERIFY(_createSyntheticSet(cachePath, 1));
+    const quint64 tileKey = UrlFactory::getTileKey(QString(kSyntheticMapType), 0, 0, kSyntheticZoom);
+
+    // While a reset or replacing import holds the database the lookup gives up with a retryable error, not a cache miss
+    worker._readLock.lockForWrite();
+    QGCFetchTileTask* const busyTask = new QGCFetchTileTask(tileKey);
+    QSignalSpy spyBusy(busyTask, &QGCMapTask::error);
+    QVERIFY(worker.enqueueTask(busyTask));
+    const bool busyReported = spyBusy.wait(kFetchTimeoutMsecs);
+    worker._readLock.unlock();
+    QVERIFY(busyReported);
+    QCOMPARE(spyBusy.at(0).at(1).toString(), QString(QGCCacheWorker::kCacheBusyError));
+
+    // The same lookup succeeds once the database is released
+    QGCFetchTileTask* const fetchTask = new QGCFetchTileTask(tileKey);
+    QSignalSpy spyFetched(fetchTask, &QGCFetchTileTask::tileFetched);
+    QVERIFY(worker.enqueueTask(fetchTask));
+    QVERIFY(spyFetched.wait(kFetchTimeoutMsecs));
+    delete spyFetched.at(0).at(0).value<QGCCacheTile*>();
+
+    _stopWorker(worker);
+}
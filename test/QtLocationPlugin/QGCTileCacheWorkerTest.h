@@ -0,0 +1,51 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+class QGCCacheWorker;
+class QGCCachedTileSet;
+
+class QGCTileCacheWorkerTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testExport();
+    void _testImport();
+    void _testFetchDuringExport();
+    void _testFetchWhileLocked();
+    void _testMigrateLegacyDatabase();
+
+private:
+    /// Runs a worker on cachePath until its database and default tile set exist
+    static bool _initDatabase(QGCCacheWorker &worker, const QString &cachePath);
+    static void _stopWorker(QGCCacheWorker &worker);
+    /// Adds a tile set with tileCount tiles directly to the cache database, returns the set id
+    static quint64 _createSyntheticSet(const QString &cachePath, int tileCount);
+    static void _setupSyntheticSet(QGCCachedTileSet &tileSet, quint64 setID);
+    /// Exports a synthetic set of kSyntheticTileCount tiles from a new cache database in cachePath
+    static bool _exportSyntheticSet(const QString &cachePath, const QString &exportPath, qint64 &elapsedMsecs);
+    /// Creates a cache database with the schema used before packed tile keys, returns the legacy set id
+    static quint64 _createLegacyDatabase(const QString &cachePath);
+    static QString _legacyHash(const QString &type, int x, int y, int z);
+    static qint64 _queryCount(const QString &databasePath, const QString &sql);
+
+    static constexpr int kSyntheticTileCount = 100000;
+    static constexpr int kSyntheticTileSize = 512;
+    static constexpr int kSyntheticZoom = 9;
+    static constexpr int kTaskTimeoutMsecs = 120000;
+    static constexpr int kFetchTimeoutMsecs = 5000; ///< Lookups are answered from a read connection without waiting on bulk work
+    static constexpr const char *kSyntheticSetName = "Synthetic";
+    static constexpr const char *kLegacySetName = "Legacy";
+    static constexpr const char *kSyntheticMapType = "Bing Satellite";
+    static constexpr const char *kTestConnection = "QGCTileCacheWorkerTest";
+};
@@ -0,0 +1,97 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "QGCTilePrefetcherTest.h"
+#include "QGCTilePrefetcher.h"
+#include "QGCMapUrlEngine.h"
+#include "MapProvider.h"
+
+#include <QtCore/QSet>
+#include <QtTest/QTest>
+
+void QGCTilePrefetcherTest::_testTilesAlongPathInvalid()
+{
+    const QList<QGeoCoordinate> path = { QGeoCoordinate(47.3977, 8.5456) };
+
+    QVERIFY(QGCTilePrefetcher::tilesAlongPath(kMapType, 15, QList<QGeoCoordinate>(), 1).isEmpty());
+    QVERIFY(QGCTilePrefetcher::tilesAlongPath(kMapType, 0, path, 1).isEmpty());
+    QVERIFY(QGCTilePrefetcher::tilesAlongPath(kMapType, static_cast<int>(MAX_MAP_ZOOM) + 1, path, 1).isEmpty());
+    QVERIFY(QGCTilePrefetcher::tilesAlongPath(QStringLiteral("No Such Map"), 15, path, 1).isEmpty());
+    QVERIFY(QGCTilePrefetcher::tilesAlongPath(kMapType, 15, { QGeoCoordinate() }, 1).isEmpty());
+}
+
+void QGCTilePrefetcherTest::_testTilesAroundPoint()
+{
+    static constexpr int zoom = 15;
+    const QGeoCoordinate coord(47.3977, 8.5456);
+    const SharedMapProvider provider = UrlFactory::getMapProviderFromProviderType(kMapType);
+    QVERIFY(provider);
+    const int centerX = provider->long2tileX(coord.longitude(), zoom);
+    const int centerY = provider->lat2tileY(coord.latitude(), zoom);
+
+    const QList<QGCTilePrefetcher::PrefetchTile> center = QGCTilePrefetcher::tilesAlongPath(kMapType, zoom, { coord }, 0);
+    QCOMPARE(center.count(), 1);
+    QCOMPARE(center.first().x, centerX);
+    QCOMPARE(center.first().y, centerY);
+    QCOMPARE(center.first().z, zoom);
+    QCOMPARE(center.first().mapId, provider->getMapId());
+    QCOMPARE(center.first().type, QString(kMapType));
+    QCOMPARE(center.first().key, UrlFactory::packTileKey(provider->getProviderId(), centerX, centerY, zoom));
+
+    // The same point twice adds no tiles
+    const QList<QGCTilePrefetcher::PrefetchTile> neighbours = QGCTilePrefetcher::tilesAlongPath(kMapType, zoom, { coord, coord }, 1);
+    QCOMPARE(neighbours.count(), 9);
+    QSet<quint64> keys;
+    for (const QGCTilePrefetcher::PrefetchTile &tile : neighbours) {
+        QVERIFY(qAbs(tile.x - centerX) <= 1);
+        QVERIFY(qAbs(tile.y - centerY) <= 1);
+        keys.insert(tile.key);
+    }
+    QCOMPARE(keys.count(), 9);
+
+    // Neighbours outside of the map are dropped at the corner tile
+    const QList<QGCTilePrefetcher::PrefetchTile> corner = QGCTilePrefetcher::tilesAlongPath(kMapType, 1, { QGeoCoordinate(80, -179) }, 1);
+    QCOMPARE(corner.count(), 4);
+}
+
+void QGCTilePrefetcherTest::_testTilesAlongSegment()
+{
+    static constexpr int zoom = 14;
+    const QGeoCoordinate start(47.3, 8.4);
+    const QGeoCoordinate end(47.5, 8.7);
+    const SharedMapProvider provider = UrlFactory::getMapProviderFromProviderType(kMapType);
+    QVERIFY(provider);
+
+    const QList<QGCTilePrefetcher::PrefetchTile> tiles = QGCTilePrefetcher::tilesAlongPath(kMapType, zoom, { start, end }, 0);
+    QVERIFY(tiles.count() > 2);
+
+    QCOMPARE(tiles.first().x, provider->long2tileX(start.longitude(), zoom));
+    QCOMPARE(tiles.first().y, provider->lat2tileY(start.latitude(), zoom));
+    QCOMPARE(tiles.last().x, provider->long2tileX(end.longitude(), zoom));
+    QCOMPARE(tiles.last().y, provider->lat2tileY(end.latitude(), zoom));
+
+    // Ordered along the path without gaps or repeats
+    QSet<quint64> keys;
+    for (qsizetype i = 0; i < tiles.count(); i++) {
+        QVERIFY(!keys.contains(tiles[i].key));
+        keys.insert(tiles[i].key);
+        if (i > 0) {
+            QVERIFY(qAbs(tiles[i].x - tiles[i - 1].x) <= 1);
+            QVERIFY(qAbs(tiles[i].y - tiles[i - 1].y) <= 1);
+        }
+    }
+}
+
+void QGCTilePrefetcherTest::_testTilesAlongPathLimit()
+{
+    // Across Europe at high zoom there are far more tiles than are ever queued
+    const QList<QGeoCoordinate> path = { QGeoCoordinate(40.0, -3.0), QGeoCoordinate(55.0, 25.0) };
+    const QList<QGCTilePrefetcher::PrefetchTile> tiles = QGCTilePrefetcher::tilesAlongPath(kMapType, 18, path, 1);
+    QCOMPARE(tiles.count(), static_cast<qsizetype>(QGCTilePrefetcher::kMaxQueuedTiles));
+}
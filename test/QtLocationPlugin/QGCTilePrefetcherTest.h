@@ -0,0 +1,26 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+class QGCTilePrefetcherTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testTilesAlongPathInvalid();
+    void _testTilesAroundPoint();
+    void _testTilesAlongSegment();
+    void _testTilesAlongPathLimit();
+
+private:
+    static constexpr const char *kMapType = "Bing Satellite";
+};
@@ -0,0 +1,402 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TerrainQueryLocalDemTest.h"
+#include "TerrainQueryLocalDem.h"
+#include "TerrainQuery.h"
+#include "ElevationMapProvider.h"
+#include "SettingsManager.h"
+#include "AppSettings.h"
+#include "FlightMapSettings.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QScopeGuard>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QtEndian>
+#include <QtPositioning/QGeoCoordinate>
+#include <QtTest/QSignalSpy>
+#include <QtTest/QTest>
+
+#include <cstring>
+
+namespace {
+
+void _appendU16(QByteArray &bytes, quint16 value)
+{
+    char buffer[sizeof(value)];
+    qToLittleEndian(value, buffer);
+    bytes.append(buffer, sizeof(buffer));
+}
+
+void _appendU32(QByteArray &bytes, quint32 value)
+{
+    char buffer[sizeof(value)];
+    qToLittleEndian(value, buffer);
+    bytes.append(buffer, sizeof(buffer));
+}
+
+void _appendF32(QByteArray &bytes, float value)
+{
+    quint32 bits;
+    (void) memcpy(&bits, &value, sizeof(bits));
+    _appendU32(bytes, bits);
+}
+
+void _appendF64(QByteArray &bytes, double value)
+{
+    quint64 bits;
+    (void) memcpy(&bits, &value, sizeof(bits));
+    char buffer[sizeof(bits)];
+    qToLittleEndian(bits, buffer);
+    bytes.append(buffer, sizeof(buffer));
+}
+
+/// Directory entry whose value is inline (count * type size <= 4) or at offset
+void _appendEntry(QByteArray &bytes, quint16 tag, quint16 type, quint32 count, quint32 valueOrOffset)
+{
+    _appendU16(bytes, tag);
+    _appendU16(bytes, type);
+    _appendU32(bytes, count);
+    if ((type == 3) && (count == 1)) {
+        _appendU16(bytes, static_cast<quint16>(valueOrOffset));
+        _appendU16(bytes, 0);
+    } else {
+        _appendU32(bytes, valueOrOffset);
+    }
+}
+
+/// Interpolation is only exact to rounding
+bool _near(double value, double expected)
+{
+    return qAbs(value - expected) < 1e-6;
+}
+
+bool _writeFile(const QString &path, const QByteArray &bytes)
+{
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && (file.write(bytes) == bytes.size());
+}
+
+}
+
+bool TerrainQueryLocalDemTest::_writeHgt(const QString &directory, qint16 voidRow, qint16 voidColumn)
+{
+    QByteArray bytes;
+    bytes.reserve(kHgtSamples * kHgtSamples * 2);
+    for (int row = 0; row < kHgtSamples; row++) {
+        for (int column = 0; column < kHgtSamples; column++) {
+            const qint16 value = ((row == voidRow) && (column == voidColumn)) ? -32768 : static_cast<qint16>(_hgtElevation(row, column));
+            char buffer[sizeof(value)];
+            qToBigEndian(value, buffer);
+            bytes.append(buffer, sizeof(buffer));
+        }
+    }
+
+    return _writeFile(directory + QStringLiteral("/N%1E%2.hgt").arg(kHgtSouthLat, 2, 10, QChar('0')).arg(kHgtWestLon, 3, 10, QChar('0')), bytes);
+}
+
+bool TerrainQueryLocalDemTest::_writeGeoTiff(const QString &path)
+{
+    static constexpr quint16 kShort = 3;
+    static constexpr quint16 kLong = 4;
+    static constexpr quint16 kDouble = 12;
+    static constexpr quint16 kAscii = 2;
+    static constexpr quint16 kEntryCount = 14;
+
+    const int tilesAcross = (kTiffColumns + kTiffTileSize - 1) / kTiffTileSize;
+    const int tilesDown = (kTiffRows + kTiffTileSize - 1) / kTiffTileSize;
+    const int tileCount = tilesAcross * tilesDown;
+    const QByteArray noData("-9999", 6);
+
+    // Header, directory, out of line values, tile data
+    const quint32 tileOffsetsOffset = 8 + 2 + (kEntryCount * 12) + 4;
+    const quint32 pixelScaleOffset = tileOffsetsOffset + (tileCount * 4);
+    const quint32 tiepointOffset = pixelScaleOffset + (3 * 8);
+    const quint32 geoKeysOffset = tiepointOffset + (6 * 8);
+    const quint32 noDataOffset = geoKeysOffset + (8 * 2);
+    const quint32 tileDataOffset = noDataOffset + 8;
+    const quint32 tileBytes = kTiffTileSize * kTiffTileSize * 4;
+
+    QByteArray bytes("II");
+    _appendU16(bytes, 42);
+    _appendU32(bytes, 8);
+
+    _appendU16(bytes, kEntryCount);
+    _appendEntry(bytes, 256, kLong, 1, kTiffColumns);
+    _appendEntry(bytes, 257, kLong, 1, kTiffRows);
+    _appendEntry(bytes, 258, kShort, 1, 32);
+    _appendEntry(bytes, 259, kShort, 1, 1);
+    _appendEntry(bytes, 277, kShort, 1, 1);
+    _appendEntry(bytes, 322, kShort, 1, kTiffTileSize);
+    _appendEntry(bytes, 323, kShort, 1, kTiffTileSize);
+    _appendEntry(bytes, 324, kLong, tileCount, tileOffsetsOffset);
+    _appendEntry(bytes, 325, kLong, 1, tileBytes);
+    _appendEntry(bytes, 339, kShort, 1, 3);
+    _appendEntry(bytes, 33550, kDouble, 3, pixelScaleOffset);
+    _appendEntry(bytes, 33922, kDouble, 6, tiepointOffset);
+    _appendEntry(bytes, 34735, kShort, 8, geoKeysOffset);
+    _appendEntry(bytes, 42113, kAscii, noData.size(), noDataOffset);
+    _appendU32(bytes, 0);
+
+    for (int i = 0; i < tileCount; i++) {
+        _appendU32(bytes, tileDataOffset + (i * tileBytes));
+    }
+    _appendF64(bytes, kTiffStep);
+    _appendF64(bytes, kTiffStep);
+    _appendF64(bytes, 0);
+    for (const double value : { 0., 0., 0., kTiffWestLon, kTiffNorthLat, 0. }) {
+        _appendF64(bytes, value);
+    }
+    // Version 1.1.0 with one key: ModelType geographic, RasterType defaults to pixel is area
+    for (const quint16 value : { 1, 1, 0, 1, 1024, 0, 1, 2 }) {
+        _appendU16(bytes, value);
+    }
+    bytes.append(noData);
+    bytes.append(2, '\0');
+
+    // Tiles at the right and bottom edges are padded to the full tile size
+    for (int tileRow = 0; tileRow < tilesDown; tileRow++) {
+        for (int tileColumn = 0; tileColumn < tilesAcross; tileColumn++) {
+            for (int y = 0; y < kTiffTileSize; y++) {
+                for (int x = 0; x < kTiffTileSize; x++) {
+                    const int row = (tileRow * kTiffTileSize) + y;
+                    const int column = (tileColumn * kTiffTileSize) + x;
+                    const bool inside = (row < kTiffRows) && (column < kTiffColumns);
+                    _appendF32(bytes, inside ? static_cast<float>(_tiffElevation(row, column)) : -9999.f);
+                }
+            }
+        }
+    }
+
+    return _writeFile(path, bytes);
+}
+
+void TerrainQueryLocalDemTest::_testHgt()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QVERIFY(_writeHgt(directory.path()));
+
+    LocalDemSource source;
+    source.setDirectory(directory.path());
+    QCOMPARE(source.files().count(), static_cast<qsizetype>(1));
+    QCOMPARE(source.resolution(10.5, 20.5), 1.0 / (kHgtSamples - 1));
+
+    // Exactly on the samples, including the edges of the tile
+    for (const int row : { 0, 1, 37, 119, 120 }) {
+        for (const int column : { 0, 1, 64, 119, 120 }) {
+            QVERIFY(_near(source.elevation(_hgtLatitude(row), _hgtLongitude(column)), _hgtElevation(row, column)));
+        }
+    }
+
+    // Bilinear between the samples
+    const double step = 1.0 / (kHgtSamples - 1);
+    QVERIFY(_near(source.elevation(_hgtLatitude(40) - (step / 2), _hgtLongitude(50)), _hgtElevation(40, 50) + 5.0));
+    QVERIFY(_near(source.elevation(_hgtLatitude(40), _hgtLongitude(50) + (step / 4)), _hgtElevation(40, 50) + 0.25));
+    QVERIFY(_near(source.elevation(_hgtLatitude(40) - (step / 2), _hgtLongitude(50) + (step / 2)), _hgtElevation(40, 50) + 5.5));
+
+    const QList<QGeoCoordinate> coordinates = {
+        QGeoCoordinate(_hgtLatitude(10), _hgtLongitude(20)),
+        QGeoCoordinate(_hgtLatitude(100), _hgtLongitude(3)),
+    };
+    QList<double> elevations;
+    QVERIFY(source.elevations(coordinates, elevations));
+    QCOMPARE(elevations.count(), coordinates.count());
+    QVERIFY(_near(elevations[0], _hgtElevation(10, 20)));
+    QVERIFY(_near(elevations[1], _hgtElevation(100, 3)));
+}
+
+void TerrainQueryLocalDemTest::_testHgtVoid()
+{
+    static constexpr int kVoidRow = 60;
+    static constexpr int kVoidColumn = 60;
+
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QVERIFY(_writeHgt(directory.path(), kVoidRow, kVoidColumn));
+
+    LocalDemSource source;
+    source.setDirectory(directory.path());
+
+    QVERIFY(qIsNaN(source.elevation(_hgtLatitude(kVoidRow), _hgtLongitude(kVoidColumn))));
+
+    // Next to the void the nearest sample is used instead of interpolating
+    const double step = 1.0 / (kHgtSamples - 1);
+    QVERIFY(_near(source.elevation(_hgtLatitude(kVoidRow) - (0.6 * step), _hgtLongitude(kVoidColumn)), _hgtElevation(kVoidRow + 1, kVoidColumn)));
+
+    // Away from it interpolation is unaffected
+    QVERIFY(_near(source.elevation(_hgtLatitude(kVoidRow + 2) - (step / 2), _hgtLongitude(kVoidColumn)), _hgtElevation(kVoidRow + 2, kVoidColumn) + 5.0));
+
+    QList<double> elevations;
+    QVERIFY(!source.elevations({ QGeoCoordinate(_hgtLatitude(kVoidRow), _hgtLongitude(kVoidColumn)) }, elevations));
+    QVERIFY(qIsNaN(elevations[0]));
+}
+
+void TerrainQueryLocalDemTest::_testGeoTiff()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QVERIFY(_writeGeoTiff(directory.filePath(QStringLiteral("dem.tif"))));
+
+    LocalDemSource source;
+    source.setDirectory(directory.path());
+    QCOMPARE(source.files().count(), static_cast<qsizetype>(1));
+    QCOMPARE(source.resolution(_tiffLatitude(5), _tiffLongitude(5)), kTiffStep);
+
+    // Samples are at the pixel centers, across tile boundaries and in the partial edge tiles
+    for (const int row : { 0, 15, 16, 29 }) {
+        for (const int column : { 0, 15, 16, 31, 32, 39 }) {
+            QVERIFY(_near(source.elevation(_tiffLatitude(row), _tiffLongitude(column)), _tiffElevation(row, column)));
+        }
+    }
+
+    // Interpolated across the boundary between tiles
+    const double elevation = source.elevation(_tiffLatitude(15) - (kTiffStep / 2), _tiffLongitude(15) + (kTiffStep / 2));
+    QVERIFY(_near(elevation, _tiffElevation(15, 15) + 0.75));
+
+    // The padding outside the raster is never sampled
+    QVERIFY(qIsNaN(source.elevation(_tiffLatitude(kTiffRows + 1), _tiffLongitude(0))));
+    QVERIFY(qIsNaN(source.elevation(_tiffLatitude(0), _tiffLongitude(kTiffColumns + 1))));
+}
+
+void TerrainQueryLocalDemTest::_testMissingCoverage()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QVERIFY(_writeHgt(directory.path()));
+
+    // Files which are not valid models are skipped
+    QFile bogus(directory.filePath(QStringLiteral("bogus.tif")));
+    QVERIFY(bogus.open(QIODevice::WriteOnly));
+    (void) bogus.write("not a tiff");
+    bogus.close();
+
+    LocalDemSource source;
+    source.setDirectory(directory.path());
+    QCOMPARE(source.files().count(), static_cast<qsizetype>(1));
+
+    const QList<QGeoCoordinate> coordinates = {
+        QGeoCoordinate(10.5, 20.5),
+        QGeoCoordinate(11.5, 20.5),
+        QGeoCoordinate(10.5, 20.5),
+    };
+    QList<double> elevations;
+    QVERIFY(!source.elevations(coordinates, elevations));
+    QCOMPARE(elevations.count(), coordinates.count());
+    QVERIFY(!qIsNaN(elevations[0]));
+    QVERIFY(qIsNaN(elevations[1]));
+    QVERIFY(!qIsNaN(elevations[2]));
+
+    QCOMPARE(source.resolution(11.5, 20.5), 0.);
+    QVERIFY(qIsNaN(source.elevation(qQNaN(), 20.5)));
+}
+
+void TerrainQueryLocalDemTest::_testDirectoryChange()
+{
+    QTemporaryDir hgtDirectory;
+    QTemporaryDir tiffDirectory;
+    QVERIFY(hgtDirectory.isValid() && tiffDirectory.isValid());
+    QVERIFY(_writeHgt(hgtDirectory.path()));
+    QVERIFY(_writeGeoTiff(tiffDirectory.filePath(QStringLiteral("dem.tif"))));
+
+    LocalDemSource source;
+    source.setDirectory(hgtDirectory.path());
+    QVERIFY(!qIsNaN(source.elevation(10.5, 20.5)));
+    QVERIFY(qIsNaN(source.elevation(_tiffLatitude(5), _tiffLongitude(5))));
+
+    source.setDirectory(tiffDirectory.path());
+    QVERIFY(qIsNaN(source.elevation(10.5, 20.5)));
+    QVERIFY(!qIsNaN(source.elevation(_tiffLatitude(5), _tiffLongitude(5))));
+
+    source.setDirectory(QString());
+    QVERIFY(source.files().isEmpty());
+}
+
+void TerrainQueryLocalDemTest::_testTerrainQueries()
+{
+    QTemporaryDir saveDirectory;
+    QVERIFY(saveDirectory.isValid());
+    const QString elevationDirectory = QDir(saveDirectory.path()).filePath(AppSettings::elevationDirectory);
+    QVERIFY(QDir().mkpath(elevationDirectory));
+    QVERIFY(_writeHgt(elevationDirectory));
+
+    // The queries read the elevation directory below the save path once the local provider is selected
+    AppSettings* const appSettings = SettingsManager::instance()->appSettings();
+    Fact* const elevationMapProvider = SettingsManager::instance()->flightMapSettings()->elevationMapProvider();
+    const QVariant previousSavePath = appSettings->savePath()->rawValue();
+    const QVariant previousElevationMapProvider = elevationMapProvider->rawValue();
+    const auto restoreSettings = qScopeGuard([&]() {
+        elevationMapProvider->setRawValue(previousElevationMapProvider);
+        appSettings->savePath()->setRawValue(previousSavePath);
+    });
+    appSettings->savePath()->setRawValue(saveDirectory.path());
+    elevationMapProvider->setRawValue(QString(LocalDemElevationProvider::kProviderKey));
+
+    const QList<QGeoCoordinate> coordinates = {
+        QGeoCoordinate(_hgtLatitude(10), _hgtLongitude(20)),
+        QGeoCoordinate(_hgtLatitude(100), _hgtLongitude(3)),
+    };
+    TerrainAtCoordinateQuery* const coordinateQuery = new TerrainAtCoordinateQuery(true /* autoDelete */, this);
+    QSignalSpy coordinateSpy(coordinateQuery, &TerrainAtCoordinateQuery::terrainDataReceived);
+    QVERIFY(coordinateSpy.isValid());
+    coordinateQuery->requestData(coordinates);
+    QVERIFY(coordinateSpy.wait(2000));
+    QVERIFY(coordinateSpy.at(0).at(0).toBool());
+    const QList<double> heights = coordinateSpy.at(0).at(1).value<QList<double>>();
+    QCOMPARE(heights.count(), coordinates.count());
+    QVERIFY(_near(heights[0], _hgtElevation(10, 20)));
+    QVERIFY(_near(heights[1], _hgtElevation(100, 3)));
+
+    TerrainPathQuery* const pathQuery = new TerrainPathQuery(true /* autoDelete */, this);
+    QSignalSpy pathSpy(pathQuery, &TerrainPathQuery::terrainDataReceived);
+    QVERIFY(pathSpy.isValid());
+    pathQuery->requestData(QGeoCoordinate(_hgtLatitude(20), _hgtLongitude(20)), QGeoCoordinate(_hgtLatitude(20), _hgtLongitude(60)));
+    QVERIFY(pathSpy.wait(2000));
+    QVERIFY(pathSpy.at(0).at(0).toBool());
+    const TerrainPathQuery::PathHeightInfo_t pathHeightInfo = pathSpy.at(0).at(1).value<TerrainPathQuery::PathHeightInfo_t>();
+    QVERIFY(pathHeightInfo.heights.count() > 2);
+    QVERIFY(_near(pathHeightInfo.heights.constFirst(), _hgtElevation(20, 20)));
+    QVERIFY(_near(pathHeightInfo.heights.constLast(), _hgtElevation(20, 60)));
+
+    // Coordinates the local files do not cover fail instead of going to the network
+    TerrainAtCoordinateQuery* const uncoveredQuery = new TerrainAtCoordinateQuery(true /* autoDelete */, this);
+    QSignalSpy uncoveredSpy(uncoveredQuery, &TerrainAtCoordinateQuery::terrainDataReceived);
+    QVERIFY(uncoveredSpy.isValid());
+    uncoveredQuery->requestData({ QGeoCoordinate(47.0, 8.0) });
+    QVERIFY(uncoveredSpy.wait(2000));
+    QVERIFY(!uncoveredSpy.at(0).at(0).toBool());
+}
+
+void TerrainQueryLocalDemTest::_benchmarkElevations()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QVERIFY(_writeHgt(directory.path()));
+
+    LocalDemSource source;
+    source.setDirectory(directory.path());
+
+    QList<QGeoCoordinate> coordinates;
+    coordinates.reserve(kBenchmarkLookups);
+    QRandomGenerator random(kBenchmarkLookups);
+    for (int i = 0; i < kBenchmarkLookups; i++) {
+        coordinates.append(QGeoCoordinate(kHgtSouthLat + random.generateDouble(), kHgtWestLon + random.generateDouble()));
+    }
+
+    QList<double> elevations;
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(source.elevations(coordinates, elevations));
+    qDebug() << "Local DEM:" << kBenchmarkLookups << "lookups in" << timer.elapsed() << "msecs";
+
+    QCOMPARE(elevations.count(), coordinates.count());
+}
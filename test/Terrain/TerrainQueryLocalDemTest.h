@@ -0,0 +1,53 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+class TerrainQueryLocalDemTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testHgt();
+    void _testHgtVoid();
+    void _testGeoTiff();
+    void _testMissingCoverage();
+    void _testDirectoryChange();
+    void _testTerrainQueries();
+    void _benchmarkElevations();
+
+private:
+    /// N10E020.hgt with elevation = row * 10 + column, rows counted from the north
+    static bool _writeHgt(const QString &directory, qint16 voidRow = -1, qint16 voidColumn = -1);
+    /// Little endian, tiled, float32 GeoTIFF with pixel-is-area georeferencing and elevation = 500 + row + column / 2
+    static bool _writeGeoTiff(const QString &path);
+
+    static double _hgtLatitude(int row) { return kHgtSouthLat + 1.0 - (static_cast<double>(row) / (kHgtSamples - 1)); }
+    static double _hgtLongitude(int column) { return kHgtWestLon + (static_cast<double>(column) / (kHgtSamples - 1)); }
+    static double _hgtElevation(int row, int column) { return (row * 10.0) + column; }
+
+    static double _tiffLatitude(int row) { return kTiffNorthLat - ((row + 0.5) * kTiffStep); }
+    static double _tiffLongitude(int column) { return kTiffWestLon + ((column + 0.5) * kTiffStep); }
+    static double _tiffElevation(int row, int column) { return 500.0 + row + (column / 2.0); }
+
+    static constexpr int kHgtSouthLat = 10;
+    static constexpr int kHgtWestLon = 20;
+    static constexpr int kHgtSamples = 121;
+
+    static constexpr double kTiffNorthLat = 47.5;
+    static constexpr double kTiffWestLon = 8.0;
+    static constexpr double kTiffStep = 0.01;
+    static constexpr int kTiffRows = 30;
+    static constexpr int kTiffColumns = 40;
+    static constexpr int kTiffTileSize = 16;
+
+    static constexpr int kBenchmarkLookups = 1000000;
+};
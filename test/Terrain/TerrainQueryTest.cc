@@ -103,7 +103,7 @@ void UnitTestTerrainQuery::requestCarpetHeights(const QGeoCoordinate &swCoord, c
 UnitTestTerrainQuery::PathHeightInfo_t UnitTestTerrainQuery::_requestPathHeights(const QGeoCoordinate &fromCoord, const QGeoCoordinate &toCoord)
 {
     PathHeightInfo_t pathHeights;
-    pathHeights.rgCoords = TerrainTileManager::_pathQueryToCoords(fromCoord, toCoord, pathHeights.distanceBetween, pathHeights.finalDistanceBetween);
+    pathHeights.rgCoords = TerrainTileManager::pathQueryToCoords(fromCoord, toCoord, pathHeights.distanceBetween, pathHeights.finalDistanceBetween);
     pathHeights.rgHeights = _requestCoordinateHeights(pathHeights.rgCoords);
     return pathHeights;
 }
@@ -195,6 +195,78 @@ void TerrainQueryTest::_testRequestCarpetHeights()
     QVERIFY(arguments.at(3).toList().constFirst().toList().constFirst().toDouble() == UnitTestTerrainQuery::Flat10Region::amslElevation);
 }
 
+void TerrainQueryTest::_testPathBatchManager()
+{
+    TerrainPathBatchManager manager;
+    UnitTestTerrainQuery* const terrainQuery = new UnitTestTerrainQuery(&manager);
+    manager._setTerrainQuery(terrainQuery);
+    QSignalSpy lookupSpy(terrainQuery, &TerrainQueryInterface::coordinateHeightsReceived);
+    QVERIFY(lookupSpy.isValid());
+
+    // A zig zag flight path, neighbouring segments share their end points
+    static constexpr int vertexCount = 20;
+    QList<QGeoCoordinate> polyPath;
+    for (int i = 0; i < vertexCount; i++) {
+        (void) polyPath.append(QGeoCoordinate(pointNemo.latitude() - 0.01 - (i * 0.004), pointNemo.longitude() + 0.01 + ((i % 2) * 0.02)));
+    }
+
+    int receivedCount = 0;
+    const auto checkPathHeights = [&receivedCount](bool success, const TerrainPathQuery::PathHeightInfo_t &pathHeightInfo) {
+        receivedCount++;
+        QVERIFY(success);
+        QVERIFY(pathHeightInfo.distanceBetween > 0.);
+        QVERIFY(pathHeightInfo.heights.count() > 2);
+        for (const double height : pathHeightInfo.heights) {
+            QCOMPARE(height, UnitTestTerrainQuery::Flat10Region::amslElevation);
+        }
+    };
+
+    // One query per segment as the flight path segments issue them, the first segment twice
+    qsizetype sampleCount = 0;
+    for (int i = 0; i < (vertexCount - 1); i++) {
+        TerrainPathQuery* const pathQuery = new TerrainPathQuery(true /* autoDelete */, this);
+        (void) connect(pathQuery, &TerrainPathQuery::terrainDataReceived, this, checkPathHeights);
+        manager.addQuery(pathQuery, polyPath[i], polyPath[i + 1]);
+
+        double distanceBetween;
+        double finalDistanceBetween;
+        sampleCount += TerrainTileManager::pathQueryToCoords(polyPath[i], polyPath[i + 1], distanceBetween, finalDistanceBetween).count();
+    }
+    TerrainPathQuery* const duplicateQuery = new TerrainPathQuery(true /* autoDelete */, this);
+    (void) connect(duplicateQuery, &TerrainPathQuery::terrainDataReceived, this, checkPathHeights);
+    manager.addQuery(duplicateQuery, polyPath[0], polyPath[1]);
+
+    QTRY_COMPARE(receivedCount, vertexCount);
+
+    // A single lookup without the shared end points
+    QCOMPARE(lookupSpy.count(), 1);
+    QCOMPARE(lookupSpy.at(0).at(1).value<QList<double>>().count(), sampleCount - (vertexCount - 2));
+
+    // Unchanged paths are answered from the cache
+    TerrainPolyPathQuery* const polyPathQuery = new TerrainPolyPathQuery(true /* autoDelete */, this);
+    QSignalSpy polyPathSpy(polyPathQuery, &TerrainPolyPathQuery::terrainDataReceived);
+    manager.addQuery(polyPathQuery, polyPath);
+    QVERIFY(polyPathSpy.wait(1000));
+    QVERIFY(polyPathSpy.at(0).at(0).toBool());
+    QCOMPARE(polyPathSpy.at(0).at(1).value<QList<TerrainPathQuery::PathHeightInfo_t>>().count(), static_cast<qsizetype>(vertexCount - 1));
+    QCOMPARE(lookupSpy.count(), 1);
+
+    // Moving one vertex only samples the two segments attached to it
+    polyPath[5].setLongitude(polyPath[5].longitude() + 0.001);
+    TerrainPolyPathQuery* const editedQuery = new TerrainPolyPathQuery(true /* autoDelete */, this);
+    QSignalSpy editedSpy(editedQuery, &TerrainPolyPathQuery::terrainDataReceived);
+    manager.addQuery(editedQuery, polyPath);
+    QVERIFY(editedSpy.wait(1000));
+    QVERIFY(editedSpy.at(0).at(0).toBool());
+    QCOMPARE(lookupSpy.count(), 2);
+
+    double distanceBetween;
+    double finalDistanceBetween;
+    const qsizetype editedSampleCount = TerrainTileManager::pathQueryToCoords(polyPath[4], polyPath[5], distanceBetween, finalDistanceBetween).count() +
+        TerrainTileManager::pathQueryToCoords(polyPath[5], polyPath[6], distanceBetween, finalDistanceBetween).count() - 1;
+    QCOMPARE(lookupSpy.at(1).at(1).value<QList<double>>().count(), editedSampleCount);
+}
+
 // Test Requires Internet, so disable by default.
 // Or, check if internet and elevation server are available?
 #if 0
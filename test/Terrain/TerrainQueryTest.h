@@ -88,5 +88,6 @@ private slots:
     void _testRequestCoordinateHeights();
     void _testRequestPathHeights();
     void _testRequestCarpetHeights();
+    void _testPathBatchManager();
     // void _testTerrainAtCoordinateQuery();
 };
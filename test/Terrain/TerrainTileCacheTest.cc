@@ -0,0 +1,161 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TerrainTileCacheTest.h"
+#include "TerrainTileCache.h"
+#include "TerrainTile.h"
+
+#include <QtCore/QAtomicInteger>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QThread>
+#include <QtPositioning/QGeoCoordinate>
+#include <QtTest/QTest>
+
+#include <cstring>
+
+namespace {
+
+/// Same layout as TerrainTile::TileInfo_t
+struct TestTileInfo_t {
+    double  swLat, swLon, neLat, neLon;
+    int16_t minElevation, maxElevation;
+    double  avgElevation;
+    int16_t gridSizeLat, gridSizeLon;
+} Q_PACKED;
+
+}
+
+std::shared_ptr<const TerrainTile> TerrainTileCacheTest::_createTile(int16_t elevation)
+{
+    const TestTileInfo_t tileInfo = { 0.0, 0.0, 0.01, 0.01, elevation, elevation, static_cast<double>(elevation), kGridSize, kGridSize };
+
+    QByteArray data(sizeof(TestTileInfo_t) + (sizeof(int16_t) * kGridSize * kGridSize), Qt::Uninitialized);
+    (void) memcpy(data.data(), &tileInfo, sizeof(tileInfo));
+    int16_t* const grid = reinterpret_cast<int16_t*>(data.data() + sizeof(TestTileInfo_t));
+    for (int i = 0; i < (kGridSize * kGridSize); i++) {
+        grid[i] = elevation;
+    }
+
+    return std::make_shared<const TerrainTile>(data);
+}
+
+void TerrainTileCacheTest::_testInsertAndLookup()
+{
+    TerrainTileCache cache(1024 * 1024);
+    QVERIFY(!cache.tile(1));
+
+    const std::shared_ptr<const TerrainTile> tile = _createTile(10);
+    QVERIFY(tile->isValid());
+    cache.insert(1, tile);
+    QVERIFY(cache.tile(1) == tile);
+    QVERIFY(cache.contains(1));
+    QCOMPARE(cache.count(), static_cast<qsizetype>(1));
+    QCOMPARE(cache.bytes(), static_cast<qint64>(tile->memoryUsage()));
+
+    // An already cached tile is not replaced
+    cache.insert(1, _createTile(20));
+    QVERIFY(cache.tile(1) == tile);
+    QCOMPARE(cache.count(), static_cast<qsizetype>(1));
+
+    cache.clear();
+    QVERIFY(!cache.contains(1));
+    QCOMPARE(cache.bytes(), static_cast<qint64>(0));
+}
+
+void TerrainTileCacheTest::_testLeastRecentlyUsedEviction()
+{
+    const qint64 tileBytes = _createTile(0)->memoryUsage();
+    constexpr int maxTiles = 10;
+    TerrainTileCache cache(tileBytes * maxTiles);
+
+    for (int i = 0; i < maxTiles; i++) {
+        cache.insert(i, _createTile(static_cast<int16_t>(i)));
+    }
+    QCOMPARE(cache.count(), static_cast<qsizetype>(maxTiles));
+
+    // Tile 0 was inserted first but is the most recently read, tile 1 is now the least recently used
+    QVERIFY(cache.tile(0));
+
+    cache.insert(maxTiles, _createTile(maxTiles));
+    QVERIFY(cache.bytes() <= cache.maxBytes());
+    QVERIFY(cache.contains(0));
+    QVERIFY(!cache.contains(1));
+    QVERIFY(cache.contains(maxTiles));
+}
+
+void TerrainTileCacheTest::_testShrinkBudget()
+{
+    const qint64 tileBytes = _createTile(0)->memoryUsage();
+    TerrainTileCache cache(tileBytes * 100);
+
+    for (int i = 0; i < 50; i++) {
+        cache.insert(i, _createTile(static_cast<int16_t>(i)));
+    }
+    QCOMPARE(cache.count(), static_cast<qsizetype>(50));
+
+    cache.setMaxBytes(tileBytes * 5);
+    QCOMPARE(cache.count(), static_cast<qsizetype>(5));
+    for (int i = 45; i < 50; i++) {
+        QVERIFY(cache.contains(i));
+    }
+
+    // The most recently used tile is kept even if it alone exceeds the budget
+    cache.setMaxBytes(1);
+    QCOMPARE(cache.count(), static_cast<qsizetype>(1));
+    QVERIFY(cache.contains(49));
+}
+
+void TerrainTileCacheTest::_testEvictedTileStaysUsable()
+{
+    TerrainTileCache cache(1);
+    cache.insert(1, _createTile(10));
+    const std::shared_ptr<const TerrainTile> tile = cache.tile(1);
+    QVERIFY(tile);
+
+    cache.insert(2, _createTile(20));
+    QVERIFY(!cache.contains(1));
+    QCOMPARE(tile->elevation(QGeoCoordinate(0.005, 0.005)), 10.0);
+}
+
+void TerrainTileCacheTest::_testConcurrentReads()
+{
+    constexpr int tileCount = 64;
+    TerrainTileCache cache(_createTile(0)->memoryUsage() * tileCount);
+    for (int i = 0; i < tileCount; i++) {
+        cache.insert(i, _createTile(static_cast<int16_t>(i)));
+    }
+
+    QAtomicInteger<int> misses(0);
+    QList<QThread*> readers;
+    for (int t = 0; t < kReaderThreads; t++) {
+        readers.append(QThread::create([&cache, &misses]() {
+            for (int i = 0; i < kLookupsPerThread; i++) {
+                const quint64 tileKey = static_cast<quint64>(i % tileCount);
+                const std::shared_ptr<const TerrainTile> tile = cache.tile(tileKey);
+                if (!tile || (tile->avgElevation() != static_cast<double>(tileKey))) {
+                    misses.fetchAndAddRelaxed(1);
+                }
+            }
+        }));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (QThread *reader : readers) {
+        reader->start();
+    }
+    for (QThread *reader : readers) {
+        QVERIFY(reader->wait());
+    }
+    qDebug() << (kReaderThreads * kLookupsPerThread) << "lookups on" << kReaderThreads << "threads in" << timer.elapsed() << "msecs";
+    qDeleteAll(readers);
+
+    QCOMPARE(misses.loadRelaxed(), 0);
+    QCOMPARE(cache.count(), static_cast<qsizetype>(tileCount));
+}
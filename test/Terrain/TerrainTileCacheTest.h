@@ -0,0 +1,36 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+#include <memory>
+
+class TerrainTile;
+
+class TerrainTileCacheTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testInsertAndLookup();
+    void _testLeastRecentlyUsedEviction();
+    void _testShrinkBudget();
+    void _testEvictedTileStaysUsable();
+    void _testConcurrentReads();
+
+private:
+    /// Valid tile with a constant elevation grid
+    static std::shared_ptr<const TerrainTile> _createTile(int16_t elevation);
+
+    static constexpr int kGridSize = 37;
+    static constexpr int kReaderThreads = 4;
+    static constexpr int kLookupsPerThread = 200000;
+};
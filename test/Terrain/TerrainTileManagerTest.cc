@@ -0,0 +1,476 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TerrainTileManagerTest.h"
+#include "TerrainTileManager.h"
+#include "TerrainQueryInterface.h"
+#include "TerrainTileCopernicus.h"
+
+#include <DeviceInfo.h>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QtMath>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QTimer>
+#include <QtCore/QUrlQuery>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#include <QtTest/QTest>
+#include <QtTest/QSignalSpy>
+
+/// Copernicus carpet API response for a tile of constant elevation
+static QByteArray _tileJson(double swLat, double swLon, double neLat, double neLon, int elevation)
+{
+    static constexpr int gridSize = 37;
+
+    QJsonArray row;
+    for (int i = 0; i < gridSize; i++) {
+        row.append(elevation);
+    }
+    QJsonArray carpet;
+    for (int i = 0; i < gridSize; i++) {
+        carpet.append(row);
+    }
+
+    const QJsonObject bounds = {
+        { QStringLiteral("sw"), QJsonArray({ swLat, swLon }) },
+        { QStringLiteral("ne"), QJsonArray({ neLat, neLon }) },
+    };
+    const QJsonObject stats = {
+        { QStringLiteral("min"), elevation },
+        { QStringLiteral("max"), elevation },
+        { QStringLiteral("avg"), elevation },
+    };
+    const QJsonObject data = {
+        { QStringLiteral("bounds"), bounds },
+        { QStringLiteral("stats"), stats },
+        { QStringLiteral("carpet"), carpet },
+    };
+    const QJsonObject root = {
+        { QStringLiteral("status"), QStringLiteral("success") },
+        { QStringLiteral("data"), data },
+    };
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+/// Minimal HTTP/1.1 stand-in for the Copernicus carpet API. Every request is answered with a tile of
+/// constant elevation covering the requested bounds after a fixed latency, one request per connection.
+class TerrainTileTestServer : public QTcpServer
+{
+public:
+    TerrainTileTestServer(int latencyMsecs, int elevation, QObject *parent = nullptr)
+        : QTcpServer(parent)
+        , _latencyMsecs(latencyMsecs)
+        , _elevation(elevation)
+    {
+        (void) connect(this, &QTcpServer::newConnection, this, [this]() {
+            while (hasPendingConnections()) {
+                _handleConnection(nextPendingConnection());
+            }
+        });
+    }
+
+    void setFailRequests(bool failRequests) { _failRequests = failRequests; }
+    int requestCount() const { return _requestCount; }
+    int maxActiveRequests() const { return _maxActiveRequests; }
+
+private:
+    void _handleConnection(QTcpSocket *socket)
+    {
+        (void) connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+
+        std::shared_ptr<QByteArray> buffer = std::make_shared<QByteArray>();
+        (void) connect(socket, &QTcpSocket::readyRead, this, [this, socket, buffer]() {
+            buffer->append(socket->readAll());
+            if (!buffer->contains("\r\n\r\n")) {
+                return;
+            }
+            (void) disconnect(socket, &QTcpSocket::readyRead, this, nullptr);
+
+            // "GET /api/v1/carpet?points=... HTTP/1.1"
+            const QList<QByteArray> requestLine = buffer->left(buffer->indexOf("\r\n")).split(' ');
+            const QUrl url = (requestLine.count() > 1) ? QUrl(QString::fromLatin1(requestLine[1])) : QUrl();
+
+            _requestCount++;
+            _activeRequests++;
+            _maxActiveRequests = qMax(_maxActiveRequests, _activeRequests);
+
+            QTimer::singleShot(_latencyMsecs, socket, [this, socket, url]() {
+                _activeRequests--;
+                (void) socket->write(_response(url));
+                socket->disconnectFromHost();
+            });
+        });
+    }
+
+    QByteArray _response(const QUrl &url) const
+    {
+        const QStringList points = QUrlQuery(url).queryItemValue(QStringLiteral("points")).split(',');
+        if (_failRequests || (points.count() != 4)) {
+            return QByteArrayLiteral("HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        }
+
+        const QByteArray body = _tileJson(points[0].toDouble(), points[1].toDouble(), points[2].toDouble(), points[3].toDouble(), _elevation);
+
+        QByteArray response = QByteArrayLiteral("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nConnection: close\r\n");
+        response += QByteArrayLiteral("Content-Length: ") + QByteArray::number(body.size()) + QByteArrayLiteral("\r\n\r\n");
+        response += body;
+        return response;
+    }
+
+    const int _latencyMsecs;
+    const int _elevation;
+    bool _failRequests = false;
+    int _requestCount = 0;
+    int _activeRequests = 0;
+    int _maxActiveRequests = 0;
+
+};
+
+/// Sends every request to the local test server, keeping path and query
+class RedirectingNetworkAccessManager : public QNetworkAccessManager
+{
+public:
+    RedirectingNetworkAccessManager(quint16 port, QObject *parent = nullptr)
+        : QNetworkAccessManager(parent)
+        , _port(port)
+    {}
+
+protected:
+    QNetworkReply *createRequest(Operation op, const QNetworkRequest &originalRequest, QIODevice *outgoingData = nullptr) final
+    {
+        QUrl url = originalRequest.url();
+        url.setScheme(QStringLiteral("http"));
+        url.setHost(QStringLiteral("127.0.0.1"));
+        url.setPort(_port);
+
+        QNetworkRequest request(originalRequest);
+        request.setUrl(url);
+        return QNetworkAccessManager::createRequest(op, request, outgoingData);
+    }
+
+private:
+    const quint16 _port;
+};
+
+void TerrainTileManagerTest::_useServer(TerrainTileManager &manager, const TerrainTileTestServer &server)
+{
+    delete manager._networkManager;
+    manager._networkManager = new RedirectingNetworkAccessManager(server.serverPort(), &manager);
+}
+
+QList<QGeoCoordinate> TerrainTileManagerTest::_tileCenters(int rows, int columns)
+{
+    // A random block of tiles keeps earlier runs which populated the tile cache database from answering the requests
+    const int baseY = QRandomGenerator::global()->bounded(3000, 15000 - rows);
+    const int baseX = QRandomGenerator::global()->bounded(0, 36000 - columns);
+
+    QList<QGeoCoordinate> coordinates;
+    for (int row = 0; row < rows; row++) {
+        for (int column = 0; column < columns; column++) {
+            const double lat = ((baseY + row + 0.5) * TerrainTileCopernicus::kTileSizeDegrees) - 90.0;
+            const double lon = ((baseX + column + 0.5) * TerrainTileCopernicus::kTileSizeDegrees) - 180.0;
+            coordinates.append(QGeoCoordinate(lat, lon));
+        }
+    }
+    return coordinates;
+}
+
+void TerrainTileManagerTest::_testConcurrentTileDownloads()
+{
+    if (!QGCDeviceInfo::isInternetAvailable()) {
+        QSKIP("Tile replies only go to the network when it is reported as reachable");
+    }
+
+    TerrainTileTestServer server(kServerLatencyMsecs, kServerElevation);
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    TerrainTileManager manager;
+    _useServer(manager, server);
+
+    TerrainQueryInterface query;
+    QSignalSpy spy(&query, &TerrainQueryInterface::coordinateHeightsReceived);
+
+    const QList<QGeoCoordinate> coordinates = _tileCenters(kTileRows, kTileColumns);
+    QElapsedTimer timer;
+    timer.start();
+    manager.addCoordinateQuery(&query, coordinates);
+    QVERIFY(spy.wait(kTimeoutMsecs));
+    const qint64 elapsedMsecs = timer.elapsed();
+
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(spy.at(0).at(0).toBool());
+    const QList<double> heights = spy.at(0).at(1).value<QList<double>>();
+    QCOMPARE(heights.count(), coordinates.count());
+    for (const double height : heights) {
+        QCOMPARE(height, static_cast<double>(kServerElevation));
+    }
+
+    const int tileCount = kTileRows * kTileColumns;
+    const qint64 serialMsecs = static_cast<qint64>(tileCount) * kServerLatencyMsecs;
+    qDebug() << "Downloaded" << tileCount << "tiles in" << elapsedMsecs << "msecs, one at a time would take at least" << serialMsecs << "msecs";
+    qDebug() << "Max concurrent requests" << server.maxActiveRequests();
+
+    QCOMPARE(server.requestCount(), tileCount);
+    QVERIFY(server.maxActiveRequests() > 1);
+    QVERIFY(server.maxActiveRequests() <= TerrainTileManager::kMaxConcurrentDownloads);
+    QVERIFY(elapsedMsecs < serialMsecs);
+}
+
+void TerrainTileManagerTest::_testSharedTileDownloads()
+{
+    if (!QGCDeviceInfo::isInternetAvailable()) {
+        QSKIP("Tile replies only go to the network when it is reported as reachable");
+    }
+
+    TerrainTileTestServer server(kServerLatencyMsecs, kServerElevation);
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    TerrainTileManager manager;
+    _useServer(manager, server);
+
+    // The second query covers a subset of the tiles of the first, nothing should be downloaded twice
+    const QList<QGeoCoordinate> coordinates = _tileCenters(kTileRows, kTileColumns);
+    const QList<QGeoCoordinate> subset = coordinates.mid(0, kTileColumns);
+
+    TerrainQueryInterface query;
+    QSignalSpy spy(&query, &TerrainQueryInterface::coordinateHeightsReceived);
+    TerrainQueryInterface subsetQuery;
+    QSignalSpy subsetSpy(&subsetQuery, &TerrainQueryInterface::coordinateHeightsReceived);
+
+    manager.addCoordinateQuery(&query, coordinates);
+    manager.addCoordinateQuery(&subsetQuery, subset);
+    QVERIFY(subsetSpy.wait(kTimeoutMsecs));
+    QVERIFY(spy.count() || spy.wait(kTimeoutMsecs));
+
+    QVERIFY(spy.at(0).at(0).toBool());
+    QVERIFY(subsetSpy.at(0).at(0).toBool());
+    QCOMPARE(subsetSpy.at(0).at(1).value<QList<double>>().count(), subset.count());
+    QCOMPARE(server.requestCount(), kTileRows * kTileColumns);
+
+    // Everything is cached now and is answered without going back to the server
+    TerrainQueryInterface cachedQuery;
+    QSignalSpy cachedSpy(&cachedQuery, &TerrainQueryInterface::coordinateHeightsReceived);
+    manager.addCoordinateQuery(&cachedQuery, coordinates);
+    QCOMPARE(cachedSpy.count(), 1);
+    QVERIFY(cachedSpy.at(0).at(0).toBool());
+    QCOMPARE(server.requestCount(), kTileRows * kTileColumns);
+}
+
+void TerrainTileManagerTest::_testFailedTileDownload()
+{
+    if (!QGCDeviceInfo::isInternetAvailable()) {
+        QSKIP("Tile replies only go to the network when it is reported as reachable");
+    }
+
+    TerrainTileTestServer server(kServerLatencyMsecs, kServerElevation);
+    server.setFailRequests(true);
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    TerrainTileManager manager;
+    _useServer(manager, server);
+
+    TerrainQueryInterface query;
+    QSignalSpy spy(&query, &TerrainQueryInterface::coordinateHeightsReceived);
+    manager.addCoordinateQuery(&query, _tileCenters(1, 2));
+    QVERIFY(spy.wait(kTimeoutMsecs));
+
+    // A request fails once, on the first of its tiles to fail
+    QTest::qWait(2 * kServerLatencyMsecs);
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(!spy.at(0).at(0).toBool());
+    QVERIFY(manager._requestQueue.isEmpty());
+}
+
+void TerrainTileManagerTest::_testCacheSmallerThanRequest()
+{
+    if (!QGCDeviceInfo::isInternetAvailable()) {
+        QSKIP("Tile replies only go to the network when it is reported as reachable");
+    }
+
+    TerrainTileTestServer server(kServerLatencyMsecs, kServerElevation);
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    TerrainTileManager manager;
+    _useServer(manager, server);
+    // Only the most recently used tile is kept, every other tile of the requests is evicted as the next one arrives
+    manager._tileCache.setMaxBytes(1);
+
+    const QList<QGeoCoordinate> coordinates = _tileCenters(kTileRows, kTileColumns);
+
+    TerrainQueryInterface query;
+    QSignalSpy spy(&query, &TerrainQueryInterface::coordinateHeightsReceived);
+    manager.addCoordinateQuery(&query, coordinates);
+    QVERIFY(spy.wait(kTimeoutMsecs));
+
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(spy.at(0).at(0).toBool());
+    const QList<double> heights = spy.at(0).at(1).value<QList<double>>();
+    QCOMPARE(heights.count(), coordinates.count());
+    for (const double height : heights) {
+        QCOMPARE(height, static_cast<double>(kServerElevation));
+    }
+    QCOMPARE(server.requestCount(), kTileRows * kTileColumns);
+    QVERIFY(manager._requestQueue.isEmpty());
+}
+
+void TerrainTileManagerTest::_testPrefetchArea()
+{
+    if (!QGCDeviceInfo::isInternetAvailable()) {
+        QSKIP("Tile replies only go to the network when it is reported as reachable");
+    }
+
+    TerrainTileTestServer server(kServerLatencyMsecs, kServerElevation);
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    TerrainTileManager manager;
+    _useServer(manager, server);
+
+    const QList<QGeoCoordinate> coordinates = _tileCenters(kTileRows, kTileColumns);
+    manager.prefetchArea(coordinates.first(), coordinates.last());
+    QTRY_COMPARE_WITH_TIMEOUT(server.requestCount(), kTileRows * kTileColumns, kTimeoutMsecs);
+    QTRY_VERIFY_WITH_TIMEOUT(manager._downloadingTiles.isEmpty(), kTimeoutMsecs);
+
+    // Prefetched tiles answer queries synchronously
+    bool error = false;
+    QList<double> altitudes;
+    QVERIFY(manager.getAltitudesForCoordinates(coordinates, altitudes, error));
+    QVERIFY(!error);
+    QCOMPARE(altitudes.count(), coordinates.count());
+    QCOMPARE(server.requestCount(), kTileRows * kTileColumns);
+}
+
+void TerrainTileManagerTest::_cacheCarpetTiles(TerrainTileManager &manager, const QGeoCoordinate &swCoord, const QGeoCoordinate &neCoord)
+{
+    static constexpr double tileSize = TerrainTileCopernicus::kTileSizeDegrees;
+    // A small overlap keeps samples on tile edges inside the tile their key points to
+    static constexpr double overlap = 1e-9;
+
+    const int southTile = qFloor((swCoord.latitude() + 90.0) / tileSize);
+    const int northTile = qFloor((neCoord.latitude() + 90.0) / tileSize);
+    const int westTile = qFloor((swCoord.longitude() + 180.0) / tileSize);
+    const int eastTile = qFloor((neCoord.longitude() + 180.0) / tileSize);
+    for (int y = southTile; y <= northTile; y++) {
+        for (int x = westTile; x <= eastTile; x++) {
+            const double swLat = (y * tileSize) - 90.0;
+            const double swLon = (x * tileSize) - 180.0;
+            const int elevation = (y - southTile) + (x - westTile);
+            const QByteArray tile = TerrainTileCopernicus::serializeFromData(_tileJson(swLat - overlap, swLon - overlap, swLat + tileSize + overlap, swLon + tileSize + overlap, elevation));
+            const QGeoCoordinate center(swLat + (tileSize / 2), swLon + (tileSize / 2));
+            manager._cacheTile(tile, TerrainTileManager::_tileKey(center));
+        }
+    }
+}
+
+int TerrainTileManagerTest::_carpetTileElevation(const QGeoCoordinate &swCoord, double latitude, double longitude)
+{
+    static constexpr double tileSize = TerrainTileCopernicus::kTileSizeDegrees;
+    return (qFloor((latitude + 90.0) / tileSize) - qFloor((swCoord.latitude() + 90.0) / tileSize)) +
+        (qFloor((longitude + 180.0) / tileSize) - qFloor((swCoord.longitude() + 180.0) / tileSize));
+}
+
+void TerrainTileManagerTest::_testCarpetQuery()
+{
+    const QGeoCoordinate swCoord(47.3012, 8.5034);
+    const QGeoCoordinate neCoord(47.3251, 8.5307);
+
+    TerrainTileManager manager;
+    _cacheCarpetTiles(manager, swCoord, neCoord);
+
+    TerrainQueryInterface query;
+    QSignalSpy spy(&query, &TerrainQueryInterface::carpetHeightsReceived);
+
+    // Every tile is cached, the carpet is signalled right away
+    manager.addCarpetQuery(&query, swCoord, neCoord, false);
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(spy.at(0).at(0).toBool());
+    QCOMPARE(spy.at(0).at(1).toDouble(), 0.);
+    QCOMPARE(spy.at(0).at(2).toDouble(), static_cast<double>(_carpetTileElevation(swCoord, neCoord.latitude(), neCoord.longitude())));
+
+    const QList<QList<double>> carpet = spy.at(0).at(3).value<QList<QList<double>>>();
+    const int rows = qCeil((neCoord.latitude() - swCoord.latitude()) / TerrainTileCopernicus::kTleValueSpacingDegrees) + 1;
+    const int columns = qCeil((neCoord.longitude() - swCoord.longitude()) / TerrainTileCopernicus::kTleValueSpacingDegrees) + 1;
+    QCOMPARE(carpet.count(), static_cast<qsizetype>(rows));
+    const double latStep = (neCoord.latitude() - swCoord.latitude()) / (rows - 1);
+    const double lonStep = (neCoord.longitude() - swCoord.longitude()) / (columns - 1);
+    for (int row = 0; row < rows; row += 7) {
+        QCOMPARE(carpet[row].count(), static_cast<qsizetype>(columns));
+        for (int column = 0; column < columns; column += 5) {
+            const double latitude = swCoord.latitude() + (row * latStep);
+            const double longitude = swCoord.longitude() + (column * lonStep);
+            // Samples right on a tile edge may come from either side
+            const int elevation = _carpetTileElevation(swCoord, latitude, longitude);
+            QVERIFY(qAbs(carpet[row][column] - elevation) <= 1.);
+        }
+    }
+
+    // Stats only, no rows are returned
+    manager.addCarpetQuery(&query, swCoord, neCoord, true);
+    QCOMPARE(spy.count(), 2);
+    QVERIFY(spy.at(1).at(0).toBool());
+    QCOMPARE(spy.at(1).at(1).toDouble(), spy.at(0).at(1).toDouble());
+    QCOMPARE(spy.at(1).at(2).toDouble(), spy.at(0).at(2).toDouble());
+    QVERIFY(spy.at(1).at(3).value<QList<QList<double>>>().isEmpty());
+
+    // Corners the wrong way round
+    manager.addCarpetQuery(&query, neCoord, swCoord, false);
+    QCOMPARE(spy.count(), 3);
+    QVERIFY(!spy.at(2).at(0).toBool());
+}
+
+void TerrainTileManagerTest::_benchmarkCarpetQuery()
+{
+    // kBenchmarkCarpetSize samples per side at the tile value spacing
+    const QGeoCoordinate swCoord(46.0005, 7.0005);
+    const double span = (kBenchmarkCarpetSize - 1.5) * TerrainTileCopernicus::kTleValueSpacingDegrees;
+    const QGeoCoordinate neCoord(swCoord.latitude() + span, swCoord.longitude() + span);
+
+    TerrainTileManager manager;
+    _cacheCarpetTiles(manager, swCoord, neCoord);
+
+    TerrainQueryInterface query;
+    QSignalSpy spy(&query, &TerrainQueryInterface::carpetHeightsReceived);
+
+    QElapsedTimer timer;
+    timer.start();
+    manager.addCarpetQuery(&query, swCoord, neCoord, false);
+    const qint64 carpetMsecs = timer.restart();
+    manager.addCarpetQuery(&query, swCoord, neCoord, true);
+    const qint64 statsMsecs = timer.elapsed();
+
+    QCOMPARE(spy.count(), 2);
+    QVERIFY(spy.at(0).at(0).toBool());
+    const QList<QList<double>> carpet = spy.at(0).at(3).value<QList<QList<double>>>();
+    QCOMPARE(carpet.count(), static_cast<qsizetype>(kBenchmarkCarpetSize));
+    QCOMPARE(carpet.first().count(), static_cast<qsizetype>(kBenchmarkCarpetSize));
+    QVERIFY(spy.at(1).at(0).toBool());
+
+    // The same grid one coordinate list at a time as path and coordinate queries are answered
+    QList<QGeoCoordinate> coordinates;
+    coordinates.reserve(kBenchmarkCarpetSize);
+    const double step = span / (kBenchmarkCarpetSize - 1);
+    timer.start();
+    for (int row = 0; row < kBenchmarkCarpetSize; row++) {
+        coordinates.clear();
+        for (int column = 0; column < kBenchmarkCarpetSize; column++) {
+            coordinates.append(QGeoCoordinate(swCoord.latitude() + (row * step), swCoord.longitude() + (column * step)));
+        }
+        bool error;
+        QList<double> altitudes;
+        QVERIFY(manager.getAltitudesForCoordinates(coordinates, altitudes, error));
+        QVERIFY(!error);
+    }
+    const qint64 serialMsecs = timer.elapsed();
+
+    qDebug() << kBenchmarkCarpetSize << "x" << kBenchmarkCarpetSize << "carpet in" << carpetMsecs << "msecs, stats only" << statsMsecs << "msecs, row by row coordinate lookups" << serialMsecs << "msecs";
+}
@@ -0,0 +1,49 @@
+/****************************************************************************
+ *
+ * (c) 2009-2024 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+#include <QtPositioning/QGeoCoordinate>
+
+class TerrainTileManager;
+class TerrainTileTestServer;
+
+/// Runs TerrainTileManager against a local stand-in for the elevation tile server which answers every
+/// request after a fixed latency. Carpet queries run against tiles placed straight into the cache.
+class TerrainTileManagerTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testConcurrentTileDownloads();
+    void _testSharedTileDownloads();
+    void _testFailedTileDownload();
+    void _testCacheSmallerThanRequest();
+    void _testPrefetchArea();
+    void _testCarpetQuery();
+    void _benchmarkCarpetQuery();
+
+private:
+    /// Redirects all network requests of manager to server
+    static void _useServer(TerrainTileManager &manager, const TerrainTileTestServer &server);
+    /// One coordinate in the center of each tile of a rows x columns block of elevation tiles
+    static QList<QGeoCoordinate> _tileCenters(int rows, int columns);
+    /// Caches the tiles covering the area, each with the constant elevation tile row + tile column counted from swCoord
+    static void _cacheCarpetTiles(TerrainTileManager &manager, const QGeoCoordinate &swCoord, const QGeoCoordinate &neCoord);
+    static int _carpetTileElevation(const QGeoCoordinate &swCoord, double latitude, double longitude);
+
+    static constexpr int kServerLatencyMsecs = 100;
+    static constexpr int kServerElevation = 42;
+    static constexpr int kTileRows = 3;
+    static constexpr int kTileColumns = 4;
+    static constexpr int kTimeoutMsecs = 10000;
+    static constexpr int kBenchmarkCarpetSize = 1000;
+};
@@ -10,4 +10,158 @@
 #include "TerrainTileTest.h"
 #include "TerrainTile.h"
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QRandomGenerator>
+#include <QtPositioning/QGeoCoordinate>
 #include <QtTest/QTest>
+
+#include <cstring>
+
+QByteArray TerrainTileTest::_createTileData()
+{
+    TerrainTile::TileInfo_t tileInfo;
+    tileInfo.swLat = kSwLat;
+    tileInfo.swLon = kSwLon;
+    tileInfo.neLat = kSwLat + kTileSizeDegrees;
+    tileInfo.neLon = kSwLon + kTileSizeDegrees;
+    tileInfo.minElevation = 0;
+    tileInfo.maxElevation = static_cast<int16_t>(_gridElevation(kGridSize - 1, kGridSize - 1));
+    tileInfo.avgElevation = _gridElevation(kGridSize - 1, kGridSize - 1) / 2.0;
+    tileInfo.gridSizeLat = kGridSize;
+    tileInfo.gridSizeLon = kGridSize;
+
+    QByteArray data(sizeof(TerrainTile::TileInfo_t) + (sizeof(int16_t) * kGridSize * kGridSize), Qt::Uninitialized);
+    (void) memcpy(data.data(), &tileInfo, sizeof(tileInfo));
+    int16_t* const grid = reinterpret_cast<int16_t*>(data.data() + sizeof(TerrainTile::TileInfo_t));
+    for (int row = 0; row < kGridSize; row++) {
+        for (int column = 0; column < kGridSize; column++) {
+            grid[(row * kGridSize) + column] = static_cast<int16_t>(_gridElevation(row, column));
+        }
+    }
+
+    return data;
+}
+
+void TerrainTileTest::_testInvalidData()
+{
+    QVERIFY(!TerrainTile(QByteArray()).isValid());
+
+    const QByteArray data = _createTileData();
+    QVERIFY(!TerrainTile(data.left(sizeof(TerrainTile::TileInfo_t) / 2)).isValid());
+    QVERIFY(!TerrainTile(data.left(data.size() - 1)).isValid());
+    QVERIFY(TerrainTile(data).isValid());
+}
+
+void TerrainTileTest::_testNearestElevations()
+{
+    const TerrainTile tile(_createTileData());
+    QVERIFY(tile.isValid());
+
+    const double cellSize = kTileSizeDegrees / kGridSize;
+    QList<double> latitudes;
+    QList<double> longitudes;
+    QList<double> expected;
+    for (int row = 0; row < kGridSize; row += 5) {
+        for (int column = 0; column < kGridSize; column += 7) {
+            // Anywhere within the cell maps to the cell value
+            (void) latitudes.append(kSwLat + ((row + 0.9) * cellSize));
+            (void) longitudes.append(kSwLon + ((column + 0.1) * cellSize));
+            (void) expected.append(_gridElevation(row, column));
+        }
+    }
+
+    QList<double> elevations(latitudes.count());
+    QVERIFY(tile.elevations(latitudes.constData(), longitudes.constData(), elevations.data(), latitudes.count()));
+    QCOMPARE(elevations, expected);
+
+    for (qsizetype i = 0; i < latitudes.count(); i++) {
+        QCOMPARE(tile.elevation(QGeoCoordinate(latitudes[i], longitudes[i])), expected[i]);
+    }
+}
+
+void TerrainTileTest::_testBilinearElevations()
+{
+    const TerrainTile tile(_createTileData());
+    const double cellSize = kTileSizeDegrees / kGridSize;
+
+    const QList<double> latitudes = {
+        kSwLat + (10.5 * cellSize),     // cell center
+        kSwLat + (11.0 * cellSize),     // between two rows
+        kSwLat + (11.25 * cellSize),    // quarter of the way between two centers
+        kSwLat + (0.1 * cellSize),      // outer half of the south edge cells
+        kSwLat + (35.9 * cellSize),     // outer half of the north edge cells
+    };
+    const QList<double> longitudes = {
+        kSwLon + (20.5 * cellSize),
+        kSwLon + (21.0 * cellSize),
+        kSwLon + (21.5 * cellSize),
+        kSwLon + (0.1 * cellSize),
+        kSwLon + (35.9 * cellSize),
+    };
+    const QList<double> expected = {
+        _gridElevation(10, 20),
+        (_gridElevation(10, 20) + _gridElevation(11, 21)) / 2.0,
+        _gridElevation(10, 21) + (0.75 * (_gridElevation(11, 21) - _gridElevation(10, 21))),
+        _gridElevation(0, 0),
+        _gridElevation(kGridSize - 1, kGridSize - 1),
+    };
+
+    QList<double> elevations(latitudes.count());
+    QVERIFY(tile.elevations(latitudes.constData(), longitudes.constData(), elevations.data(), latitudes.count(), TerrainTile::Interpolation::Bilinear));
+    for (qsizetype i = 0; i < expected.count(); i++) {
+        QVERIFY2(qAbs(elevations[i] - expected[i]) < 1e-6, qPrintable(QStringLiteral("%1: %2 != %3").arg(i).arg(elevations[i]).arg(expected[i])));
+    }
+}
+
+void TerrainTileTest::_testOutsideTile()
+{
+    const TerrainTile tile(_createTileData());
+
+    const QList<double> latitudes = { kSwLat - 0.001, kSwLat + 0.005, kSwLat + kTileSizeDegrees + 0.001, qQNaN() };
+    const QList<double> longitudes = { kSwLon + 0.005, kSwLon + 0.005, kSwLon + 0.005, kSwLon + 0.005 };
+
+    for (const TerrainTile::Interpolation interpolation : { TerrainTile::Interpolation::Nearest, TerrainTile::Interpolation::Bilinear }) {
+        QList<double> elevations(latitudes.count());
+        QVERIFY(!tile.elevations(latitudes.constData(), longitudes.constData(), elevations.data(), latitudes.count(), interpolation));
+        QVERIFY(qIsNaN(elevations[0]));
+        QVERIFY(!qIsNaN(elevations[1]));
+        QVERIFY(qIsNaN(elevations[2]));
+        QVERIFY(qIsNaN(elevations[3]));
+    }
+}
+
+void TerrainTileTest::_benchmarkElevations()
+{
+    const TerrainTile tile(_createTileData());
+
+    QList<double> latitudes(kBenchmarkLookups);
+    QList<double> longitudes(kBenchmarkLookups);
+    QRandomGenerator random(1234);
+    for (int i = 0; i < kBenchmarkLookups; i++) {
+        latitudes[i] = kSwLat + (random.generateDouble() * kTileSizeDegrees);
+        longitudes[i] = kSwLon + (random.generateDouble() * kTileSizeDegrees);
+    }
+
+    QList<double> single(kBenchmarkLookups);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < kBenchmarkLookups; i++) {
+        single[i] = tile.elevation(QGeoCoordinate(latitudes[i], longitudes[i]));
+    }
+    const qint64 singleNsecs = timer.nsecsElapsed();
+
+    QList<double> nearest(kBenchmarkLookups);
+    timer.restart();
+    QVERIFY(tile.elevations(latitudes.constData(), longitudes.constData(), nearest.data(), kBenchmarkLookups));
+    const qint64 nearestNsecs = timer.nsecsElapsed();
+
+    QList<double> bilinear(kBenchmarkLookups);
+    timer.restart();
+    QVERIFY(tile.elevations(latitudes.constData(), longitudes.constData(), bilinear.data(), kBenchmarkLookups, TerrainTile::Interpolation::Bilinear));
+    const qint64 bilinearNsecs = timer.nsecsElapsed();
+
+    QCOMPARE(nearest, single);
+
+    qDebug() << kBenchmarkLookups << "lookups (msecs) single:" << (singleNsecs / 1000000.0)
+             << "batch nearest:" << (nearestNsecs / 1000000.0) << "batch bilinear:" << (bilinearNsecs / 1000000.0);
+}
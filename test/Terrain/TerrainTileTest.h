@@ -16,4 +16,20 @@ class TerrainTileTest : public UnitTest
     Q_OBJECT
 
 private slots:
+    void _testInvalidData();
+    void _testNearestElevations();
+    void _testBilinearElevations();
+    void _testOutsideTile();
+    void _benchmarkElevations();
+
+private:
+    /// Serialized tile with elevation = row * 100 + column
+    static QByteArray _createTileData();
+    static double _gridElevation(int row, int column) { return (row * 100.0) + column; }
+
+    static constexpr double kSwLat = -48.875;
+    static constexpr double kSwLon = -123.393;
+    static constexpr double kTileSizeDegrees = 0.01;
+    static constexpr int kGridSize = 36;
+    static constexpr int kBenchmarkLookups = 1000000;
 };
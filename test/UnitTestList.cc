@@ -57,6 +57,8 @@
 #include "CameraSectionTest.h"
 #include "CorridorScanComplexItemTest.h"
 // #include "FWLandingPatternTest.h"
+#include "GeoFenceControllerTest.h"
+#include "GeoFenceIndexTest.h"
 // #include "LandingComplexItemTest.h"
 // #include "MissionCommandTreeEditorTest.h"
 #include "MissionCommandTreeTest.h"
@@ -65,6 +67,7 @@
 #include "MissionItemTest.h"
 #include "MissionManagerTest.h"
 #include "MissionSettingsTest.h"
+#include "PlanBatchGeneratorTest.h"
 #include "PlanMasterControllerTest.h"
 #include "QGCMapPolygonTest.h"
 #include "QGCMapPolylineTest.h"
@@ -81,9 +84,19 @@
 #include "ComponentInformationTranslationTest.h"
 
 // QmlControls
+#include "QmlObjectListModelTest.h"
+
+// QtLocationPlugin
+#include "LocalTileSourceTest.h"
+#include "QGCMapUrlEngineTest.h"
+#include "QGCTileCacheWorkerTest.h"
+#include "QGCTilePrefetcherTest.h"
 
 // Terrain
+#include "TerrainQueryLocalDemTest.h"
 #include "TerrainQueryTest.h"
+#include "TerrainTileCacheTest.h"
+#include "TerrainTileManagerTest.h"
 #include "TerrainTileTest.h"
 
 // UI
@@ -160,6 +173,8 @@ int runTests(bool stress, QStringView unitTestOptions)
     UT_REGISTER_TEST(CameraSectionTest)
     UT_REGISTER_TEST(CorridorScanComplexItemTest)
     // UT_REGISTER_TEST(FWLandingPatternTest)
+    UT_REGISTER_TEST(GeoFenceControllerTest)
+    UT_REGISTER_TEST(GeoFenceIndexTest)
     // UT_REGISTER_TEST(LandingComplexItemTest)
     // UT_REGISTER_TEST_STANDALONE(MissionCommandTreeEditorTest)
     UT_REGISTER_TEST(MissionCommandTreeTest)
@@ -168,6 +183,7 @@ int runTests(bool stress, QStringView unitTestOptions)
     UT_REGISTER_TEST(MissionItemTest)
     UT_REGISTER_TEST(MissionManagerTest)
     UT_REGISTER_TEST(MissionSettingsTest)
+    UT_REGISTER_TEST(PlanBatchGeneratorTest)
     UT_REGISTER_TEST(PlanMasterControllerTest)
     UT_REGISTER_TEST(QGCMapPolygonTest)
     UT_REGISTER_TEST(QGCMapPolylineTest)
@@ -182,9 +198,19 @@ int runTests(bool stress, QStringView unitTestOptions)
     // qgcunittest
 
     // QmlControls
+    UT_REGISTER_TEST(QmlObjectListModelTest)
+
+    // QtLocationPlugin
+    UT_REGISTER_TEST(LocalTileSourceTest)
+    UT_REGISTER_TEST(QGCMapUrlEngineTest)
+    UT_REGISTER_TEST(QGCTileCacheWorkerTest)
+    UT_REGISTER_TEST(QGCTilePrefetcherTest)
 
     // Terrain
+    UT_REGISTER_TEST(TerrainQueryLocalDemTest)
     UT_REGISTER_TEST(TerrainQueryTest)
+    UT_REGISTER_TEST(TerrainTileCacheTest)
+    UT_REGISTER_TEST(TerrainTileManagerTest)
     UT_REGISTER_TEST(TerrainTileTest)
 
     // UI